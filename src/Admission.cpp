@@ -0,0 +1,161 @@
+#include <cstring>
+
+#include "Admission.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr Admission::Config DEFAULT_CONFIG = {
+      100U,        // frames/s per sender, 10x nominal heartbeat rate
+      20U,
+      1000U,       // frames/s per CAN ID
+      100U,
+      10U,         // violations in a row
+      1000000000U  // 1 s quarantine
+    };
+
+    // rate 0 blocks all frames
+    constexpr uint64_t BLOCKED = UINT64_MAX;
+
+    uint64_t interval(uint32_t rate) {
+      return rate ? (1000000000U / rate) : BLOCKED;
+    }
+
+    uint64_t tolerance(uint64_t intervalNs, uint32_t burst) {
+      uint64_t numOfIntervals = burst ? burst - 1U : 0U;
+      if((BLOCKED == intervalNs) || (0U == numOfIntervals)) {
+        return 0U;
+      }
+      return (intervalNs > UINT64_MAX / numOfIntervals) ? UINT64_MAX : intervalNs * numOfIntervals;
+    }
+
+    uint64_t add(uint64_t a, uint64_t b) {
+      return (a > UINT64_MAX - b) ? UINT64_MAX : a + b;
+    }
+  }
+
+
+  Admission::Admission() :
+    Admission(DEFAULT_CONFIG) {}
+
+
+  Admission::Admission(const Config &config) :
+    m_config(config),
+    m_senderIntervalNs(interval(config.m_senderRate)),
+    m_senderToleranceNs(tolerance(m_senderIntervalNs, config.m_senderBurst)),
+    m_canIdIntervalNs(interval(config.m_canIdRate)),
+    m_canIdToleranceNs(tolerance(m_canIdIntervalNs, config.m_canIdBurst)) {
+    reset();
+  }
+
+
+  void Admission::reset() {
+    std::memset(ma_senders, 0, sizeof(ma_senders));
+    std::memset(ma_senderStats, 0, sizeof(ma_senderStats));
+    std::memset(ma_canIds, 0, sizeof(ma_canIds));
+    std::memset(ma_counts, 0, sizeof(ma_counts));
+  }
+
+
+  bool Admission::conform(Bucket &bucket, uint64_t nowNs, uint64_t intervalNs,
+                          uint64_t toleranceNs) {
+    if((BLOCKED == intervalNs) || (bucket.m_tatNs > add(nowNs, toleranceNs))) {
+      return false;
+    }
+    bucket.m_tatNs = add((bucket.m_tatNs > nowNs) ? bucket.m_tatNs : nowNs, intervalNs);
+    return true;
+  }
+
+
+  Admission::Verdict Admission::reject(Verdict verdict) {
+    ++ma_counts[verdict];
+    return verdict;
+  }
+
+
+  Admission::Verdict Admission::admit(const Protocol::Can::RawMsg &msg, uint64_t nowNs) {
+    CanIdIndex canId;
+    uint32_t dlc;
+    // any ID scheme, Device checks whether it is the configured one
+    auto id = Protocol::Can::Id::AGGREGATE;
+    char idDeviceId = Protocol::DeviceId::INVALID;
+    Protocol::Can::fromCanId(msg.m_canId, id, idDeviceId);
+    switch(id) {
+      case Protocol::Can::Id::ACTIVATE:
+        canId = ACTIVATE;
+        dlc = Protocol::Msg::Activate::DLC;
+        break;
+      case Protocol::Can::Id::HEARTBEAT:
+        canId = HEARTBEAT;
+        dlc = Protocol::Msg::Heartbeat::DLC;
+        break;
+      case Protocol::Can::Id::DISCOVER:
+        canId = DISCOVER;
+        dlc = Protocol::Msg::Discover::DLC;
+        break;
+      case Protocol::Can::Id::CMD:
+        canId = CMD;
+        dlc = Protocol::Msg::Cmd::DLC;
+        break;
+      default:
+        return reject(INVALID_CAN_ID);
+    }
+
+    // first byte: Device ID [0-5] Device Type [6-7]
+    auto deviceId = static_cast<char>(msg.m_dataL & 0x3FU);
+    auto deviceType = (msg.m_dataL >> 6U) & 0x03U;
+    if(not Protocol::DeviceId::isCorrectId(deviceId)) {
+      return reject(INVALID_DEVICE_ID);
+    }
+    auto &sender = ma_senders[static_cast<uint32_t>(deviceId)];
+    auto &stats = ma_senderStats[static_cast<uint32_t>(deviceId)];
+
+    Verdict verdict = ADMITTED;
+    if(nowNs < sender.m_quarantineEndNs) {
+      verdict = QUARANTINED;
+    } else if(dlc != msg.m_dlc) {
+      verdict = INVALID_CAN_DLC;
+    } else if((deviceType < static_cast<uint32_t>(Protocol::DeviceType::MASTER)) ||
+              (deviceType > static_cast<uint32_t>(Protocol::DeviceType::SLAVE))) {
+      verdict = INVALID_DEVICE_TYPE;
+    } else if(not conform(sender.m_bucket, nowNs, m_senderIntervalNs, m_senderToleranceNs)) {
+      verdict = SENDER_RATE_EXCEEDED;
+    } else if(not conform(ma_canIds[canId], nowNs, m_canIdIntervalNs, m_canIdToleranceNs)) {
+      // not sender's fault
+      ++stats.m_numOfRejected;
+      return reject(CAN_ID_RATE_EXCEEDED);
+    }
+
+    if(ADMITTED == verdict) {
+      sender.m_numOfViolations = 0U;
+      ++stats.m_numOfAdmitted;
+      ++ma_counts[ADMITTED];
+      return ADMITTED;
+    }
+    ++stats.m_numOfRejected;
+    if((QUARANTINED != verdict) && (++sender.m_numOfViolations >= m_config.m_maxViolations)) {
+      sender.m_numOfViolations = 0U;
+      sender.m_quarantineEndNs = add(nowNs, m_config.m_quarantineNs);
+      ++stats.m_numOfQuarantines;
+    }
+    return reject(verdict);
+  }
+
+
+  uint64_t Admission::getCount(Verdict verdict) const {
+    return ma_counts[verdict];
+  }
+
+
+  const Admission::SenderStats &Admission::getSenderStats(char deviceId) const {
+    auto sender = Protocol::DeviceId::isCorrectId(deviceId) ? static_cast<uint32_t>(deviceId) : 0U;
+    return ma_senderStats[sender];
+  }
+
+
+  bool Admission::isQuarantined(char deviceId, uint64_t nowNs) const {
+    return Protocol::DeviceId::isCorrectId(deviceId) &&
+           (nowNs < ma_senders[static_cast<uint32_t>(deviceId)].m_quarantineEndNs);
+  }
+
+} // end namespace Eet
@@ -0,0 +1,97 @@
+#ifndef EET_ADMISSION_H
+#define EET_ADMISSION_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Admission stage in front of Device::pushMsg().
+ * Call admit() for every received frame and push frame to the device only
+ * if ADMITTED is returned.
+ *
+ * 1. Cheap checks of CAN ID, DLC and first data byte (device ID and type)
+ *    reject frames which pushMsg() would reject anyway.
+ * 2. Rate of every sender and every CAN ID is limited by token buckets
+ *    (implemented as GCRA, one timestamp per bucket).
+ * 3. Sender which violates its limit maxViolations times in a row is
+ *    quarantined - all its frames are rejected during quarantine time.
+ */
+  class Admission {
+    public:
+      enum Verdict {
+          ADMITTED = 0,
+          INVALID_CAN_ID,
+          INVALID_CAN_DLC,
+          INVALID_DEVICE_ID,
+          INVALID_DEVICE_TYPE,
+          SENDER_RATE_EXCEEDED,
+          CAN_ID_RATE_EXCEEDED,
+          QUARANTINED,
+          NUM_OF_VERDICTS
+      };
+
+      struct Config {
+        uint32_t m_senderRate;  // frames per second of one sender, 0 - block all
+        uint32_t m_senderBurst; // frames
+        uint32_t m_canIdRate;   // frames per second of one CAN ID, all senders, 0 - block all
+        uint32_t m_canIdBurst;
+        uint32_t m_maxViolations;
+        uint64_t m_quarantineNs;
+      };
+
+      struct SenderStats {
+        uint64_t m_numOfAdmitted;
+        uint64_t m_numOfRejected;
+        uint64_t m_numOfQuarantines;
+      };
+
+      static constexpr uint32_t MAX_SENDERS = Protocol::DeviceId::MAX_DEVICE_ID + 1U;
+
+      Admission();
+      explicit Admission(const Config &config);
+
+      Verdict admit(const Protocol::Can::RawMsg &msg, uint64_t nowNs);
+      void reset();
+
+      uint64_t getCount(Verdict verdict) const;
+      const SenderStats &getSenderStats(char deviceId) const;
+      bool isQuarantined(char deviceId, uint64_t nowNs) const;
+
+    private:
+      enum CanIdIndex {
+          ACTIVATE = 0,
+          HEARTBEAT,
+          DISCOVER,
+          CMD,
+          NUM_OF_CAN_IDS
+      };
+
+      struct Bucket {
+        uint64_t m_tatNs; // theoretical arrival time
+      };
+
+      struct Sender {
+        Bucket m_bucket;
+        uint32_t m_numOfViolations;
+        uint64_t m_quarantineEndNs;
+      };
+
+      static bool conform(Bucket &bucket, uint64_t nowNs, uint64_t intervalNs,
+                          uint64_t toleranceNs);
+      Verdict reject(Verdict verdict);
+
+      Config m_config;
+      uint64_t m_senderIntervalNs;
+      uint64_t m_senderToleranceNs;
+      uint64_t m_canIdIntervalNs;
+      uint64_t m_canIdToleranceNs;
+      Sender ma_senders[MAX_SENDERS];
+      SenderStats ma_senderStats[MAX_SENDERS];
+      Bucket ma_canIds[NUM_OF_CAN_IDS];
+      uint64_t ma_counts[NUM_OF_VERDICTS];
+  };
+} // end namespace Eet
+
+#endif // EET_ADMISSION_H
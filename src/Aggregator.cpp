@@ -0,0 +1,112 @@
+#include <cstring>
+
+#include "Aggregator.h"
+
+namespace Eet {
+
+  namespace {
+    // record byte 3 - Can::Id, byte 0 - Device ID and Device Type
+    constexpr uint32_t RECORD_KEY_MASK = 0xFF0000FFU;
+  }
+
+  Aggregator::Aggregator() :
+    Aggregator(0U) {}
+
+
+  Aggregator::Aggregator(uint64_t maxDelayNs) :
+    m_maxDelayNs(maxDelayNs),
+    m_aggregate(),
+    m_firstNs(0U),
+    m_numOfPushed(0U),
+    m_numOfReplaced(0U),
+    m_numOfFrames(0U) {}
+
+
+  void Aggregator::setMaxDelay(uint64_t maxDelayNs) {
+    m_maxDelayNs = maxDelayNs;
+  }
+
+
+  bool Aggregator::push(const Protocol::Can::RawMsg &msg, uint64_t nowNs) {
+    Protocol::Msg::Aggregate single;
+    if(not single.add(msg)) {
+      return false;
+    }
+    auto record = single.ma_records[0];
+    auto numOfRecords = m_aggregate.getNumOfRecords();
+    auto *records = m_aggregate.ma_records;
+    for(uint32_t i = 0U; i < numOfRecords; ++i) {
+      if((records[i] & RECORD_KEY_MASK) == (record & RECORD_KEY_MASK)) {
+        // receivers apply records in order, the newer one goes after all
+        // records pushed before it
+        std::memmove(records + i, records + i + 1U, (numOfRecords - i - 1U) * sizeof(*records));
+        records[numOfRecords - 1U] = record;
+        ++m_numOfPushed;
+        ++m_numOfReplaced;
+        return true;
+      }
+    }
+    if(not m_aggregate.add(msg)) {
+      return false; // full
+    }
+    ++m_numOfPushed;
+    if(0U == numOfRecords) {
+      m_firstNs = nowNs;
+    }
+    return true;
+  }
+
+
+  bool Aggregator::isDue(uint64_t nowNs) const {
+    return nowNs >= getDueNs();
+  }
+
+
+  uint64_t Aggregator::getDueNs() const {
+    auto numOfRecords = m_aggregate.getNumOfRecords();
+    if(0U == numOfRecords) {
+      return NEVER;
+    }
+    if(numOfRecords >= Protocol::Msg::Aggregate::MAX_RECORDS) {
+      return m_firstNs;
+    }
+    return (m_firstNs > NEVER - m_maxDelayNs) ? NEVER : m_firstNs + m_maxDelayNs;
+  }
+
+
+  bool Aggregator::pop(Protocol::Can::FdRawMsg &frame) {
+    if(0U == m_aggregate.getNumOfRecords()) {
+      return false;
+    }
+    frame = static_cast<Protocol::Can::FdRawMsg>(m_aggregate);
+    m_aggregate.clear();
+    ++m_numOfFrames;
+    return true;
+  }
+
+
+  void Aggregator::clear() {
+    m_aggregate.clear();
+  }
+
+
+  uint32_t Aggregator::getNumOfRecords() const {
+    return m_aggregate.getNumOfRecords();
+  }
+
+
+  uint64_t Aggregator::getNumOfPushed() const {
+    return m_numOfPushed;
+  }
+
+
+  uint64_t Aggregator::getNumOfReplaced() const {
+    return m_numOfReplaced;
+  }
+
+
+  uint64_t Aggregator::getNumOfFrames() const {
+    return m_numOfFrames;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,58 @@
+#ifndef EET_AGGREGATOR_H
+#define EET_AGGREGATOR_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Sending side of AGGREGATE frames (see Protocol::Msg::Aggregate): packs
+ * classic messages of one or more devices into one CAN FD frame.
+ * A device with several local messages or a designated aggregator, e.g.
+ * a bridge from a classic segment to a CAN FD one, calls:
+ * 1. push() for each classic message it would send
+ * 2. pop() and send the frame when isDue(), getDueNs() is for timeouts
+ *
+ * Frame is due when all MAX_RECORDS records are taken or the oldest
+ * record has waited maxDelayNs (0 - at once). Message carries full state
+ * of its sender, so a newer message of the same type and sender replaces
+ * the pending one instead of taking one more record: the old record is
+ * removed and the new one is appended, records stay in push() order.
+ *
+ * Fixed size, no allocation.
+ */
+  class Aggregator {
+    public:
+      static constexpr uint64_t NEVER = UINT64_MAX;
+
+      Aggregator();
+      explicit Aggregator(uint64_t maxDelayNs);
+
+      void setMaxDelay(uint64_t maxDelayNs);
+      // false if msg is not ACTIVATE, HEARTBEAT, DISCOVER or CMD, or frame
+      // is full and msg replaces no record - send it as a classic frame or
+      // pop() first
+      bool push(const Protocol::Can::RawMsg &msg, uint64_t nowNs);
+      bool isDue(uint64_t nowNs) const;
+      uint64_t getDueNs() const; // NEVER if there are no records
+      // frame of all pending records, false if there are none
+      bool pop(Protocol::Can::FdRawMsg &frame);
+      void clear();
+      uint32_t getNumOfRecords() const; // pending
+
+      uint64_t getNumOfPushed() const;
+      uint64_t getNumOfReplaced() const;
+      uint64_t getNumOfFrames() const;
+
+    private:
+      uint64_t m_maxDelayNs;
+      Protocol::Msg::Aggregate m_aggregate;
+      uint64_t m_firstNs; // push() time of the oldest pending record
+      uint64_t m_numOfPushed;
+      uint64_t m_numOfReplaced;
+      uint64_t m_numOfFrames;
+  };
+} // end namespace Eet
+
+#endif // EET_AGGREGATOR_H
@@ -0,0 +1,235 @@
+#include "Analyzer.h"
+#include "Helpers.h"
+
+namespace Eet {
+
+  namespace {
+    // frames with the same timestamp give zero inter-arrival time, a stream
+    // cannot be faster than its frames back-to-back
+    uint64_t getPeriodNs(const Analyzer::Stream &stream, uint32_t bitrate) {
+      auto frameNs = Analyzer::getFrameNs(stream.m_dlc, bitrate);
+      return (stream.m_periodNs > frameNs) ? stream.m_periodNs : frameNs;
+    }
+  }
+
+  Analyzer::Analyzer(uint32_t bitrate, uint64_t windowNs) :
+    m_bitrate(bitrate),
+    m_windowNs(windowNs) {
+    reset();
+  }
+
+
+  void Analyzer::reset() {
+    m_windowHead = 0U;
+    m_windowSize = 0U;
+    m_windowBusyNs = 0U;
+    m_firstNs = 0U;
+    m_lastNs = 0U;
+    m_busyNs = 0U;
+    m_numOfFrames = 0U;
+    m_maxUtilization = 0.0;
+    for(auto &sender : ma_senders) {
+      for(auto &stats : sender) {
+        stats.m_numOfFrames = 0U;
+        stats.m_lastNs = 0U;
+        stats.m_canId = 0U;
+        stats.m_intervalNs.reset();
+      }
+    }
+    for(auto &dlc : ma_dlc) {
+      dlc = 0U;
+    }
+  }
+
+
+  Analyzer::Kind Analyzer::getKind(uint32_t canId) {
+    auto id = Protocol::Can::Id::AGGREGATE;
+    char deviceId = Protocol::DeviceId::INVALID;
+    Protocol::Can::fromCanId(canId, id, deviceId);
+    switch(id) {
+      case Protocol::Can::Id::ACTIVATE:
+        return ACTIVATE;
+      case Protocol::Can::Id::HEARTBEAT:
+        return HEARTBEAT;
+      case Protocol::Can::Id::CMD:
+        return CMD;
+      default:
+        return OTHER;
+    }
+  }
+
+
+  void Analyzer::onFrame(const Protocol::Can::RawMsg &msg, uint64_t timeNs) {
+    auto frameNs = getFrameNs(msg.m_dlc, m_bitrate);
+    if(0U == m_numOfFrames) {
+      m_firstNs = timeNs - frameNs;
+    }
+    ++m_numOfFrames;
+    m_lastNs = timeNs;
+    m_busyNs += frameNs;
+
+    // sliding window, oldest frames are dropped if window overflows
+    if(MAX_WINDOW_FRAMES == m_windowSize) {
+      m_windowBusyNs -= ma_window[m_windowHead].m_frameNs;
+      m_windowHead = (m_windowHead + 1U) % MAX_WINDOW_FRAMES;
+      --m_windowSize;
+    }
+    ma_window[(m_windowHead + m_windowSize) % MAX_WINDOW_FRAMES] = {timeNs, frameNs};
+    ++m_windowSize;
+    m_windowBusyNs += frameNs;
+    while(ma_window[m_windowHead].m_timeNs + m_windowNs <= timeNs) {
+      m_windowBusyNs -= ma_window[m_windowHead].m_frameNs;
+      m_windowHead = (m_windowHead + 1U) % MAX_WINDOW_FRAMES;
+      --m_windowSize;
+    }
+    if(timeNs - m_firstNs >= m_windowNs) {
+      auto utilization = getUtilization();
+      if(utilization > m_maxUtilization) {
+        m_maxUtilization = utilization;
+      }
+    }
+
+    auto kind = getKind(msg.m_canId);
+    auto deviceId = Helpers::bits2type<char>(msg.m_dataL, 0U, 0U, 6U);
+    auto sender = Protocol::DeviceId::isCorrectId(deviceId) ? static_cast<uint32_t>(deviceId) : 0U;
+    auto &stats = ma_senders[sender][kind];
+    if(stats.m_numOfFrames) {
+      stats.m_intervalNs.record(timeNs - stats.m_lastNs);
+    }
+    ++stats.m_numOfFrames;
+    stats.m_lastNs = timeNs;
+    stats.m_canId = msg.m_canId;
+    if(msg.m_dlc > ma_dlc[kind]) {
+      ma_dlc[kind] = msg.m_dlc;
+    }
+  }
+
+
+  uint64_t Analyzer::getNumOfFrames() const {
+    return m_numOfFrames;
+  }
+
+
+  double Analyzer::getUtilization() const {
+    return static_cast<double>(m_windowBusyNs) / static_cast<double>(m_windowNs);
+  }
+
+
+  double Analyzer::getMaxUtilization() const {
+    return m_maxUtilization;
+  }
+
+
+  double Analyzer::getMeanUtilization() const {
+    auto durationNs = m_lastNs - m_firstNs;
+    return durationNs ? static_cast<double>(m_busyNs) / static_cast<double>(durationNs) : 0.0;
+  }
+
+
+  const Analyzer::SenderStats &Analyzer::getSenderStats(char deviceId, Kind kind) const {
+    auto sender = Protocol::DeviceId::isCorrectId(deviceId) ? static_cast<uint32_t>(deviceId) : 0U;
+    return ma_senders[sender][kind];
+  }
+
+
+  uint32_t Analyzer::getStreams(Stream *streams, uint32_t maxStreams) const {
+    uint32_t ret = 0U;
+    for(uint32_t sender = 0U; sender < MAX_SENDERS; ++sender) {
+      for(uint32_t kind = 0U; kind < OTHER; ++kind) {
+        const auto &stats = ma_senders[sender][kind];
+        const auto &interval = stats.m_intervalNs;
+        if((0U == interval.getCount()) || (ret >= maxStreams)) {
+          continue;
+        }
+        Stream stream = {stats.m_canId, ma_dlc[kind], interval.getMin(),
+                         (interval.getMax() - interval.getMin()) / 2U};
+        stream.m_periodNs = getPeriodNs(stream, m_bitrate);
+        streams[ret++] = stream;
+      }
+    }
+    return ret;
+  }
+
+
+  uint64_t Analyzer::getFrameNs(uint32_t dlc, uint32_t bitrate) {
+    return static_cast<uint64_t>(Protocol::Can::getMaxFrameBits(dlc)) * 1000000000U / bitrate;
+  }
+
+
+  double Analyzer::getUtilization(const Stream *streams, uint32_t numOfStreams,
+                                  uint32_t bitrate) {
+    double ret = 0.0;
+    for(uint32_t i = 0U; i < numOfStreams; ++i) {
+      ret += static_cast<double>(getFrameNs(streams[i].m_dlc, bitrate)) /
+             static_cast<double>(getPeriodNs(streams[i], bitrate));
+    }
+    return ret;
+  }
+
+
+  uint64_t Analyzer::getResponseNs(const Stream *streams, uint32_t numOfStreams,
+                                   uint32_t index, uint32_t bitrate) {
+    const auto &m = streams[index];
+    const uint64_t bitNs = 1000000000U / bitrate;
+    const uint64_t frameNs = getFrameNs(m.m_dlc, bitrate);
+
+    // blocking by lower priority frame which is already on the bus
+    uint64_t blockingNs = frameNs;
+    for(uint32_t k = 0U; k < numOfStreams; ++k) {
+      if((k != index) && (streams[k].m_canId > m.m_canId)) {
+        auto kFrameNs = getFrameNs(streams[k].m_dlc, bitrate);
+        blockingNs = (kFrameNs > blockingNs) ? kFrameNs : blockingNs;
+      }
+    }
+
+    // queuing delay, w = B + sum(ceil((w + Jk + tau) / Tk) * Ck)
+    uint64_t waitNs = blockingNs;
+    const uint64_t limitNs = 1000U * getPeriodNs(m, bitrate);
+    while(true) {
+      uint64_t nextNs = blockingNs;
+      for(uint32_t k = 0U; k < numOfStreams; ++k) {
+        if((k != index) && (streams[k].m_canId <= m.m_canId)) {
+          const auto &s = streams[k];
+          const auto periodNs = getPeriodNs(s, bitrate);
+          nextNs += (waitNs + s.m_jitterNs + bitNs + periodNs - 1U) / periodNs *
+                    getFrameNs(s.m_dlc, bitrate);
+        }
+      }
+      if(nextNs == waitNs) {
+        break;
+      }
+      if(nextNs > limitNs) {
+        return UNBOUNDED;
+      }
+      waitNs = nextNs;
+    }
+    return m.m_jitterNs + waitNs + frameNs;
+  }
+
+
+  uint32_t Analyzer::makeStreams(uint32_t numOfMasters, uint32_t numOfSlaves,
+                                 uint64_t heartbeatPeriodNs, uint64_t cmdPeriodNs,
+                                 Stream *streams, uint32_t maxStreams,
+                                 Protocol::Can::IdScheme idScheme) {
+    using Protocol::Can::Id;
+    using Protocol::Can::toCanId;
+    auto id = [](uint32_t i) {
+      return static_cast<char>(Protocol::DeviceId::MIN_DEVICE_ID + i);
+    };
+    uint32_t ret = 0U;
+    for(uint32_t i = 0U; (i < numOfMasters + numOfSlaves) && (ret < maxStreams); ++i) {
+      streams[ret++] = {toCanId(Id::HEARTBEAT, id(i), idScheme),
+                        Protocol::Msg::Heartbeat::DLC, heartbeatPeriodNs, 0U};
+    }
+    for(uint32_t i = 0U; (i < numOfMasters) && (ret < maxStreams); ++i) {
+      streams[ret++] = {toCanId(Id::CMD, id(i), idScheme),
+                        Protocol::Msg::Cmd::DLC, cmdPeriodNs, 0U};
+    }
+    for(uint32_t i = 0U; (i < numOfSlaves) && (ret < maxStreams); ++i) {
+      streams[ret++] = {toCanId(Id::ACTIVATE, id(numOfMasters + i), idScheme),
+                        Protocol::Msg::Activate::DLC, cmdPeriodNs, 0U};
+    }
+    return ret;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,103 @@
+#ifndef EET_ANALYZER_H
+#define EET_ANALYZER_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+#include "FrameSink.h"
+#include "Histogram.h"
+
+namespace Eet {
+/**
+ * Bus load and timing analyzer of EET traffic.
+ * Feed it with frames and their end-of-frame timestamps (live socket,
+ * capture or Simulator::setSink()), then read utilization over sliding
+ * window, inter-arrival statistics per sender and message type and
+ * worst-case response time bounds.
+ *
+ * Response time analysis is the sufficient test for non-preemptive
+ * fixed priority CAN (Davis, Burns, Bril, Lukkien, 2007) with worst-case
+ * bit stuffing. Streams with the same CAN ID (e.g. V1 heartbeats of all
+ * devices) are treated as interfering with each other. Both ID schemes
+ * (see Protocol::Can::IdScheme) are recognized.
+ *
+ * Instance is large (histograms per sender), do not put it on stack.
+ */
+  class Analyzer final : public IFrameSink {
+    public:
+      enum Kind {
+          ACTIVATE = 0,
+          HEARTBEAT,
+          CMD,
+          OTHER,
+          NUM_OF_KINDS
+      };
+
+      struct Stream {
+        uint32_t m_canId;
+        uint32_t m_dlc;
+        uint64_t m_periodNs; // or minimal inter-arrival time, 0 is frame time
+        uint64_t m_jitterNs;
+      };
+
+      struct SenderStats {
+        uint64_t m_numOfFrames;
+        uint64_t m_lastNs;
+        uint32_t m_canId; // of the last frame
+        Histogram m_intervalNs;
+      };
+
+      static constexpr uint32_t MAX_WINDOW_FRAMES = 16384U;
+      static constexpr uint32_t MAX_SENDERS = Protocol::DeviceId::MAX_DEVICE_ID + 1U; // 0 - invalid
+      static constexpr uint64_t UNBOUNDED = UINT64_MAX;
+
+      Analyzer(uint32_t bitrate, uint64_t windowNs);
+      void onFrame(const Protocol::Can::RawMsg &msg, uint64_t timeNs) override;
+      void reset();
+
+      uint64_t getNumOfFrames() const;
+      double getUtilization() const; // of the last window, 0.0 - 1.0
+      double getMaxUtilization() const;
+      double getMeanUtilization() const;
+      const SenderStats &getSenderStats(char deviceId, Kind kind) const;
+      // streams observed so far, period is minimal inter-arrival time but
+      // at least the frame time
+      uint32_t getStreams(Stream *streams, uint32_t maxStreams) const;
+
+      static Kind getKind(uint32_t canId);
+      static uint64_t getFrameNs(uint32_t dlc, uint32_t bitrate);
+      static double getUtilization(const Stream *streams, uint32_t numOfStreams,
+                                   uint32_t bitrate);
+      // UNBOUNDED if busy period does not end
+      static uint64_t getResponseNs(const Stream *streams, uint32_t numOfStreams,
+                                    uint32_t index, uint32_t bitrate);
+      // what-if: every device sends heartbeats, Masters send cmds, Slaves activations
+      // Device IDs are 1.. for Masters, then Slaves
+      static uint32_t makeStreams(uint32_t numOfMasters, uint32_t numOfSlaves,
+                                  uint64_t heartbeatPeriodNs, uint64_t cmdPeriodNs,
+                                  Stream *streams, uint32_t maxStreams,
+                                  Protocol::Can::IdScheme idScheme = Protocol::Can::IdScheme::V1);
+
+    private:
+      struct WindowFrame {
+        uint64_t m_timeNs;
+        uint64_t m_frameNs;
+      };
+
+      uint32_t m_bitrate;
+      uint64_t m_windowNs;
+      WindowFrame ma_window[MAX_WINDOW_FRAMES];
+      uint32_t m_windowHead;
+      uint32_t m_windowSize;
+      uint64_t m_windowBusyNs;
+      uint64_t m_firstNs;
+      uint64_t m_lastNs;
+      uint64_t m_busyNs;
+      uint64_t m_numOfFrames;
+      double m_maxUtilization;
+      SenderStats ma_senders[MAX_SENDERS][NUM_OF_KINDS];
+      uint32_t ma_dlc[NUM_OF_KINDS];
+  };
+} // end namespace Eet
+
+#endif // EET_ANALYZER_H
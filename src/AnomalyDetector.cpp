@@ -0,0 +1,321 @@
+#include "AnomalyDetector.h"
+#include "Device.h"
+#include "Helpers.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr AnomalyDetector::Config DEFAULT_CONFIG = {
+      10U,          // jitter above 10% of heartbeat period
+      16U,          // after 16 heartbeat intervals
+      4U,           // DUPLICATED_DEVICE_ID set/cleared 4 times
+      10000000000U, // within 10 s
+      3U,           // 3 cmd type changes in a row
+      250000000U,   // each within 250 ms of the previous one
+      10U,          // 10 rejected frames
+      1000000000U   // within 1 s
+    };
+
+    constexpr uint32_t EWMA_SHIFT = 4U; // weight of new sample is 1/16
+    // CmdType::INVALID in heartbeat, its bit in byte 3 is beyond DLC
+    constexpr uint32_t NO_CMD_TYPE = 0x3FU;
+
+    Protocol::CmdType getCmdType(uint32_t dataL) {
+      return Helpers::enum2type(dataL, 2U, 2U, 7U,
+                                Protocol::CmdType::COMPLETE,
+                                Protocol::CmdType::FULL_ASTERN);
+    }
+
+    // counts event within window started at windowNs, true if it is the
+    // limit-th one
+    bool countInWindow(uint32_t &counter, uint64_t &windowNs, uint64_t timeNs,
+                       uint64_t durationNs, uint32_t limit) {
+      if((0U == counter) || (timeNs - windowNs > durationNs)) {
+        counter = 0U;
+        windowNs = timeNs;
+      }
+      ++counter;
+      return (limit == counter);
+    }
+  }
+
+
+  AnomalyDetector::AnomalyDetector(const IClock &clock) :
+    AnomalyDetector(DEFAULT_CONFIG, clock) {}
+
+
+  AnomalyDetector::AnomalyDetector(const Config &config, const IClock &clock) :
+    m_config(config),
+    m_clock(clock),
+    m_listener(nullptr) {
+    reset();
+  }
+
+
+  void AnomalyDetector::setListener(IListener *listener) {
+    m_listener = listener;
+  }
+
+
+  void AnomalyDetector::onMsg(const Protocol::Can::RawMsg &msg, uint16_t notValid,
+                              uint64_t timeNs) {
+    auto canId = Protocol::Can::Id::AGGREGATE;
+    char canIdDeviceId = Protocol::DeviceId::INVALID;
+    Protocol::Msg::CommonFields commonFields(msg.m_dataL);
+    auto deviceId = commonFields.m_deviceId;
+    auto deviceType = commonFields.m_deviceType;
+    bool isKnownId = Protocol::Can::fromCanId(msg.m_canId, canId, canIdDeviceId);
+    // heartbeat of a device which has not got any command yet is not an anomaly
+    if(isKnownId && (Protocol::Can::Id::HEARTBEAT == canId) &&
+       (NO_CMD_TYPE == Helpers::bits2type<uint32_t>(msg.m_dataL, 2U, 2U, 6U))) {
+      notValid &= ~(1U << Protocol::Msg::Errors::INVALID_CMD_TYPE);
+    }
+    if(notValid || not isKnownId || not Protocol::DeviceId::isCorrectId(deviceId)) {
+      onInvalid(timeNs);
+      return;
+    }
+    onErrors(deviceId, static_cast<char>(commonFields.m_errors), timeNs);
+    switch(canId) {
+      case Protocol::Can::Id::HEARTBEAT: {
+        auto approveState = Helpers::enum2type(msg.m_dataL, 2U, 1U, 1U,
+                                               Protocol::ApproveState::NOT_APPROVED,
+                                               Protocol::ApproveState::APPROVED);
+        auto cmdType = getCmdType(msg.m_dataL);
+        onHeartbeat(deviceId, timeNs);
+        if(Protocol::DeviceType::MASTER == deviceType) {
+          onCommanded(cmdType);
+        }
+        onCmdType(deviceId, cmdType, timeNs);
+        onApproveState(deviceId, deviceType, approveState, cmdType, timeNs);
+        break;
+      }
+      case Protocol::Can::Id::CMD: {
+        auto cmdType = getCmdType(msg.m_dataL);
+        if(Protocol::DeviceType::MASTER == deviceType) {
+          onCommanded(cmdType);
+        }
+        onCmdType(deviceId, cmdType, timeNs);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+
+  void AnomalyDetector::onFrame(const Protocol::Can::RawMsg &msg, uint64_t timeNs) {
+    // the same checks as Device::pushMsg() does, except the sender's ID
+    Protocol::Msg::CommonFields commonFields(msg.m_dataL);
+    uint16_t notValid = commonFields.isNotValid();
+    auto canId = Protocol::Can::Id::AGGREGATE;
+    char canIdDeviceId = Protocol::DeviceId::INVALID;
+    if(not Protocol::Can::fromCanId(msg.m_canId, canId, canIdDeviceId) ||
+       ((Protocol::DeviceId::INVALID != canIdDeviceId) &&
+        (canIdDeviceId != commonFields.m_deviceId))) {
+      notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_ID);
+    } else if(Protocol::Can::Id::HEARTBEAT == canId) {
+      Protocol::Msg::Heartbeat heartbeatMsg(
+        commonFields,
+        Helpers::enum2type(msg.m_dataL, 2U, 0U, 1U,
+                           Protocol::SlaveState::NOT_ACTIVE,
+                           Protocol::SlaveState::ACTIVE),
+        Helpers::enum2type(msg.m_dataL, 2U, 1U, 1U,
+                           Protocol::ApproveState::NOT_APPROVED,
+                           Protocol::ApproveState::APPROVED),
+        getCmdType(msg.m_dataL));
+      notValid |= heartbeatMsg.isNotValid();
+      notValid |= ((Protocol::Msg::Heartbeat::DLC != msg.m_dlc) <<
+                   Protocol::Msg::Errors::INVALID_CAN_DLC);
+    } else if(Protocol::Can::Id::CMD == canId) {
+      Protocol::Msg::Cmd cmdMsg(commonFields, getCmdType(msg.m_dataL));
+      notValid |= cmdMsg.isNotValid();
+      notValid |= ((Protocol::Msg::Cmd::DLC != msg.m_dlc) <<
+                   Protocol::Msg::Errors::INVALID_CAN_DLC);
+    } else if(Protocol::Can::Id::AGGREGATE == canId) {
+      notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_DLC); // not a classic frame
+    } else {
+      // ACTIVATE and DISCOVER have the same DLC
+      notValid |= ((Protocol::Msg::Activate::DLC != msg.m_dlc) <<
+                   Protocol::Msg::Errors::INVALID_CAN_DLC);
+    }
+    onMsg(msg, notValid, timeNs);
+  }
+
+
+  void AnomalyDetector::onInput(const Device &device, Input input,
+                                Protocol::CmdType cmdType) {
+    if((Input::SET_CMD_TYPE == input) &&
+       (Protocol::DeviceType::MASTER == device.getDeviceType())) {
+      onCommanded(cmdType);
+    }
+  }
+
+
+  void AnomalyDetector::onTransition(const Device &device, StateField field,
+                                     uint8_t from, uint8_t to) {
+    (void) from; // unused
+    auto deviceId = device.getDeviceId();
+    if(not Protocol::DeviceId::isCorrectId(deviceId)) {
+      return;
+    }
+    auto timeNs = m_clock.nowNs();
+    switch(field) {
+      case StateField::CMD_TYPE:
+        onCmdType(deviceId, static_cast<Protocol::CmdType>(to), timeNs);
+        break;
+      case StateField::APPROVE_STATE:
+        onApproveState(deviceId, device.getDeviceType(),
+                       static_cast<Protocol::ApproveState>(to),
+                       device.getCmdType(), timeNs);
+        break;
+      case StateField::ERRORS:
+        onErrors(deviceId, static_cast<char>(to), timeNs);
+        break;
+      default:
+        break;
+    }
+  }
+
+
+  uint64_t AnomalyDetector::getNumOfEvents(Type type) const {
+    return (type < NUM_OF_TYPES) ? ma_numOfEvents[type] : 0U;
+  }
+
+
+  uint64_t AnomalyDetector::getJitterNs(char deviceId) const {
+    if(not Protocol::DeviceId::isCorrectId(deviceId)) {
+      return 0U;
+    }
+    return static_cast<uint64_t>(ma_sketches[static_cast<uint32_t>(deviceId)].m_jitterNs);
+  }
+
+
+  void AnomalyDetector::reset() {
+    for(auto &sketch : ma_sketches) {
+      sketch = Sketch{};
+      sketch.m_cmdType = Protocol::CmdType::INVALID;
+      sketch.m_approveState = Protocol::ApproveState::INVALID;
+    }
+    m_commanded = 0U;
+    m_isMasterSeen = false;
+    m_numOfInvalid = 0U;
+    m_invalidWindowNs = 0U;
+    for(auto &numOfEvents : ma_numOfEvents) {
+      numOfEvents = 0U;
+    }
+  }
+
+
+  void AnomalyDetector::onHeartbeat(char deviceId, uint64_t timeNs) {
+    auto &sketch = ma_sketches[static_cast<uint32_t>(deviceId)];
+    auto lastNs = sketch.m_lastHeartbeatNs;
+    sketch.m_lastHeartbeatNs = timeNs;
+    if((0U == lastNs) || (timeNs <= lastNs)) {
+      return;
+    }
+    auto intervalNs = static_cast<int64_t>(timeNs - lastNs);
+    if(0U == sketch.m_numOfIntervals++) {
+      sketch.m_meanIntervalNs = intervalNs;
+      return;
+    }
+    auto deviationNs = intervalNs - sketch.m_meanIntervalNs;
+    deviationNs = (deviationNs < 0) ? -deviationNs : deviationNs;
+    // a lost heartbeat or a restart is not jitter, it is limited to one period
+    deviationNs = (deviationNs > sketch.m_meanIntervalNs) ?
+                  sketch.m_meanIntervalNs : deviationNs;
+    sketch.m_meanIntervalNs += (intervalNs - sketch.m_meanIntervalNs) / (1 << EWMA_SHIFT);
+    sketch.m_jitterNs += (deviationNs - sketch.m_jitterNs) / (1 << EWMA_SHIFT);
+    if(sketch.m_numOfIntervals < m_config.m_minIntervals) {
+      return;
+    }
+    auto jitter = sketch.m_jitterNs * 100;
+    auto limit = sketch.m_meanIntervalNs * static_cast<int64_t>(m_config.m_jitterPercent);
+    if((not sketch.m_isJittery) && (jitter > limit)) {
+      sketch.m_isJittery = true;
+      raise(HEARTBEAT_JITTER, deviceId, Protocol::CmdType::INVALID,
+            static_cast<uint64_t>(sketch.m_jitterNs), timeNs);
+    } else if(sketch.m_isJittery && (2 * jitter < limit)) {
+      sketch.m_isJittery = false;
+    }
+  }
+
+
+  void AnomalyDetector::onErrors(char deviceId, char errors, uint64_t timeNs) {
+    auto &sketch = ma_sketches[static_cast<uint32_t>(deviceId)];
+    bool isDuplicated = (errors >> Protocol::ErrorBit::DUPLICATED_DEVICE_ID) & 0x01;
+    if(isDuplicated == sketch.m_isDuplicated) {
+      return;
+    }
+    sketch.m_isDuplicated = isDuplicated;
+    if(countInWindow(sketch.m_numOfFlaps, sketch.m_flapWindowNs, timeNs,
+                     m_config.m_flapWindowNs, m_config.m_maxFlaps)) {
+      raise(DUPLICATED_ID_FLAP, deviceId, Protocol::CmdType::INVALID,
+            sketch.m_numOfFlaps, timeNs);
+    }
+  }
+
+
+  void AnomalyDetector::onCmdType(char deviceId, Protocol::CmdType cmdType,
+                                  uint64_t timeNs) {
+    auto &sketch = ma_sketches[static_cast<uint32_t>(deviceId)];
+    if(cmdType == sketch.m_cmdType) {
+      return;
+    }
+    bool isFirst = (Protocol::CmdType::INVALID == sketch.m_cmdType);
+    sketch.m_cmdType = cmdType;
+    bool isFast = (not isFirst) &&
+                  (timeNs - sketch.m_lastCmdChangeNs < m_config.m_minCmdIntervalNs);
+    sketch.m_lastCmdChangeNs = timeNs;
+    sketch.m_numOfFastChanges = isFast ? (sketch.m_numOfFastChanges + 1U) : 0U;
+    if(m_config.m_maxFastChanges == sketch.m_numOfFastChanges) {
+      raise(CMD_OSCILLATION, deviceId, cmdType, sketch.m_numOfFastChanges, timeNs);
+    }
+  }
+
+
+  void AnomalyDetector::onApproveState(char deviceId, Protocol::DeviceType deviceType,
+                                       Protocol::ApproveState approveState,
+                                       Protocol::CmdType cmdType, uint64_t timeNs) {
+    auto &sketch = ma_sketches[static_cast<uint32_t>(deviceId)];
+    if(approveState == sketch.m_approveState) {
+      return;
+    }
+    sketch.m_approveState = approveState;
+    auto cmd = static_cast<uint32_t>(cmdType);
+    bool isCommanded = (Protocol::CmdType::INVALID != cmdType) &&
+                       ((m_commanded >> cmd) & 0x01);
+    // before the first Master msg commands issued earlier are unknown
+    if(m_isMasterSeen && (Protocol::DeviceType::SLAVE == deviceType) &&
+       (Protocol::ApproveState::APPROVED == approveState) && (not isCommanded)) {
+      raise(UNCOMMANDED_APPROVE, deviceId, cmdType, 0U, timeNs);
+    }
+  }
+
+
+  void AnomalyDetector::onCommanded(Protocol::CmdType cmdType) {
+    m_isMasterSeen = true;
+    if(Protocol::CmdType::INVALID != cmdType) {
+      m_commanded |= static_cast<uint16_t>(1U << static_cast<uint32_t>(cmdType));
+    }
+  }
+
+
+  void AnomalyDetector::onInvalid(uint64_t timeNs) {
+    if(countInWindow(m_numOfInvalid, m_invalidWindowNs, timeNs,
+                     m_config.m_invalidWindowNs, m_config.m_maxInvalid)) {
+      raise(INVALID_FRAMES, Protocol::DeviceId::INVALID, Protocol::CmdType::INVALID,
+            m_numOfInvalid, timeNs);
+    }
+  }
+
+
+  void AnomalyDetector::raise(Type type, char deviceId, Protocol::CmdType cmdType,
+                              uint64_t value, uint64_t timeNs) {
+    ++ma_numOfEvents[type];
+    if(nullptr != m_listener) {
+      Event event{timeNs, type, deviceId, cmdType, value};
+      m_listener->onAnomaly(event);
+    }
+  }
+
+} // end namespace Eet
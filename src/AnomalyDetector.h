@@ -0,0 +1,134 @@
+#ifndef EET_ANOMALY_DETECTOR_H
+#define EET_ANOMALY_DETECTOR_H
+
+#include <cstdint>
+
+#include "Observer.h"
+#include "FrameSink.h"
+#include "Clock.h"
+
+namespace Eet {
+/**
+ * Online detector of suspicious behaviour which is still valid protocol.
+ * Sources (any combination, the same state change seen twice counts once):
+ *   onMsg()/onFrame() - frames of all devices on the bus, e.g. Simulator
+ *                       sink or frames received by Device::pushMsg()
+ *   IObserver         - transitions and operator inputs of local devices
+ * Anomalies:
+ *   HEARTBEAT_JITTER    - EWMA of heartbeat interval deviation of a sender
+ *                         exceeded m_jitterPercent of its mean interval
+ *   DUPLICATED_ID_FLAP  - DUPLICATED_DEVICE_ID error bit of a device toggled
+ *                         m_maxFlaps times within m_flapWindowNs
+ *   CMD_OSCILLATION     - cmd type of a device changed m_maxFastChanges
+ *                         times in a row faster than m_minCmdIntervalNs
+ *                         (faster than an operator moves the lever)
+ *   UNCOMMANDED_APPROVE - Slave approved cmd type no Master has commanded
+ *                         (checked once any Master msg or input is seen)
+ *   INVALID_FRAMES      - m_maxInvalid frames within m_invalidWindowNs
+ *                         were rejected (pushMsg() result is not 0),
+ *                         heartbeats without cmd type yet are not counted
+ * Each anomaly is raised once when it starts, jitter is raised again after
+ * it has dropped below half of the limit. Memory is fixed: a few counters
+ * and integer EWMAs per Device ID, cost is O(1) per frame.
+ * Heartbeats of a sender with adaptive HeartbeatPolicy change period on
+ * purpose, raise m_jitterPercent for such networks.
+ */
+  class AnomalyDetector final : public IObserver, public IFrameSink {
+    public:
+      enum Type {
+          HEARTBEAT_JITTER = 0,
+          DUPLICATED_ID_FLAP,
+          CMD_OSCILLATION,
+          UNCOMMANDED_APPROVE,
+          INVALID_FRAMES,
+          NUM_OF_TYPES
+      };
+
+      struct Event {
+        uint64_t m_timeNs;
+        Type m_type;
+        char m_deviceId; // INVALID for INVALID_FRAMES
+        Protocol::CmdType m_cmdType; // CMD_OSCILLATION, UNCOMMANDED_APPROVE
+        uint64_t m_value; // jitter ns, number of flaps/changes/invalid frames
+      };
+
+      class IListener {
+        public:
+          virtual ~IListener() = default;
+          // called synchronously, should be cheap
+          virtual void onAnomaly(const Event &event) = 0;
+      };
+
+      struct Config {
+        uint32_t m_jitterPercent;
+        uint32_t m_minIntervals; // heartbeat intervals before jitter is checked
+        uint32_t m_maxFlaps;
+        uint64_t m_flapWindowNs;
+        uint32_t m_maxFastChanges;
+        uint64_t m_minCmdIntervalNs;
+        uint32_t m_maxInvalid;
+        uint64_t m_invalidWindowNs;
+      };
+
+      explicit AnomalyDetector(const IClock &clock = Clock::monotonic());
+      explicit AnomalyDetector(const Config &config,
+                               const IClock &clock = Clock::monotonic());
+
+      void setListener(IListener *listener); // nullptr to detach
+      // frame seen on the bus, notValid is result of Device::pushMsg() for it
+      void onMsg(const Protocol::Can::RawMsg &msg, uint16_t notValid, uint64_t timeNs);
+      // checks fields of the frame itself
+      void onFrame(const Protocol::Can::RawMsg &msg, uint64_t timeNs) override;
+      void onInput(const Device &device, Input input,
+                   Protocol::CmdType cmdType) override;
+      void onTransition(const Device &device, StateField field,
+                        uint8_t from, uint8_t to) override;
+
+      uint64_t getNumOfEvents(Type type) const;
+      uint64_t getJitterNs(char deviceId) const; // current EWMA, 0 if unknown
+      void reset();
+
+    private:
+      static constexpr uint32_t NUM_OF_IDS =
+        static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID) + 1U;
+
+      // fixed-size sketch of one Device ID
+      struct Sketch {
+        uint64_t m_lastHeartbeatNs;
+        int64_t m_meanIntervalNs; // EWMA, 1/16
+        int64_t m_jitterNs;       // EWMA of |interval - mean|, 1/16
+        uint32_t m_numOfIntervals;
+        bool m_isJittery;
+        bool m_isDuplicated;
+        uint32_t m_numOfFlaps;
+        uint64_t m_flapWindowNs; // start of window
+        Protocol::CmdType m_cmdType;
+        uint64_t m_lastCmdChangeNs;
+        uint32_t m_numOfFastChanges;
+        Protocol::ApproveState m_approveState;
+      };
+
+      void onHeartbeat(char deviceId, uint64_t timeNs);
+      void onErrors(char deviceId, char errors, uint64_t timeNs);
+      void onCmdType(char deviceId, Protocol::CmdType cmdType, uint64_t timeNs);
+      void onApproveState(char deviceId, Protocol::DeviceType deviceType,
+                          Protocol::ApproveState approveState,
+                          Protocol::CmdType cmdType, uint64_t timeNs);
+      void onCommanded(Protocol::CmdType cmdType); // any Master msg or input
+      void onInvalid(uint64_t timeNs);
+      void raise(Type type, char deviceId, Protocol::CmdType cmdType,
+                 uint64_t value, uint64_t timeNs);
+
+      const Config m_config;
+      const IClock &m_clock;
+      IListener *m_listener;
+      Sketch ma_sketches[NUM_OF_IDS];
+      uint16_t m_commanded; // bit per cmd type commanded by any Master
+      bool m_isMasterSeen;
+      uint32_t m_numOfInvalid;
+      uint64_t m_invalidWindowNs; // start of window
+      uint64_t ma_numOfEvents[NUM_OF_TYPES];
+  };
+} // end namespace Eet
+
+#endif // EET_ANOMALY_DETECTOR_H
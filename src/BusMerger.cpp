@@ -0,0 +1,119 @@
+#include <cstring>
+
+#include "BusMerger.h"
+#include "Helpers.h"
+
+namespace Eet {
+
+  BusMerger::BusMerger(uint32_t numOfBuses, uint64_t windowNs) :
+    m_numOfBuses((numOfBuses > MAX_BUSES) ? MAX_BUSES : numOfBuses),
+    m_windowNs(windowNs) {
+    reset();
+  }
+
+
+  void BusMerger::reset() {
+    std::memset(ma_buses, 0, sizeof(ma_buses));
+    std::memset(ma_entries, 0, sizeof(ma_entries));
+  }
+
+
+  uint32_t BusMerger::fingerprint(const Protocol::Can::RawMsg &msg) {
+    // FNV-1a over the words of the frame
+    uint32_t hash = 2166136261UL;
+    const uint32_t words[] = {msg.m_canId, msg.m_dlc, msg.m_dataL, msg.m_dataH};
+    for(auto word : words) {
+      hash = (hash ^ word) * 16777619UL;
+      hash ^= hash >> 15;
+    }
+    return hash;
+  }
+
+
+  bool BusMerger::isSameFrame(const Entry &entry, const Protocol::Can::RawMsg &msg,
+                              uint32_t fingerprint) {
+    return (entry.m_fingerprint == fingerprint) && (entry.m_msg.m_canId == msg.m_canId) &&
+           (entry.m_msg.m_dlc == msg.m_dlc) && (entry.m_msg.m_dataL == msg.m_dataL) &&
+           (entry.m_msg.m_dataH == msg.m_dataH);
+  }
+
+
+  void BusMerger::release(Entry &entry) {
+    for(uint32_t bus = 0U; bus < m_numOfBuses; ++bus) {
+      ma_buses[bus].m_numOfLost += not ((entry.m_busMask >> bus) & 0x01);
+    }
+    entry.m_busMask = 0U;
+  }
+
+
+  bool BusMerger::accept(uint32_t bus, const Protocol::Can::RawMsg &msg, uint64_t timeNs) {
+    if(bus >= m_numOfBuses) {
+      return false;
+    }
+    auto &stats = ma_buses[bus];
+    ++stats.m_numOfFrames;
+    stats.m_lastFrameNs = timeNs;
+
+    auto deviceId = Helpers::bits2type<char>(msg.m_dataL, 0U, 0U, 6U);
+    auto sender = Protocol::DeviceId::isCorrectId(deviceId) ? static_cast<uint32_t>(deviceId) : 0U;
+    auto &entries = ma_entries[sender];
+    auto hash = fingerprint(msg);
+    const uint32_t busBit = 1U << bus;
+
+    Entry *oldest = &entries[0];
+    for(auto &entry : entries) {
+      if(entry.m_busMask && (timeNs - entry.m_firstNs >= m_windowNs)) {
+        release(entry);
+      }
+      if(entry.m_busMask && isSameFrame(entry, msg, hash)) {
+        if(not (entry.m_busMask & busBit)) {
+          entry.m_busMask |= busBit;
+          ++stats.m_numOfDuplicates;
+          return false;
+        }
+        // the same bus repeats the frame - it is a new frame
+        release(entry);
+        oldest = &entry;
+        break;
+      }
+      if((0U == entry.m_busMask) ||
+         ((0U != oldest->m_busMask) && (entry.m_firstNs < oldest->m_firstNs))) {
+        oldest = &entry;
+      }
+    }
+    if(oldest->m_busMask) {
+      release(*oldest);
+    }
+    *oldest = {msg, hash, busBit, timeNs};
+    ++stats.m_numOfFirst;
+    return true;
+  }
+
+
+  void BusMerger::expire(uint64_t nowNs) {
+    for(auto &entries : ma_entries) {
+      for(auto &entry : entries) {
+        if(entry.m_busMask && (nowNs - entry.m_firstNs >= m_windowNs)) {
+          release(entry);
+        }
+      }
+    }
+  }
+
+
+  uint32_t BusMerger::getNumOfBuses() const {
+    return m_numOfBuses;
+  }
+
+
+  const BusMerger::BusStats &BusMerger::getBusStats(uint32_t bus) const {
+    return ma_buses[(bus < m_numOfBuses) ? bus : 0U];
+  }
+
+
+  bool BusMerger::isBusAlive(uint32_t bus, uint64_t nowNs, uint64_t timeoutNs) const {
+    const auto &stats = getBusStats(bus);
+    return (0U != stats.m_numOfFrames) && (nowNs - stats.m_lastFrameNs < timeoutNs);
+  }
+
+} // end namespace Eet
@@ -0,0 +1,66 @@
+#ifndef EET_BUS_MERGER_H
+#define EET_BUS_MERGER_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Merges frames of redundant buses into one stream.
+ * Call accept() for every frame received on any bus and pass the frame to
+ * Device::pushMsg() only if accept() returned true (first copy).
+ *
+ * Copy of a frame is a frame with the same CAN ID, DLC and data from the
+ * same sender seen on another bus within the window. Fingerprint of them
+ * only filters out most entries before the exact comparison. Window must be shorter than the
+ * heartbeat period, because heartbeats of a device usually repeat.
+ * When an entry leaves the window, every bus which has not delivered
+ * the frame gets a loss.
+ */
+  class BusMerger {
+    public:
+      struct BusStats {
+        uint64_t m_numOfFrames;
+        uint64_t m_numOfFirst;      // frames forwarded from this bus
+        uint64_t m_numOfDuplicates; // suppressed copies
+        uint64_t m_numOfLost;       // frames seen on other buses only
+        uint64_t m_lastFrameNs;
+      };
+
+      static constexpr uint32_t MAX_BUSES = 4U;
+      static constexpr uint32_t SLOTS_PER_SENDER = 4U;
+      static constexpr uint32_t MAX_SENDERS = Protocol::DeviceId::MAX_DEVICE_ID + 1U; // 0 - invalid
+
+      BusMerger(uint32_t numOfBuses, uint64_t windowNs);
+
+      bool accept(uint32_t bus, const Protocol::Can::RawMsg &msg, uint64_t timeNs);
+      void expire(uint64_t nowNs); // account losses of old entries
+      void reset();
+
+      uint32_t getNumOfBuses() const;
+      const BusStats &getBusStats(uint32_t bus) const;
+      // bus has delivered any frame during timeout
+      bool isBusAlive(uint32_t bus, uint64_t nowNs, uint64_t timeoutNs) const;
+
+    private:
+      struct Entry {
+        Protocol::Can::RawMsg m_msg;
+        uint32_t m_fingerprint;
+        uint32_t m_busMask; // 0 - free entry
+        uint64_t m_firstNs;
+      };
+
+      static uint32_t fingerprint(const Protocol::Can::RawMsg &msg);
+      static bool isSameFrame(const Entry &entry, const Protocol::Can::RawMsg &msg,
+                              uint32_t fingerprint);
+      void release(Entry &entry);
+
+      uint32_t m_numOfBuses;
+      uint64_t m_windowNs;
+      BusStats ma_buses[MAX_BUSES];
+      Entry ma_entries[MAX_SENDERS][SLOTS_PER_SENDER];
+  };
+} // end namespace Eet
+
+#endif // EET_BUS_MERGER_H
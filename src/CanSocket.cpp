@@ -0,0 +1,193 @@
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "CanSocket.h"
+#include "Tracer.h"
+
+namespace Eet {
+
+  namespace {
+    static_assert(sizeof(CanSocket::Frame) == sizeof(can_frame) &&
+                  offsetof(CanSocket::Frame, m_dlc) == offsetof(can_frame, can_dlc) &&
+                  offsetof(CanSocket::Frame, ma_data) == offsetof(can_frame, data),
+                  "CanSocket::Frame is not struct can_frame");
+
+    // iovecs point to frames, no copies
+    uint32_t prepare(CanSocket::Frame *frames, uint32_t numOfFrames,
+                     mmsghdr *msgs, iovec *iovs) {
+      numOfFrames = (numOfFrames > CanSocket::MAX_BATCH) ? CanSocket::MAX_BATCH : numOfFrames;
+      for(uint32_t i = 0U; i < numOfFrames; ++i) {
+        iovs[i].iov_base = &frames[i];
+        iovs[i].iov_len = sizeof(CanSocket::Frame);
+        msgs[i] = mmsghdr{};
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1U;
+      }
+      return numOfFrames;
+    }
+  }
+
+  CanSocket::CanSocket() :
+    m_fd(-1),
+    m_isFd(false) {}
+
+
+  CanSocket::~CanSocket() {
+    close();
+  }
+
+
+  bool CanSocket::open(const char *ifName, bool isFd, bool isNonBlocking) {
+    close();
+    int type = SOCK_RAW | SOCK_CLOEXEC | (isNonBlocking ? SOCK_NONBLOCK : 0);
+    m_fd = ::socket(PF_CAN, type, CAN_RAW);
+    if(m_fd < 0) {
+      return false;
+    }
+    ifreq ifr{};
+    std::strncpy(ifr.ifr_name, ifName, IFNAMSIZ - 1);
+    if(0 != ::ioctl(m_fd, SIOCGIFINDEX, &ifr)) {
+      close();
+      return false;
+    }
+    int enable = 1;
+    if(isFd && (0 != ::setsockopt(m_fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES,
+                                  &enable, sizeof(enable)))) {
+      close();
+      return false;
+    }
+    sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if(0 != ::bind(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))) {
+      close();
+      return false;
+    }
+    m_isFd = isFd;
+    return true;
+  }
+
+
+  void CanSocket::close() {
+    if(m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+
+  bool CanSocket::isOpen() const {
+    return m_fd >= 0;
+  }
+
+
+  int CanSocket::getFd() const {
+    return m_fd;
+  }
+
+
+  bool CanSocket::send(const Protocol::Can::RawMsg &msg) {
+    EET_TRACE_SPAN(span, "TX", Protocol::DeviceId::INVALID);
+    auto fdMsg = Protocol::Can::toFdRawMsg(msg);
+    can_frame frame{};
+    frame.can_id = fdMsg.m_canId & CAN_SFF_MASK;
+    frame.can_dlc = static_cast<uint8_t>(fdMsg.m_len);
+    std::memcpy(frame.data, fdMsg.ma_data, CAN_MAX_DLEN);
+    return sizeof(frame) == ::write(m_fd, &frame, sizeof(frame));
+  }
+
+
+  bool CanSocket::send(const Protocol::Can::FdRawMsg &msg) {
+    EET_TRACE_SPAN(span, "TX FD", Protocol::DeviceId::INVALID);
+    if((not m_isFd) || (msg.m_len > CANFD_MAX_DLEN)) {
+      return false;
+    }
+    canfd_frame frame{};
+    frame.can_id = msg.m_canId & CAN_SFF_MASK;
+    frame.len = static_cast<uint8_t>(Protocol::Can::getFdLen(msg.m_len));
+    frame.flags = CANFD_BRS;
+    std::memcpy(frame.data, msg.ma_data, msg.m_len);
+    return sizeof(frame) == ::write(m_fd, &frame, sizeof(frame));
+  }
+
+
+  bool CanSocket::recv(Protocol::Can::FdRawMsg &msg) {
+    canfd_frame frame{};
+    auto size = ::read(m_fd, &frame, sizeof(frame));
+    if((CAN_MTU != size) && (CANFD_MTU != size)) {
+      return false;
+    }
+    if(frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) {
+      return false; // not EET frame
+    }
+    msg.m_canId = frame.can_id & CAN_SFF_MASK;
+    msg.m_len = frame.len;
+    std::memset(msg.ma_data, 0, sizeof(msg.ma_data));
+    std::memcpy(msg.ma_data, frame.data, frame.len);
+    return true;
+  }
+
+
+  uint32_t CanSocket::recv(Frame *frames, uint32_t numOfFrames) {
+    mmsghdr msgs[MAX_BATCH];
+    iovec iovs[MAX_BATCH];
+    numOfFrames = prepare(frames, numOfFrames, msgs, iovs);
+    int ret = ::recvmmsg(m_fd, msgs, numOfFrames, MSG_DONTWAIT, nullptr);
+    if(ret <= 0) {
+      return 0U;
+    }
+    // keep EET frames only, in place
+    uint32_t numOfKept = 0U;
+    for(uint32_t i = 0U; i < static_cast<uint32_t>(ret); ++i) {
+      if((CAN_MTU != msgs[i].msg_len) ||
+         (frames[i].m_canId & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG))) {
+        continue;
+      }
+      frames[numOfKept++] = frames[i];
+    }
+    return numOfKept;
+  }
+
+
+  uint32_t CanSocket::send(const Frame *frames, uint32_t numOfFrames) {
+    EET_TRACE_SPAN(span, "TX batch", Protocol::DeviceId::INVALID);
+    mmsghdr msgs[MAX_BATCH];
+    iovec iovs[MAX_BATCH];
+    // sendmmsg() does not change frames
+    numOfFrames = prepare(const_cast<Frame *>(frames), numOfFrames, msgs, iovs);
+    int ret = ::sendmmsg(m_fd, msgs, numOfFrames, MSG_DONTWAIT);
+    return (ret > 0) ? static_cast<uint32_t>(ret) : 0U;
+  }
+
+
+  Protocol::Can::RawMsg CanSocket::toRawMsg(const Frame &frame) {
+    Protocol::Can::RawMsg msg{};
+    msg.m_canId = frame.m_canId & CAN_SFF_MASK;
+    msg.m_dlc = (frame.m_dlc > CAN_MAX_DLEN) ? CAN_MAX_DLEN : frame.m_dlc;
+    for(uint32_t byte = 0U; byte < 4U; ++byte) {
+      msg.m_dataL |= static_cast<uint32_t>(frame.ma_data[byte]) << (8U * byte);
+      msg.m_dataH |= static_cast<uint32_t>(frame.ma_data[byte + 4U]) << (8U * byte);
+    }
+    return msg;
+  }
+
+
+  CanSocket::Frame CanSocket::toFrame(const Protocol::Can::RawMsg &msg) {
+    Frame frame{};
+    frame.m_canId = msg.m_canId & CAN_SFF_MASK;
+    frame.m_dlc = static_cast<uint8_t>((msg.m_dlc > CAN_MAX_DLEN) ? CAN_MAX_DLEN : msg.m_dlc);
+    for(uint32_t byte = 0U; byte < 4U; ++byte) {
+      frame.ma_data[byte] = static_cast<uint8_t>(msg.m_dataL >> (8U * byte));
+      frame.ma_data[byte + 4U] = static_cast<uint8_t>(msg.m_dataH >> (8U * byte));
+    }
+    return frame;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,57 @@
+#ifndef EET_CAN_SOCKET_H
+#define EET_CAN_SOCKET_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Linux SocketCAN raw socket (can0, vcan0, ...).
+ * With CAN FD enabled both classic and FD frames are received, pass them
+ * to Device::pushFdMsg(). Classic frames are sent as classic frames.
+ * Batched I/O (recvmmsg()/sendmmsg()) moves up to MAX_BATCH classic
+ * frames per syscall directly from/to caller's Frame array, FD frames are
+ * skipped by it.
+ */
+  class CanSocket {
+    public:
+      // layout of struct can_frame
+      struct Frame {
+        uint32_t m_canId;
+        uint8_t m_dlc;
+        uint8_t ma_reserve[3];
+        uint8_t ma_data[8];
+      };
+
+      static constexpr uint32_t MAX_BATCH = 64U;
+
+      CanSocket();
+      ~CanSocket();
+      CanSocket(const CanSocket &) = delete;
+      CanSocket &operator=(const CanSocket &) = delete;
+
+      bool open(const char *ifName, bool isFd, bool isNonBlocking = false);
+      void close();
+      bool isOpen() const;
+      int getFd() const; // for poll()/epoll
+
+      bool send(const Protocol::Can::RawMsg &msg);
+      bool send(const Protocol::Can::FdRawMsg &msg); // needs isFd
+      // false if nothing has been received (non-blocking) or on error
+      bool recv(Protocol::Can::FdRawMsg &msg);
+      // number of frames received/sent, 0 if nothing to receive
+      // (non-blocking), TX buffer is full or on error
+      uint32_t recv(Frame *frames, uint32_t numOfFrames);
+      uint32_t send(const Frame *frames, uint32_t numOfFrames);
+
+      static Protocol::Can::RawMsg toRawMsg(const Frame &frame);
+      static Frame toFrame(const Protocol::Can::RawMsg &msg);
+
+    private:
+      int m_fd;
+      bool m_isFd;
+  };
+} // end namespace Eet
+
+#endif // EET_CAN_SOCKET_H
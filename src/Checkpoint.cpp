@@ -0,0 +1,99 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Checkpoint.h"
+
+namespace Eet {
+
+  Checkpoint::Checkpoint() :
+    m_fd(-1),
+    m_data(nullptr),
+    m_sequence(0U) {}
+
+
+  Checkpoint::~Checkpoint() {
+    close();
+  }
+
+
+  bool Checkpoint::open(const char *path) {
+    close();
+    m_fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(m_fd < 0) {
+      return false;
+    }
+    if(0 != ::ftruncate(m_fd, FILE_SIZE)) {
+      close();
+      return false;
+    }
+    void *data = ::mmap(nullptr, FILE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, m_fd, 0);
+    if(MAP_FAILED == data) {
+      close();
+      return false;
+    }
+    m_data = static_cast<uint8_t *>(data);
+
+    // continue numbering after the latest saved snapshot
+    Snapshot snapshot{};
+    if(load(snapshot)) {
+      m_sequence = snapshot.m_sequence;
+    }
+    return true;
+  }
+
+
+  void Checkpoint::close() {
+    if(nullptr != m_data) {
+      ::munmap(m_data, FILE_SIZE);
+      m_data = nullptr;
+    }
+    if(m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+    m_sequence = 0U;
+  }
+
+
+  bool Checkpoint::isOpen() const {
+    return nullptr != m_data;
+  }
+
+
+  bool Checkpoint::save(Snapshot snapshot) {
+    if(not isOpen()) {
+      return false;
+    }
+    snapshot.m_sequence = ++m_sequence;
+    uint8_t *slot = m_data + (m_sequence % SLOTS) * Snapshot::SIZE;
+    return Snapshot::SIZE == snapshot.encode(slot, Snapshot::SIZE);
+  }
+
+
+  bool Checkpoint::load(Snapshot &snapshot) {
+    bool ret = false;
+    if(not isOpen()) {
+      return ret;
+    }
+    for(uint32_t i = 0U; i < SLOTS; ++i) {
+      Snapshot candidate{};
+      if(0U != candidate.decode(m_data + i * Snapshot::SIZE, Snapshot::SIZE)) {
+        continue;
+      }
+      // serial number arithmetic, sequence wraps around
+      if((not ret) || (static_cast<int32_t>(candidate.m_sequence - snapshot.m_sequence) > 0)) {
+        snapshot = candidate;
+        ret = true;
+      }
+    }
+    return ret;
+  }
+
+
+  bool Checkpoint::sync() {
+    return isOpen() && (0 == ::msync(m_data, FILE_SIZE, MS_SYNC));
+  }
+
+} // end namespace Eet
@@ -0,0 +1,43 @@
+#ifndef EET_CHECKPOINT_H
+#define EET_CHECKPOINT_H
+
+#include <cstdint>
+
+#include "Snapshot.h"
+
+namespace Eet {
+/**
+ * Memory-mapped checkpoint file for Snapshot.
+ * 1. Call open() once at startup
+ * 2. Call load() to get last saved snapshot (if any)
+ * 3. Call save() after every update()
+ *
+ * File holds two slots which are written in turn, so a crash in the middle
+ * of save() leaves the previous snapshot intact. load() picks valid slot
+ * with the latest sequence number (serial number arithmetic, wraps around).
+ */
+  class Checkpoint {
+    public:
+      Checkpoint();
+      ~Checkpoint();
+      Checkpoint(const Checkpoint &) = delete;
+      Checkpoint &operator=(const Checkpoint &) = delete;
+
+      bool open(const char *path);
+      void close();
+      bool isOpen() const;
+      bool save(Snapshot snapshot);
+      bool load(Snapshot &snapshot);
+      bool sync(); // flush to storage, not needed to survive process crash
+
+      static constexpr uint32_t SLOTS = 2U;
+      static constexpr uint32_t FILE_SIZE = SLOTS * Snapshot::SIZE;
+
+    private:
+      int m_fd;
+      uint8_t *m_data;
+      uint32_t m_sequence;
+  };
+} // end namespace Eet
+
+#endif // EET_CHECKPOINT_H
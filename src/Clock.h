@@ -0,0 +1,35 @@
+#ifndef EET_CLOCK_H
+#define EET_CLOCK_H
+
+#include <cstdint>
+#include <chrono>
+
+namespace Eet {
+  class IClock {
+    public:
+      virtual ~IClock() = default;
+      virtual uint64_t nowNs() const = 0;
+  };
+
+
+  class Clock final : public IClock {
+    public:
+      uint64_t nowNs() const override {
+        return monotonicNs();
+      }
+
+      // monotonic time, not related to wall time
+      static uint64_t monotonicNs() {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+      }
+
+      static const IClock &monotonic() {
+        static const Clock clock;
+        return clock;
+      }
+  };
+} // end namespace Eet
+
+#endif // EET_CLOCK_H
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "CmdTrace.h"
+#include "Device.h"
+
+namespace Eet {
+
+  CmdTrace::CmdTrace(const IClock &clock) :
+    m_clock(clock),
+    ma_pointNs{},
+    ma_events{},
+    m_numOfEvents(0U),
+    m_numOfSaved(0U) {}
+
+
+  void CmdTrace::onInput(const Device &device, Input input,
+                         Protocol::CmdType cmdType) {
+    auto deviceType = device.getDeviceType();
+    if((Input::SET_CMD_TYPE == input) && (Protocol::DeviceType::MASTER == deviceType)) {
+      record(ISSUED, cmdType, device.getDeviceId(), m_clock.nowNs());
+    } else if((Input::CMD_RECEIVED == input) && (Protocol::DeviceType::SLAVE == deviceType)) {
+      // not a transition if Master re-sends the cmd Slave holds
+      record(RECEIVED, cmdType, device.getDeviceId(), m_clock.nowNs());
+    }
+  }
+
+
+  void CmdTrace::onTransition(const Device &device, StateField field,
+                              uint8_t from, uint8_t to) {
+    (void) from; // unused
+    if((StateField::APPROVE_STATE == field) &&
+       (static_cast<uint8_t>(Protocol::ApproveState::APPROVED) == to)) {
+      auto point = (Protocol::DeviceType::SLAVE == device.getDeviceType()) ? APPROVED : CONFIRMED;
+      record(point, device.getCmdType(), device.getDeviceId(), m_clock.nowNs());
+    }
+  }
+
+
+  void CmdTrace::record(Point point, Protocol::CmdType cmdType, char deviceId,
+                        uint64_t timeNs) {
+    auto cmd = static_cast<uint32_t>(cmdType);
+    if(cmd >= NUM_OF_CMD_TYPES) {
+      return;
+    }
+    auto &event = ma_events[m_numOfEvents % MAX_EVENTS];
+    event.m_timeNs = timeNs;
+    event.m_point = static_cast<uint8_t>(point);
+    event.m_cmdType = static_cast<uint8_t>(cmd);
+    event.m_deviceId = deviceId;
+    event.m_reserve = 0U;
+    ++m_numOfEvents;
+    correlate(point, cmd, timeNs);
+  }
+
+
+  void CmdTrace::correlate(Point point, uint32_t cmd, uint64_t timeNs) {
+    auto &pointNs = ma_pointNs[cmd];
+    if(ISSUED == point) {
+      std::memset(pointNs, 0, sizeof(pointNs));
+      pointNs[ISSUED] = timeNs;
+      return;
+    }
+    // only the first occurrence after previous point counts
+    auto prev = static_cast<Point>(point - 1);
+    if((0U == pointNs[prev]) || (0U != pointNs[point]) || (timeNs < pointNs[prev])) {
+      return;
+    }
+    pointNs[point] = timeNs;
+    ma_histograms[prev].record(timeNs - pointNs[prev]);
+    if(CONFIRMED == point) {
+      ma_histograms[TOTAL].record(timeNs - pointNs[ISSUED]);
+    }
+  }
+
+
+  const Histogram &CmdTrace::getHistogram(Stage stage) const {
+    return ma_histograms[stage];
+  }
+
+
+  void CmdTrace::reset() {
+    std::memset(ma_pointNs, 0, sizeof(ma_pointNs));
+    for(auto &histogram : ma_histograms) {
+      histogram.reset();
+    }
+    m_numOfEvents = 0U;
+    m_numOfSaved = 0U;
+  }
+
+
+  bool CmdTrace::saveEvents(const char *path) {
+    auto file = std::fopen(path, "ab");
+    if(nullptr == file) {
+      return false;
+    }
+    // older events have been overwritten in the ring
+    if(m_numOfEvents - m_numOfSaved > MAX_EVENTS) {
+      m_numOfSaved = m_numOfEvents - MAX_EVENTS;
+    }
+    bool ret = true;
+    for(; m_numOfSaved < m_numOfEvents; ++m_numOfSaved) {
+      if(1U != std::fwrite(&ma_events[m_numOfSaved % MAX_EVENTS], sizeof(Event), 1U, file)) {
+        ret = false;
+        break;
+      }
+    }
+    return (0 == std::fclose(file)) && ret;
+  }
+
+
+  bool CmdTrace::loadEvents(const char *const *paths, uint32_t numOfPaths) {
+    std::vector<Event> events;
+    for(uint32_t i = 0U; i < numOfPaths; ++i) {
+      auto file = std::fopen(paths[i], "rb");
+      if(nullptr == file) {
+        return false;
+      }
+      Event event{};
+      while(1U == std::fread(&event, sizeof(Event), 1U, file)) {
+        events.push_back(event);
+      }
+      std::fclose(file);
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event &a, const Event &b) { return a.m_timeNs < b.m_timeNs; });
+    for(const auto &event : events) {
+      if(event.m_point < NUM_OF_POINTS) {
+        record(static_cast<Point>(event.m_point),
+               static_cast<Protocol::CmdType>(event.m_cmdType),
+               event.m_deviceId, event.m_timeNs);
+      }
+    }
+    return true;
+  }
+
+} // end namespace Eet
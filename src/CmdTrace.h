@@ -0,0 +1,87 @@
+#ifndef EET_CMD_TRACE_H
+#define EET_CMD_TRACE_H
+
+#include <cstdint>
+
+#include "Observer.h"
+#include "Histogram.h"
+#include "Clock.h"
+
+namespace Eet {
+/**
+ * Command latency tracing.
+ * Trace points:
+ *   ISSUED    - Master::setCmdType() (bridge lever moved)
+ *   RECEIVED  - Slave got cmd of a Master (engine room sees command),
+ *               also a re-sent one which does not change its cmd type
+ *   APPROVED  - Slave approve state became APPROVED (operator acknowledged)
+ *   CONFIRMED - Master approve state became APPROVED (bridge sees approve)
+ * Points are correlated by cmd type and feed one histogram per stage.
+ *
+ * In-process (simulator): set the same CmdTrace as observer of all devices.
+ * Separate processes (vcan): each process saves its events with
+ * saveEvents(), then loadEvents() correlates all files offline.
+ * CLOCK_MONOTONIC is shared by processes of one host, so timestamps of
+ * different processes are comparable.
+ */
+  class CmdTrace final : public IObserver {
+    public:
+      enum Point {
+          ISSUED = 0,
+          RECEIVED,
+          APPROVED,
+          CONFIRMED,
+          NUM_OF_POINTS
+      };
+
+      enum Stage {
+          TO_SLAVE = 0, // ISSUED -> RECEIVED
+          TO_APPROVE,   // RECEIVED -> APPROVED
+          TO_MASTER,    // APPROVED -> CONFIRMED
+          TOTAL,        // ISSUED -> CONFIRMED
+          NUM_OF_STAGES
+      };
+
+      struct Event {
+        uint64_t m_timeNs;
+        uint8_t m_point;
+        uint8_t m_cmdType;
+        char m_deviceId;
+        uint8_t m_reserve;
+      };
+
+      static constexpr uint32_t MAX_EVENTS = 4096U;
+
+      explicit CmdTrace(const IClock &clock = Clock::monotonic());
+
+      void onInput(const Device &device, Input input,
+                   Protocol::CmdType cmdType) override;
+      void onTransition(const Device &device, StateField field,
+                        uint8_t from, uint8_t to) override;
+
+      void record(Point point, Protocol::CmdType cmdType, char deviceId,
+                  uint64_t timeNs);
+      const Histogram &getHistogram(Stage stage) const;
+      void reset();
+
+      // appends events recorded since previous call, false on I/O error
+      bool saveEvents(const char *path);
+      // merges events of all files in time order and records them
+      bool loadEvents(const char *const *paths, uint32_t numOfPaths);
+
+    private:
+      static constexpr uint32_t NUM_OF_CMD_TYPES =
+        static_cast<uint32_t>(Protocol::CmdType::FULL_ASTERN) + 1U;
+
+      void correlate(Point point, uint32_t cmd, uint64_t timeNs);
+
+      const IClock &m_clock;
+      uint64_t ma_pointNs[NUM_OF_CMD_TYPES][NUM_OF_POINTS];
+      Histogram ma_histograms[NUM_OF_STAGES];
+      Event ma_events[MAX_EVENTS];
+      uint64_t m_numOfEvents;
+      uint64_t m_numOfSaved;
+  };
+} // end namespace Eet
+
+#endif // EET_CMD_TRACE_H
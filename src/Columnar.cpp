@@ -0,0 +1,422 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Columnar.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr char MAGIC_0 = 'E';
+    constexpr char MAGIC_1 = 'C';
+
+    static_assert(sizeof(Columnar::FileHeader) == 8U, "FileHeader must not have padding");
+    static_assert(sizeof(Columnar::ChunkHeader) == 48U, "ChunkHeader must not have padding");
+
+    bool writeAll(int fd, const void *buf, size_t size) {
+      auto *p = static_cast<const uint8_t *>(buf);
+      while(size > 0U) {
+        ssize_t ret = ::write(fd, p, size);
+        if(ret <= 0) {
+          return false;
+        }
+        p += ret;
+        size -= static_cast<size_t>(ret);
+      }
+      return true;
+    }
+
+    uint32_t putVarint(uint8_t *buf, uint64_t value) {
+      uint32_t size = 0U;
+      while(value >= 0x80U) {
+        buf[size++] = static_cast<uint8_t>(value | 0x80U);
+        value >>= 7;
+      }
+      buf[size++] = static_cast<uint8_t>(value);
+      return size;
+    }
+
+    // false if header or chunk data does not fit the file
+    bool getChunkHeader(const uint8_t *data, uint64_t size, uint64_t offset,
+                        Columnar::ChunkHeader &header) {
+      if(offset + sizeof(header) > size) {
+        return false;
+      }
+      std::memcpy(&header, data + offset, sizeof(header)); // chunks are not aligned
+      return (0U != header.m_numOfRows) && (header.m_numOfRows <= Columnar::MAX_ROWS) &&
+             (offset + sizeof(header) + header.m_size <= size);
+    }
+
+    uint8_t getColumn(const LogRecord &record, Columnar::Column column) {
+      switch(column) {
+        case Columnar::TYPE:
+          return ('O' == record.m_type) ? 1U : 0U;
+        case Columnar::DEVICE_ID:
+          return static_cast<uint8_t>(record.m_deviceId);
+        case Columnar::SUBJECT_ID:
+          return static_cast<uint8_t>(record.getSubjectId());
+        case Columnar::DEVICE_TYPE:
+          return static_cast<uint8_t>(record.m_deviceType);
+        case Columnar::ERRORS:
+          return static_cast<uint8_t>(record.m_errors);
+        case Columnar::SLAVE_STATE:
+          return static_cast<uint8_t>(record.m_slaveState);
+        case Columnar::APPROVE_STATE:
+          return static_cast<uint8_t>(record.m_approveState);
+        case Columnar::CMD_TYPE:
+          return static_cast<uint8_t>(record.m_cmdType);
+        default:
+          return 0U;
+      }
+    }
+  }
+
+
+  Columnar::Writer::Writer() :
+    m_fd(-1),
+    m_lastNs(0U) {
+    m_chunk.m_numOfRows = 0U;
+  }
+
+
+  Columnar::Writer::~Writer() {
+    close();
+  }
+
+
+  bool Columnar::Writer::open(const char *path) {
+    close();
+    m_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(m_fd < 0) {
+      return false;
+    }
+    FileHeader header{{MAGIC_0, MAGIC_1}, VERSION,
+                      static_cast<uint8_t>(NUM_OF_COLUMNS), MAX_ROWS};
+    if(not writeAll(m_fd, &header, sizeof(header))) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+
+  bool Columnar::Writer::close() {
+    bool ret = true;
+    if(m_fd >= 0) {
+      ret = flush();
+      ret = (0 == ::close(m_fd)) && ret;
+      m_fd = -1;
+    }
+    m_chunk.m_numOfRows = 0U;
+    m_lastNs = 0U;
+    return ret;
+  }
+
+
+  bool Columnar::Writer::add(const LogRecord &record) {
+    if(m_fd < 0) {
+      return false;
+    }
+    uint64_t timeNs = (record.m_timeNs < m_lastNs) ? m_lastNs : record.m_timeNs;
+    uint32_t row = m_chunk.m_numOfRows++;
+    m_chunk.ma_timeNs[row] = timeNs;
+    for(uint32_t column = 0U; column < NUM_OF_COLUMNS; ++column) {
+      m_chunk.ma_columns[column][row] = getColumn(record, static_cast<Column>(column));
+    }
+    m_lastNs = timeNs;
+    if(MAX_ROWS == m_chunk.m_numOfRows) {
+      return flush();
+    }
+    return true;
+  }
+
+
+  bool Columnar::Writer::flush() {
+    uint32_t numOfRows = m_chunk.m_numOfRows;
+    if((m_fd < 0) || (0U == numOfRows)) {
+      return true;
+    }
+    m_chunk.m_numOfRows = 0U;
+
+    ChunkHeader header{};
+    header.m_numOfRows = numOfRows;
+    header.m_minNs = m_chunk.ma_timeNs[0];
+    header.m_maxNs = m_chunk.ma_timeNs[numOfRows - 1U];
+
+    uint32_t size = 0U;
+    uint64_t prevNs = header.m_minNs;
+    for(uint32_t row = 0U; row < numOfRows; ++row) {
+      size += putVarint(ma_buf + size, m_chunk.ma_timeNs[row] - prevNs);
+      prevNs = m_chunk.ma_timeNs[row];
+    }
+    for(uint32_t column = 0U; column < NUM_OF_COLUMNS; ++column) {
+      const uint8_t *values = m_chunk.ma_columns[column];
+      uint8_t min = UINT8_MAX;
+      uint8_t max = 0U;
+      uint8_t mask = 0U;
+      for(uint32_t row = 0U; row < numOfRows; ++row) {
+        min = (values[row] < min) ? values[row] : min;
+        max = (values[row] > max) ? values[row] : max;
+        mask |= values[row];
+      }
+      header.ma_min[column] = min;
+      header.ma_max[column] = max;
+      if(ERRORS == column) {
+        header.m_errorMask = mask;
+      }
+      if(min != max) {
+        std::memcpy(ma_buf + size, values, numOfRows);
+        size += numOfRows;
+      }
+    }
+    header.m_size = size;
+    return writeAll(m_fd, &header, sizeof(header)) && writeAll(m_fd, ma_buf, size);
+  }
+
+
+  Columnar::Reader::Reader() :
+    m_fd(-1),
+    m_data(nullptr),
+    m_size(0U),
+    m_offset(0U),
+    m_chunkOffset(0U),
+    m_header() {}
+
+
+  Columnar::Reader::~Reader() {
+    close();
+  }
+
+
+  bool Columnar::Reader::open(const char *path) {
+    close();
+    m_fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if(m_fd < 0) {
+      return false;
+    }
+    struct stat st{};
+    if((0 != ::fstat(m_fd, &st)) ||
+       (static_cast<uint64_t>(st.st_size) < sizeof(FileHeader))) {
+      close();
+      return false;
+    }
+    FileHeader header{};
+    if((static_cast<ssize_t>(sizeof(header)) != ::pread(m_fd, &header, sizeof(header), 0)) ||
+       (MAGIC_0 != header.ma_magic[0]) || (MAGIC_1 != header.ma_magic[1]) ||
+       (VERSION != header.m_version) || (NUM_OF_COLUMNS != header.m_numOfColumns) ||
+       (MAX_ROWS != header.m_maxRows)) {
+      close();
+      return false;
+    }
+    m_size = static_cast<uint64_t>(st.st_size);
+    void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if(MAP_FAILED == data) {
+      close();
+      return false;
+    }
+    m_data = static_cast<const uint8_t *>(data);
+
+    // chunks must fill the file exactly, otherwise it is truncated
+    uint64_t offset = sizeof(FileHeader);
+    ChunkHeader chunkHeader{};
+    while(getChunkHeader(m_data, m_size, offset, chunkHeader)) {
+      offset += sizeof(chunkHeader) + chunkHeader.m_size;
+    }
+    if(offset != m_size) {
+      close();
+      return false;
+    }
+    ::madvise(data, m_size, MADV_SEQUENTIAL);
+    rewind();
+    return true;
+  }
+
+
+  void Columnar::Reader::close() {
+    if(nullptr != m_data) {
+      ::munmap(const_cast<uint8_t *>(m_data), m_size);
+      m_data = nullptr;
+    }
+    if(m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+    m_size = 0U;
+    m_offset = 0U;
+    m_chunkOffset = 0U;
+  }
+
+
+  void Columnar::Reader::rewind() {
+    m_offset = sizeof(FileHeader);
+    m_chunkOffset = 0U;
+  }
+
+
+  const Columnar::ChunkHeader *Columnar::Reader::next() {
+    m_chunkOffset = 0U;
+    if((nullptr == m_data) || not getChunkHeader(m_data, m_size, m_offset, m_header)) {
+      return nullptr;
+    }
+    m_chunkOffset = m_offset + sizeof(ChunkHeader);
+    m_offset = m_chunkOffset + m_header.m_size;
+    return &m_header;
+  }
+
+
+  bool Columnar::Reader::load(Chunk &chunk) const {
+    if(0U == m_chunkOffset) {
+      return false;
+    }
+    uint32_t numOfRows = m_header.m_numOfRows;
+    const uint8_t *p = m_data + m_chunkOffset;
+    const uint8_t *end = p + m_header.m_size;
+
+    uint64_t timeNs = m_header.m_minNs;
+    for(uint32_t row = 0U; row < numOfRows; ++row) {
+      uint64_t delta = 0U;
+      uint32_t shift = 0U;
+      while((p < end) && (*p & 0x80U) && (shift < 63U)) {
+        delta |= static_cast<uint64_t>(*p++ & 0x7FU) << shift;
+        shift += 7U;
+      }
+      if(p == end) {
+        return false;
+      }
+      delta |= static_cast<uint64_t>(*p++) << shift;
+      timeNs += delta;
+      chunk.ma_timeNs[row] = timeNs;
+    }
+    for(uint32_t column = 0U; column < NUM_OF_COLUMNS; ++column) {
+      if(m_header.ma_min[column] == m_header.ma_max[column]) {
+        std::memset(chunk.ma_columns[column], m_header.ma_min[column], numOfRows);
+        continue;
+      }
+      if(p + numOfRows > end) {
+        return false;
+      }
+      std::memcpy(chunk.ma_columns[column], p, numOfRows);
+      p += numOfRows;
+    }
+    chunk.m_numOfRows = numOfRows;
+    return true;
+  }
+
+
+  void Columnar::selectAll(const Chunk &chunk, uint8_t *selection) {
+    std::memset(selection, 1, chunk.m_numOfRows);
+  }
+
+
+  void Columnar::selectEq(const Chunk &chunk, Column column, uint8_t value,
+                          uint8_t *selection) {
+    const uint8_t *values = chunk.ma_columns[column];
+    for(uint32_t row = 0U; row < chunk.m_numOfRows; ++row) {
+      selection[row] &= static_cast<uint8_t>(values[row] == value);
+    }
+  }
+
+
+  void Columnar::selectBits(const Chunk &chunk, Column column, uint8_t bits,
+                            uint8_t *selection) {
+    const uint8_t *values = chunk.ma_columns[column];
+    for(uint32_t row = 0U; row < chunk.m_numOfRows; ++row) {
+      selection[row] &= static_cast<uint8_t>(0U != (values[row] & bits));
+    }
+  }
+
+
+  void Columnar::selectTime(const Chunk &chunk, uint64_t fromNs, uint64_t toNs,
+                            uint8_t *selection) {
+    for(uint32_t row = 0U; row < chunk.m_numOfRows; ++row) {
+      selection[row] &= static_cast<uint8_t>((chunk.ma_timeNs[row] >= fromNs) &
+                                             (chunk.ma_timeNs[row] <= toNs));
+    }
+  }
+
+
+  uint32_t Columnar::count(const Chunk &chunk, const uint8_t *selection) {
+    uint32_t ret = 0U;
+    for(uint32_t row = 0U; row < chunk.m_numOfRows; ++row) {
+      ret += selection[row];
+    }
+    return ret;
+  }
+
+
+  void Columnar::groupCount(const Chunk &chunk, Column key, const uint8_t *selection,
+                            uint64_t counts[256]) {
+    const uint8_t *keys = chunk.ma_columns[key];
+    for(uint32_t row = 0U; row < chunk.m_numOfRows; ++row) {
+      counts[keys[row]] += selection[row];
+    }
+  }
+
+
+  bool Columnar::isSkippable(const ChunkHeader &header, Column column, uint8_t value) {
+    if(ERRORS == column) {
+      return 0U == (header.m_errorMask & value);
+    }
+    return (value < header.ma_min[column]) || (value > header.ma_max[column]);
+  }
+
+
+  Columnar::Transitions::Transitions(Column column, uint8_t mask, Column key) :
+    m_column(column),
+    m_mask(mask),
+    m_key(key),
+    ma_isSeen{},
+    ma_last{},
+    ma_counts{} {}
+
+
+  void Columnar::Transitions::scan(const Chunk &chunk, const uint8_t *selection) {
+    const uint8_t *values = chunk.ma_columns[m_column];
+    const uint8_t *keys = chunk.ma_columns[m_key];
+    for(uint32_t row = 0U; row < chunk.m_numOfRows; ++row) {
+      if(0U == selection[row]) {
+        continue;
+      }
+      uint8_t key = keys[row];
+      uint8_t value = values[row] & m_mask;
+      ma_counts[key] += ma_isSeen[key] & static_cast<uint8_t>(value != ma_last[key]);
+      ma_isSeen[key] = 1U;
+      ma_last[key] = value;
+    }
+  }
+
+
+  uint64_t Columnar::Transitions::getCount(uint8_t key) const {
+    return ma_counts[key];
+  }
+
+
+  Columnar::Durations::Durations(Column key) :
+    m_key(key),
+    ma_isStarted{},
+    ma_startNs{} {}
+
+
+  void Columnar::Durations::scan(const Chunk &chunk, const uint8_t *startSelection,
+                                 const uint8_t *endSelection) {
+    const uint8_t *keys = chunk.ma_columns[m_key];
+    for(uint32_t row = 0U; row < chunk.m_numOfRows; ++row) {
+      uint8_t key = keys[row];
+      if(ma_isStarted[key] && endSelection[row]) {
+        m_histogram.record(chunk.ma_timeNs[row] - ma_startNs[key]);
+        ma_isStarted[key] = 0U;
+      } else if((not ma_isStarted[key]) && startSelection[row]) {
+        ma_isStarted[key] = 1U;
+        ma_startNs[key] = chunk.ma_timeNs[row];
+      }
+    }
+  }
+
+
+  const Histogram &Columnar::Durations::getHistogram() const {
+    return m_histogram;
+  }
+
+} // end namespace Eet
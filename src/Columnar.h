@@ -0,0 +1,169 @@
+#ifndef EET_COLUMNAR_H
+#define EET_COLUMNAR_H
+
+#include <cstdint>
+
+#include "Histogram.h"
+#include "LogParser.h"
+
+namespace Eet {
+/**
+ * Columnar file of log records for offline analytics.
+ *
+ * Records are stored in chunks of up to MAX_ROWS rows, every chunk starts
+ * with ChunkHeader which holds min/max of every column, so whole chunks can
+ * be skipped without decoding. Columns of a chunk:
+ *   TIME     - varint deltas, the first one from m_minNs
+ *   U8 columns - one byte per row, enums keep their Protocol.h codes
+ *            (dictionary of at most 12 values, INVALID is 255),
+ *            ERRORS holds 7 ErrorBit flags of a row packed in one byte.
+ *            Column which has the same value in all rows (min == max)
+ *            is not stored.
+ *
+ * Queries work on decoded Chunk with selection vectors (one byte per row,
+ * 0 or 1), select*() functions narrow the selection with branch-free loops
+ * which compilers vectorize.
+ *
+ * File layout (host byte order): FileHeader, then chunks.
+ */
+  namespace Columnar {
+    enum Column {
+        TYPE = 0,      // 0 - T line, 1 - O line
+        DEVICE_ID,     // device which wrote the log
+        SUBJECT_ID,    // device which state is described, see LogRecord
+        DEVICE_TYPE,
+        ERRORS,
+        SLAVE_STATE,
+        APPROVE_STATE,
+        CMD_TYPE,
+        NUM_OF_COLUMNS // of uint8_t columns, TIME is separate
+    };
+
+    constexpr uint32_t MAX_ROWS = 16384U;
+    constexpr uint8_t VERSION = 1U;
+
+    struct FileHeader {
+      char ma_magic[2]; // "EC"
+      uint8_t m_version;
+      uint8_t m_numOfColumns;
+      uint32_t m_maxRows;
+    };
+
+    struct ChunkHeader {
+      uint32_t m_numOfRows;
+      uint32_t m_size; // of chunk data after the header
+      uint64_t m_minNs;
+      uint64_t m_maxNs;
+      uint8_t ma_min[NUM_OF_COLUMNS];
+      uint8_t ma_max[NUM_OF_COLUMNS];
+      uint8_t m_errorMask; // OR of ERRORS column
+      uint8_t ma_reserve[7];
+    };
+
+    struct Chunk {
+      uint32_t m_numOfRows;
+      uint64_t ma_timeNs[MAX_ROWS];
+      uint8_t ma_columns[NUM_OF_COLUMNS][MAX_ROWS];
+    };
+
+    class Writer {
+      public:
+        Writer();
+        ~Writer();
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        bool open(const char *path);
+        // flushes current chunk
+        bool close();
+        // time must not decrease, it is clamped otherwise
+        bool add(const LogRecord &record);
+        bool flush();
+
+      private:
+        int m_fd;
+        uint64_t m_lastNs;
+        Chunk m_chunk; // ~256 KiB, keep Writer static
+        uint8_t ma_buf[MAX_ROWS * (10U + NUM_OF_COLUMNS)];
+    };
+
+    class Reader {
+      public:
+        Reader();
+        ~Reader();
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        // false if file is not a columnar file or is truncated
+        bool open(const char *path);
+        void close();
+        void rewind();
+        // header of the next chunk, nullptr at the end of file
+        const ChunkHeader *next();
+        // decodes chunk returned by the last next()
+        bool load(Chunk &chunk) const;
+
+      private:
+        int m_fd;
+        const uint8_t *m_data;
+        uint64_t m_size;
+        uint64_t m_offset;
+        uint64_t m_chunkOffset; // of data of the last next() chunk, 0 - none
+        ChunkHeader m_header;   // copy, chunks in the file are not aligned
+    };
+
+    // selection vectors
+    void selectAll(const Chunk &chunk, uint8_t *selection);
+    void selectEq(const Chunk &chunk, Column column, uint8_t value, uint8_t *selection);
+    void selectBits(const Chunk &chunk, Column column, uint8_t bits, uint8_t *selection);
+    void selectTime(const Chunk &chunk, uint64_t fromNs, uint64_t toNs, uint8_t *selection);
+    uint32_t count(const Chunk &chunk, const uint8_t *selection);
+    // counts[value of key] += number of selected rows
+    void groupCount(const Chunk &chunk, Column key, const uint8_t *selection,
+                    uint64_t counts[256]);
+    // chunk can not have rows with the value
+    bool isSkippable(const ChunkHeader &header, Column column, uint8_t value);
+
+    /**
+     * Counts changes of (column & mask) per key, e.g. how often
+     * E_SOME_SLAVES_LOST flaps per device. The first row of a key
+     * is not a change. Chunks must be scanned in file order.
+     */
+    class Transitions {
+      public:
+        Transitions(Column column, uint8_t mask, Column key = SUBJECT_ID);
+        void scan(const Chunk &chunk, const uint8_t *selection);
+        uint64_t getCount(uint8_t key) const;
+
+      private:
+        Column m_column;
+        uint8_t m_mask;
+        Column m_key;
+        uint8_t ma_isSeen[256];
+        uint8_t ma_last[256];
+        uint64_t ma_counts[256];
+    };
+
+    /**
+     * Time from a row of start selection to the next row of end selection
+     * of the same key, e.g. how long NOT_APPROVED lasts after FULL_AHEAD.
+     * Later start rows before the end do not restart measurement.
+     * Chunks must be scanned in file order.
+     */
+    class Durations {
+      public:
+        explicit Durations(Column key = SUBJECT_ID);
+        void scan(const Chunk &chunk, const uint8_t *startSelection,
+                  const uint8_t *endSelection);
+        const Histogram &getHistogram() const;
+
+      private:
+        Column m_key;
+        uint8_t ma_isStarted[256];
+        uint64_t ma_startNs[256];
+        Histogram m_histogram;
+    };
+  } // end namespace Columnar
+} // end namespace Eet
+
+#endif // EET_COLUMNAR_H
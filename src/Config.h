@@ -0,0 +1,24 @@
+#ifndef EET_CONFIG_H
+#define EET_CONFIG_H
+
+/**
+ * Build profile, see eet-core target in src/CMakeLists.txt.
+ *
+ * EET_FREESTANDING     - no heap, exceptions and RTTI. Devices and messages
+ *                        are never deleted through base pointers there, so
+ *                        interfaces have non-virtual destructors: deleting
+ *                        destructors would pull operator delete in.
+ * EET_LOG_MSG_MAX_SIZE - LogMsg buffer size, at least LogMsg::MAX_LEN,
+ *                        MAX_LEN + MAX_TIME_LEN for timestamps on every line.
+ */
+#ifdef EET_FREESTANDING
+#define EET_VIRTUAL_DTOR
+#else
+#define EET_VIRTUAL_DTOR virtual
+#endif
+
+#ifndef EET_LOG_MSG_MAX_SIZE
+#define EET_LOG_MSG_MAX_SIZE 512
+#endif
+
+#endif // EET_CONFIG_H
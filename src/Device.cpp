@@ -1,5 +1,6 @@
 #include "Device.h"
 #include "Helpers.h"
+#include "Tracer.h"
 
 namespace Eet {
 
@@ -13,20 +14,69 @@ namespace Eet {
     m_isAnyActiveSlave(false),
     m_slaveState(Protocol::SlaveState::NOT_ACTIVE),
     m_cmdType(Protocol::CmdType::INVALID),
-    m_approveState(Protocol::ApproveState::NOT_APPROVED) {}
+    m_approveState(Protocol::ApproveState::NOT_APPROVED),
+    m_observer(nullptr),
+    m_numOfDiscoveryUpdates(0U),
+    m_isDiscovering(false),
+    m_isHeartbeatRequested(false),
+    m_liveness(1U),
+    ma_slavesLiveness{},
+    ma_mastersLiveness{},
+    m_idScheme(Protocol::Can::IdScheme::V1),
+    ma_heartbeatCache{} {}
 
 
   uint16_t Device::pushMsg(const Protocol::Can::RawMsg &rawMsg) {
+    return pushMsg(rawMsg, m_idScheme);
+  }
+
+
+  uint16_t Device::pushMsg(const Protocol::Can::RawMsg &rawMsg,
+                           Protocol::Can::IdScheme idScheme) {
+    EET_TRACE_SPAN(span, "pushMsg INVALID", m_deviceId);
     uint16_t notValid = 0U;
 
+    // steady state: the same heartbeat from a sender each period
+    auto senderIndex =
+      static_cast<uint32_t>(Helpers::bits2type<char>(rawMsg.m_dataL, 0U, 0U, 6U)) - 1U;
+    if(senderIndex < static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID)) {
+      const auto &cache = ma_heartbeatCache[senderIndex];
+      if(cache.m_isValid && (cache.m_dataL == rawMsg.m_dataL) &&
+         (cache.m_canId == rawMsg.m_canId) && (cache.m_dlc == rawMsg.m_dlc) &&
+         (cache.m_idScheme == idScheme)) {
+        EET_TRACE_SPAN_NAME(span, "pushMsg HEARTBEAT");
+        auto deviceId = static_cast<char>(senderIndex + 1U);
+        notValid = registerResponderId(deviceId, cache.m_deviceType);
+        if(not notValid) {
+          Protocol::Msg::CommonFields commonFields(deviceId, cache.m_deviceType, cache.m_errors);
+          Protocol::Msg::Heartbeat heartbeatMsg(commonFields, cache.m_slaveState,
+                                                cache.m_approveState, cache.m_cmdType);
+          pushHeartbeat(heartbeatMsg);
+        }
+        return notValid;
+      }
+    }
+
     Protocol::Msg::CommonFields commonFileds(rawMsg.m_dataL);
     notValid |= commonFileds.isNotValid();
     if(not notValid) {
       notValid |= registerResponderId(commonFileds.m_deviceId,
                                       commonFileds.m_deviceType);
-      if(not notValid) {
-        switch(static_cast<Protocol::Can::Id>(rawMsg.m_canId)) {
+      auto canId = Protocol::Can::Id::AGGREGATE;
+      char canIdDeviceId = Protocol::DeviceId::INVALID;
+      bool isKnownId = Protocol::Can::fromCanId(rawMsg.m_canId, canId, canIdDeviceId);
+      bool isV2 = (Protocol::DeviceId::INVALID != canIdDeviceId);
+      // V2 ID should have Device ID of the sender
+      bool isAcceptedId = isKnownId &&
+        ((Protocol::Can::IdScheme::V1 != idScheme) || not isV2) &&
+        ((Protocol::Can::IdScheme::V2 != idScheme) || isV2) &&
+        (not isV2 || (canIdDeviceId == commonFileds.m_deviceId));
+      if((not notValid) && (not isAcceptedId)) {
+        notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_ID);
+      } else if(not notValid) {
+        switch(canId) {
           case Protocol::Can::Id::ACTIVATE: {
+            EET_TRACE_SPAN_NAME(span, "pushMsg ACTIVATE");
             if(Protocol::Msg::Activate::DLC != rawMsg.m_dlc) {
               notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_DLC);
             } else {
@@ -39,6 +89,7 @@ namespace Eet {
             break;
           }
           case Protocol::Can::Id::HEARTBEAT: {
+            EET_TRACE_SPAN_NAME(span, "pushMsg HEARTBEAT");
             if(Protocol::Msg::Heartbeat::DLC != rawMsg.m_dlc) {
               notValid = (1U << Protocol::Msg::Errors::INVALID_CAN_DLC);
             } else {
@@ -56,11 +107,28 @@ namespace Eet {
               notValid |= heartbeatMsg.isNotValid();
               if(not notValid) {
                 pushHeartbeat(heartbeatMsg);
+                ma_heartbeatCache[commonFileds.m_deviceId - 1] = {
+                  rawMsg.m_canId, rawMsg.m_dlc, rawMsg.m_dataL, true, idScheme,
+                  commonFileds.m_deviceType, commonFileds.m_errors,
+                  slaveState, approveState, cmdType
+                };
               }
             }
             break;
           }
+          case Protocol::Can::Id::DISCOVER: {
+            EET_TRACE_SPAN_NAME(span, "pushMsg DISCOVER");
+            if(Protocol::Msg::Discover::DLC != rawMsg.m_dlc) {
+              notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_DLC);
+            } else {
+              Protocol::Msg::Discover discoverMsg(commonFileds);
+              notValid |= discoverMsg.isNotValid();
+              m_isHeartbeatRequested |= (not notValid);
+            }
+            break;
+          }
           case Protocol::Can::Id::CMD: {
+            EET_TRACE_SPAN_NAME(span, "pushMsg CMD");
             if(Protocol::Msg::Cmd::DLC != rawMsg.m_dlc) {
               notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_DLC);
             } else {
@@ -86,6 +154,31 @@ namespace Eet {
   }
 
 
+  uint16_t Device::pushFdMsg(const Protocol::Can::FdRawMsg &fdRawMsg) {
+    using Protocol::Msg::Aggregate;
+    uint16_t notValid = 0U;
+
+    Protocol::Can::RawMsg rawMsg{};
+    if(fdRawMsg.m_len > Protocol::Can::FdRawMsg::MAX_LEN) {
+      notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_DLC);
+    } else if(static_cast<uint32_t>(Protocol::Can::Id::AGGREGATE) == fdRawMsg.m_canId) {
+      for(uint32_t i = 0U; i < fdRawMsg.m_len / Aggregate::RECORD_SIZE; ++i) {
+        if(Aggregate::getRecord(fdRawMsg, i, rawMsg)) {
+          // records always have V1 Id
+          notValid |= pushMsg(rawMsg, Protocol::Can::IdScheme::V1);
+        } else if(0U != fdRawMsg.ma_data[i * Aggregate::RECORD_SIZE + 3U]) {
+          notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_ID);
+        }
+      }
+    } else if(Protocol::Can::toRawMsg(fdRawMsg, rawMsg)) {
+      notValid |= pushMsg(rawMsg);
+    } else {
+      notValid |= (1U << Protocol::Msg::Errors::INVALID_CAN_DLC);
+    }
+    return notValid;
+  }
+
+
   char Device::getDeviceId() const {
     return m_deviceId;
   }
@@ -96,44 +189,56 @@ namespace Eet {
   }
 
 
-  Protocol::DeviceType Device::getDeviceType() {
+  Protocol::DeviceType Device::getDeviceType() const {
     return m_deviceType;
   }
 
 
-  Protocol::SlaveState Device::getSlaveState() {
+  Protocol::SlaveState Device::getSlaveState() const {
     return m_slaveState;
   }
 
 
-  Protocol::ApproveState Device::getApproveState() {
+  Protocol::ApproveState Device::getApproveState() const {
     return m_approveState;
   }
 
 
-  Protocol::CmdType Device::getCmdType() {
+  Protocol::CmdType Device::getCmdType() const {
     return m_cmdType;
   }
 
 
   Protocol::Can::RawMsg Device::getActivateMsg() {
+    EET_TRACE_SPAN(span, "encode ACTIVATE", m_deviceId);
     Protocol::Msg::CommonFields commonFields(m_deviceId, m_deviceType, m_errors);
     Protocol::Msg::Activate activateMsg(commonFields);
-    return static_cast<Protocol::Can::RawMsg>(activateMsg);
+    return toScheme(static_cast<Protocol::Can::RawMsg>(activateMsg));
   }
 
 
   Protocol::Can::RawMsg Device::getHeartbeatMsg() {
+    EET_TRACE_SPAN(span, "encode HEARTBEAT", m_deviceId);
+    m_isHeartbeatRequested = false;
     Protocol::Msg::CommonFields commonFields(m_deviceId, m_deviceType, m_errors);
     Protocol::Msg::Heartbeat heartbeatMsg(commonFields, m_slaveState, m_approveState, m_cmdType);
-    return static_cast<Protocol::Can::RawMsg>(heartbeatMsg);
+    return toScheme(static_cast<Protocol::Can::RawMsg>(heartbeatMsg));
+  }
+
+
+  Protocol::Can::RawMsg Device::getDiscoverMsg() {
+    EET_TRACE_SPAN(span, "encode DISCOVER", m_deviceId);
+    Protocol::Msg::CommonFields commonFields(m_deviceId, m_deviceType, m_errors);
+    Protocol::Msg::Discover discoverMsg(commonFields);
+    return toScheme(static_cast<Protocol::Can::RawMsg>(discoverMsg));
   }
 
 
   Protocol::Can::RawMsg Device::getCmdMsg() {
+    EET_TRACE_SPAN(span, "encode CMD", m_deviceId);
     Protocol::Msg::CommonFields commonFields(m_deviceId, m_deviceType, m_errors);
     Protocol::Msg::Cmd cmdMsg(commonFields, m_cmdType);
-    return static_cast<Protocol::Can::RawMsg>(cmdMsg);
+    return toScheme(static_cast<Protocol::Can::RawMsg>(cmdMsg));
   }
 
 
@@ -166,6 +271,251 @@ namespace Eet {
   }
 
 
+  Snapshot Device::getSnapshot() const {
+    Snapshot snapshot{};
+    snapshot.m_deviceType = m_deviceType;
+    snapshot.m_deviceId = m_deviceId;
+    snapshot.m_errors = m_errors;
+    snapshot.m_numOfMasters = static_cast<uint8_t>(m_numOfMasters);
+    snapshot.m_numOfSlaves = static_cast<uint8_t>(m_numOfSlaves);
+    snapshot.m_flags |= (m_isAnyDuplicatedId << Snapshot::IS_ANY_DUPLICATED_ID);
+    snapshot.m_flags |= (m_isAnyActiveSlave << Snapshot::IS_ANY_ACTIVE_SLAVE);
+    snapshot.m_slaveState = m_slaveState;
+    snapshot.m_approveState = m_approveState;
+    snapshot.m_cmdType = m_cmdType;
+    snapshot.ma_activeSlaves = static_cast<uint16_t>(ma_activeSlaves.to_ulong());
+    snapshot.ma_respondedSlaves = static_cast<uint16_t>(ma_respondedSlaves.to_ulong());
+    snapshot.ma_respondedMasters = static_cast<uint16_t>(ma_respondedMasters.to_ulong());
+    snapshot.m_flags |= (m_isDiscovering << Snapshot::IS_DISCOVERING);
+    snapshot.m_flags |= (m_isHeartbeatRequested << Snapshot::IS_HEARTBEAT_REQUESTED);
+    snapshot.m_idScheme = m_idScheme;
+    snapshot.m_liveness = m_liveness;
+    snapshot.m_numOfDiscoveryUpdates = static_cast<uint16_t>(
+      (m_numOfDiscoveryUpdates > UINT16_MAX) ? UINT16_MAX : m_numOfDiscoveryUpdates);
+    for(uint32_t i = 0U; i < static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID); ++i) {
+      snapshot.ma_slavesLiveness[i] = ma_slavesLiveness[i];
+      snapshot.ma_mastersLiveness[i] = ma_mastersLiveness[i];
+    }
+    return snapshot;
+  }
+
+
+  bool Device::restore(const Snapshot &snapshot) {
+    if(snapshot.m_deviceType != m_deviceType) {
+      return false;
+    }
+    m_deviceId = snapshot.m_deviceId;
+    m_errors = snapshot.m_errors;
+    m_numOfMasters = snapshot.m_numOfMasters;
+    m_numOfSlaves = snapshot.m_numOfSlaves;
+    m_isAnyDuplicatedId = (snapshot.m_flags >> Snapshot::IS_ANY_DUPLICATED_ID) & 0x01;
+    m_isAnyActiveSlave = (snapshot.m_flags >> Snapshot::IS_ANY_ACTIVE_SLAVE) & 0x01;
+    m_slaveState = snapshot.m_slaveState;
+    m_approveState = snapshot.m_approveState;
+    m_cmdType = snapshot.m_cmdType;
+    ma_activeSlaves = snapshot.ma_activeSlaves;
+    ma_respondedSlaves = snapshot.ma_respondedSlaves;
+    ma_respondedMasters = snapshot.ma_respondedMasters;
+    m_isDiscovering = (snapshot.m_flags >> Snapshot::IS_DISCOVERING) & 0x01;
+    m_isHeartbeatRequested = (snapshot.m_flags >> Snapshot::IS_HEARTBEAT_REQUESTED) & 0x01;
+    m_idScheme = snapshot.m_idScheme;
+    setLiveness(snapshot.m_liveness);
+    m_numOfDiscoveryUpdates = snapshot.m_numOfDiscoveryUpdates;
+    for(uint32_t i = 0U; i < static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID); ++i) {
+      ma_slavesLiveness[i] = snapshot.ma_slavesLiveness[i];
+      ma_mastersLiveness[i] = snapshot.ma_mastersLiveness[i];
+    }
+    clearHeartbeatCache();
+    return true;
+  }
+
+
+  void Device::setObserver(IObserver *observer) {
+    m_observer = observer;
+  }
+
+
+  void Device::startDiscovery(uint32_t numOfUpdates) {
+    m_numOfDiscoveryUpdates = numOfUpdates;
+    m_isDiscovering = true;
+  }
+
+
+  bool Device::isDiscovering() const {
+    return m_isDiscovering;
+  }
+
+
+  bool Device::isDiscoveryComplete() const {
+    return isDiscovering() &&
+           (ma_respondedSlaves.count() >= m_numOfSlaves) &&
+           (ma_respondedMasters.count() >= m_numOfMasters);
+  }
+
+
+  bool Device::isHeartbeatRequested() const {
+    return m_isHeartbeatRequested;
+  }
+
+
+  void Device::setLiveness(uint32_t numOfUpdates) {
+    m_liveness = static_cast<uint8_t>((0U == numOfUpdates) ? 1U :
+                                      (numOfUpdates > UINT8_MAX) ? UINT8_MAX : numOfUpdates);
+  }
+
+
+  void Device::setIdScheme(Protocol::Can::IdScheme scheme) {
+    m_idScheme = scheme;
+  }
+
+
+  Protocol::Can::IdScheme Device::getIdScheme() const {
+    return m_idScheme;
+  }
+
+
+  Protocol::Can::RawMsg Device::toScheme(Protocol::Can::RawMsg rawMsg) const {
+    Protocol::Can::Id id = Protocol::Can::Id::AGGREGATE;
+    char deviceId = Protocol::DeviceId::INVALID;
+    if(Protocol::Can::fromCanId(rawMsg.m_canId, id, deviceId)) {
+      rawMsg.m_canId = Protocol::Can::toCanId(id, m_deviceId, m_idScheme);
+    }
+    return rawMsg;
+  }
+
+
+  void Device::startPeriod() {
+    // peers which still may be silent are kept as responded,
+    // with liveness 1 all the sets are just cleared
+    BitSet<Protocol::DeviceId::MAX_DEVICE_ID> aliveSlaves;
+    BitSet<Protocol::DeviceId::MAX_DEVICE_ID> aliveMasters;
+    for(uint32_t i = 0U; i < static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID); ++i) {
+      if(ma_slavesLiveness[i] > 0U) {
+        --ma_slavesLiveness[i];
+        if(ma_slavesLiveness[i] > 0U) {
+          aliveSlaves.set(i);
+        }
+      }
+      if(ma_mastersLiveness[i] > 0U) {
+        --ma_mastersLiveness[i];
+        if(ma_mastersLiveness[i] > 0U) {
+          aliveMasters.set(i);
+        }
+      }
+    }
+    ma_activeSlaves = ma_activeSlaves.to_ulong() & aliveSlaves.to_ulong();
+    ma_respondedSlaves = aliveSlaves;
+    ma_respondedMasters = aliveMasters;
+    m_isAnyDuplicatedId = false;
+    m_isAnyActiveSlave = false;
+  }
+
+
+  void Device::clearHeartbeatCache() {
+    for(auto &cache : ma_heartbeatCache) {
+      cache.m_isValid = false;
+    }
+  }
+
+
+  char Device::filterDiscoveryErrors(char errors) {
+    if(not isDiscovering()) {
+      return errors;
+    }
+    if(isDiscoveryComplete() || (0U == m_numOfDiscoveryUpdates)) {
+      m_isDiscovering = false;
+      return errors;
+    }
+    --m_numOfDiscoveryUpdates;
+    // peers which have not answered yet are not lost
+    constexpr char LOSS_ERRORS = (1 << Protocol::CON_WITH_SOME_SLAVES_LOST) |
+                                 (1 << Protocol::CON_WITH_ALL_SLAVES_LOST) |
+                                 (1 << Protocol::CON_WITH_SOME_MASTERS_LOST) |
+                                 (1 << Protocol::CON_WITH_ALL_MASTERS_LOST) |
+                                 (1 << Protocol::NO_CONNECTION) |
+                                 (1 << Protocol::NO_ACTIVE_SLAVE);
+    return static_cast<char>(errors & ~LOSS_ERRORS);
+  }
+
+
+  void Device::storeSlaveState(Protocol::SlaveState slaveState) {
+    auto from = m_slaveState;
+    m_slaveState = slaveState;
+    if(from != slaveState) {
+      EET_TRACE_INSTANT("SLAVE_STATE", m_deviceId, static_cast<uint8_t>(from),
+                        static_cast<uint8_t>(slaveState));
+    }
+    if((nullptr != m_observer) && (from != slaveState)) {
+      m_observer->onTransition(*this, StateField::SLAVE_STATE,
+                               static_cast<uint8_t>(from),
+                               static_cast<uint8_t>(slaveState));
+    }
+  }
+
+
+  void Device::storeApproveState(Protocol::ApproveState approveState) {
+    auto from = m_approveState;
+    m_approveState = approveState;
+    if(from != approveState) {
+      EET_TRACE_INSTANT("APPROVE_STATE", m_deviceId, static_cast<uint8_t>(from),
+                        static_cast<uint8_t>(approveState));
+    }
+    if((nullptr != m_observer) && (from != approveState)) {
+      m_observer->onTransition(*this, StateField::APPROVE_STATE,
+                               static_cast<uint8_t>(from),
+                               static_cast<uint8_t>(approveState));
+    }
+  }
+
+
+  void Device::storeCmdType(Protocol::CmdType cmdType) {
+    auto from = m_cmdType;
+    m_cmdType = cmdType;
+    if(from != cmdType) {
+      EET_TRACE_INSTANT("CMD_TYPE", m_deviceId, static_cast<uint8_t>(from),
+                        static_cast<uint8_t>(cmdType));
+    }
+    if((nullptr != m_observer) && (from != cmdType)) {
+      m_observer->onTransition(*this, StateField::CMD_TYPE,
+                               static_cast<uint8_t>(from),
+                               static_cast<uint8_t>(cmdType));
+    }
+  }
+
+
+  void Device::storeErrors(char errors) {
+    auto from = m_errors;
+    m_errors = errors;
+#ifdef EET_TRACE_ENABLED
+    // one event per changed ErrorBit, names as in LogMsg
+    static const char *const errorNames[] = {
+      "E_DUPLICATED_DEVICE_ID", "E_CON_WITH_SOME_SLAVES_LOST", "E_CON_WITH_ALL_SLAVES_LOST",
+      "E_CON_WITH_SOME_MASTERS_LOST", "E_CON_WITH_ALL_MASTERS_LOST", "E_NO_CONNECTION",
+      "E_NO_ACTIVE_SLAVE"};
+    for(uint32_t bit = 0U; (from != errors) && Tracer::isEnabled() &&
+                           (bit < sizeof(errorNames) / sizeof(errorNames[0])); ++bit) {
+      auto fromBit = static_cast<uint8_t>((from >> bit) & 0x01);
+      auto toBit = static_cast<uint8_t>((errors >> bit) & 0x01);
+      if(fromBit != toBit) {
+        Tracer::instant(errorNames[bit], m_deviceId, fromBit, toBit);
+      }
+    }
+#endif
+    if((nullptr != m_observer) && (from != errors)) {
+      m_observer->onTransition(*this, StateField::ERRORS,
+                               static_cast<uint8_t>(from),
+                               static_cast<uint8_t>(errors));
+    }
+  }
+
+
+  void Device::notifyInput(Input input, Protocol::CmdType cmdType) {
+    if(nullptr != m_observer) {
+      m_observer->onInput(*this, input, cmdType);
+    }
+  }
+
+
   bool Device::isConWithSomeSlavesLost() {
     auto total = ma_respondedSlaves.count();
     return total < m_numOfSlaves;
@@ -208,9 +558,11 @@ namespace Eet {
       switch(deviceType) {
         case Protocol::DeviceType::SLAVE:
           ma_respondedSlaves.set(static_cast<size_t>(deviceId - 1));
+          ma_slavesLiveness[deviceId - 1] = m_liveness;
           break;
         case Protocol::DeviceType::MASTER:
           ma_respondedMasters.set(static_cast<size_t>(deviceId - 1));
+          ma_mastersLiveness[deviceId - 1] = m_liveness;
           break;
         default:
           ret = (1U << Protocol::Msg::Errors::INVALID_DEVICE_TYPE);
@@ -1,38 +1,59 @@
 #ifndef EET_DEVICE_H
 #define EET_DEVICE_H
 
-#include <list>
-#include <unordered_set>
-#include <memory>
-#include <bitset>
+#include <cstddef>
 
 #include "Protocol.h"
+#include "Helpers.h"
+#include "Snapshot.h"
+#include "Observer.h"
 
 namespace Eet {
 /**
  * 1. Call pushMsg() to tell device to take msg into account
  * 2. Call update() to tell device to update device's state and errors
+ *
+ * Boot (optional, see DISCOVER in doc/protocol.md):
+ * 1. Call startDiscovery() and send getDiscoverMsg()
+ * 2. Call update() at once when isDiscoveryComplete() after pushMsg()
+ * Every device sends getHeartbeatMsg() at once when isHeartbeatRequested().
  */
   class Device {
     public:
-      virtual ~Device() = default;
+      EET_VIRTUAL_DTOR ~Device() = default;
       explicit Device(Protocol::DeviceType deviceType);
 
       uint16_t pushMsg(const Protocol::Can::RawMsg &rawMsg);
+      uint16_t pushFdMsg(const Protocol::Can::FdRawMsg &fdRawMsg); // classic or aggregate
       char getDeviceId() const;
       char getErrors() const;
-      Protocol::DeviceType getDeviceType();
-      Protocol::SlaveState getSlaveState();
-      Protocol::ApproveState getApproveState();
-      Protocol::CmdType getCmdType();
+      Protocol::DeviceType getDeviceType() const;
+      Protocol::SlaveState getSlaveState() const;
+      Protocol::ApproveState getApproveState() const;
+      Protocol::CmdType getCmdType() const;
       virtual Protocol::Can::RawMsg getActivateMsg();
-      Protocol::Can::RawMsg getHeartbeatMsg();
+      Protocol::Can::RawMsg getHeartbeatMsg(); // clears heartbeat request
+      Protocol::Can::RawMsg getDiscoverMsg();
       virtual Protocol::Can::RawMsg getCmdMsg();
       bool isDuplicatedDeviceId();
       bool isAnyError();
       bool isAnyConLost();
       bool isAnyCon();
       bool isAnyActiveSlave();
+      virtual Snapshot getSnapshot() const;
+      virtual bool restore(const Snapshot &snapshot); // false if snapshot is not applicable
+      void setObserver(IObserver *observer); // nullptr to detach
+      // loss alarms are suppressed until all peers respond, at most for numOfUpdates
+      void startDiscovery(uint32_t numOfUpdates = 1U);
+      bool isDiscovering() const; // errors are not final yet
+      bool isDiscoveryComplete() const; // all peers have responded
+      bool isHeartbeatRequested() const; // some peer is discovering
+      // peer is lost after numOfUpdates update() periods without its messages,
+      // 1 (default) - after one period, for peers with adaptive heartbeat see HeartbeatPolicy
+      void setLiveness(uint32_t numOfUpdates);
+      // scheme of CAN IDs of get*Msg() and of accepted msgs, V1 by default
+      void setIdScheme(Protocol::Can::IdScheme scheme);
+      Protocol::Can::IdScheme getIdScheme() const;
 
       virtual void setDeviceId(char id) = 0;
       virtual void setNumOfMasters(size_t num) = 0;
@@ -48,6 +69,19 @@ namespace Eet {
       bool isNoConnection();
       bool isNoActiveSlave();
 
+      // change state and notify observer
+      void storeSlaveState(Protocol::SlaveState slaveState);
+      void storeApproveState(Protocol::ApproveState approveState);
+      void storeCmdType(Protocol::CmdType cmdType);
+      void storeErrors(char errors);
+      void notifyInput(Input input, Protocol::CmdType cmdType);
+      // called by update() once per cycle
+      char filterDiscoveryErrors(char errors);
+      // called at the end of update(), starts collecting responses of the next period
+      void startPeriod();
+      // forgets decoded heartbeats, e.g. when Device ID changes
+      void clearHeartbeatCache();
+
       virtual void pushActivate(const Protocol::Msg::Activate &msg) = 0;
       virtual void pushHeartbeat(const Protocol::Msg::Heartbeat &msg) = 0;
       virtual void pushCmd(const Protocol::Msg::Cmd &msg) = 0;
@@ -68,12 +102,45 @@ namespace Eet {
        */
       Protocol::ApproveState m_approveState;
 
-      std::bitset<Protocol::DeviceId::MAX_DEVICE_ID> ma_activeSlaves;
-      std::bitset<Protocol::DeviceId::MAX_DEVICE_ID> ma_respondedSlaves;
-      std::bitset<Protocol::DeviceId::MAX_DEVICE_ID> ma_respondedMasters;
+      BitSet<Protocol::DeviceId::MAX_DEVICE_ID> ma_activeSlaves;
+      BitSet<Protocol::DeviceId::MAX_DEVICE_ID> ma_respondedSlaves;
+      BitSet<Protocol::DeviceId::MAX_DEVICE_ID> ma_respondedMasters;
+      IObserver *m_observer;
+      uint32_t m_numOfDiscoveryUpdates;
+      bool m_isDiscovering;
+      bool m_isHeartbeatRequested;
+      uint8_t m_liveness;
+      // update() periods left until peer is lost, by Device ID - 1
+      uint8_t ma_slavesLiveness[Protocol::DeviceId::MAX_DEVICE_ID];
+      uint8_t ma_mastersLiveness[Protocol::DeviceId::MAX_DEVICE_ID];
+      Protocol::Can::IdScheme m_idScheme;
 
     private:
+      /*
+       * Last valid heartbeat of a sender and its decoded fields. Decoding
+       * depends only on CAN ID, DLC, m_dataL and accepted ID scheme, so an
+       * equal frame gets the same fields; registerResponderId() and
+       * pushHeartbeat() still run for every frame.
+       */
+      struct HeartbeatCache {
+        uint32_t m_canId;
+        uint32_t m_dlc;
+        uint32_t m_dataL;
+        bool m_isValid;
+        Protocol::Can::IdScheme m_idScheme;
+        Protocol::DeviceType m_deviceType;
+        uint8_t m_errors;
+        Protocol::SlaveState m_slaveState;
+        Protocol::ApproveState m_approveState;
+        Protocol::CmdType m_cmdType;
+      };
+
+      uint16_t pushMsg(const Protocol::Can::RawMsg &rawMsg, Protocol::Can::IdScheme idScheme);
       uint16_t registerResponderId(char deviceId, Protocol::DeviceType type);
+      Protocol::Can::RawMsg toScheme(Protocol::Can::RawMsg rawMsg) const;
+
+      // by sender Device ID - 1
+      HeartbeatCache ma_heartbeatCache[Protocol::DeviceId::MAX_DEVICE_ID];
   };
 
 
@@ -90,6 +157,8 @@ namespace Eet {
       bool isAnyActiveSlaveResponded();
       Protocol::SlaveState getState();
       void approve(Protocol::CmdType cmdType);
+      Snapshot getSnapshot() const override;
+      bool restore(const Snapshot &snapshot) override;
 
     private:
       void pushActivate(const Protocol::Msg::Activate &msg) override;
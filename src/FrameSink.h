@@ -0,0 +1,17 @@
+#ifndef EET_FRAME_SINK_H
+#define EET_FRAME_SINK_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+  // consumer of frames seen on a bus, timeNs is end of frame
+  class IFrameSink {
+    public:
+      virtual ~IFrameSink() = default;
+      virtual void onFrame(const Protocol::Can::RawMsg &msg, uint64_t timeNs) = 0;
+  };
+} // end namespace Eet
+
+#endif // EET_FRAME_SINK_H
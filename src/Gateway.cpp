@@ -0,0 +1,199 @@
+#include <cstring>
+
+#include "Gateway.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr uint8_t DEVICE_ID_MASK = 0x3FU; // byte 0, the rest is DeviceType
+
+    bool isValidScheme(Protocol::Can::IdScheme scheme) {
+      return (Protocol::Can::IdScheme::V1 == scheme) ||
+             (Protocol::Can::IdScheme::V2 == scheme) ||
+             (Protocol::Can::IdScheme::COMPAT == scheme);
+    }
+
+    uint8_t getKind(Protocol::Can::Id id) {
+      switch(id) {
+        case Protocol::Can::Id::HEARTBEAT: return Gateway::HEARTBEAT;
+        case Protocol::Can::Id::CMD: return Gateway::CMD;
+        default: return 0U;
+      }
+    }
+  }
+
+
+  Gateway::Gateway(uint32_t numOfBuses) :
+    m_numOfBuses((numOfBuses > MAX_BUSES) ? MAX_BUSES : numOfBuses),
+    ma_routes{},
+    ma_nextRoute{},
+    m_numOfRoutes(0U),
+    ma_ownedIds{} {
+    std::memset(ma_firstRoute, NO_ROUTE, sizeof(ma_firstRoute));
+    for(auto &tx : ma_tx) {
+      tx.m_numOfFrames = 0U;
+    }
+    resetStats();
+  }
+
+
+  bool Gateway::addRoute(const Route &route) {
+    constexpr uint8_t ALL_KINDS = HEARTBEAT | CMD;
+    if((m_numOfRoutes >= MAX_ROUTES) ||
+       (route.m_fromBus >= m_numOfBuses) || (route.m_toBus >= m_numOfBuses) ||
+       (route.m_fromBus == route.m_toBus) ||
+       (0U == route.m_kinds) || (route.m_kinds & ~ALL_KINDS) ||
+       not Protocol::DeviceId::isCorrectId(route.m_fromDeviceId) ||
+       not Protocol::DeviceId::isCorrectId(route.m_toDeviceId) ||
+       not isValidScheme(route.m_toIdScheme)) {
+      return false;
+    }
+    for(uint32_t i = 0U; i < m_numOfRoutes; ++i) {
+      const auto &other = ma_routes[i];
+      bool isSameSource = (other.m_fromBus == route.m_fromBus) &&
+                          (other.m_fromDeviceId == route.m_fromDeviceId);
+      bool isSameTarget = (other.m_toBus == route.m_toBus) &&
+                          (other.m_toDeviceId == route.m_toDeviceId);
+      // forwarded frames of one route would be the source of the other one
+      bool isLoop = ((other.m_toBus == route.m_fromBus) &&
+                     (other.m_toDeviceId == route.m_fromDeviceId)) ||
+                    ((route.m_toBus == other.m_fromBus) &&
+                     (route.m_toDeviceId == other.m_fromDeviceId));
+      // two senders with the same ID on the target bus or frames forwarded twice
+      bool isConflict = isSameTarget &&
+                        ((not isSameSource) || (other.m_kinds & route.m_kinds));
+      if(isLoop || isConflict) {
+        return false;
+      }
+    }
+
+    auto index = m_numOfRoutes++;
+    ma_routes[index] = route;
+    ma_nextRoute[index] = NO_ROUTE;
+    auto &first = ma_firstRoute[route.m_fromBus][static_cast<uint32_t>(route.m_fromDeviceId)];
+    if(NO_ROUTE == first) {
+      first = static_cast<uint8_t>(index);
+    } else {
+      auto last = first;
+      while(NO_ROUTE != ma_nextRoute[last]) {
+        last = ma_nextRoute[last];
+      }
+      ma_nextRoute[last] = static_cast<uint8_t>(index);
+    }
+    ma_ownedIds[route.m_toBus] |= static_cast<uint16_t>(1U << route.m_toDeviceId);
+    return true;
+  }
+
+
+  uint32_t Gateway::getNumOfRoutes() const {
+    return m_numOfRoutes;
+  }
+
+
+  const Gateway::Route &Gateway::getRoute(uint32_t route) const {
+    return ma_routes[(route < MAX_ROUTES) ? route : 0U];
+  }
+
+
+  void Gateway::forward(uint32_t bus, const CanSocket::Frame *frames,
+                        uint32_t numOfFrames, uint64_t rxNs) {
+    if(bus >= m_numOfBuses) {
+      return;
+    }
+    auto &busStats = ma_busStats[bus];
+    busStats.m_numOfFrames += numOfFrames;
+    for(uint32_t i = 0U; i < numOfFrames; ++i) {
+      const auto &frame = frames[i];
+      auto deviceId = static_cast<uint32_t>(frame.ma_data[0] & DEVICE_ID_MASK);
+      if((deviceId < NUM_OF_IDS) && ((ma_ownedIds[bus] >> deviceId) & 0x01)) {
+        ++busStats.m_numOfLooped;
+        continue;
+      }
+      auto id = Protocol::Can::Id::AGGREGATE;
+      char canIdDeviceId = Protocol::DeviceId::INVALID;
+      uint8_t kind = 0U;
+      if((deviceId < NUM_OF_IDS) &&
+         Protocol::Can::fromCanId(frame.m_canId, id, canIdDeviceId)) {
+        kind = getKind(id);
+      }
+      bool isRouted = false;
+      for(auto route = (0U != kind) ? ma_firstRoute[bus][deviceId] : NO_ROUTE;
+          NO_ROUTE != route; route = ma_nextRoute[route]) {
+        const auto &target = ma_routes[route];
+        if(0U == (target.m_kinds & kind)) {
+          continue;
+        }
+        isRouted = true;
+        auto &tx = ma_tx[target.m_toBus];
+        if(tx.m_numOfFrames >= MAX_TX) {
+          ++ma_routeStats[route].m_numOfDropped;
+          continue;
+        }
+        auto &out = tx.ma_frames[tx.m_numOfFrames];
+        out = frame;
+        out.m_canId = Protocol::Can::toCanId(id, target.m_toDeviceId, target.m_toIdScheme);
+        out.ma_data[0] = static_cast<uint8_t>((frame.ma_data[0] & ~DEVICE_ID_MASK) |
+                                              static_cast<uint8_t>(target.m_toDeviceId));
+        tx.ma_rxNs[tx.m_numOfFrames] = rxNs;
+        tx.ma_routes[tx.m_numOfFrames] = route;
+        ++tx.m_numOfFrames;
+      }
+      busStats.m_numOfUnrouted += (not isRouted);
+    }
+  }
+
+
+  uint32_t Gateway::getTx(uint32_t bus, const CanSocket::Frame *&frames) const {
+    if(bus >= m_numOfBuses) {
+      frames = nullptr;
+      return 0U;
+    }
+    frames = ma_tx[bus].ma_frames;
+    return ma_tx[bus].m_numOfFrames;
+  }
+
+
+  void Gateway::commitTx(uint32_t bus, uint32_t numOfSent, uint64_t txNs) {
+    if(bus >= m_numOfBuses) {
+      return;
+    }
+    auto &tx = ma_tx[bus];
+    numOfSent = (numOfSent > tx.m_numOfFrames) ? tx.m_numOfFrames : numOfSent;
+    for(uint32_t i = 0U; i < numOfSent; ++i) {
+      auto &stats = ma_routeStats[tx.ma_routes[i]];
+      ++stats.m_numOfFrames;
+      stats.m_latencyNs.record((txNs > tx.ma_rxNs[i]) ? (txNs - tx.ma_rxNs[i]) : 0U);
+    }
+    // usually everything is sent, the rest waits for the next send
+    auto numOfLeft = tx.m_numOfFrames - numOfSent;
+    if((0U != numOfLeft) && (0U != numOfSent)) {
+      std::memmove(tx.ma_frames, tx.ma_frames + numOfSent, numOfLeft * sizeof(tx.ma_frames[0]));
+      std::memmove(tx.ma_rxNs, tx.ma_rxNs + numOfSent, numOfLeft * sizeof(tx.ma_rxNs[0]));
+      std::memmove(tx.ma_routes, tx.ma_routes + numOfSent, numOfLeft * sizeof(tx.ma_routes[0]));
+    }
+    tx.m_numOfFrames = numOfLeft;
+  }
+
+
+  const Gateway::RouteStats &Gateway::getRouteStats(uint32_t route) const {
+    return ma_routeStats[(route < MAX_ROUTES) ? route : 0U];
+  }
+
+
+  const Gateway::BusStats &Gateway::getBusStats(uint32_t bus) const {
+    return ma_busStats[(bus < MAX_BUSES) ? bus : 0U];
+  }
+
+
+  void Gateway::resetStats() {
+    for(auto &stats : ma_routeStats) {
+      stats.m_numOfFrames = 0U;
+      stats.m_numOfDropped = 0U;
+      stats.m_latencyNs.reset();
+    }
+    for(auto &stats : ma_busStats) {
+      stats = BusStats{};
+    }
+  }
+
+} // end namespace Eet
@@ -0,0 +1,105 @@
+#ifndef EET_GATEWAY_H
+#define EET_GATEWAY_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+#include "CanSocket.h"
+#include "Histogram.h"
+
+namespace Eet {
+/**
+ * Forwards HEARTBEAT/CMD frames of selected devices between EET networks
+ * on separate buses (e.g. bridge-wing Master of one network drives
+ * Slaves of another one). Route takes frames of one sender on one bus
+ * and puts them on another bus as frames of another Device ID and CAN ID
+ * scheme (only Device ID field and CAN ID are rewritten). The remapped
+ * sender must be configured in the target network like a local device.
+ *
+ * I/O is done by the caller in batches (see CanSocket::recv()/send()):
+ * 1. forward() frames received on a bus with their receive time
+ * 2. send getTx() of every bus, commitTx() number of sent frames
+ * Frames are rewritten into per-bus TX batches, the only copy besides
+ * the kernel ones.
+ *
+ * Loops: addRoute() refuses a route back to its own source, and a Device
+ * ID which a route puts on a bus is owned by the gateway there, frames
+ * of owned IDs received on that bus (forwarded ones coming back through
+ * other gateways or a conflicting device) are never forwarded.
+ *
+ * Per route: forwarded/dropped frames and latency from receive time to
+ * commitTx(). Large object, do not put it on stack.
+ */
+  class Gateway {
+    public:
+      enum Kind : uint8_t {
+          HEARTBEAT = 1U << 0,
+          CMD = 1U << 1
+      };
+
+      struct Route {
+        uint32_t m_fromBus;
+        uint32_t m_toBus;
+        uint8_t m_kinds; // Kind bits
+        char m_fromDeviceId;
+        char m_toDeviceId;
+        Protocol::Can::IdScheme m_toIdScheme;
+      };
+
+      struct RouteStats {
+        uint64_t m_numOfFrames;  // put on the target bus
+        uint64_t m_numOfDropped; // TX batch was full
+        Histogram m_latencyNs;
+      };
+
+      struct BusStats {
+        uint64_t m_numOfFrames;   // received
+        uint64_t m_numOfLooped;   // sender is owned on this bus
+        uint64_t m_numOfUnrouted;
+      };
+
+      static constexpr uint32_t MAX_BUSES = 4U;
+      static constexpr uint32_t MAX_ROUTES = 32U;
+      static constexpr uint32_t MAX_TX = 4U * CanSocket::MAX_BATCH; // per bus
+
+      explicit Gateway(uint32_t numOfBuses);
+
+      // false if route is not valid, makes a loop or the table is full
+      bool addRoute(const Route &route);
+      uint32_t getNumOfRoutes() const;
+      const Route &getRoute(uint32_t route) const;
+
+      void forward(uint32_t bus, const CanSocket::Frame *frames,
+                   uint32_t numOfFrames, uint64_t rxNs);
+      uint32_t getTx(uint32_t bus, const CanSocket::Frame *&frames) const; // pending
+      void commitTx(uint32_t bus, uint32_t numOfSent, uint64_t txNs);
+
+      const RouteStats &getRouteStats(uint32_t route) const;
+      const BusStats &getBusStats(uint32_t bus) const;
+      void resetStats();
+
+    private:
+      static constexpr uint32_t NUM_OF_IDS =
+        static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID) + 1U;
+      static constexpr uint8_t NO_ROUTE = UINT8_MAX;
+
+      struct Tx {
+        CanSocket::Frame ma_frames[MAX_TX];
+        uint64_t ma_rxNs[MAX_TX];
+        uint8_t ma_routes[MAX_TX];
+        uint32_t m_numOfFrames;
+      };
+
+      uint32_t m_numOfBuses;
+      Route ma_routes[MAX_ROUTES];
+      uint8_t ma_nextRoute[MAX_ROUTES]; // next route of the same sender
+      uint32_t m_numOfRoutes;
+      uint8_t ma_firstRoute[MAX_BUSES][NUM_OF_IDS]; // by bus and sender
+      uint16_t ma_ownedIds[MAX_BUSES]; // bit per Device ID
+      RouteStats ma_routeStats[MAX_ROUTES];
+      BusStats ma_busStats[MAX_BUSES];
+      Tx ma_tx[MAX_BUSES];
+  };
+} // end namespace Eet
+
+#endif // EET_GATEWAY_H
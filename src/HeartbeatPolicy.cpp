@@ -0,0 +1,66 @@
+#include "HeartbeatPolicy.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr HeartbeatPolicy::Config DEFAULT_CONFIG = {
+      20000000U,   // fast heartbeat each 20 ms
+      3U,          // 3 fast heartbeats after the change one
+      1000000000U  // idle heartbeat each 1 s
+    };
+  }
+
+
+  HeartbeatPolicy::HeartbeatPolicy() :
+    HeartbeatPolicy(DEFAULT_CONFIG) {}
+
+
+  HeartbeatPolicy::HeartbeatPolicy(const Config &config) :
+    m_config(config),
+    m_isStarted(false),
+    m_state(0U),
+    m_periodNs(config.m_fastPeriodNs),
+    m_numOfFastLeft(config.m_numOfFast),
+    m_nextNs(0U) {}
+
+
+  uint64_t HeartbeatPolicy::getNextNs(const Device &device, uint64_t nowNs) {
+    auto state = getState(device);
+    if((not m_isStarted) || (state != m_state)) {
+      m_isStarted = true;
+      m_state = state;
+      m_periodNs = m_config.m_fastPeriodNs;
+      m_numOfFastLeft = m_config.m_numOfFast;
+      m_nextNs = nowNs;
+    }
+    return m_nextNs;
+  }
+
+
+  void HeartbeatPolicy::onSent(uint64_t nowNs) {
+    if(0U != m_numOfFastLeft) {
+      --m_numOfFastLeft;
+    } else {
+      m_periodNs *= 2U;
+    }
+    if(m_periodNs > m_config.m_idlePeriodNs) {
+      m_periodNs = m_config.m_idlePeriodNs;
+    }
+    m_nextNs = nowNs + m_periodNs;
+  }
+
+
+  uint32_t HeartbeatPolicy::getLiveness(const Config &config, uint64_t updatePeriodNs) {
+    // update() windows which may pass between idle heartbeats, plus margin for bus delays
+    return static_cast<uint32_t>((config.m_idlePeriodNs + updatePeriodNs - 1U) / updatePeriodNs) + 1U;
+  }
+
+
+  uint32_t HeartbeatPolicy::getState(const Device &device) {
+    return static_cast<uint32_t>(device.getCmdType()) |
+           (static_cast<uint32_t>(device.getApproveState()) << 8) |
+           (static_cast<uint32_t>(device.getSlaveState()) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(device.getErrors())) << 24);
+  }
+
+} // end namespace Eet
@@ -0,0 +1,52 @@
+#ifndef EET_HEARTBEAT_POLICY_H
+#define EET_HEARTBEAT_POLICY_H
+
+#include <cstdint>
+
+#include "Device.h"
+
+namespace Eet {
+/**
+ * Adaptive heartbeat transmit policy.
+ *
+ * Heartbeat is sent at once when cmd type, approve state, slave state or
+ * errors of the device change, then m_numOfFast more each fast period,
+ * then period doubles after every heartbeat up to the idle period.
+ *
+ * Peers must not treat the device as lost while it is idle: set
+ * Device::setLiveness(getLiveness(config, update period)) on all devices.
+ *
+ * 1. Call getNextNs() each time device may have changed (after pushMsg(),
+ *    update() and operator actions), send heartbeat when nowNs reaches it
+ * 2. Call onSent() after the heartbeat is sent
+ */
+  class HeartbeatPolicy {
+    public:
+      struct Config {
+        uint64_t m_fastPeriodNs;
+        uint32_t m_numOfFast;
+        uint64_t m_idlePeriodNs;
+      };
+
+      HeartbeatPolicy();
+      explicit HeartbeatPolicy(const Config &config);
+
+      uint64_t getNextNs(const Device &device, uint64_t nowNs);
+      void onSent(uint64_t nowNs);
+
+      // number of update() periods peers should wait before loss alarm
+      static uint32_t getLiveness(const Config &config, uint64_t updatePeriodNs);
+
+    private:
+      static uint32_t getState(const Device &device);
+
+      Config m_config;
+      bool m_isStarted;
+      uint32_t m_state;
+      uint64_t m_periodNs;
+      uint32_t m_numOfFastLeft;
+      uint64_t m_nextNs;
+  };
+} // end namespace Eet
+
+#endif // EET_HEARTBEAT_POLICY_H
@@ -51,6 +51,84 @@ namespace Eet {
         }
         return ret;
       }
+
+
+      // decimal digits of value without terminating zero, returns their number
+      static uint32_t toDecimal(char *buf, uint32_t value) {
+        char digits[10];
+        uint32_t n = 0U;
+        do {
+          digits[n++] = static_cast<char>('0' + value % 10U);
+          value /= 10U;
+        } while(0U != value);
+        for(uint32_t i = 0U; i < n; ++i) {
+          buf[i] = digits[n - 1U - i];
+        }
+        return n;
+      }
+
+      static uint32_t toDecimal(char *buf, uint64_t value) {
+        char digits[20];
+        uint32_t n = 0U;
+        do {
+          digits[n++] = static_cast<char>('0' + value % 10U);
+          value /= 10U;
+        } while(0U != value);
+        for(uint32_t i = 0U; i < n; ++i) {
+          buf[i] = digits[n - 1U - i];
+        }
+        return n;
+      }
+  };
+
+
+/**
+ * Fixed-size replacement of std::bitset for N <= 32 with the subset of its
+ * interface used by devices.
+ */
+  template<uint32_t N>
+  class BitSet {
+      static_assert(N <= 32U, "BitSet holds at most 32 bits");
+
+    public:
+      BitSet() : m_bits(0U) {}
+      BitSet(uint32_t bits) : m_bits(bits & MASK) {}
+
+      void set(uint32_t pos) {
+        assert(pos < N);
+        m_bits |= (1U << pos);
+      }
+
+      void reset(uint32_t pos) {
+        assert(pos < N);
+        m_bits &= ~(1U << pos);
+      }
+
+      void reset() {
+        m_bits = 0U;
+      }
+
+      bool test(uint32_t pos) const {
+        assert(pos < N);
+        return 0U != (m_bits & (1U << pos));
+      }
+
+      uint32_t count() const {
+        uint32_t ret = 0U;
+        for(uint32_t bits = m_bits; 0U != bits; bits &= bits - 1U) {
+          ++ret;
+        }
+        return ret;
+      }
+
+      uint32_t to_ulong() const {
+        return m_bits;
+      }
+
+    private:
+      static constexpr uint32_t MASK = (N == 32U) ? UINT32_MAX : ((1U << N) - 1U);
+
+      uint32_t m_bits;
   };
 } // end namespace Eet
 
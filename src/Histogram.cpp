@@ -0,0 +1,109 @@
+#include <cstring>
+
+#include "Histogram.h"
+
+namespace Eet {
+
+  Histogram::Histogram() {
+    reset();
+  }
+
+
+  uint32_t Histogram::index(uint64_t value) {
+    if(value < SUB_BUCKETS) {
+      return static_cast<uint32_t>(value);
+    }
+    auto msb = 63U - static_cast<uint32_t>(__builtin_clzll(value));
+    auto shift = msb - SUB_BITS;
+    return (shift + 1U) * SUB_BUCKETS +
+           static_cast<uint32_t>((value >> shift) & (SUB_BUCKETS - 1U));
+  }
+
+
+  uint64_t Histogram::upperBound(uint32_t index) {
+    if(index < SUB_BUCKETS) {
+      return index;
+    }
+    auto shift = index / SUB_BUCKETS - 1U;
+    uint64_t sub = (index % SUB_BUCKETS) | SUB_BUCKETS;
+    return ((sub + 1U) << shift) - 1U;
+  }
+
+
+  void Histogram::record(uint64_t value) {
+    ++ma_counts[index(value)];
+    ++m_count;
+    m_sum += value;
+    if(value < m_min) {
+      m_min = value;
+    }
+    if(value > m_max) {
+      m_max = value;
+    }
+  }
+
+
+  void Histogram::merge(const Histogram &other) {
+    for(uint32_t i = 0U; i < BUCKETS; ++i) {
+      ma_counts[i] += other.ma_counts[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    if(other.m_min < m_min) {
+      m_min = other.m_min;
+    }
+    if(other.m_max > m_max) {
+      m_max = other.m_max;
+    }
+  }
+
+
+  void Histogram::reset() {
+    std::memset(ma_counts, 0, sizeof(ma_counts));
+    m_count = 0U;
+    m_min = UINT64_MAX;
+    m_max = 0U;
+    m_sum = 0U;
+  }
+
+
+  uint64_t Histogram::getCount() const {
+    return m_count;
+  }
+
+
+  uint64_t Histogram::getMin() const {
+    return m_count ? m_min : 0U;
+  }
+
+
+  uint64_t Histogram::getMax() const {
+    return m_max;
+  }
+
+
+  uint64_t Histogram::getMean() const {
+    return m_count ? (m_sum / m_count) : 0U;
+  }
+
+
+  uint64_t Histogram::getPercentile(double percentile) const {
+    if(0U == m_count) {
+      return 0U;
+    }
+    auto rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(m_count) + 0.5);
+    if(0U == rank) {
+      rank = 1U;
+    }
+    uint64_t seen = 0U;
+    for(uint32_t i = 0U; i < BUCKETS; ++i) {
+      seen += ma_counts[i];
+      if(seen >= rank) {
+        auto ret = upperBound(i);
+        return (ret > m_max) ? m_max : ret;
+      }
+    }
+    return m_max;
+  }
+
+} // end namespace Eet
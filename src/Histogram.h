@@ -0,0 +1,42 @@
+#ifndef EET_HISTOGRAM_H
+#define EET_HISTOGRAM_H
+
+#include <cstdint>
+
+namespace Eet {
+/**
+ * Log-linear (HDR-style) histogram of non-negative values, e.g. latencies
+ * in nanoseconds. Each power of two is split into SUB_BUCKETS buckets, so
+ * relative error of any reported value is below 1/SUB_BUCKETS.
+ * Fixed size, no allocations, record() is O(1).
+ */
+  class Histogram {
+    public:
+      static constexpr uint32_t SUB_BITS = 4U;
+      static constexpr uint32_t SUB_BUCKETS = 1U << SUB_BITS;
+      static constexpr uint32_t BUCKETS = (64U - SUB_BITS + 1U) * SUB_BUCKETS;
+
+      Histogram();
+      void record(uint64_t value);
+      void merge(const Histogram &other);
+      void reset();
+
+      uint64_t getCount() const;
+      uint64_t getMin() const;
+      uint64_t getMax() const;
+      uint64_t getMean() const;
+      uint64_t getPercentile(double percentile) const; // 0.0 - 100.0
+
+    private:
+      static uint32_t index(uint64_t value);
+      static uint64_t upperBound(uint32_t index);
+
+      uint64_t ma_counts[BUCKETS];
+      uint64_t m_count;
+      uint64_t m_min;
+      uint64_t m_max;
+      uint64_t m_sum;
+  };
+} // end namespace Eet
+
+#endif // EET_HISTOGRAM_H
@@ -0,0 +1,354 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "LogIndex.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr char MAGIC_0 = 'E';
+    constexpr char MAGIC_1 = 'I';
+
+    static_assert(sizeof(LogIndex::Header) == 8U, "Header must not have padding");
+    static_assert(sizeof(LogIndex::Block) == 40U, "Block must not have padding");
+
+    bool writeAll(int fd, const void *buf, size_t size) {
+      auto *p = static_cast<const uint8_t *>(buf);
+      while(size > 0U) {
+        ssize_t ret = ::write(fd, p, size);
+        if(ret <= 0) {
+          return false;
+        }
+        p += ret;
+        size -= static_cast<size_t>(ret);
+      }
+      return true;
+    }
+
+    bool isHeaderValid(const LogIndex::Header &header) {
+      return (MAGIC_0 == header.ma_magic[0]) && (MAGIC_1 == header.ma_magic[1]) &&
+             (LogIndex::VERSION == header.m_version) &&
+             (sizeof(LogIndex::Block) == header.m_blockSize);
+    }
+  }
+
+
+  uint16_t LogIndex::getDeviceBit(char deviceId) {
+    if((deviceId < Protocol::DeviceId::MIN_DEVICE_ID) ||
+       (deviceId > Protocol::DeviceId::MAX_DEVICE_ID)) {
+      return 1U;
+    }
+    return static_cast<uint16_t>(1U << deviceId);
+  }
+
+
+  uint16_t LogIndex::getCmdTypeBit(Protocol::CmdType cmdType) {
+    if(cmdType > Protocol::CmdType::FULL_ASTERN) {
+      return static_cast<uint16_t>(1U << 15);
+    }
+    return static_cast<uint16_t>(1U << static_cast<uint8_t>(cmdType));
+  }
+
+
+  bool LogIndex::Query::isMatch(const Block &block) const {
+    return (block.m_lastNs >= m_fromNs) && (block.m_firstNs <= m_toNs) &&
+           ((0U == m_deviceMask) || (m_deviceMask & block.m_deviceMask)) &&
+           ((0U == m_cmdTypeMask) || (m_cmdTypeMask & block.m_cmdTypeMask)) &&
+           ((0U == m_errorMask) || (m_errorMask & block.m_errorMask));
+  }
+
+
+  LogIndex::Writer::Writer() :
+    m_fd(-1),
+    m_config{},
+    m_block{},
+    m_lastNs(0U),
+    m_endOffset(0U) {}
+
+
+  LogIndex::Writer::~Writer() {
+    close();
+  }
+
+
+  bool LogIndex::Writer::open(const char *path, Config config) {
+    close();
+    m_fd = ::open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(m_fd < 0) {
+      return false;
+    }
+    m_config = config;
+    struct stat st{};
+    if(0 != ::fstat(m_fd, &st)) {
+      close();
+      return false;
+    }
+
+    if(0 == st.st_size) {
+      Header header{{MAGIC_0, MAGIC_1}, VERSION,
+                    static_cast<uint8_t>(sizeof(Block)), 0U};
+      if(not writeAll(m_fd, &header, sizeof(header))) {
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    // continue existing index, drop a partially written entry if any
+    Header header{};
+    auto size = static_cast<uint64_t>(st.st_size);
+    if((size < sizeof(Header)) ||
+       (sizeof(header) != ::pread(m_fd, &header, sizeof(header), 0)) ||
+       (not isHeaderValid(header))) {
+      close();
+      return false;
+    }
+    uint64_t numOfBlocks = (size - sizeof(Header)) / sizeof(Block);
+    uint64_t validSize = sizeof(Header) + numOfBlocks * sizeof(Block);
+    if((validSize != size) && (0 != ::ftruncate(m_fd, static_cast<off_t>(validSize)))) {
+      close();
+      return false;
+    }
+    if(numOfBlocks > 0U) {
+      Block last{};
+      if(sizeof(last) != ::pread(m_fd, &last, sizeof(last),
+                                 static_cast<off_t>(validSize - sizeof(Block)))) {
+        close();
+        return false;
+      }
+      m_lastNs = last.m_lastNs;
+      m_endOffset = last.m_offset + last.m_size;
+    }
+    return true;
+  }
+
+
+  void LogIndex::Writer::close() {
+    if(m_fd >= 0) {
+      flush();
+      ::close(m_fd);
+      m_fd = -1;
+    }
+    m_block = Block{};
+    m_lastNs = 0U;
+    m_endOffset = 0U;
+  }
+
+
+  bool LogIndex::Writer::isOpen() const {
+    return m_fd >= 0;
+  }
+
+
+  bool LogIndex::Writer::add(uint64_t timeNs, uint64_t offset, uint32_t size,
+                             uint16_t deviceMask, Protocol::CmdType cmdType,
+                             char errors) {
+    if(not isOpen()) {
+      return false;
+    }
+    if(timeNs < m_lastNs) {
+      timeNs = m_lastNs;
+    }
+    bool ret = true;
+    if((m_block.m_numOfRecords > 0U) &&
+       ((offset + size - m_block.m_offset > m_config.m_maxBlockSize) ||
+        (timeNs - m_block.m_firstNs > m_config.m_maxBlockNs))) {
+      ret = flush();
+    }
+    if(0U == m_block.m_numOfRecords) {
+      m_block.m_firstNs = timeNs;
+      m_block.m_offset = offset;
+    }
+    m_block.m_lastNs = timeNs;
+    m_block.m_size = static_cast<uint32_t>(offset + size - m_block.m_offset);
+    ++m_block.m_numOfRecords;
+    m_block.m_deviceMask |= deviceMask;
+    m_block.m_cmdTypeMask |= getCmdTypeBit(cmdType);
+    m_block.m_errorMask |= static_cast<uint8_t>(errors);
+    m_lastNs = timeNs;
+    m_endOffset = offset + size;
+    return ret;
+  }
+
+
+  bool LogIndex::Writer::addLine(uint64_t timeNs, uint64_t offset,
+                                 const char *line, uint32_t size) {
+    LogRecord record{};
+    if(not LogParser::parse(line, size, record)) {
+      return false;
+    }
+    if(0U == timeNs) {
+      timeNs = record.m_timeNs;
+    }
+    uint16_t deviceMask = getDeviceBit(record.m_deviceId);
+    if('O' == record.m_type) {
+      deviceMask |= getDeviceBit(record.m_otherDeviceId);
+    }
+    return add(timeNs, offset, size, deviceMask, record.m_cmdType, record.m_errors);
+  }
+
+
+  bool LogIndex::Writer::flush() {
+    if((not isOpen()) || (0U == m_block.m_numOfRecords)) {
+      return true;
+    }
+    bool ret = writeAll(m_fd, &m_block, sizeof(m_block));
+    m_block = Block{};
+    return ret;
+  }
+
+
+  uint64_t LogIndex::Writer::getEndOffset() const {
+    return m_endOffset;
+  }
+
+
+  LogIndex::Reader::Reader() :
+    m_index{-1, nullptr, 0U},
+    m_log{-1, nullptr, 0U},
+    m_blocks(nullptr),
+    m_numOfBlocks(0U) {}
+
+
+  LogIndex::Reader::~Reader() {
+    close();
+  }
+
+
+  bool LogIndex::Reader::open(const char *indexPath, const char *logPath) {
+    close();
+    m_index.m_fd = ::open(indexPath, O_RDONLY | O_CLOEXEC);
+    if(m_index.m_fd < 0) {
+      return false;
+    }
+    if(nullptr != logPath) {
+      m_log.m_fd = ::open(logPath, O_RDONLY | O_CLOEXEC);
+      if(m_log.m_fd < 0) {
+        close();
+        return false;
+      }
+    }
+    if(not refresh()) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+
+  void LogIndex::Reader::close() {
+    unmap(m_index);
+    unmap(m_log);
+    if(m_index.m_fd >= 0) {
+      ::close(m_index.m_fd);
+      m_index.m_fd = -1;
+    }
+    if(m_log.m_fd >= 0) {
+      ::close(m_log.m_fd);
+      m_log.m_fd = -1;
+    }
+    m_blocks = nullptr;
+    m_numOfBlocks = 0U;
+  }
+
+
+  bool LogIndex::Reader::refresh() {
+    if((not map(m_index)) || ((m_log.m_fd >= 0) && (not map(m_log)))) {
+      return false;
+    }
+    if((m_index.m_size < sizeof(Header)) ||
+       (not isHeaderValid(*reinterpret_cast<const Header *>(m_index.m_data)))) {
+      return false;
+    }
+    m_blocks = reinterpret_cast<const Block *>(m_index.m_data + sizeof(Header));
+    m_numOfBlocks = static_cast<uint32_t>((m_index.m_size - sizeof(Header)) / sizeof(Block));
+    return true;
+  }
+
+
+  uint32_t LogIndex::Reader::getNumOfBlocks() const {
+    return m_numOfBlocks;
+  }
+
+
+  const LogIndex::Block &LogIndex::Reader::getBlock(uint32_t i) const {
+    return m_blocks[i];
+  }
+
+
+  uint32_t LogIndex::Reader::lowerBound(uint64_t timeNs) const {
+    uint32_t lo = 0U;
+    uint32_t hi = m_numOfBlocks;
+    while(lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2U;
+      if(m_blocks[mid].m_lastNs < timeNs) {
+        lo = mid + 1U;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+
+  uint32_t LogIndex::Reader::next(const Query &query, uint32_t i) const {
+    for(; i < m_numOfBlocks; ++i) {
+      if(m_blocks[i].m_firstNs > query.m_toNs) {
+        return m_numOfBlocks;
+      }
+      if(query.isMatch(m_blocks[i])) {
+        return i;
+      }
+    }
+    return m_numOfBlocks;
+  }
+
+
+  uint32_t LogIndex::Reader::first(const Query &query) const {
+    return next(query, lowerBound(query.m_fromNs));
+  }
+
+
+  const char *LogIndex::Reader::getData(const Block &block) const {
+    if((nullptr == m_log.m_data) || (block.m_offset + block.m_size > m_log.m_size)) {
+      return nullptr;
+    }
+    return reinterpret_cast<const char *>(m_log.m_data + block.m_offset);
+  }
+
+
+  bool LogIndex::Reader::map(File &file) {
+    struct stat st{};
+    if(0 != ::fstat(file.m_fd, &st)) {
+      return false;
+    }
+    auto size = static_cast<uint64_t>(st.st_size);
+    if((nullptr != file.m_data) && (size == file.m_size)) {
+      return true;
+    }
+    unmap(file);
+    if(0U == size) {
+      return true;
+    }
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file.m_fd, 0);
+    if(MAP_FAILED == data) {
+      return false;
+    }
+    file.m_data = static_cast<const uint8_t *>(data);
+    file.m_size = size;
+    return true;
+  }
+
+
+  void LogIndex::Reader::unmap(File &file) {
+    if(nullptr != file.m_data) {
+      ::munmap(const_cast<uint8_t *>(file.m_data), file.m_size);
+      file.m_data = nullptr;
+    }
+    file.m_size = 0U;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,147 @@
+#ifndef EET_LOG_INDEX_H
+#define EET_LOG_INDEX_H
+
+#include <cstdint>
+
+#include "LogParser.h"
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Sidecar index for log files.
+ *
+ * Log is split into blocks of consecutive records, every block gets one
+ * fixed-size Block entry in the index file:
+ *   time range, byte range in the log, masks of device ids, cmd types
+ *   and error bits of its records.
+ * Blocks are ordered by time, so Reader finds the first block of a time
+ * window with binary search and skips blocks which can not match device,
+ * cmd type or error bit of the Query without touching the log itself.
+ *
+ * The index does not depend on log format: Writer::add() takes offset,
+ * size and fields of any record, Writer::addLine() parses ASCII log lines.
+ * Index file is append-only, completed blocks become visible to
+ * Reader::refresh() while the log is being written.
+ *
+ * File layout (host byte order): Header, then Block entries.
+ */
+  namespace LogIndex {
+    struct Header {
+      char ma_magic[2]; // "EI"
+      uint8_t m_version;
+      uint8_t m_blockSize; // sizeof(Block)
+      uint32_t m_reserve;
+    };
+
+    struct Block {
+      uint64_t m_firstNs;
+      uint64_t m_lastNs;
+      uint64_t m_offset;
+      uint32_t m_size;
+      uint32_t m_numOfRecords;
+      uint16_t m_deviceMask;  // see getDeviceBit()
+      uint16_t m_cmdTypeMask; // see getCmdTypeBit()
+      uint8_t m_errorMask;    // Protocol::ErrorBit
+      uint8_t ma_reserve[3];
+    };
+
+    constexpr uint8_t VERSION = 1U;
+
+    // bit 0 is for invalid ids
+    uint16_t getDeviceBit(char deviceId);
+    // bit 15 is for INVALID
+    uint16_t getCmdTypeBit(Protocol::CmdType cmdType);
+
+    /**
+     * Zero mask matches any block, otherwise a block matches if it has
+     * any of the bits of the mask.
+     */
+    struct Query {
+      uint64_t m_fromNs;
+      uint64_t m_toNs;
+      uint16_t m_deviceMask;
+      uint16_t m_cmdTypeMask;
+      uint8_t m_errorMask;
+
+      bool isMatch(const Block &block) const;
+    };
+
+    class Writer {
+      public:
+        struct Config {
+          uint32_t m_maxBlockSize; // bytes of log
+          uint64_t m_maxBlockNs;   // time span of a block
+        };
+
+        Writer();
+        ~Writer();
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        // appends to existing index, offsets continue from its last block
+        bool open(const char *path, Config config = {64U * 1024U, 1000000000ULL});
+        void close();
+        bool isOpen() const;
+
+        /**
+         * Records must be added in log order, time must not decrease
+         * (decreasing time is clamped to keep blocks ordered).
+         */
+        bool add(uint64_t timeNs, uint64_t offset, uint32_t size,
+                 uint16_t deviceMask, Protocol::CmdType cmdType, char errors);
+        // time from the line (if any) is used when timeNs is 0
+        bool addLine(uint64_t timeNs, uint64_t offset, const char *line, uint32_t size);
+        // writes current block, e.g. before Reader has to see it
+        bool flush();
+
+        uint64_t getEndOffset() const;
+
+      private:
+        int m_fd;
+        Config m_config;
+        Block m_block;
+        uint64_t m_lastNs;
+        uint64_t m_endOffset;
+    };
+
+    class Reader {
+      public:
+        Reader();
+        ~Reader();
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        // log is optional, without it getData() returns nullptr
+        bool open(const char *indexPath, const char *logPath = nullptr);
+        void close();
+        // maps blocks and log data written after open()
+        bool refresh();
+
+        uint32_t getNumOfBlocks() const;
+        const Block &getBlock(uint32_t i) const;
+        // first block which ends at or after timeNs
+        uint32_t lowerBound(uint64_t timeNs) const;
+        // next matching block starting from i, getNumOfBlocks() if none
+        uint32_t next(const Query &query, uint32_t i) const;
+        uint32_t first(const Query &query) const;
+        const char *getData(const Block &block) const;
+
+      private:
+        struct File {
+          int m_fd;
+          const uint8_t *m_data;
+          uint64_t m_size;
+        };
+
+        static bool map(File &file);
+        static void unmap(File &file);
+
+        File m_index;
+        File m_log;
+        const Block *m_blocks;
+        uint32_t m_numOfBlocks;
+    };
+  } // end namespace LogIndex
+} // end namespace Eet
+
+#endif // EET_LOG_INDEX_H
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "LogMerger.h"
+#include "LogParser.h"
+
+namespace Eet {
+
+  namespace {
+    struct Cursor {
+      uint64_t m_timeNs;
+      uint32_t m_log;
+      const char *m_pos;
+      const char *m_lineEnd;
+      const char *m_end;
+
+      bool operator<(const Cursor &other) const {
+        return (m_timeNs < other.m_timeNs) ||
+               ((m_timeNs == other.m_timeNs) && (m_log < other.m_log));
+      }
+    };
+
+    const char *findLineEnd(const char *pos, const char *end) {
+      auto newLine = static_cast<const char *>(std::memchr(pos, '\n', static_cast<size_t>(end - pos)));
+      return (nullptr == newLine) ? end : newLine + 1;
+    }
+
+    // last line has no '\n', merged output gets one after it
+    bool isUnterminated(const char *data, uint64_t size) {
+      return (size > 0U) && ('\n' != data[size - 1U]);
+    }
+
+    uint64_t getTime(const char *pos, const char *lineEnd) {
+      return LogParser::getTime(pos, static_cast<uint32_t>(lineEnd - pos));
+    }
+
+    // time of the first line with time which starts at or after pos, UINT64_MAX if none
+    uint64_t getTimeAfter(const char *data, uint64_t size, uint64_t pos) {
+      const char *end = data + size;
+      const char *p = data + pos;
+      if((0U != pos) && ('\n' != data[pos - 1U])) {
+        p = findLineEnd(p, end);
+      }
+      while(p < end) {
+        auto lineEnd = findLineEnd(p, end);
+        auto timeNs = getTime(p, lineEnd);
+        if(0U != timeNs) {
+          return timeNs;
+        }
+        p = lineEnd;
+      }
+      return UINT64_MAX;
+    }
+
+    void siftDown(Cursor *heap, uint32_t size) {
+      uint32_t i = 0U;
+      while(true) {
+        uint32_t least = i;
+        uint32_t left = 2U * i + 1U;
+        uint32_t right = left + 1U;
+        if((left < size) && (heap[left] < heap[least])) {
+          least = left;
+        }
+        if((right < size) && (heap[right] < heap[least])) {
+          least = right;
+        }
+        if(least == i) {
+          return;
+        }
+        std::swap(heap[i], heap[least]);
+        i = least;
+      }
+    }
+  }
+
+
+  LogMerger::LogMerger() :
+    ma_logs{},
+    m_numOfLogs(0U),
+    m_size(0U),
+    m_numOfLines(0U),
+    m_numOfSlices(0U) {}
+
+
+  LogMerger::~LogMerger() {
+    close();
+  }
+
+
+  bool LogMerger::add(const char *path) {
+    if(m_numOfLogs >= MAX_LOGS) {
+      return false;
+    }
+    auto &log = ma_logs[m_numOfLogs];
+    log = {::open(path, O_RDONLY | O_CLOEXEC), nullptr, 0U};
+    if(log.m_fd < 0) {
+      return false;
+    }
+    struct stat st{};
+    if(0 != ::fstat(log.m_fd, &st)) {
+      ::close(log.m_fd);
+      return false;
+    }
+    log.m_size = static_cast<uint64_t>(st.st_size);
+    if(log.m_size > 0U) {
+      void *data = ::mmap(nullptr, log.m_size, PROT_READ, MAP_SHARED, log.m_fd, 0);
+      if(MAP_FAILED == data) {
+        ::close(log.m_fd);
+        return false;
+      }
+      ::madvise(data, log.m_size, MADV_SEQUENTIAL);
+      log.m_data = static_cast<const char *>(data);
+    }
+    m_size += log.m_size + (isUnterminated(log.m_data, log.m_size) ? 1U : 0U);
+    ++m_numOfLogs;
+    return true;
+  }
+
+
+  void LogMerger::close() {
+    for(uint32_t i = 0U; i < m_numOfLogs; ++i) {
+      auto &log = ma_logs[i];
+      if(nullptr != log.m_data) {
+        ::munmap(const_cast<char *>(log.m_data), log.m_size);
+      }
+      ::close(log.m_fd);
+      log = {-1, nullptr, 0U};
+    }
+    m_numOfLogs = 0U;
+    m_size = 0U;
+  }
+
+
+  uint64_t LogMerger::lowerBound(const Log &log, uint64_t timeNs) const {
+    // the first timed line with time >= timeNs, untimed lines before it
+    // stay with the previous timed line
+    uint64_t lo = 0U;
+    uint64_t hi = log.m_size;
+    while(lo < hi) {
+      uint64_t mid = lo + (hi - lo) / 2U;
+      if(getTimeAfter(log.m_data, log.m_size, mid) >= timeNs) {
+        hi = mid;
+      } else {
+        lo = mid + 1U;
+      }
+    }
+    const char *end = log.m_data + log.m_size;
+    const char *p = log.m_data + lo;
+    if((0U != lo) && ('\n' != log.m_data[lo - 1U])) {
+      p = findLineEnd(p, end);
+    }
+    while(p < end) {
+      auto lineEnd = findLineEnd(p, end);
+      if(0U != getTime(p, lineEnd)) {
+        break;
+      }
+      p = lineEnd;
+    }
+    return static_cast<uint64_t>(p - log.m_data);
+  }
+
+
+  uint64_t LogMerger::mergeSlice(uint32_t slice, char *out) const {
+    Cursor heap[MAX_LOGS];
+    uint32_t size = 0U;
+    for(uint32_t i = 0U; i < m_numOfLogs; ++i) {
+      auto begin = ma_bounds[i][slice];
+      auto end = ma_bounds[i][slice + 1U];
+      if(begin < end) {
+        auto pos = ma_logs[i].m_data + begin;
+        auto lineEnd = findLineEnd(pos, ma_logs[i].m_data + end);
+        // only the first slice may start with untimed lines, they go first
+        heap[size++] = {getTime(pos, lineEnd), i, pos, lineEnd, ma_logs[i].m_data + end};
+      }
+    }
+    std::make_heap(heap, heap + size, [](const Cursor &a, const Cursor &b) { return b < a; });
+
+    uint64_t numOfLines = 0U;
+    while(size > 0U) {
+      auto &top = heap[0];
+      auto lineSize = static_cast<size_t>(top.m_lineEnd - top.m_pos);
+      std::memcpy(out, top.m_pos, lineSize);
+      out += lineSize;
+      if((top.m_lineEnd == top.m_end) && ('\n' != top.m_lineEnd[-1])) {
+        *out++ = '\n'; // the last line of the log, see isUnterminated()
+      }
+      ++numOfLines;
+      top.m_pos = top.m_lineEnd;
+      if(top.m_pos == top.m_end) {
+        top = heap[--size];
+      } else {
+        top.m_lineEnd = findLineEnd(top.m_pos, top.m_end);
+        // untimed line keeps time of the previous one
+        auto timeNs = getTime(top.m_pos, top.m_lineEnd);
+        if(0U != timeNs) {
+          top.m_timeNs = timeNs;
+        }
+      }
+      siftDown(heap, size);
+    }
+    return numOfLines;
+  }
+
+
+  bool LogMerger::merge(const char *outPath, uint32_t numOfThreads) {
+    numOfThreads = (0U == numOfThreads) ? 1U :
+                   (numOfThreads > MAX_THREADS) ? MAX_THREADS : numOfThreads;
+    m_numOfLines = 0U;
+
+    // slices of about the same number of sampled lines
+    uint32_t numOfSamples = 0U;
+    for(uint32_t i = 0U; i < m_numOfLogs; ++i) {
+      for(uint32_t s = 0U; (s < SAMPLES_PER_LOG) && (ma_logs[i].m_size > 0U); ++s) {
+        auto timeNs = getTimeAfter(ma_logs[i].m_data, ma_logs[i].m_size,
+                                   ma_logs[i].m_size * s / SAMPLES_PER_LOG);
+        if(UINT64_MAX != timeNs) {
+          ma_samples[numOfSamples++] = timeNs;
+        }
+      }
+    }
+    std::sort(ma_samples, ma_samples + numOfSamples);
+    m_numOfSlices = (numOfSamples > 0U) ? numOfThreads : 1U;
+    for(uint32_t i = 0U; i < m_numOfLogs; ++i) {
+      ma_bounds[i][0] = 0U;
+      for(uint32_t k = 1U; k < m_numOfSlices; ++k) {
+        auto bound = lowerBound(ma_logs[i], ma_samples[numOfSamples * k / m_numOfSlices]);
+        ma_bounds[i][k] = std::max(bound, ma_bounds[i][k - 1U]);
+      }
+      ma_bounds[i][m_numOfSlices] = ma_logs[i].m_size;
+    }
+
+    int fd = ::open(outPath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) {
+      return false;
+    }
+    if(0U == m_size) {
+      ::close(fd);
+      return true;
+    }
+    void *data = MAP_FAILED;
+    if(0 == ::ftruncate(fd, static_cast<off_t>(m_size))) {
+      data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if(MAP_FAILED == data) {
+      ::close(fd);
+      return false;
+    }
+
+    auto out = static_cast<char *>(data);
+    std::thread threads[MAX_THREADS];
+    uint64_t numOfLines[MAX_THREADS] = {};
+    uint64_t offset = 0U;
+    for(uint32_t k = 0U; k < m_numOfSlices; ++k) {
+      if(k > 0U) {
+        threads[k] = std::thread([this, k, out, offset, &numOfLines]() {
+          numOfLines[k] = mergeSlice(k, out + offset);
+        });
+      }
+      for(uint32_t i = 0U; i < m_numOfLogs; ++i) {
+        auto begin = ma_bounds[i][k];
+        auto end = ma_bounds[i][k + 1U];
+        offset += end - begin;
+        offset += ((begin < end) && (end == ma_logs[i].m_size) &&
+                   isUnterminated(ma_logs[i].m_data, end)) ? 1U : 0U;
+      }
+    }
+    numOfLines[0] = mergeSlice(0U, out);
+    for(uint32_t k = 0U; k < m_numOfSlices; ++k) {
+      if(threads[k].joinable()) {
+        threads[k].join();
+      }
+      m_numOfLines += numOfLines[k];
+    }
+
+    ::munmap(data, m_size);
+    return 0 == ::close(fd);
+  }
+
+
+  uint32_t LogMerger::getNumOfLogs() const {
+    return m_numOfLogs;
+  }
+
+
+  uint64_t LogMerger::getSize() const {
+    return m_size;
+  }
+
+
+  uint64_t LogMerger::getNumOfLines() const {
+    return m_numOfLines;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,66 @@
+#ifndef EET_LOG_MERGER_H
+#define EET_LOG_MERGER_H
+
+#include <cstdint>
+
+namespace Eet {
+/**
+ * Merges logs of several devices into one time-ordered log.
+ *
+ * Every log has to be ordered by time itself (<TimeNs> field, see
+ * LogMsg::setTimeNs() and WallClock), lines without time stay right after
+ * the previous line of their log. Lines are copied as is, a log which
+ * does not end with '\n' gets one after its last line.
+ *
+ * Logs are memory-mapped. Time range is split into slices at times
+ * sampled from the logs and every slice boundary is found in every log
+ * with binary search, so the output size and offset of every slice are
+ * known before merging. Slices are then merged by threads at once, each
+ * with k-way merge (binary heap of logs) straight into its part of the
+ * memory-mapped output file.
+ *
+ * Instance is large, do not put it on stack.
+ */
+  class LogMerger {
+    public:
+      static constexpr uint32_t MAX_LOGS = 1024U;
+      static constexpr uint32_t MAX_THREADS = 64U;
+
+      LogMerger();
+      ~LogMerger();
+      LogMerger(const LogMerger &) = delete;
+      LogMerger &operator=(const LogMerger &) = delete;
+
+      bool add(const char *path); // false if log can not be mapped or too many logs
+      void close();
+      // output is created or truncated
+      bool merge(const char *outPath, uint32_t numOfThreads = 1U);
+
+      uint32_t getNumOfLogs() const;
+      uint64_t getSize() const; // of all logs, with '\n' after unterminated ones
+      uint64_t getNumOfLines() const; // of the last merge()
+
+    private:
+      struct Log {
+        int m_fd;
+        const char *m_data;
+        uint64_t m_size;
+      };
+
+      static constexpr uint32_t SAMPLES_PER_LOG = 16U;
+
+      uint64_t lowerBound(const Log &log, uint64_t timeNs) const;
+      uint64_t mergeSlice(uint32_t slice, char *out) const;
+
+      Log ma_logs[MAX_LOGS];
+      uint32_t m_numOfLogs;
+      uint64_t m_size;
+      uint64_t m_numOfLines;
+      uint32_t m_numOfSlices;
+      // byte offset where slice begins, by log
+      uint64_t ma_bounds[MAX_LOGS][MAX_THREADS + 1U];
+      uint64_t ma_samples[MAX_LOGS * SAMPLES_PER_LOG];
+  };
+} // end namespace Eet
+
+#endif // EET_LOG_MERGER_H
@@ -0,0 +1,175 @@
+#include <cstring>
+
+#include "LogParser.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr uint32_t MAX_FIELDS = 20U;
+
+    struct Field {
+      const char *m_begin;
+      uint32_t m_size;
+
+      bool is(const char *str) const {
+        return (std::strlen(str) == m_size) && (0 == std::memcmp(m_begin, str, m_size));
+      }
+    };
+
+    char parseId(const Field &field) {
+      if((0U == field.m_size) || (field.m_size > 2U)) {
+        return Protocol::DeviceId::INVALID;
+      }
+      uint32_t id = 0U;
+      for(uint32_t i = 0U; i < field.m_size; ++i) {
+        if((field.m_begin[i] < '0') || (field.m_begin[i] > '9')) {
+          return Protocol::DeviceId::INVALID;
+        }
+        id = id * 10U + static_cast<uint32_t>(field.m_begin[i] - '0');
+      }
+      return static_cast<char>(id);
+    }
+
+    uint64_t parseTime(const Field &field) {
+      uint64_t ret = 0U;
+      for(uint32_t i = 0U; i < field.m_size; ++i) {
+        if((field.m_begin[i] < '0') || (field.m_begin[i] > '9')) {
+          return 0U;
+        }
+        ret = ret * 10U + static_cast<uint64_t>(field.m_begin[i] - '0');
+      }
+      return ret;
+    }
+
+    Protocol::DeviceType parseDeviceType(const Field &field) {
+      if(field.is("MASTER")) {
+        return Protocol::DeviceType::MASTER;
+      }
+      if(field.is("SLAVE")) {
+        return Protocol::DeviceType::SLAVE;
+      }
+      return Protocol::DeviceType::INVALID;
+    }
+
+    Protocol::SlaveState parseSlaveState(const Field &field) {
+      if(field.is("ACTIVE")) {
+        return Protocol::SlaveState::ACTIVE;
+      }
+      if(field.is("NOT_ACTIVE")) {
+        return Protocol::SlaveState::NOT_ACTIVE;
+      }
+      return Protocol::SlaveState::INVALID;
+    }
+
+    Protocol::ApproveState parseApproveState(const Field &field) {
+      if(field.is("APPROVED")) {
+        return Protocol::ApproveState::APPROVED;
+      }
+      if(field.is("NOT_APPROVED")) {
+        return Protocol::ApproveState::NOT_APPROVED;
+      }
+      return Protocol::ApproveState::INVALID;
+    }
+
+    Protocol::CmdType parseCmdType(const Field &field) {
+      // T lines print DEAD_SLOW_AHEAD as SLOWEST_AHEAD
+      const char *names[] = {
+        "COMPLETE", "GET_READY", "FULL_AHEAD", "HALF_AHEAD", "SLOW_AHEAD",
+        "DEAD_SLOW_AHEAD", "STOP", "DEAD_SLOW_ASTERN", "SLOW_ASTERN",
+        "HALF_ASTERN", "FULL_ASTERN"
+      };
+      for(uint32_t i = 0U; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if(field.is(names[i])) {
+          return static_cast<Protocol::CmdType>(i);
+        }
+      }
+      if(field.is("SLOWEST_AHEAD")) {
+        return Protocol::CmdType::DEAD_SLOW_AHEAD;
+      }
+      return Protocol::CmdType::INVALID;
+    }
+
+    char parseErrors(const Field *fields) {
+      char ret = 0;
+      for(uint32_t bit = 0U; bit <= Protocol::NO_ACTIVE_SLAVE; ++bit) {
+        ret |= ((0U != fields[bit].m_size) << bit);
+      }
+      return ret;
+    }
+  }
+
+
+  char LogRecord::getSubjectId() const {
+    return ('O' == m_type) ? m_otherDeviceId : m_deviceId;
+  }
+
+
+  uint64_t LogParser::getTime(const char *line, uint32_t size) {
+    // the last field is the time if it has digits only, other fields which
+    // may be the last one (CmdType and empty) have none
+    while((size > 0U) && (('\n' == line[size - 1U]) || ('\r' == line[size - 1U]))) {
+      --size;
+    }
+    if((0U == size) || (',' != line[size - 1U])) {
+      return 0U;
+    }
+    uint32_t begin = size - 1U;
+    while((begin > 0U) && (line[begin - 1U] >= '0') && (line[begin - 1U] <= '9')) {
+      --begin;
+    }
+    if((begin == size - 1U) || (0U == begin) || (',' != line[begin - 1U])) {
+      return 0U;
+    }
+    return parseTime({line + begin, size - 1U - begin});
+  }
+
+
+  bool LogParser::parse(const char *line, uint32_t size, LogRecord &record) {
+    if((size < 3U) || ('$' != line[0]) || ((',' != line[2]))) {
+      return false;
+    }
+    Field fields[MAX_FIELDS];
+    uint32_t numOfFields = 0U;
+    const char *begin = line + 1;
+    const char *end = line + size;
+    for(const char *p = begin; (p < end) && (numOfFields < MAX_FIELDS); ++p) {
+      if(',' == *p) {
+        fields[numOfFields++] = {begin, static_cast<uint32_t>(p - begin)};
+        begin = p + 1;
+      }
+    }
+
+    record.m_type = line[1];
+    record.m_timeNs = 0U;
+    if(('O' == record.m_type) && (numOfFields >= 17U)) {
+      record.m_deviceId = parseId(fields[1]);
+      record.m_canId = (1U == fields[2].m_size) ? fields[2].m_begin[0] : 0;
+      record.m_otherDeviceId = parseId(fields[4]);
+      record.m_deviceType = parseDeviceType(fields[6]);
+      record.m_errors = parseErrors(fields + 7);
+      record.m_slaveState = parseSlaveState(fields[14]);
+      record.m_approveState = parseApproveState(fields[15]);
+      record.m_cmdType = parseCmdType(fields[16]);
+      if(numOfFields > 17U) {
+        record.m_timeNs = parseTime(fields[17]);
+      }
+      return true;
+    }
+    if(('T' == record.m_type) && (numOfFields >= 13U)) {
+      record.m_deviceId = parseId(fields[1]);
+      record.m_canId = 0;
+      record.m_otherDeviceId = Protocol::DeviceId::INVALID;
+      record.m_deviceType = parseDeviceType(fields[2]);
+      record.m_errors = parseErrors(fields + 3);
+      record.m_slaveState = parseSlaveState(fields[10]);
+      record.m_approveState = parseApproveState(fields[11]);
+      record.m_cmdType = parseCmdType(fields[12]);
+      if(numOfFields > 13U) {
+        record.m_timeNs = parseTime(fields[13]);
+      }
+      return true;
+    }
+    return false;
+  }
+
+} // end namespace Eet
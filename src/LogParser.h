@@ -0,0 +1,39 @@
+#ifndef EET_LOG_PARSER_H
+#define EET_LOG_PARSER_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Fields of one ASCII log line (see doc/protocol.md, Log messages).
+ * For O lines state fields describe the other device, for T lines - this one.
+ * Empty fields are INVALID.
+ */
+  struct LogRecord {
+    char m_type; // 'O' or 'T'
+    char m_deviceId;      // tDeviceId
+    char m_otherDeviceId; // oDeviceId, INVALID for T lines
+    char m_canId;         // 'A', 'H', 'C', 0 for T lines or invalid CAN ID
+    Protocol::DeviceType m_deviceType;
+    char m_errors;
+    Protocol::SlaveState m_slaveState;
+    Protocol::ApproveState m_approveState;
+    Protocol::CmdType m_cmdType;
+    uint64_t m_timeNs; // 0 if line has no timestamp
+
+    // device which state is described by the line
+    char getSubjectId() const;
+  };
+
+  class LogParser {
+    public:
+      // false if line is not a log line, size may include "\r\n"
+      static bool parse(const char *line, uint32_t size, LogRecord &record);
+      // <TimeNs> of the line without parsing other fields, 0 if none
+      static uint64_t getTime(const char *line, uint32_t size);
+  };
+} // end namespace Eet
+
+#endif // EET_LOG_PARSER_H
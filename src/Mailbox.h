@@ -0,0 +1,72 @@
+#ifndef EET_MAILBOX_H
+#define EET_MAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Eet {
+  constexpr uint32_t CACHE_LINE_SIZE = 64U;
+
+/**
+ * Bounded lock-free queue, many producers and single consumer.
+ * Producers and consumer indexes live on separate cache lines.
+ */
+  template<typename T, uint32_t N>
+  class Mailbox {
+      static_assert((N >= 2U) && (0U == (N & (N - 1U))), "N must be power of two");
+    public:
+      Mailbox() :
+        m_head(0U),
+        m_tail(0U) {
+        for(uint32_t i = 0U; i < N; ++i) {
+          ma_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+      }
+
+      // any thread, false if mailbox is full
+      bool push(const T &value) {
+        auto pos = m_head.load(std::memory_order_relaxed);
+        while(true) {
+          auto &cell = ma_cells[pos & (N - 1U)];
+          auto sequence = cell.m_sequence.load(std::memory_order_acquire);
+          auto diff = static_cast<int32_t>(sequence - pos);
+          if(0 == diff) {
+            if(m_head.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+              cell.m_value = value;
+              cell.m_sequence.store(pos + 1U, std::memory_order_release);
+              return true;
+            }
+          } else if(diff < 0) {
+            return false;
+          } else {
+            pos = m_head.load(std::memory_order_relaxed);
+          }
+        }
+      }
+
+      // consumer thread only, false if mailbox is empty
+      bool pop(T &value) {
+        auto &cell = ma_cells[m_tail & (N - 1U)];
+        auto sequence = cell.m_sequence.load(std::memory_order_acquire);
+        if(sequence != m_tail + 1U) {
+          return false;
+        }
+        value = cell.m_value;
+        cell.m_sequence.store(m_tail + N, std::memory_order_release);
+        ++m_tail;
+        return true;
+      }
+
+    private:
+      struct Cell {
+        std::atomic<uint32_t> m_sequence;
+        T m_value;
+      };
+
+      Cell ma_cells[N];
+      alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> m_head;
+      alignas(CACHE_LINE_SIZE) uint32_t m_tail;
+  };
+} // end namespace Eet
+
+#endif // EET_MAILBOX_H
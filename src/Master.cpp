@@ -1,4 +1,5 @@
 #include "Device.h"
+#include "Tracer.h"
 
 namespace Eet {
 
@@ -15,8 +16,8 @@ namespace Eet {
     switch(msg.m_commonFields.m_deviceType) {
       case Protocol::DeviceType::SLAVE: {
         if(Protocol::SlaveState::ACTIVE == msg.m_slaveState) {
-          setCmdType(msg.m_cmdType);
-          m_approveState = msg.m_approveState;
+          storeCmdType(msg.m_cmdType);
+          storeApproveState(msg.m_approveState);
           ma_activeSlaves.set(static_cast<size_t>(msg.m_commonFields.m_deviceId - 1));
         } else {
           ma_activeSlaves.reset(static_cast<size_t>(msg.m_commonFields.m_deviceId - 1));
@@ -33,8 +34,8 @@ namespace Eet {
 
 
   void Master::pushCmd(const Protocol::Msg::Cmd &msg) {
-    setCmdType(msg.m_cmdType);
-    m_approveState = Protocol::ApproveState::NOT_APPROVED;
+    storeCmdType(msg.m_cmdType);
+    storeApproveState(Protocol::ApproveState::NOT_APPROVED);
   }
 
 
@@ -46,6 +47,7 @@ namespace Eet {
 
   void Master::setDeviceId(char id) {
     m_deviceId = id;
+    clearHeartbeatCache();
   }
 
 
@@ -60,30 +62,29 @@ namespace Eet {
 
 
   void Master::update() {
+    EET_TRACE_SPAN(span, "update", m_deviceId);
     using Protocol::SlaveState;
 
-    m_errors = 0; // wipe errors
-    m_errors |= (isDuplicatedDeviceId() << Protocol::DUPLICATED_DEVICE_ID);
-    m_errors |= (isConWithSomeSlavesLost() << Protocol::CON_WITH_SOME_SLAVES_LOST);
-    m_errors |= (isConWithAllSlavesLost() << Protocol::CON_WITH_ALL_SLAVES_LOST);
-    m_errors |= (isConWithSomeMastersLost() << Protocol::CON_WITH_SOME_MASTERS_LOST);
-    m_errors |= (isConWithAllMastersLost() << Protocol::CON_WITH_ALL_MASTERS_LOST);
-    m_errors |= (isNoConnection() << Protocol::NO_CONNECTION);
+    char errors = 0;
+    errors |= (isDuplicatedDeviceId() << Protocol::DUPLICATED_DEVICE_ID);
+    errors |= (isConWithSomeSlavesLost() << Protocol::CON_WITH_SOME_SLAVES_LOST);
+    errors |= (isConWithAllSlavesLost() << Protocol::CON_WITH_ALL_SLAVES_LOST);
+    errors |= (isConWithSomeMastersLost() << Protocol::CON_WITH_SOME_MASTERS_LOST);
+    errors |= (isConWithAllMastersLost() << Protocol::CON_WITH_ALL_MASTERS_LOST);
+    errors |= (isNoConnection() << Protocol::NO_CONNECTION);
 
     m_isAnyActiveSlave |= (0UL != ma_activeSlaves.count());
-    m_errors |= (isNoActiveSlave() << Protocol::NO_ACTIVE_SLAVE);
+    errors |= (isNoActiveSlave() << Protocol::NO_ACTIVE_SLAVE);
+    storeErrors(filterDiscoveryErrors(errors));
 
-    ma_activeSlaves.reset();
-    ma_respondedMasters.reset();
-    ma_respondedSlaves.reset();
-    m_isAnyDuplicatedId = false;
-    m_isAnyActiveSlave = false;
+    startPeriod();
   }
 
 
   void Master::setCmdType(Protocol::CmdType cmdType) {
-    m_cmdType = cmdType;
-    m_approveState = Protocol::ApproveState::NOT_APPROVED;
+    notifyInput(Input::SET_CMD_TYPE, cmdType);
+    storeCmdType(cmdType);
+    storeApproveState(Protocol::ApproveState::NOT_APPROVED);
   }
 
 } // end namespace Eet
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef EET_OBSERVER_H
+#define EET_OBSERVER_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+  class Device;
+
+  enum class StateField : uint8_t {
+      SLAVE_STATE = 0,
+      APPROVE_STATE,
+      CMD_TYPE,
+      ERRORS
+  };
+
+  // operator actions and commands received by Slave
+  enum class Input : uint8_t {
+      SET_CMD_TYPE = 0, // Master::setCmdType()
+      APPROVE,          // Slave::approve()
+      ACTIVATE,         // Slave::activate()
+      CMD_RECEIVED      // Slave got Cmd of a Master, also the one it holds
+  };
+
+/**
+ * Device calls observer synchronously from pushMsg()/update() and operator
+ * calls, so implementation should be cheap and must not call back into
+ * the device (except const getters).
+ */
+  class IObserver {
+    public:
+      EET_VIRTUAL_DTOR ~IObserver() = default;
+
+      virtual void onInput(const Device &, Input, Protocol::CmdType) {}
+      // called after the field has got new value, from != to
+      virtual void onTransition(const Device &, StateField, uint8_t, uint8_t) {}
+  };
+} // end namespace Eet
+
+#endif // EET_OBSERVER_H
@@ -1,11 +1,25 @@
 #include <cstring>
-#include <string>
 
 #include "Protocol.h"
 #include "Helpers.h"
+#include "Tracer.h"
 
 namespace Eet {
 
+  namespace {
+    constexpr uint32_t V2_CODE_SHIFT = 6U;
+    constexpr uint32_t V2_DEVICE_ID_MASK = (1U << V2_CODE_SHIFT) - 1U;
+    // by V2 code
+    constexpr Protocol::Can::Id V2_IDS[] = {
+      Protocol::Can::Id::CMD,
+      Protocol::Can::Id::ACTIVATE,
+      Protocol::Can::Id::HEARTBEAT,
+      Protocol::Can::Id::DISCOVER
+    };
+    constexpr uint32_t NUM_OF_V2_CODES = sizeof(V2_IDS) / sizeof(V2_IDS[0]);
+  }
+
+
   Protocol::Msg::
   IMsg::IMsg(const CommonFields &commonFields, Can::Id canId) :
     m_commonFields(commonFields),
@@ -36,6 +50,30 @@ namespace Eet {
   }
 
 
+  Protocol::Msg::
+  Discover::Discover(const CommonFields &commonFields) :
+    IMsg(commonFields, Can::Id::DISCOVER) {}
+
+
+  uint16_t Protocol::Msg::Discover::isNotValid() {
+    return m_commonFields.isNotValid();
+  }
+
+
+  Protocol::Msg::Discover::operator Can::RawMsg() {
+    Can::RawMsg msg{};
+    msg.m_canId = static_cast<uint32_t>(m_canId);
+    msg.m_dlc = DLC;
+    msg.m_dataL = 0UL;
+    msg.m_dataH = 0UL;
+
+    Helpers::setBits(msg.m_dataL, m_commonFields.m_deviceId, 0, 0, 6);
+    Helpers::setBits(msg.m_dataL, m_commonFields.m_deviceType, 0, 6, 2);
+    Helpers::setBits(msg.m_dataL, m_commonFields.m_errors, 1, 0, 8);
+    return msg;
+  }
+
+
   Protocol::Msg::
   Heartbeat::Heartbeat(const CommonFields &commonFields, SlaveState slaveState,
                        ApproveState approveState, CmdType cmdType) :
@@ -104,6 +142,189 @@ namespace Eet {
   }
 
 
+  uint32_t Protocol::Can::toCanId(Id id, char deviceId, IdScheme scheme) {
+    if(IdScheme::V2 == scheme) {
+      for(uint32_t code = 0U; code < NUM_OF_V2_CODES; ++code) {
+        if(V2_IDS[code] == id) {
+          return (code << V2_CODE_SHIFT) |
+                 (static_cast<uint32_t>(deviceId) & V2_DEVICE_ID_MASK);
+        }
+      }
+    }
+    return static_cast<uint32_t>(id);
+  }
+
+
+  bool Protocol::Can::fromCanId(uint32_t canId, Id &id, char &deviceId) {
+    constexpr Id V1_IDS[] = {Id::ACTIVATE, Id::HEARTBEAT, Id::DISCOVER, Id::CMD, Id::AGGREGATE};
+    deviceId = DeviceId::INVALID;
+    for(auto v1Id : V1_IDS) {
+      if(static_cast<uint32_t>(v1Id) == canId) {
+        id = v1Id;
+        return true;
+      }
+    }
+    // V1 IDs are not valid V2 IDs - their device ID part is 0 or above MAX_DEVICE_ID
+    auto code = canId >> V2_CODE_SHIFT;
+    auto v2DeviceId = static_cast<char>(canId & V2_DEVICE_ID_MASK);
+    if((code >= NUM_OF_V2_CODES) || not DeviceId::isCorrectId(v2DeviceId)) {
+      return false;
+    }
+    id = V2_IDS[code];
+    deviceId = v2DeviceId;
+    return true;
+  }
+
+
+  uint32_t Protocol::Can::getMaxFrameBits(uint32_t dlc) {
+    // 34 stuffable bits of header and CRC, 13 bits of CRC delimiter, ACK, EOF and IFS
+    uint32_t stuffable = 34U + 8U * dlc;
+    return stuffable + 13U + (stuffable - 1U) / 4U;
+  }
+
+
+  Protocol::Can::FdRawMsg Protocol::Can::toFdRawMsg(const RawMsg &msg) {
+    FdRawMsg fdMsg{};
+    fdMsg.m_canId = msg.m_canId;
+    fdMsg.m_len = (msg.m_dlc > 8U) ? 8U : msg.m_dlc;
+    for(uint32_t byte = 0U; byte < 4U; ++byte) {
+      fdMsg.ma_data[byte] = Helpers::bits2type<uint8_t>(msg.m_dataL, byte, 0U, 8U);
+      fdMsg.ma_data[byte + 4U] = Helpers::bits2type<uint8_t>(msg.m_dataH, byte, 0U, 8U);
+    }
+    return fdMsg;
+  }
+
+
+  bool Protocol::Can::toRawMsg(const FdRawMsg &msg, RawMsg &rawMsg) {
+    if(msg.m_len > 8U) {
+      return false;
+    }
+    rawMsg.m_canId = msg.m_canId;
+    rawMsg.m_dlc = msg.m_len;
+    rawMsg.m_dataL = 0UL;
+    rawMsg.m_dataH = 0UL;
+    for(uint32_t byte = 0U; byte < 4U; ++byte) {
+      Helpers::setBits(rawMsg.m_dataL, msg.ma_data[byte], byte, 0U, 8U);
+      Helpers::setBits(rawMsg.m_dataH, msg.ma_data[byte + 4U], byte, 0U, 8U);
+    }
+    return true;
+  }
+
+
+  uint32_t Protocol::Can::getFdLen(uint32_t len) {
+    constexpr uint32_t lens[] = {8U, 12U, 16U, 20U, 24U, 32U, 48U, 64U};
+    if(len <= 8U) {
+      return len;
+    }
+    for(auto fdLen : lens) {
+      if(len <= fdLen) {
+        return fdLen;
+      }
+    }
+    return 0U;
+  }
+
+
+  uint64_t Protocol::Can::getMaxFdFrameNs(uint32_t len, uint32_t nominalBitrate,
+                                          uint32_t dataBitrate) {
+    len = getFdLen(len);
+    // SOF, ID, RRS, IDE, FDF, res, BRS with stuffing and
+    // CRC delimiter, ACK, EOF, IFS at nominal bit rate
+    uint64_t nominalBits = 17U + (17U - 1U) / 4U + 13U;
+    // ESI, DLC, data with dynamic stuffing, stuff count and CRC with fixed stuff bits
+    uint32_t crcBits = (len <= 16U) ? 17U : 21U;
+    uint32_t stuffable = 5U + 8U * len;
+    uint64_t dataBits = stuffable + (stuffable - 1U) / 4U + 4U + crcBits + (crcBits + 4U + 3U) / 4U;
+    return nominalBits * 1000000000U / nominalBitrate + dataBits * 1000000000U / dataBitrate;
+  }
+
+
+  Protocol::Msg::
+  Aggregate::Aggregate() :
+    ma_records{},
+    m_numOfRecords(0U) {}
+
+
+  bool Protocol::Msg::Aggregate::add(const Can::RawMsg &msg) {
+    if(m_numOfRecords >= MAX_RECORDS) {
+      return false;
+    }
+    // record keeps V1 Id whatever scheme msg has been made with
+    auto id = Can::Id::AGGREGATE;
+    char deviceId = DeviceId::INVALID;
+    Can::fromCanId(msg.m_canId, id, deviceId);
+    switch(id) {
+      case Can::Id::ACTIVATE:
+      case Can::Id::HEARTBEAT:
+      case Can::Id::DISCOVER:
+      case Can::Id::CMD:
+        break;
+      default:
+        return false;
+    }
+    uint32_t record = msg.m_dataL;
+    Helpers::setBits(record, static_cast<uint32_t>(id), 3, 0, 8);
+    ma_records[m_numOfRecords++] = record;
+    return true;
+  }
+
+
+  void Protocol::Msg::Aggregate::clear() {
+    m_numOfRecords = 0U;
+  }
+
+
+  uint32_t Protocol::Msg::Aggregate::getNumOfRecords() const {
+    return m_numOfRecords;
+  }
+
+
+  Protocol::Msg::Aggregate::operator Can::FdRawMsg() const {
+    Can::FdRawMsg msg{};
+    msg.m_canId = static_cast<uint32_t>(Can::Id::AGGREGATE);
+    msg.m_len = Can::getFdLen(m_numOfRecords * RECORD_SIZE);
+    for(uint32_t i = 0U; i < m_numOfRecords; ++i) {
+      for(uint32_t byte = 0U; byte < RECORD_SIZE; ++byte) {
+        msg.ma_data[i * RECORD_SIZE + byte] =
+          Helpers::bits2type<uint8_t>(ma_records[i], byte, 0U, 8U);
+      }
+    }
+    return msg;
+  }
+
+
+  bool Protocol::Msg::Aggregate::getRecord(const Can::FdRawMsg &msg, uint32_t index,
+                                           Can::RawMsg &record) {
+    auto pos = index * RECORD_SIZE;
+    if((msg.m_len > Can::FdRawMsg::MAX_LEN) || (pos + RECORD_SIZE > msg.m_len)) {
+      return false;
+    }
+    record.m_canId = msg.ma_data[pos + 3U];
+    switch(static_cast<Can::Id>(record.m_canId)) {
+      case Can::Id::ACTIVATE:
+        record.m_dlc = Activate::DLC;
+        break;
+      case Can::Id::HEARTBEAT:
+        record.m_dlc = Heartbeat::DLC;
+        break;
+      case Can::Id::DISCOVER:
+        record.m_dlc = Discover::DLC;
+        break;
+      case Can::Id::CMD:
+        record.m_dlc = Cmd::DLC;
+        break;
+      default:
+        return false;
+    }
+    record.m_dataL = 0UL;
+    record.m_dataH = 0UL;
+    for(uint32_t byte = 0U; byte < record.m_dlc; ++byte) {
+      Helpers::setBits(record.m_dataL, msg.ma_data[pos + byte], byte, 0U, 8U);
+    }
+    return true;
+  }
+
+
   Protocol::Msg::
   CommonFields::CommonFields(char id, DeviceType type, uint8_t e) :
     m_deviceId(id),
@@ -133,7 +354,10 @@ namespace Eet {
 
 
   Protocol::Msg::
-  LogMsg::LogMsg(char tDeviceId, uint16_t errors, const Can::RawMsg &msg) {
+  LogMsg::LogMsg(char tDeviceId, uint16_t errors, const Can::RawMsg &msg) :
+    m_msgSize(0U),
+    m_isTimed(false) {
+    EET_TRACE_SPAN(span, "LogMsg O", tDeviceId);
     clean();
     size_t pos = 0UL;
 
@@ -147,13 +371,14 @@ namespace Eet {
       std::memcpy(m_msg+pos, "INVALID_DEVICE_ID", 17);
       pos += 17;
     } else {
-      auto tDeviceIdStr = std::to_string(static_cast<unsigned>(tDeviceId));
-      std::memcpy(m_msg + pos, tDeviceIdStr.c_str(), tDeviceIdStr.size());
-      pos += tDeviceIdStr.size();
+      pos += Helpers::toDecimal(m_msg + pos, static_cast<uint32_t>(tDeviceId));
     }
     m_msg[pos++] = ',';
     // <CanId>,
-    auto canId = static_cast<Protocol::Can::Id>(msg.m_canId);
+    // any scheme, unknown identifier is printed as INVALID_CAN_ID like AGGREGATE
+    auto canId = Protocol::Can::Id::AGGREGATE;
+    char canIdDeviceId = Protocol::DeviceId::INVALID;
+    Protocol::Can::fromCanId(msg.m_canId, canId, canIdDeviceId);
     switch(canId) {
       case Protocol::Can::Id::ACTIVATE:
         m_msg[pos++] = 'A';
@@ -161,6 +386,9 @@ namespace Eet {
       case Protocol::Can::Id::HEARTBEAT:
         m_msg[pos++] = 'H';
         break;
+      case Protocol::Can::Id::DISCOVER:
+        m_msg[pos++] = 'D';
+        break;
       case Protocol::Can::Id::CMD:
         m_msg[pos++] = 'C';
         break;
@@ -176,9 +404,7 @@ namespace Eet {
       std::memcpy(m_msg+pos, invalidCanDlcStr, 15);
       pos += 15;
     } else {
-      auto canDlcStr = std::to_string(msg.m_dlc);
-      std::memcpy(m_msg+pos, canDlcStr.c_str(), canDlcStr.size());
-      pos += canDlcStr.size();
+      pos += Helpers::toDecimal(m_msg + pos, msg.m_dlc);
     }
     m_msg[pos++] = ',';
     // <oDeviceId>,
@@ -187,9 +413,8 @@ namespace Eet {
       std::memcpy(m_msg+pos, "O_INVALID_DEVICE_ID", 19);
       pos += 19;
     } else {
-      auto oDeviceIdStr = std::to_string(static_cast<unsigned>(commonFields.m_deviceId));
-      std::memcpy(m_msg + pos, oDeviceIdStr.c_str(), oDeviceIdStr.size());
-      pos += oDeviceIdStr.size();
+      pos += Helpers::toDecimal(m_msg + pos,
+                                static_cast<uint32_t>(commonFields.m_deviceId));
     }
     m_msg[pos++] = ',';
     // <oDuplicatedId>,
@@ -262,6 +487,7 @@ namespace Eet {
     m_msg[pos++] = ',';
     // <SlaveState>,
     if((Protocol::Can::Id::ACTIVATE != canId) &&
+       (Protocol::Can::Id::DISCOVER != canId) &&
        (Protocol::Can::Id::CMD != canId) &&
        (Protocol::DeviceType::MASTER != commonFields.m_deviceType)) {
       auto slaveState = Helpers::enum2type(msg.m_dataL, 2U, 0U, 1U,
@@ -288,6 +514,7 @@ namespace Eet {
     m_msg[pos++] = ',';
     // <ApproveState>,
     if((Protocol::Can::Id::ACTIVATE != canId) &&
+       (Protocol::Can::Id::DISCOVER != canId) &&
        (Protocol::Can::Id::CMD != canId)) {
       auto approveState = Helpers::enum2type(msg.m_dataL, 2U, 1U, 1U,
                                              Protocol::ApproveState::NOT_APPROVED,
@@ -312,7 +539,8 @@ namespace Eet {
     }
     m_msg[pos++] = ',';
     // <CmdType>,
-    if(Protocol::Can::Id::ACTIVATE != canId) {
+    if((Protocol::Can::Id::ACTIVATE != canId) &&
+       (Protocol::Can::Id::DISCOVER != canId)) {
       auto cmdType = Helpers::enum2type(msg.m_dataL, 2U, 2U, 7U,
                                         Protocol::CmdType::COMPLETE,
                                         Protocol::CmdType::FULL_ASTERN);
@@ -391,7 +619,10 @@ namespace Eet {
 
   Protocol::Msg::
   LogMsg::LogMsg(char deviceId, DeviceType deviceType, char errors,
-                 SlaveState slaveState, ApproveState approveState, CmdType cmdType) {
+                 SlaveState slaveState, ApproveState approveState, CmdType cmdType) :
+    m_msgSize(0U),
+    m_isTimed(false) {
+    EET_TRACE_SPAN(span, "LogMsg T", deviceId);
     clean();
     size_t pos = 0UL;
 
@@ -405,9 +636,7 @@ namespace Eet {
       std::memcpy(m_msg+pos, "INVALID_DEVICE_ID", 17);
       pos += 17;
     } else {
-      auto tDeviceIdStr = std::to_string(static_cast<unsigned>(deviceId));
-      std::memcpy(m_msg + pos, tDeviceIdStr.c_str(), tDeviceIdStr.size());
-      pos += tDeviceIdStr.size();
+      pos += Helpers::toDecimal(m_msg + pos, static_cast<uint32_t>(deviceId));
     }
     m_msg[pos++] = ',';
     // <DeviceType>,
@@ -584,9 +813,26 @@ namespace Eet {
   }
 
 
+  void Protocol::Msg::
+  LogMsg::setTimeNs(uint64_t timeNs) {
+    if(m_isTimed || (m_msgSize < 2U) || (m_msgSize + MAX_TIME_LEN > LOG_MSG_MAX_SIZE)) {
+      return;
+    }
+    // "\r\n" -> "<TimeNs>,\r\n"
+    size_t pos = m_msgSize - 2U;
+    pos += Helpers::toDecimal(m_msg + pos, timeNs);
+    m_msg[pos++] = ',';
+    m_msg[pos++] = '\r';
+    m_msg[pos++] = '\n';
+    m_msgSize = pos;
+    m_isTimed = true;
+  }
+
+
   void Protocol::Msg::
   LogMsg::clean() {
     std::memset(m_msg, 0, m_msgSize);
     m_msgSize = 0UL;
+    m_isTimed = false;
   }
 } // end namespace Eet
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <cstdint>
 
+#include "Config.h"
+
 namespace Eet {
   namespace Protocol {
     enum class DeviceType : uint8_t {
@@ -59,7 +61,23 @@ namespace Eet {
       enum class Id : char {
           ACTIVATE = 0b00010000,
           HEARTBEAT = 0b00100000,
-          CMD = 0b01000000
+          DISCOVER = 0b00110000, // booting device asks peers for heartbeats
+          CMD = 0b01000000,
+          AGGREGATE = 0b01010000 // CAN FD only, see Msg::Aggregate
+      };
+
+      /*
+       * Identifier on the bus, see doc/protocol.md.
+       * V1 - Id as is, the same for all senders, CMD has the lowest priority
+       * V2 - code << 6 | sender Device ID, codes: CMD 0, ACTIVATE 1,
+       *      HEARTBEAT 2, DISCOVER 3, so CMD has the highest priority.
+       *      AGGREGATE is the same as in V1
+       * COMPAT - transmit V1, receive both, for buses being migrated to V2
+       */
+      enum class IdScheme : uint8_t {
+          V1 = 1,
+          V2,
+          COMPAT
       };
 
       struct RawMsg {
@@ -68,6 +86,27 @@ namespace Eet {
         uint32_t m_dataL;
         uint32_t m_dataH;
       };
+
+      struct FdRawMsg {
+        static constexpr uint32_t MAX_LEN = 64U;
+
+        uint32_t m_canId;
+        uint32_t m_len;
+        uint8_t ma_data[MAX_LEN];
+      };
+
+      uint32_t toCanId(Id id, char deviceId, IdScheme scheme);
+      // false if canId is neither V1 nor V2 identifier, deviceId is INVALID for V1
+      bool fromCanId(uint32_t canId, Id &id, char &deviceId);
+      // standard 11-bit ID frame including worst-case bit stuffing and IFS
+      uint32_t getMaxFrameBits(uint32_t dlc);
+      FdRawMsg toFdRawMsg(const RawMsg &msg);
+      bool toRawMsg(const FdRawMsg &msg, RawMsg &rawMsg); // false if len > 8
+      // smallest valid CAN FD data length which fits len bytes
+      uint32_t getFdLen(uint32_t len);
+      // standard 11-bit ID CAN FD frame with bit rate switch, worst-case stuffing
+      uint64_t getMaxFdFrameNs(uint32_t len, uint32_t nominalBitrate,
+                               uint32_t dataBitrate);
     }
 
     namespace Msg {
@@ -95,7 +134,7 @@ namespace Eet {
       };
 
       struct IMsg {
-        virtual ~IMsg() = default;
+        EET_VIRTUAL_DTOR ~IMsg() = default;
         IMsg(const CommonFields &commonFields, Can::Id canId);
         virtual uint16_t isNotValid() = 0;
 
@@ -111,6 +150,14 @@ namespace Eet {
         static constexpr uint32_t DLC = 2;
       };
 
+      struct Discover final : IMsg {
+        explicit Discover(const CommonFields &commonFields);
+        explicit operator Can::RawMsg();
+        uint16_t isNotValid() override;
+
+        static constexpr uint32_t DLC = 2;
+      };
+
       struct Heartbeat final : IMsg {
         Heartbeat(const CommonFields &commonFields,
                   SlaveState slaveState, ApproveState approveState,
@@ -133,16 +180,47 @@ namespace Eet {
         static constexpr uint32_t DLC = 3;
       };
 
+      /*
+       * CAN FD frame with several EET messages (records) of one or more
+       * devices. Record is 4 bytes: bytes 0-2 are the same as bytes 0-2 of
+       * corresponding classic message, byte 3 is its Can::Id.
+       * Zero record is padding.
+       */
+      struct Aggregate {
+        static constexpr uint32_t RECORD_SIZE = 4U;
+        static constexpr uint32_t MAX_RECORDS = Can::FdRawMsg::MAX_LEN / RECORD_SIZE;
+
+        Aggregate();
+        bool add(const Can::RawMsg &msg); // false if full or msg has unknown CAN ID
+        void clear();
+        uint32_t getNumOfRecords() const;
+        explicit operator Can::FdRawMsg() const;
+        // false for padding, records of unknown type and m_len over MAX_LEN
+        static bool getRecord(const Can::FdRawMsg &msg, uint32_t index,
+                              Can::RawMsg &record);
+
+        uint32_t ma_records[MAX_RECORDS];
+        uint32_t m_numOfRecords;
+      };
+
       struct LogMsg {
-        static const uint32_t LOG_MSG_MAX_SIZE = 512UL;
+        static const uint32_t LOG_MSG_MAX_SIZE = EET_LOG_MSG_MAX_SIZE;
+        static const uint32_t MAX_LEN = 302U; // O line with all fields invalid
+        static const uint32_t MAX_TIME_LEN = 21U; // <TimeNs>,
+        static_assert(LOG_MSG_MAX_SIZE >= MAX_LEN, "LogMsg buffer is too small");
 
         LogMsg(char deviceId, uint16_t errors, const Can::RawMsg &msg);
         LogMsg(char deviceId, DeviceType deviceType, char errors,
                SlaveState slaveState, ApproveState approveState, CmdType cmdType);
+        // appends optional <TimeNs> field, later calls are no-op; without it the line
+        // has the original format. Skipped if buffer is smaller than
+        // MAX_LEN + MAX_TIME_LEN and the line does not fit
+        void setTimeNs(uint64_t timeNs);
         void clean();
 
         char m_msg[LOG_MSG_MAX_SIZE];
         uint32_t m_msgSize;
+        bool m_isTimed; // setTimeNs() has appended the field
       };
     } // end namespace Msg
   } // end namespace Protocol
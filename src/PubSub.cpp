@@ -0,0 +1,672 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "PubSub.h"
+#include "Clock.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr uint32_t NO_TOPIC = PubSub::MAX_TOPICS;
+
+    bool fillAddr(sockaddr_un &addr, const char *path) {
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      auto len = std::strlen(path);
+      if(len >= sizeof(addr.sun_path)) {
+        return false;
+      }
+      std::memcpy(addr.sun_path, path, len);
+      return true;
+    }
+
+    void putU16(uint8_t *buf, uint16_t value) {
+      buf[0] = static_cast<uint8_t>(value);
+      buf[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void putU64(uint8_t *buf, uint64_t value) {
+      for(uint32_t i = 0U; i < 8U; ++i) {
+        buf[i] = static_cast<uint8_t>(value >> (8U * i));
+      }
+    }
+
+    uint16_t getU16(const uint8_t *buf) {
+      return static_cast<uint16_t>(buf[0] | (buf[1] << 8));
+    }
+
+    uint64_t getU64(const uint8_t *buf) {
+      uint64_t value = 0U;
+      for(uint32_t i = 0U; i < 8U; ++i) {
+        value |= static_cast<uint64_t>(buf[i]) << (8U * i);
+      }
+      return value;
+    }
+
+    // Masters first, then Slaves, by Device ID - 1
+    uint32_t getTopic(Protocol::DeviceType deviceType, char deviceId) {
+      auto maxId = Protocol::DeviceId::MAX_DEVICE_ID;
+      if(not Protocol::DeviceId::isCorrectId(deviceId)) {
+        return NO_TOPIC;
+      }
+      if(Protocol::DeviceType::MASTER == deviceType) {
+        return static_cast<uint32_t>(deviceId - 1);
+      }
+      if(Protocol::DeviceType::SLAVE == deviceType) {
+        return static_cast<uint32_t>(maxId + deviceId - 1);
+      }
+      return NO_TOPIC;
+    }
+
+    PubSub::Update toUpdate(const Snapshot &snapshot, uint64_t timeNs) {
+      PubSub::Update update{};
+      update.m_deviceType = snapshot.m_deviceType;
+      update.m_deviceId = snapshot.m_deviceId;
+      update.m_errors = snapshot.m_errors;
+      update.m_slaveState = snapshot.m_slaveState;
+      update.m_approveState = snapshot.m_approveState;
+      update.m_cmdType = snapshot.m_cmdType;
+      update.m_flags = snapshot.m_flags;
+      update.ma_activeSlaves = snapshot.ma_activeSlaves;
+      update.ma_respondedSlaves = snapshot.ma_respondedSlaves;
+      update.ma_respondedMasters = snapshot.ma_respondedMasters;
+      update.m_timeNs = timeNs;
+      return update;
+    }
+
+    uint8_t getChangedFields(const PubSub::Update &from, const PubSub::Update &to) {
+      uint8_t fields = 0U;
+      fields |= (from.m_errors != to.m_errors) << PubSub::ERRORS;
+      fields |= (from.m_slaveState != to.m_slaveState) << PubSub::SLAVE_STATE;
+      fields |= (from.m_approveState != to.m_approveState) << PubSub::APPROVE_STATE;
+      fields |= (from.m_cmdType != to.m_cmdType) << PubSub::CMD_TYPE;
+      fields |= (from.m_flags != to.m_flags) << PubSub::FLAGS;
+      fields |= (from.ma_activeSlaves != to.ma_activeSlaves) << PubSub::ACTIVE_SLAVES;
+      fields |= (from.ma_respondedSlaves != to.ma_respondedSlaves) << PubSub::RESPONDED_SLAVES;
+      fields |= (from.ma_respondedMasters != to.ma_respondedMasters) << PubSub::RESPONDED_MASTERS;
+      return fields;
+    }
+
+    void encodeRecord(uint8_t *buf, const PubSub::Update &update, uint8_t fields,
+                      bool isSnapshot) {
+      buf[0] = static_cast<uint8_t>(update.m_deviceType);
+      buf[1] = static_cast<uint8_t>(update.m_deviceId);
+      buf[2] = fields;
+      buf[3] = static_cast<uint8_t>(isSnapshot << PubSub::IS_SNAPSHOT);
+      buf[4] = static_cast<uint8_t>(update.m_errors);
+      buf[5] = static_cast<uint8_t>(update.m_slaveState);
+      buf[6] = static_cast<uint8_t>(update.m_approveState);
+      buf[7] = static_cast<uint8_t>(update.m_cmdType);
+      buf[8] = update.m_flags;
+      buf[9] = 0U;
+      putU16(buf + 10, update.ma_activeSlaves);
+      putU16(buf + 12, update.ma_respondedSlaves);
+      putU16(buf + 14, update.ma_respondedMasters);
+      putU64(buf + 16, update.m_timeNs);
+    }
+
+    void decodeRecord(const uint8_t *buf, PubSub::Update &update) {
+      update.m_deviceType = static_cast<Protocol::DeviceType>(buf[0]);
+      update.m_deviceId = static_cast<char>(buf[1]);
+      update.m_fields = buf[2];
+      update.m_isSnapshot = (buf[3] >> PubSub::IS_SNAPSHOT) & 0x01;
+      update.m_errors = static_cast<char>(buf[4]);
+      update.m_slaveState = static_cast<Protocol::SlaveState>(buf[5]);
+      update.m_approveState = static_cast<Protocol::ApproveState>(buf[6]);
+      update.m_cmdType = static_cast<Protocol::CmdType>(buf[7]);
+      update.m_flags = buf[8];
+      update.ma_activeSlaves = getU16(buf + 10);
+      update.ma_respondedSlaves = getU16(buf + 12);
+      update.ma_respondedMasters = getU16(buf + 14);
+      update.m_timeNs = getU64(buf + 16);
+    }
+
+    void startPacket(uint8_t *buf, uint8_t packetFlags) {
+      buf[0] = static_cast<uint8_t>(PubSub::MsgType::UPDATES);
+      buf[1] = packetFlags;
+      putU16(buf + 2, 0U);
+    }
+
+    // adds record, returns new size of packet
+    uint32_t addRecord(uint8_t *buf, uint32_t size, const PubSub::Update &update,
+                       uint8_t fields, bool isSnapshot) {
+      encodeRecord(buf + size, update, fields, isSnapshot);
+      putU16(buf + 2, static_cast<uint16_t>(getU16(buf + 2) + 1U));
+      return size + PubSub::RECORD_SIZE;
+    }
+
+    // fields of update requested by filters, 0 if no filter matches the device
+    template<typename Filter>
+    uint8_t getRequestedFields(const Filter *filters, uint32_t numOfFilters,
+                               const PubSub::Update &update) {
+      uint8_t fields = 0U;
+      for(uint32_t i = 0U; i < numOfFilters; ++i) {
+        const auto &filter = filters[i];
+        bool isMatch = ((Protocol::DeviceType::INVALID == filter.m_deviceType) ||
+                        (filter.m_deviceType == update.m_deviceType)) &&
+                       ((PubSub::ANY_DEVICE_ID == filter.m_deviceId) ||
+                        (filter.m_deviceId == update.m_deviceId));
+        fields |= isMatch ? filter.m_fields : 0U;
+      }
+      return fields;
+    }
+  }
+
+
+  PubSub::Broker::Broker() :
+    m_listenFd(-1),
+    ma_clients{},
+    m_numOfClients(0U),
+    ma_topics{},
+    ma_batch{},
+    m_batchSize(0U),
+    ma_packet{},
+    m_numOfPackets(0U),
+    m_numOfCoalesced(0U),
+    m_numOfRefused(0U) {
+    for(auto &client : ma_clients) {
+      client.m_fd = -1;
+    }
+  }
+
+
+  PubSub::Broker::~Broker() {
+    close();
+  }
+
+
+  bool PubSub::Broker::open(const char *path) {
+    close();
+    sockaddr_un addr{};
+    if(not fillAddr(addr, path)) {
+      return false;
+    }
+    m_listenFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if(m_listenFd < 0) {
+      return false;
+    }
+    ::unlink(path);
+    if((0 != ::bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))) ||
+       (0 != ::listen(m_listenFd, static_cast<int>(MAX_CLIENTS)))) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+
+  void PubSub::Broker::close() {
+    for(auto &client : ma_clients) {
+      if(client.m_fd >= 0) {
+        drop(client);
+      }
+    }
+    if(m_listenFd >= 0) {
+      ::close(m_listenFd);
+      m_listenFd = -1;
+    }
+  }
+
+
+  void PubSub::Broker::publish(const Device &device) {
+    publish(device.getSnapshot(), Clock::monotonicNs());
+  }
+
+
+  void PubSub::Broker::publish(const Snapshot &snapshot, uint64_t timeNs) {
+    auto index = getTopic(snapshot.m_deviceType, snapshot.m_deviceId);
+    if(NO_TOPIC == index) {
+      return;
+    }
+    auto &topic = ma_topics[index];
+    auto state = toUpdate(snapshot, timeNs);
+    auto fields = topic.m_isKnown ? getChangedFields(topic.m_state, state) : ALL_FIELDS;
+    if(0U == fields) {
+      return;
+    }
+    if(0U == topic.m_changed) {
+      ma_batch[m_batchSize++] = index;
+    }
+    topic.m_changed |= fields;
+    topic.m_state = state;
+    topic.m_isKnown = true;
+  }
+
+
+  void PubSub::Broker::flush() {
+    if(0U == m_batchSize) {
+      return;
+    }
+    for(auto &client : ma_clients) {
+      if((client.m_fd < 0) || (0U == client.m_numOfFilters)) {
+        continue;
+      }
+      for(uint32_t i = 0U; i < m_batchSize; ++i) {
+        const auto &topic = ma_topics[ma_batch[i]];
+        auto fields = topic.m_changed & getRequestedFields(client.ma_filters,
+                                                           client.m_numOfFilters,
+                                                           topic.m_state);
+        addPending(client, ma_batch[i], static_cast<uint8_t>(fields), false);
+      }
+      if(not client.m_isBlocked) {
+        sendPending(client);
+      }
+    }
+    for(uint32_t i = 0U; i < m_batchSize; ++i) {
+      ma_topics[ma_batch[i]].m_changed = 0U;
+    }
+    m_batchSize = 0U;
+  }
+
+
+  void PubSub::Broker::poll(int timeoutMs) {
+    pollfd fds[MAX_POLL_FDS];
+    auto numOfFds = getPollFds(fds, MAX_POLL_FDS);
+    if((0U != numOfFds) && (::poll(fds, numOfFds, timeoutMs) > 0)) {
+      onPoll(fds, numOfFds);
+    }
+  }
+
+
+  uint32_t PubSub::Broker::getPollFds(pollfd *fds, uint32_t maxFds) const {
+    if((m_listenFd < 0) || (0U == maxFds)) {
+      return 0U;
+    }
+    uint32_t numOfFds = 0U;
+    fds[numOfFds++] = pollfd{m_listenFd, POLLIN, 0};
+    for(const auto &client : ma_clients) {
+      if((client.m_fd >= 0) && (numOfFds < maxFds)) {
+        fds[numOfFds++] = pollfd{client.m_fd,
+                                 static_cast<short>(POLLIN | (client.m_isBlocked ? POLLOUT : 0)),
+                                 0};
+      }
+    }
+    return numOfFds;
+  }
+
+
+  void PubSub::Broker::onPoll(const pollfd *fds, uint32_t numOfFds) {
+    for(uint32_t i = 1U; i < numOfFds; ++i) {
+      auto events = fds[i].revents;
+      Client *client = nullptr;
+      for(auto &candidate : ma_clients) {
+        if(candidate.m_fd == fds[i].fd) {
+          client = &candidate;
+          break;
+        }
+      }
+      if((nullptr == client) || (0 == events)) {
+        continue;
+      }
+      if(0 != (events & POLLIN)) {
+        receive(*client);
+      }
+      if((client->m_fd >= 0) && (0 != (events & POLLOUT))) {
+        client->m_isBlocked = false;
+        sendPending(*client);
+      }
+      if((client->m_fd >= 0) && (0 != (events & (POLLERR | POLLHUP)))) {
+        drop(*client);
+      }
+    }
+    if((0U != numOfFds) && (0 != (fds[0].revents & POLLIN))) {
+      accept();
+    }
+  }
+
+
+  uint32_t PubSub::Broker::getNumOfClients() const {
+    return m_numOfClients;
+  }
+
+
+  uint64_t PubSub::Broker::getNumOfPackets() const {
+    return m_numOfPackets;
+  }
+
+
+  uint64_t PubSub::Broker::getNumOfCoalesced() const {
+    return m_numOfCoalesced;
+  }
+
+
+  uint64_t PubSub::Broker::getNumOfRefused() const {
+    return m_numOfRefused;
+  }
+
+
+  void PubSub::Broker::addPending(Client &client, uint32_t index, uint8_t fields,
+                                  bool isSnapshot) {
+    if(0U == fields) {
+      return;
+    }
+    auto bit = 1U << index;
+    client.m_isCoalesced = client.m_isCoalesced || (0U != (client.m_pendingTopics & bit));
+    client.m_pendingTopics |= bit;
+    client.m_snapshotTopics |= isSnapshot ? bit : 0U;
+    client.ma_pending[index] |= fields;
+  }
+
+
+  void PubSub::Broker::sendPending(Client &client) {
+    if(0U == client.m_pendingTopics) {
+      return;
+    }
+    startPacket(ma_packet, static_cast<uint8_t>(client.m_isCoalesced << IS_COALESCED));
+    uint32_t size = HEADER_SIZE;
+    for(uint32_t index = 0U; index < MAX_TOPICS; ++index) {
+      auto bit = 1U << index;
+      if(0U != (client.m_pendingTopics & bit)) {
+        size = addRecord(ma_packet, size, ma_topics[index].m_state, client.ma_pending[index],
+                         0U != (client.m_snapshotTopics & bit));
+      }
+    }
+    auto ret = ::send(client.m_fd, ma_packet, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(ret == static_cast<ssize_t>(size)) {
+      ++m_numOfPackets;
+      m_numOfCoalesced += client.m_isCoalesced ? 1U : 0U;
+      for(uint32_t index = 0U; index < MAX_TOPICS; ++index) {
+        client.ma_pending[index] = 0U;
+      }
+      client.m_pendingTopics = 0U;
+      client.m_snapshotTopics = 0U;
+      client.m_isCoalesced = false;
+    } else if((ret < 0) && ((EAGAIN == errno) || (EWOULDBLOCK == errno))) {
+      client.m_isBlocked = true; // changes stay pending until POLLOUT
+    } else {
+      drop(client);
+    }
+  }
+
+
+  void PubSub::Broker::accept() {
+    while(true) {
+      auto fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+      if(fd < 0) {
+        return;
+      }
+      Client *free = nullptr;
+      for(auto &client : ma_clients) {
+        if(client.m_fd < 0) {
+          free = &client;
+          break;
+        }
+      }
+      if(nullptr == free) {
+        ::close(fd);
+        ++m_numOfRefused;
+        continue;
+      }
+      int bufferSize = SOCKET_BUFFER_SIZE;
+      ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+      free->m_fd = fd;
+      free->m_numOfFilters = 0U;
+      free->m_isBlocked = false;
+      free->m_isCoalesced = false;
+      free->m_pendingTopics = 0U;
+      free->m_snapshotTopics = 0U;
+      for(auto &pending : free->ma_pending) {
+        pending = 0U;
+      }
+      ++m_numOfClients;
+    }
+  }
+
+
+  void PubSub::Broker::receive(Client &client) {
+    uint8_t msg[SUBSCRIBE_SIZE + 1U];
+    while(client.m_fd >= 0) {
+      auto size = ::recv(client.m_fd, msg, sizeof(msg), MSG_DONTWAIT);
+      if(size > 0) {
+        if((SUBSCRIBE_SIZE == static_cast<uint32_t>(size)) &&
+           (static_cast<uint8_t>(MsgType::SUBSCRIBE) == msg[0])) {
+          subscribe(client, msg);
+        }
+      } else if((0 == size) || ((EAGAIN != errno) && (EWOULDBLOCK != errno))) {
+        drop(client);
+      } else {
+        return;
+      }
+    }
+  }
+
+
+  void PubSub::Broker::subscribe(Client &client, const uint8_t *msg) {
+    if(MAX_FILTERS == client.m_numOfFilters) {
+      return;
+    }
+    auto &filter = client.ma_filters[client.m_numOfFilters++];
+    filter.m_deviceType = static_cast<Protocol::DeviceType>(msg[1]);
+    filter.m_deviceId = static_cast<char>(msg[2]);
+    filter.m_fields = msg[3];
+    // snapshot of matching devices
+    for(uint32_t index = 0U; index < MAX_TOPICS; ++index) {
+      const auto &topic = ma_topics[index];
+      if(topic.m_isKnown) {
+        addPending(client, index, getRequestedFields(&filter, 1U, topic.m_state), true);
+      }
+    }
+    if(not client.m_isBlocked) {
+      sendPending(client);
+    }
+  }
+
+
+  void PubSub::Broker::drop(Client &client) {
+    ::close(client.m_fd);
+    client.m_fd = -1;
+    client.m_numOfFilters = 0U;
+    client.m_pendingTopics = 0U;
+    --m_numOfClients;
+  }
+
+
+  PubSub::Publisher::Publisher() :
+    m_broker(),
+    m_mailbox(),
+    m_eventFd(-1),
+    m_thread(),
+    m_isStopped(true),
+    m_numOfClients(0U),
+    m_last(),
+    m_isPosted(false) {}
+
+
+  PubSub::Publisher::~Publisher() {
+    stop();
+  }
+
+
+  bool PubSub::Publisher::start(const char *path) {
+    stop();
+    if(not m_broker.open(path)) {
+      return false;
+    }
+    m_eventFd = ::eventfd(0U, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(m_eventFd < 0) {
+      m_broker.close();
+      return false;
+    }
+    m_isPosted = false;
+    m_isStopped = false;
+    m_thread = std::thread(&Publisher::run, this);
+    return true;
+  }
+
+
+  void PubSub::Publisher::stop() {
+    if(m_thread.joinable()) {
+      m_isStopped = true;
+      wake();
+      m_thread.join();
+    }
+    m_broker.close();
+    if(m_eventFd >= 0) {
+      ::close(m_eventFd);
+      m_eventFd = -1;
+    }
+  }
+
+
+  bool PubSub::Publisher::post(const Device &device, uint64_t timeNs) {
+    return post(device.getSnapshot(), timeNs);
+  }
+
+
+  bool PubSub::Publisher::post(const Snapshot &snapshot, uint64_t timeNs) {
+    if(m_isPosted && (0U == getChangedFields(toUpdate(m_last, 0U), toUpdate(snapshot, 0U))) &&
+       (m_last.m_deviceType == snapshot.m_deviceType) &&
+       (m_last.m_deviceId == snapshot.m_deviceId)) {
+      return true;
+    }
+    if(not m_mailbox.push(Entry{snapshot, timeNs})) {
+      return false;
+    }
+    m_last = snapshot;
+    m_isPosted = true;
+    wake();
+    return true;
+  }
+
+
+  uint32_t PubSub::Publisher::getNumOfClients() const {
+    return m_numOfClients.load(std::memory_order_relaxed);
+  }
+
+
+  const PubSub::Broker &PubSub::Publisher::getBroker() const {
+    return m_broker;
+  }
+
+
+  void PubSub::Publisher::wake() {
+    uint64_t one = 1U;
+    auto ret = ::write(m_eventFd, &one, sizeof(one));
+    (void)ret; // counter is full - broker thread is awake anyway
+  }
+
+
+  void PubSub::Publisher::run() {
+    pollfd fds[1U + Broker::MAX_POLL_FDS];
+    Entry entry{};
+    while(not m_isStopped.load(std::memory_order_relaxed)) {
+      fds[0] = pollfd{m_eventFd, POLLIN, 0};
+      auto numOfFds = m_broker.getPollFds(fds + 1, Broker::MAX_POLL_FDS);
+      if(::poll(fds, 1U + numOfFds, -1) <= 0) {
+        continue; // EINTR
+      }
+      if(0 != (fds[0].revents & POLLIN)) {
+        uint64_t value = 0U;
+        auto ret = ::read(m_eventFd, &value, sizeof(value));
+        (void)ret;
+      }
+      // mailbox is drained whatever woke the thread
+      while(m_mailbox.pop(entry)) {
+        m_broker.publish(entry.m_snapshot, entry.m_timeNs);
+      }
+      m_broker.flush();
+      m_broker.onPoll(fds + 1, numOfFds);
+      m_numOfClients.store(m_broker.getNumOfClients(), std::memory_order_relaxed);
+    }
+  }
+
+
+  PubSub::Subscriber::Subscriber() :
+    m_fd(-1),
+    m_numOfCoalesced(0U) {}
+
+
+  PubSub::Subscriber::~Subscriber() {
+    close();
+  }
+
+
+  bool PubSub::Subscriber::open(const char *path) {
+    close();
+    sockaddr_un addr{};
+    if(not fillAddr(addr, path)) {
+      return false;
+    }
+    m_fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(m_fd < 0) {
+      return false;
+    }
+    if(0 != ::connect(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+
+  void PubSub::Subscriber::close() {
+    if(m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+
+  bool PubSub::Subscriber::isOpen() const {
+    return m_fd >= 0;
+  }
+
+
+  int PubSub::Subscriber::getFd() const {
+    return m_fd;
+  }
+
+
+  bool PubSub::Subscriber::subscribe(Protocol::DeviceType deviceType, char deviceId,
+                                     uint8_t fields) {
+    if(not isOpen()) {
+      return false;
+    }
+    uint8_t msg[SUBSCRIBE_SIZE] = {static_cast<uint8_t>(MsgType::SUBSCRIBE),
+                                   static_cast<uint8_t>(deviceType),
+                                   static_cast<uint8_t>(deviceId), fields};
+    return SUBSCRIBE_SIZE == ::send(m_fd, msg, SUBSCRIBE_SIZE, MSG_NOSIGNAL);
+  }
+
+
+  uint32_t PubSub::Subscriber::receive(Update *updates, uint32_t numOfUpdates, int timeoutMs) {
+    if(not isOpen()) {
+      return 0U;
+    }
+    if(0 != timeoutMs) {
+      pollfd fd = {m_fd, POLLIN, 0};
+      if(::poll(&fd, 1U, timeoutMs) <= 0) {
+        return 0U;
+      }
+    }
+    uint8_t msg[MAX_PACKET_SIZE];
+    auto size = ::recv(m_fd, msg, sizeof(msg), MSG_DONTWAIT);
+    if((0 == size) || ((size < 0) && (EAGAIN != errno) && (EWOULDBLOCK != errno))) {
+      close(); // broker has gone
+      return 0U;
+    }
+    if((size < static_cast<ssize_t>(HEADER_SIZE)) ||
+       (static_cast<uint8_t>(MsgType::UPDATES) != msg[0])) {
+      return 0U;
+    }
+    m_numOfCoalesced += (msg[1] >> IS_COALESCED) & 0x01;
+    uint32_t numOfRecords = getU16(msg + 2);
+    auto maxRecords = (static_cast<uint32_t>(size) - HEADER_SIZE) / RECORD_SIZE;
+    numOfRecords = (numOfRecords < maxRecords) ? numOfRecords : maxRecords;
+    numOfRecords = (numOfRecords < numOfUpdates) ? numOfRecords : numOfUpdates;
+    for(uint32_t i = 0U; i < numOfRecords; ++i) {
+      decodeRecord(msg + HEADER_SIZE + i * RECORD_SIZE, updates[i]);
+    }
+    return numOfRecords;
+  }
+
+
+  uint64_t PubSub::Subscriber::getNumOfCoalesced() const {
+    return m_numOfCoalesced;
+  }
+
+} // end namespace Eet
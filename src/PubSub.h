@@ -0,0 +1,268 @@
+#ifndef EET_PUB_SUB_H
+#define EET_PUB_SUB_H
+
+#include <atomic>
+#include <cstdint>
+#include <poll.h>
+#include <thread>
+
+#include "Device.h"
+#include "Mailbox.h"
+
+namespace Eet {
+  namespace PubSub {
+    enum class MsgType : uint8_t {
+        UPDATES = 1, // broker -> subscriber
+        SUBSCRIBE    // subscriber -> broker
+    };
+
+    // bits of fields masks
+    enum Field {
+        ERRORS = 0,
+        SLAVE_STATE,
+        APPROVE_STATE,
+        CMD_TYPE,
+        FLAGS,            // Snapshot::Flags
+        ACTIVE_SLAVES,
+        RESPONDED_SLAVES,
+        RESPONDED_MASTERS
+    };
+
+    constexpr uint8_t ALL_FIELDS = 0xFFU;
+    constexpr char ANY_DEVICE_ID = 0;
+
+    /*
+     * Messages on the wire (SOCK_SEQPACKET, one message per packet,
+     * little-endian).
+     * UPDATES:
+     *   0     MsgType
+     *   1     Packet flags (see PacketFlags)
+     *   2-3   Number of records
+     *   4-... Records of RECORD_SIZE bytes:
+     *     0     DeviceType
+     *     1     Device ID
+     *     2     Changed fields (bits of Field, requested fields in snapshots)
+     *     3     Record flags (see RecordFlags)
+     *     4     Errors byte
+     *     5     SlaveState
+     *     6     ApproveState
+     *     7     CmdType
+     *     8     Snapshot::Flags
+     *     9     RESERVE
+     *     10-11 Active Slaves bits
+     *     12-13 Responded Slaves bits
+     *     14-15 Responded Masters bits
+     *     16-23 CLOCK_MONOTONIC of the last change, ns
+     *   Records carry all current values, only changed fields are marked.
+     * SUBSCRIBE (adds a filter, broker answers with a snapshot of matching
+     * devices):
+     *   0     MsgType
+     *   1     DeviceType, INVALID for any
+     *   2     Device ID, ANY_DEVICE_ID for any
+     *   3     Fields mask
+     */
+    enum PacketFlags {
+        IS_COALESCED = 0 // subscriber has not read for a while, several
+                         // changes of a device are merged in one record
+    };
+
+    enum RecordFlags {
+        IS_SNAPSHOT = 0
+    };
+
+    constexpr uint32_t HEADER_SIZE = 4U;
+    constexpr uint32_t RECORD_SIZE = 24U;
+    constexpr uint32_t SUBSCRIBE_SIZE = 4U;
+    // one record per Master/Slave ID
+    constexpr uint32_t MAX_TOPICS = 2U * static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID);
+    constexpr uint32_t MAX_PACKET_SIZE = HEADER_SIZE + MAX_TOPICS * RECORD_SIZE;
+
+    struct Update {
+      Protocol::DeviceType m_deviceType;
+      char m_deviceId;
+      uint8_t m_fields; // changed fields
+      bool m_isSnapshot;
+      char m_errors;
+      Protocol::SlaveState m_slaveState;
+      Protocol::ApproveState m_approveState;
+      Protocol::CmdType m_cmdType;
+      uint8_t m_flags;
+      uint16_t ma_activeSlaves;
+      uint16_t ma_respondedSlaves;
+      uint16_t ma_respondedMasters;
+      uint64_t m_timeNs;
+    };
+
+/**
+ * Publishes state changes of devices to local subscribers. Topic is a
+ * device (DeviceType and Device ID), subscriber filters topics and fields.
+ *
+ * publish() compares device state with the last published one and adds
+ * changed fields to the batch, it makes no syscalls. Changes of the same
+ * device between two flush() calls are coalesced (values are the latest
+ * ones). flush() sends at most one packet to each subscriber with matching
+ * changes. Broker is not thread-safe: either call publish() after
+ * pushMsg()/update(), flush() and poll() once per loop iteration, or let
+ * Publisher run it on a thread of its own.
+ *
+ * poll() accepts subscribers, handles SUBSCRIBE and sends pending changes
+ * (getPollFds()/onPoll() do the same within the caller's poll()).
+ * Records carry full state, so nothing is queued: subscriber keeps only
+ * changed fields per topic. When its socket (SOCKET_BUFFER_SIZE, a few
+ * packets) is full, further changes are merged into the pending ones and
+ * sent in one packet (IS_COALESCED) as soon as the socket has room. A slow
+ * subscriber gets the latest state once it reads and never blocks the
+ * broker.
+ */
+    class Broker {
+      public:
+        static constexpr uint32_t MAX_CLIENTS = 64U;
+        static constexpr uint32_t MAX_FILTERS = 8U; // per subscriber, more are ignored
+        static constexpr uint32_t MAX_POLL_FDS = 1U + MAX_CLIENTS;
+        // SO_SNDBUF of subscriber sockets, the kernel rounds it up to its
+        // minimum - room for a few packets
+        static constexpr int SOCKET_BUFFER_SIZE = 2 * static_cast<int>(MAX_PACKET_SIZE);
+
+        Broker();
+        ~Broker();
+        Broker(const Broker &) = delete;
+        Broker &operator=(const Broker &) = delete;
+
+        bool open(const char *path);
+        void close();
+        void publish(const Device &device);
+        void publish(const Snapshot &snapshot, uint64_t timeNs);
+        void flush();
+        void poll(int timeoutMs); // 0 - does not block
+        // fds to poll for the broker, returns their number (at most MAX_POLL_FDS)
+        uint32_t getPollFds(pollfd *fds, uint32_t maxFds) const;
+        // fds of getPollFds() with revents after poll()
+        void onPoll(const pollfd *fds, uint32_t numOfFds);
+        uint32_t getNumOfClients() const;
+        uint64_t getNumOfPackets() const; // sent
+        uint64_t getNumOfCoalesced() const; // packets with merged changes
+        uint64_t getNumOfRefused() const; // connections over MAX_CLIENTS
+
+      private:
+        static_assert(MAX_TOPICS <= 32U, "topics do not fit into Client masks");
+
+        struct Filter {
+          Protocol::DeviceType m_deviceType;
+          char m_deviceId;
+          uint8_t m_fields;
+        };
+
+        struct Client {
+          int m_fd;
+          uint32_t m_numOfFilters;
+          Filter ma_filters[MAX_FILTERS];
+          bool m_isBlocked; // socket is full, waits for POLLOUT
+          bool m_isCoalesced;
+          uint32_t m_pendingTopics; // bits of topics with pending fields
+          uint32_t m_snapshotTopics; // pending records are snapshots
+          uint8_t ma_pending[MAX_TOPICS]; // fields to send
+        };
+
+        struct Topic {
+          bool m_isKnown;
+          uint8_t m_changed; // fields changed since the last flush()
+          Update m_state;
+        };
+
+        void addPending(Client &client, uint32_t index, uint8_t fields, bool isSnapshot);
+        void sendPending(Client &client);
+        void accept();
+        void receive(Client &client);
+        void subscribe(Client &client, const uint8_t *msg);
+        void drop(Client &client);
+
+        int m_listenFd;
+        Client ma_clients[MAX_CLIENTS];
+        uint32_t m_numOfClients;
+        Topic ma_topics[MAX_TOPICS];
+        uint32_t ma_batch[MAX_TOPICS]; // indexes of topics with changes
+        uint32_t m_batchSize;
+        uint8_t ma_packet[MAX_PACKET_SIZE];
+        uint64_t m_numOfPackets;
+        uint64_t m_numOfCoalesced;
+        uint64_t m_numOfRefused;
+    };
+
+/**
+ * Broker on a thread of its own, so fan-out to subscribers stays off the
+ * processing thread. The processing thread calls post() after
+ * pushMsg()/update(): it compares device state with the last posted one
+ * and on change passes the snapshot through a Mailbox and wakes the
+ * broker thread (one eventfd write). Broker thread polls the wake-up
+ * eventfd together with broker sockets, so subscribers are served as soon
+ * as they connect or their sockets have room.
+ *
+ * Start it before Realtime::apply(), the broker thread should not inherit
+ * real-time priority and CPU of the processing thread.
+ */
+    class Publisher {
+      public:
+        static constexpr uint32_t MAILBOX_SIZE = 64U;
+
+        Publisher();
+        ~Publisher();
+        Publisher(const Publisher &) = delete;
+        Publisher &operator=(const Publisher &) = delete;
+
+        bool start(const char *path);
+        void stop();
+        // processing thread, false if mailbox is full - state is posted
+        // again by the next call
+        bool post(const Device &device, uint64_t timeNs);
+        bool post(const Snapshot &snapshot, uint64_t timeNs);
+        uint32_t getNumOfClients() const; // any thread
+        const Broker &getBroker() const; // counters, after stop()
+
+      private:
+        struct Entry {
+          Snapshot m_snapshot;
+          uint64_t m_timeNs;
+        };
+
+        void run();
+        void wake();
+
+        Broker m_broker;
+        Mailbox<Entry, MAILBOX_SIZE> m_mailbox;
+        int m_eventFd;
+        std::thread m_thread;
+        std::atomic<bool> m_isStopped;
+        std::atomic<uint32_t> m_numOfClients;
+        Snapshot m_last; // the last posted state
+        bool m_isPosted;
+    };
+
+/**
+ * Client of Broker. receive() returns updates of one packet.
+ */
+    class Subscriber {
+      public:
+        Subscriber();
+        ~Subscriber();
+        Subscriber(const Subscriber &) = delete;
+        Subscriber &operator=(const Subscriber &) = delete;
+
+        bool open(const char *path);
+        void close();
+        bool isOpen() const; // false after broker has closed connection
+        int getFd() const;
+        // deviceType INVALID - any type, fields - mask of Field bits
+        bool subscribe(Protocol::DeviceType deviceType, char deviceId, uint8_t fields);
+        // waits up to timeoutMs (-1 forever), returns number of updates,
+        // updates should have room for MAX_TOPICS
+        uint32_t receive(Update *updates, uint32_t numOfUpdates, int timeoutMs);
+        uint64_t getNumOfCoalesced() const; // received packets with merged changes
+
+      private:
+        int m_fd;
+        uint64_t m_numOfCoalesced;
+    };
+  } // end namespace PubSub
+} // end namespace Eet
+
+#endif // EET_PUB_SUB_H
@@ -0,0 +1,155 @@
+#include <alloca.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "Realtime.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr int MIN_NICE = -20;
+
+    // frame of this call spans the stack the processing loop will use
+    __attribute__((noinline)) void prefaultStack(size_t size) {
+      auto *stack = static_cast<volatile char *>(::alloca(size));
+      auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+      for(size_t i = 0U; i < size; i += page) {
+        stack[i] = 0;
+      }
+    }
+
+    // SCHED_FIFO with at most the requested priority, 0 if not allowed
+    int setFifo(int priority, int &error) {
+      sched_param param = {};
+      param.sched_priority = priority;
+      if(0 == ::sched_setscheduler(0, SCHED_FIFO, &param)) {
+        return priority;
+      }
+      error = (0 != error) ? error : errno;
+      rlimit limit = {};
+      if((0 == ::getrlimit(RLIMIT_RTPRIO, &limit)) && (limit.rlim_cur > 0U) &&
+         (limit.rlim_cur < static_cast<rlim_t>(priority))) {
+        param.sched_priority = static_cast<int>(limit.rlim_cur);
+        if(0 == ::sched_setscheduler(0, SCHED_FIFO, &param)) {
+          return param.sched_priority;
+        }
+      }
+      return 0;
+    }
+
+    // lowest nice value RLIMIT_NICE allows (20 - limit), current one if none
+    int setLowestNice() {
+      rlimit limit = {};
+      int nice = MIN_NICE;
+      if((0 == ::getrlimit(RLIMIT_NICE, &limit)) && (RLIM_INFINITY != limit.rlim_cur) &&
+         (limit.rlim_cur < 40U)) {
+        nice = 20 - static_cast<int>(limit.rlim_cur);
+      }
+      errno = 0;
+      int current = ::getpriority(PRIO_PROCESS, 0);
+      if((0 == errno) && (nice < current) && (0 == ::setpriority(PRIO_PROCESS, 0, nice))) {
+        return nice;
+      }
+      return current;
+    }
+  }
+
+
+  Realtime::Status Realtime::apply(const Config &config) {
+    Status status = {-1, 0, 0, false, false, 0, 0, 0};
+
+    if(config.m_cpu >= 0) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      if(config.m_cpu >= CPU_SETSIZE) {
+        status.m_cpuErrno = EINVAL;
+      } else {
+        CPU_SET(config.m_cpu, &cpus);
+        if(0 == ::sched_setaffinity(0, sizeof(cpus), &cpus)) {
+          status.m_cpu = config.m_cpu;
+        } else {
+          status.m_cpuErrno = errno;
+        }
+      }
+    }
+
+    if(config.m_priority > 0) {
+      int maxPriority = ::sched_get_priority_max(SCHED_FIFO);
+      int priority = config.m_priority;
+      if(priority > maxPriority) {
+        priority = maxPriority;
+        status.m_priorityErrno = EINVAL;
+      }
+      status.m_priority = setFifo(priority, status.m_priorityErrno);
+      if(0 == status.m_priority) {
+        status.m_nice = setLowestNice();
+      }
+    }
+
+    if(config.m_isMemoryLocked) {
+      if(0 == ::mlockall(MCL_CURRENT | MCL_FUTURE)) {
+        status.m_isMemoryLocked = true;
+        status.m_isFutureMemoryLocked = true;
+      } else {
+        status.m_lockErrno = errno;
+        status.m_isMemoryLocked = (0 == ::mlockall(MCL_CURRENT));
+      }
+    }
+
+    if(0U != config.m_stackBytes) {
+      prefaultStack(config.m_stackBytes);
+    }
+    return status;
+  }
+
+
+  void Realtime::prefault(void *data, size_t size) {
+    auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    auto *bytes = static_cast<volatile char *>(data);
+    // write the same value back, page gets allocated and stays dirty
+    for(size_t i = 0U; i < size; i += page) {
+      bytes[i] = bytes[i];
+    }
+    if(0U != size) {
+      bytes[size - 1U] = bytes[size - 1U];
+    }
+  }
+
+
+  void Realtime::print(const Config &config, const Status &status) {
+    if(config.m_cpu >= 0) {
+      if(status.m_cpu >= 0) {
+        std::printf("pinned to CPU %d\n", status.m_cpu);
+      } else {
+        std::printf("not pinned (CPU %d: %s)\n", config.m_cpu, std::strerror(status.m_cpuErrno));
+      }
+    }
+    if(config.m_priority > 0) {
+      if(status.m_priority == config.m_priority) {
+        std::printf("SCHED_FIFO %d\n", status.m_priority);
+      } else if(status.m_priority > 0) {
+        std::printf("SCHED_FIFO %d (requested %d: %s)\n", status.m_priority,
+                    config.m_priority, std::strerror(status.m_priorityErrno));
+      } else {
+        std::printf("SCHED_OTHER nice %d (SCHED_FIFO %d: %s)\n", status.m_nice,
+                    config.m_priority, std::strerror(status.m_priorityErrno));
+      }
+    }
+    if(config.m_isMemoryLocked) {
+      if(status.m_isFutureMemoryLocked) {
+        std::printf("memory locked\n");
+      } else if(status.m_isMemoryLocked) {
+        std::printf("current memory locked (future: %s)\n", std::strerror(status.m_lockErrno));
+      } else {
+        std::printf("memory not locked (%s), prefaulted only\n",
+                    std::strerror(status.m_lockErrno));
+      }
+    }
+  }
+
+} // end namespace Eet
@@ -0,0 +1,50 @@
+#ifndef EET_REALTIME_H
+#define EET_REALTIME_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Eet {
+/**
+ * Real-time setup of the calling (processing) thread on a stock Linux
+ * kernel, every step falls back on its own when privileges are missing:
+ *   pin to CPU      - sched_setaffinity(), skipped if the CPU is not allowed
+ *   SCHED_FIFO      - requested priority, clamped to RLIMIT_RTPRIO without
+ *                     CAP_SYS_NICE, SCHED_OTHER with the lowest allowed nice
+ *                     value if RT priority is not allowed at all
+ *   lock memory     - mlockall(current and future), only current mappings
+ *                     if RLIMIT_MEMLOCK is too small for future ones
+ *   prefault stack  - touches m_stackBytes below the caller's frame
+ * Call apply() before the processing loop, then prefault() every buffer
+ * the loop uses (devices, frames, histograms) so it never page faults;
+ * without locked memory prefaulted pages may still be swapped out.
+ */
+  class Realtime {
+    public:
+      struct Config {
+        int m_cpu;       // -1 - not pinned
+        int m_priority;  // SCHED_FIFO 1..99, 0 - SCHED_OTHER
+        bool m_isMemoryLocked;
+        size_t m_stackBytes;
+      };
+
+      // what has been applied, errno of the first failed attempt of each step
+      struct Status {
+        int m_cpu;      // -1 - not pinned
+        int m_priority; // SCHED_FIFO priority, 0 - SCHED_OTHER
+        int m_nice;     // SCHED_OTHER only
+        bool m_isMemoryLocked;        // current mappings
+        bool m_isFutureMemoryLocked;  // and future ones
+        int m_cpuErrno;
+        int m_priorityErrno;
+        int m_lockErrno;
+      };
+
+      static Status apply(const Config &config);
+      static void prefault(void *data, size_t size);
+      // one line per step, e.g. "SCHED_FIFO 40 (requested 80: Operation not permitted)"
+      static void print(const Config &config, const Status &status);
+  };
+} // end namespace Eet
+
+#endif // EET_REALTIME_H
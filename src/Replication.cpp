@@ -0,0 +1,319 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Replication.h"
+#include "Clock.h"
+
+namespace Eet {
+
+  namespace {
+    bool fillAddr(sockaddr_un &addr, const char *path) {
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      auto len = std::strlen(path);
+      if(len >= sizeof(addr.sun_path)) {
+        return false;
+      }
+      std::memcpy(addr.sun_path, path, len);
+      return true;
+    }
+
+    using Epoch = std::atomic<uint32_t>;
+
+    // file is created zeroed, so the first open() or takeover makes epoch 1
+    Epoch *mapEpoch(const char *path) {
+      char name[sizeof(sockaddr_un::sun_path) + 8U];
+      if(std::strlen(path) + std::strlen(Replication::EPOCH_SUFFIX) >= sizeof(name)) {
+        return nullptr;
+      }
+      std::strcpy(name, path);
+      std::strcat(name, Replication::EPOCH_SUFFIX);
+      auto fd = ::open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+      if(fd < 0) {
+        return nullptr;
+      }
+      struct stat st{};
+      if((0 != ::fstat(fd, &st)) ||
+         ((st.st_size < static_cast<off_t>(sizeof(Epoch))) &&
+          (0 != ::ftruncate(fd, sizeof(Epoch))))) {
+        ::close(fd);
+        return nullptr;
+      }
+      auto addr = ::mmap(nullptr, sizeof(Epoch), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      return (MAP_FAILED == addr) ? nullptr : static_cast<Epoch *>(addr);
+    }
+
+    void unmapEpoch(Epoch *&epoch) {
+      if(nullptr != epoch) {
+        ::munmap(epoch, sizeof(Epoch));
+        epoch = nullptr;
+      }
+    }
+
+    uint32_t claimEpoch(Epoch &epoch) {
+      return epoch.fetch_add(1U, std::memory_order_acq_rel) + 1U;
+    }
+  }
+
+
+  Replication::Primary::Primary() :
+    m_path{},
+    m_fd(-1),
+    m_isSnapshotSent(false),
+    ma_lastState{},
+    m_epoch(nullptr),
+    m_ownEpoch(0U),
+    m_numOfDropped(0U) {}
+
+
+  Replication::Primary::~Primary() {
+    close();
+  }
+
+
+  bool Replication::Primary::open(const char *path) {
+    close();
+    std::strncpy(m_path, path, MAX_PATH_SIZE - 1);
+    m_path[MAX_PATH_SIZE - 1] = '\0';
+    m_epoch = mapEpoch(m_path);
+    if(nullptr == m_epoch) {
+      return false;
+    }
+    m_ownEpoch = claimEpoch(*m_epoch);
+    m_numOfDropped = 0U;
+    connect();
+    return true;
+  }
+
+
+  void Replication::Primary::close() {
+    disconnect();
+    unmapEpoch(m_epoch);
+  }
+
+
+  void Replication::Primary::disconnect() {
+    if(m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+    m_isSnapshotSent = false;
+  }
+
+
+  bool Replication::Primary::isActive() const {
+    return (nullptr != m_epoch) && (m_ownEpoch == m_epoch->load(std::memory_order_acquire));
+  }
+
+
+  bool Replication::Primary::isConnected() const {
+    return m_fd >= 0;
+  }
+
+
+  bool Replication::Primary::connect() {
+    sockaddr_un addr{};
+    if(not fillAddr(addr, m_path)) {
+      return false;
+    }
+    m_fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if(m_fd < 0) {
+      return false;
+    }
+    if(0 != ::connect(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))) {
+      disconnect();
+      return false;
+    }
+    m_isSnapshotSent = false; // new standby must get full state
+    return true;
+  }
+
+
+  bool Replication::Primary::send(const uint8_t *buf, uint32_t size) {
+    if(not isActive()) {
+      disconnect(); // replaced, standby must not get our state any more
+      return false;
+    }
+    if((not isConnected()) && (not connect())) {
+      return false;
+    }
+    auto ret = ::send(m_fd, buf, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if((ret < 0) && ((EAGAIN == errno) || (EWOULDBLOCK == errno))) {
+      // standby is slow, drop the message, STATE is resent by next publish()
+      ++m_numOfDropped;
+      return false;
+    }
+    if(ret != static_cast<ssize_t>(size)) {
+      disconnect();
+      return false;
+    }
+    return true;
+  }
+
+
+  bool Replication::Primary::publish(const Device &device) {
+    uint8_t msg[MAX_MSG_SIZE];
+    msg[0] = static_cast<uint8_t>(MsgType::STATE);
+    device.getSnapshot().encode(msg + 1, Snapshot::SIZE);
+
+    // sequence and checksum differ each time, compare state bytes only
+    if(m_isSnapshotSent && isConnected() &&
+       (0 == std::memcmp(ma_lastState, msg + 1, Snapshot::SEQUENCE_POS))) {
+      return keepalive();
+    }
+    bool ret = send(msg, MAX_MSG_SIZE);
+    if(ret) {
+      std::memcpy(ma_lastState, msg + 1, Snapshot::SIZE);
+      m_isSnapshotSent = true;
+    }
+    return ret;
+  }
+
+
+  bool Replication::Primary::keepalive() {
+    auto msg = static_cast<uint8_t>(MsgType::KEEPALIVE);
+    return send(&msg, 1U);
+  }
+
+
+  uint64_t Replication::Primary::getNumOfDropped() const {
+    return m_numOfDropped;
+  }
+
+
+  Replication::Standby::Standby() :
+    m_epoch(nullptr),
+    m_ownEpoch(0U),
+    m_listenFd(-1),
+    m_fd(-1),
+    m_timeoutNs(0U),
+    m_lastRxNs(0U),
+    m_takeoverNs(0U),
+    m_numOfUpdates(0U),
+    m_isActive(false) {}
+
+
+  Replication::Standby::~Standby() {
+    close();
+  }
+
+
+  bool Replication::Standby::open(const char *path, uint64_t timeoutNs) {
+    close();
+    sockaddr_un addr{};
+    if(not fillAddr(addr, path)) {
+      return false;
+    }
+    m_epoch = mapEpoch(path);
+    if(nullptr == m_epoch) {
+      return false;
+    }
+    m_listenFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if(m_listenFd < 0) {
+      return false;
+    }
+    ::unlink(path);
+    if((0 != ::bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))) ||
+       (0 != ::listen(m_listenFd, 1))) {
+      close();
+      return false;
+    }
+    m_timeoutNs = timeoutNs;
+    m_lastRxNs = Clock::monotonicNs();
+    m_isActive = false;
+    m_numOfUpdates = 0U;
+    return true;
+  }
+
+
+  void Replication::Standby::close() {
+    disconnect();
+    unmapEpoch(m_epoch);
+  }
+
+
+  void Replication::Standby::disconnect() {
+    if(m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+    if(m_listenFd >= 0) {
+      ::close(m_listenFd);
+      m_listenFd = -1;
+    }
+  }
+
+
+  void Replication::Standby::poll(Device &device) {
+    if(m_isActive) {
+      return;
+    }
+    if(m_fd < 0) {
+      m_fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+      if(m_fd >= 0) {
+        m_lastRxNs = Clock::monotonicNs();
+      }
+    }
+    if(m_fd >= 0) {
+      uint8_t msg[MAX_MSG_SIZE];
+      while(true) {
+        auto size = ::recv(m_fd, msg, sizeof(msg), MSG_DONTWAIT);
+        if(size > 0) {
+          m_lastRxNs = Clock::monotonicNs();
+          Snapshot snapshot{};
+          if((static_cast<uint8_t>(MsgType::STATE) == msg[0]) &&
+             (0U == snapshot.decode(msg + 1, static_cast<uint32_t>(size - 1))) &&
+             device.restore(snapshot)) {
+            ++m_numOfUpdates;
+          }
+        } else if((0 == size) || ((EAGAIN != errno) && (EWOULDBLOCK != errno))) {
+          // primary has closed connection or died
+          takeover();
+          return;
+        } else {
+          break;
+        }
+      }
+    }
+    if(Clock::monotonicNs() - m_lastRxNs > m_timeoutNs) {
+      takeover();
+    }
+  }
+
+
+  void Replication::Standby::takeover() {
+    m_ownEpoch = claimEpoch(*m_epoch); // fences off the old primary
+    m_isActive = true;
+    m_takeoverNs = Clock::monotonicNs();
+    disconnect();
+  }
+
+
+  bool Replication::Standby::isActive() const {
+    return m_isActive && (nullptr != m_epoch) &&
+           (m_ownEpoch == m_epoch->load(std::memory_order_acquire));
+  }
+
+
+  bool Replication::Standby::isPrimaryConnected() const {
+    return m_fd >= 0;
+  }
+
+
+  uint64_t Replication::Standby::getTakeoverTimeNs() const {
+    return m_takeoverNs;
+  }
+
+
+  uint32_t Replication::Standby::getNumOfUpdates() const {
+    return m_numOfUpdates;
+  }
+
+} // end namespace Eet
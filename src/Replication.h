@@ -0,0 +1,117 @@
+#ifndef EET_REPLICATION_H
+#define EET_REPLICATION_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Device.h"
+
+namespace Eet {
+  namespace Replication {
+    enum class MsgType : uint8_t {
+        KEEPALIVE = 1,
+        STATE
+    };
+
+    /*
+     * Message on the wire (SOCK_SEQPACKET, one message per packet):
+     *   0     MsgType
+     *   1-... Snapshot (only for STATE)
+     * STATE is sent only when snapshot differs from the last sent one,
+     * otherwise single byte KEEPALIVE is sent.
+     */
+    constexpr uint32_t MAX_MSG_SIZE = 1U + Snapshot::SIZE;
+
+    /*
+     * Fencing token: epoch in file <path>.epoch shared by both sides.
+     * Primary::open() and Standby takeover increment it and the side which
+     * has made the latest increment is the active one. A side which has
+     * lost its role sees another epoch in the file, isActive() is false.
+     */
+    constexpr const char *EPOCH_SUFFIX = ".epoch";
+
+/**
+ * Active side. Call publish() after every update() of the Master and
+ * transmit to the bus only while isActive() - it is false once standby
+ * has taken over, even if this process has only been stalled.
+ * Connection to standby is (re)established on demand, so primary
+ * may be started before standby. Full socket buffer (slow standby) drops
+ * the message and keeps the connection, the next publish() sends the
+ * latest state.
+ */
+    class Primary {
+      public:
+        Primary();
+        ~Primary();
+        Primary(const Primary &) = delete;
+        Primary &operator=(const Primary &) = delete;
+
+        // false if the epoch file can not be mapped
+        bool open(const char *path);
+        void close();
+        bool isActive() const;
+        bool isConnected() const;
+        // false if not active, disconnected or the message has been dropped
+        bool publish(const Device &device);
+        bool keepalive(); // may be called more often than publish()
+        uint64_t getNumOfDropped() const; // on full socket buffer
+
+      private:
+        bool connect();
+        void disconnect();
+        bool send(const uint8_t *buf, uint32_t size);
+
+        static constexpr uint32_t MAX_PATH_SIZE = 108U;
+        char m_path[MAX_PATH_SIZE];
+        int m_fd;
+        bool m_isSnapshotSent;
+        uint8_t ma_lastState[Snapshot::SIZE];
+        std::atomic<uint32_t> *m_epoch; // shared
+        uint32_t m_ownEpoch;
+        uint64_t m_numOfDropped;
+    };
+
+/**
+ * Backup side. Call poll() periodically (at least as often as primary
+ * publishes). Standby takes over when primary closes connection (process
+ * died) or when nothing was received during timeout. After takeover
+ * isActive() is true and backup Master should start transmitting, the
+ * old primary is fenced off by the new epoch.
+ * Timeout covers hung primary only and must be longer than the interval
+ * between publish()/keepalive() calls. Messages queued while standby has
+ * not polled count as received, so a slow standby does not take over
+ * from a running primary.
+ */
+    class Standby {
+      public:
+        Standby();
+        ~Standby();
+        Standby(const Standby &) = delete;
+        Standby &operator=(const Standby &) = delete;
+
+        bool open(const char *path, uint64_t timeoutNs);
+        void close();
+        void poll(Device &device);
+        bool isActive() const; // has taken over and not been fenced since
+        bool isPrimaryConnected() const;
+        uint64_t getTakeoverTimeNs() const; // monotonic time of takeover
+        uint32_t getNumOfUpdates() const;
+
+      private:
+        void takeover();
+        void disconnect();
+
+        std::atomic<uint32_t> *m_epoch; // shared
+        uint32_t m_ownEpoch;
+        int m_listenFd;
+        int m_fd;
+        uint64_t m_timeoutNs;
+        uint64_t m_lastRxNs;
+        uint64_t m_takeoverNs;
+        uint32_t m_numOfUpdates;
+        bool m_isActive;
+    };
+  } // end namespace Replication
+} // end namespace Eet
+
+#endif // EET_REPLICATION_H
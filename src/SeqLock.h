@@ -0,0 +1,59 @@
+#ifndef EET_SEQ_LOCK_H
+#define EET_SEQ_LOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Eet {
+/**
+ * Single writer, many readers. Writer never waits, readers retry when
+ * they have raced with writer. Works in process-shared memory as long as
+ * std::atomic<uint32_t> is lock-free.
+ */
+  template<typename T>
+  class SeqLock {
+      static_assert(std::is_trivially_copyable<T>::value,
+                    "SeqLock value must be trivially copyable");
+    public:
+      SeqLock() :
+        m_sequence(0U),
+        m_value() {}
+
+      void store(const T &value) {
+        auto sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1U, std::memory_order_relaxed); // odd - writing
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&m_value, &value, sizeof(T));
+        m_sequence.store(sequence + 2U, std::memory_order_release);
+      }
+
+      // false if value has been changed during read
+      bool tryLoad(T &value) const {
+        auto before = m_sequence.load(std::memory_order_acquire);
+        if(before & 1U) {
+          return false;
+        }
+        std::memcpy(&value, &m_value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return before == m_sequence.load(std::memory_order_relaxed);
+      }
+
+      T load() const {
+        T value;
+        while(not tryLoad(value)) {}
+        return value;
+      }
+
+      uint32_t getSequence() const {
+        return m_sequence.load(std::memory_order_acquire);
+      }
+
+    private:
+      std::atomic<uint32_t> m_sequence;
+      T m_value;
+  };
+} // end namespace Eet
+
+#endif // EET_SEQ_LOCK_H
@@ -0,0 +1,136 @@
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "SharedState.h"
+#include "Clock.h"
+
+namespace Eet {
+
+  SharedState::Writer::Writer() :
+    m_segment(nullptr),
+    m_name{},
+    m_record{} {}
+
+
+  SharedState::Writer::~Writer() {
+    close();
+  }
+
+
+  bool SharedState::Writer::open(const char *name) {
+    close();
+    auto fd = ::shm_open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) {
+      return false;
+    }
+    void *data = MAP_FAILED;
+    if(0 == ::ftruncate(fd, sizeof(Segment))) {
+      data = ::mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if(MAP_FAILED == data) {
+      ::shm_unlink(name);
+      return false;
+    }
+    m_segment = new(data) Segment();
+    m_segment->m_magic = Segment::MAGIC;
+    m_segment->m_version = Segment::VERSION;
+    m_segment->m_size = sizeof(Segment);
+    std::strncpy(m_name, name, sizeof(m_name) - 1U);
+    m_record = Record{};
+    return true;
+  }
+
+
+  void SharedState::Writer::close() {
+    if(nullptr != m_segment) {
+      ::munmap(m_segment, sizeof(Segment));
+      ::shm_unlink(m_name);
+      m_segment = nullptr;
+    }
+  }
+
+
+  void SharedState::Writer::countFrame(uint16_t pushResult) {
+    ++m_record.m_numOfFrames;
+    m_record.m_numOfInvalidFrames += (0U != pushResult);
+  }
+
+
+  void SharedState::Writer::publish(const Device &device) {
+    if(nullptr == m_segment) {
+      return;
+    }
+    m_record.m_snapshot = device.getSnapshot();
+    m_record.m_timeNs = Clock::monotonicNs();
+    ++m_record.m_numOfUpdates;
+    m_segment->m_record.store(m_record);
+  }
+
+
+  SharedState::Reader::Reader() :
+    m_segment(nullptr) {}
+
+
+  SharedState::Reader::~Reader() {
+    close();
+  }
+
+
+  bool SharedState::Reader::open(const char *name) {
+    close();
+    auto fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if(fd < 0) {
+      return false;
+    }
+    void *data = ::mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(MAP_FAILED == data) {
+      return false;
+    }
+    m_segment = static_cast<const Segment *>(data);
+    if((Segment::MAGIC != m_segment->m_magic) ||
+       (Segment::VERSION != m_segment->m_version) ||
+       (sizeof(Segment) != m_segment->m_size)) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+
+  void SharedState::Reader::close() {
+    if(nullptr != m_segment) {
+      ::munmap(const_cast<Segment *>(m_segment), sizeof(Segment));
+      m_segment = nullptr;
+    }
+  }
+
+
+  bool SharedState::Reader::isOpen() const {
+    return nullptr != m_segment;
+  }
+
+
+  bool SharedState::Reader::read(Record &record) const {
+    if(not isOpen()) {
+      return false;
+    }
+    for(uint32_t i = 0U; i < MAX_RETRIES; ++i) {
+      if(m_segment->m_record.tryLoad(record)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+
+  uint32_t SharedState::Reader::getSequence() const {
+    return isOpen() ? m_segment->m_record.getSequence() : 0U;
+  }
+
+} // end namespace Eet
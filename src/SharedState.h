@@ -0,0 +1,78 @@
+#ifndef EET_SHARED_STATE_H
+#define EET_SHARED_STATE_H
+
+#include <cstdint>
+
+#include "Device.h"
+#include "SeqLock.h"
+
+namespace Eet {
+  namespace SharedState {
+    struct Record {
+      Snapshot m_snapshot;
+      uint64_t m_timeNs; // CLOCK_MONOTONIC of publish()
+      uint64_t m_numOfUpdates;
+      uint64_t m_numOfFrames;
+      uint64_t m_numOfInvalidFrames;
+    };
+
+    // layout of POSIX shared memory object
+    struct Segment {
+      static constexpr uint32_t MAGIC = 0x45455453UL; // "EETS"
+      static constexpr uint32_t VERSION = 2U; // of Snapshot layout too
+
+      uint32_t m_magic;
+      uint32_t m_version;
+      uint32_t m_size;
+      alignas(64) SeqLock<Record> m_record;
+    };
+
+/**
+ * Publishes device state into shared memory object (shm_open() name, e.g.
+ * "/eet-master-1"). Call countFrame() with result of every pushMsg() and
+ * publish() after every update(). Never blocks.
+ */
+    class Writer {
+      public:
+        Writer();
+        ~Writer();
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        bool open(const char *name);
+        void close();
+        void countFrame(uint16_t pushResult);
+        void publish(const Device &device);
+
+      private:
+        Segment *m_segment;
+        char m_name[64];
+        Record m_record;
+    };
+
+/**
+ * Lock-free and syscall-free (after open()) reader of Writer's segment.
+ */
+    class Reader {
+      public:
+        Reader();
+        ~Reader();
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        bool open(const char *name);
+        void close();
+        bool isOpen() const;
+        // false if not open or writer has died in the middle of publish()
+        bool read(Record &record) const;
+        uint32_t getSequence() const; // changes on every publish()
+
+      private:
+        static constexpr uint32_t MAX_RETRIES = 100000U;
+
+        const Segment *m_segment;
+    };
+  } // end namespace SharedState
+} // end namespace Eet
+
+#endif // EET_SHARED_STATE_H
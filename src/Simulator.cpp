@@ -0,0 +1,271 @@
+#include "Simulator.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr Simulator::Config DEFAULT_CONFIG = {
+      125000U,     // bit/s
+      100000000U,  // heartbeat each 100 ms
+      300000000U   // update each 300 ms
+    };
+  }
+
+
+  Simulator::Simulator() :
+    Simulator(DEFAULT_CONFIG) {}
+
+
+  Simulator::Simulator(const Config &config) :
+    m_config(config),
+    m_sink(nullptr),
+    m_timeNs(0U),
+    ma_nodes{},
+    m_numOfNodes(0U),
+    m_txQueueMode(TxQueue::Mode::PRIORITY),
+    m_isBusy(false),
+    m_onBus{},
+    m_txEndNs(0U),
+    m_busyNs(0U),
+    m_numOfFrames(0U),
+    m_numOfDropped(0U),
+    m_numOfAlarms(0U) {}
+
+
+  bool Simulator::attach(Device &device, bool isBooting) {
+    if(m_numOfNodes >= MAX_DEVICES) {
+      return false;
+    }
+    auto &node = ma_nodes[m_numOfNodes];
+    node.m_device = &device;
+    // spread nodes over the period like unsynchronized real devices
+    node.m_nextHeartbeatNs = m_timeNs + m_config.m_heartbeatPeriodNs * m_numOfNodes / MAX_DEVICES;
+    node.m_nextUpdateNs = m_timeNs + m_config.m_updatePeriodNs * (m_numOfNodes + 1U) / (MAX_DEVICES + 1U);
+    node.m_numOfUpdates = 0U;
+    node.m_policy = nullptr;
+    node.m_txQueue.clear();
+    node.m_txQueue.setMode(m_txQueueMode);
+    ++m_numOfNodes;
+    if(isBooting) {
+      device.startDiscovery();
+      send(device, device.getDiscoverMsg());
+    }
+    return true;
+  }
+
+
+  uint32_t Simulator::findNode(const Device &device) const {
+    uint32_t i = 0U;
+    while((i < m_numOfNodes) && (ma_nodes[i].m_device != &device)) {
+      ++i;
+    }
+    return i;
+  }
+
+
+  bool Simulator::send(const Device &from, const Protocol::Can::RawMsg &msg) {
+    auto node = findNode(from);
+    if((node >= m_numOfNodes) || not ma_nodes[node].m_txQueue.push(msg, m_timeNs)) {
+      ++m_numOfDropped;
+      return false;
+    }
+    if(not m_isBusy) {
+      startTx();
+    }
+    return true;
+  }
+
+
+  bool Simulator::setUpdatePhase(const Device &device, uint64_t delayNs) {
+    auto node = findNode(device);
+    if(node >= m_numOfNodes) {
+      return false;
+    }
+    ma_nodes[node].m_nextUpdateNs = m_timeNs + delayNs;
+    return true;
+  }
+
+
+  bool Simulator::setHeartbeatPhase(const Device &device, uint64_t delayNs) {
+    auto node = findNode(device);
+    if(node >= m_numOfNodes) {
+      return false;
+    }
+    ma_nodes[node].m_nextHeartbeatNs = m_timeNs + delayNs;
+    return true;
+  }
+
+
+  bool Simulator::setHeartbeatPolicy(const Device &device, HeartbeatPolicy *policy) {
+    auto node = findNode(device);
+    if(node >= m_numOfNodes) {
+      return false;
+    }
+    ma_nodes[node].m_policy = policy;
+    return true;
+  }
+
+
+  void Simulator::setTxQueueMode(TxQueue::Mode mode) {
+    m_txQueueMode = mode;
+    for(uint32_t i = 0U; i < m_numOfNodes; ++i) {
+      ma_nodes[i].m_txQueue.setMode(mode);
+    }
+  }
+
+
+  void Simulator::setSink(IFrameSink *sink) {
+    m_sink = sink;
+  }
+
+
+  void Simulator::startTx() {
+    if(m_isBusy) {
+      return;
+    }
+    // arbitration between fronts of TX queues - lowest CAN ID wins,
+    // FIFO among equal IDs
+    uint32_t winner = m_numOfNodes;
+    for(uint32_t i = 0U; i < m_numOfNodes; ++i) {
+      if(ma_nodes[i].m_txQueue.isEmpty()) {
+        continue;
+      }
+      if(winner == m_numOfNodes) {
+        winner = i;
+        continue;
+      }
+      const auto &a = ma_nodes[i].m_txQueue.front();
+      const auto &b = ma_nodes[winner].m_txQueue.front();
+      if((a.m_msg.m_canId < b.m_msg.m_canId) ||
+         ((a.m_msg.m_canId == b.m_msg.m_canId) && (a.m_queuedNs < b.m_queuedNs))) {
+        winner = i;
+      }
+    }
+    if(winner == m_numOfNodes) {
+      return;
+    }
+    m_onBus = {ma_nodes[winner].m_txQueue.front().m_msg, winner};
+    ma_nodes[winner].m_txQueue.pop();
+    auto bits = static_cast<uint64_t>(Protocol::Can::getMaxFrameBits(m_onBus.m_msg.m_dlc));
+    auto frameNs = bits * 1000000000U / m_config.m_bitrate;
+    m_txEndNs = m_timeNs + frameNs;
+    m_busyNs += frameNs;
+    m_isBusy = true;
+  }
+
+
+  void Simulator::finishTx() {
+    m_isBusy = false;
+    ++m_numOfFrames;
+    if(nullptr != m_sink) {
+      m_sink->onFrame(m_onBus.m_msg, m_timeNs);
+    }
+    for(uint32_t i = 0U; i < m_numOfNodes; ++i) {
+      if(i != m_onBus.m_node) {
+        ma_nodes[i].m_device->pushMsg(m_onBus.m_msg);
+      }
+    }
+    // after delivery - send() may put the next frame on the bus
+    for(uint32_t i = 0U; i < m_numOfNodes; ++i) {
+      auto &node = ma_nodes[i];
+      if(node.m_device->isHeartbeatRequested()) {
+        send(*node.m_device, node.m_device->getHeartbeatMsg());
+      }
+      if(node.m_device->isDiscoveryComplete()) {
+        update(node);
+      }
+    }
+    startTx();
+  }
+
+
+  void Simulator::update(Node &node) {
+    constexpr char LOSS_ERRORS = (1 << Protocol::CON_WITH_SOME_SLAVES_LOST) |
+                                 (1 << Protocol::CON_WITH_ALL_SLAVES_LOST) |
+                                 (1 << Protocol::CON_WITH_SOME_MASTERS_LOST) |
+                                 (1 << Protocol::CON_WITH_ALL_MASTERS_LOST) |
+                                 (1 << Protocol::NO_CONNECTION);
+    node.m_device->update();
+    ++node.m_numOfUpdates;
+    m_numOfAlarms += (0 != (node.m_device->getErrors() & LOSS_ERRORS));
+  }
+
+
+  void Simulator::run(uint64_t durationNs) {
+    auto endNs = m_timeNs + durationNs;
+    while(true) {
+      auto nextNs = endNs + 1U;
+      if(m_isBusy) {
+        nextNs = m_txEndNs;
+      }
+      for(uint32_t i = 0U; i < m_numOfNodes; ++i) {
+        if(nullptr != ma_nodes[i].m_policy) {
+          auto heartbeatNs = ma_nodes[i].m_policy->getNextNs(*ma_nodes[i].m_device, m_timeNs);
+          ma_nodes[i].m_nextHeartbeatNs = (heartbeatNs < m_timeNs) ? m_timeNs : heartbeatNs;
+        }
+        if(ma_nodes[i].m_nextUpdateNs < nextNs) {
+          nextNs = ma_nodes[i].m_nextUpdateNs;
+        }
+        if(ma_nodes[i].m_nextHeartbeatNs < nextNs) {
+          nextNs = ma_nodes[i].m_nextHeartbeatNs;
+        }
+      }
+      if(nextNs > endNs) {
+        break;
+      }
+      m_timeNs = nextNs;
+
+      // frame end first, so update() takes into account frame which just arrived
+      if(m_isBusy && (m_txEndNs == m_timeNs)) {
+        finishTx();
+      }
+      for(uint32_t i = 0U; i < m_numOfNodes; ++i) {
+        auto &node = ma_nodes[i];
+        if(node.m_nextUpdateNs == m_timeNs) {
+          update(node);
+          node.m_nextUpdateNs += m_config.m_updatePeriodNs;
+        }
+        if(node.m_nextHeartbeatNs == m_timeNs) {
+          send(*node.m_device, node.m_device->getHeartbeatMsg());
+          if(nullptr != node.m_policy) {
+            node.m_policy->onSent(m_timeNs);
+          } else {
+            node.m_nextHeartbeatNs += m_config.m_heartbeatPeriodNs;
+          }
+        }
+      }
+    }
+    m_timeNs = endNs;
+  }
+
+
+  uint64_t Simulator::nowNs() const {
+    return m_timeNs;
+  }
+
+
+  uint64_t Simulator::getBusyNs() const {
+    return m_busyNs;
+  }
+
+
+  uint64_t Simulator::getNumOfFrames() const {
+    return m_numOfFrames;
+  }
+
+
+  uint64_t Simulator::getNumOfDropped() const {
+    return m_numOfDropped;
+  }
+
+
+  uint64_t Simulator::getNumOfAlarms() const {
+    return m_numOfAlarms;
+  }
+
+
+  uint64_t Simulator::getNumOfUpdates(const Device &device) const {
+    auto node = findNode(device);
+    return (node < m_numOfNodes) ? ma_nodes[node].m_numOfUpdates : 0U;
+  }
+
+} // end namespace Eet
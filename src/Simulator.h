@@ -0,0 +1,98 @@
+#ifndef EET_SIMULATOR_H
+#define EET_SIMULATOR_H
+
+#include <cstdint>
+
+#include "Device.h"
+#include "Clock.h"
+#include "FrameSink.h"
+#include "HeartbeatPolicy.h"
+#include "TxQueue.h"
+
+namespace Eet {
+/**
+ * Discrete-event simulation of one EET network on a single CAN bus.
+ * 1. attach() devices
+ * 2. run() for some virtual time, do operator actions on devices
+ *    (send() frames they produce, e.g. Master cmd), run() again
+ *
+ * Every attached device sends heartbeat each heartbeat period (or when
+ * its HeartbeatPolicy tells) and calls update() each update period,
+ * phases are staggered. Booting device starts
+ * discovery, devices answer heartbeat requests at once and booting device
+ * calls update() as soon as discovery is complete. Frames wait in TxQueue
+ * of the sender, the fronts of the queues win arbitration by lowest CAN ID
+ * (the earliest queued among equal IDs), frame time is worst-case (bit stuffed)
+ * length at configured bitrate. Virtual time is available through IClock
+ * so tracers may be attached to devices.
+ */
+  class Simulator final : public IClock {
+    public:
+      struct Config {
+        uint32_t m_bitrate;
+        uint64_t m_heartbeatPeriodNs;
+        uint64_t m_updatePeriodNs;
+      };
+
+      static constexpr uint32_t MAX_DEVICES = Protocol::DeviceId::MAX_DEVICE_ID;
+
+      Simulator();
+      explicit Simulator(const Config &config);
+
+      bool attach(Device &device, bool isBooting = false);
+      bool send(const Device &from, const Protocol::Can::RawMsg &msg);
+      // next periodic update() of the device is after delayNs
+      bool setUpdatePhase(const Device &device, uint64_t delayNs);
+      // next heartbeat of the device is after delayNs, the same delay for all
+      // devices gives the critical instant (worst-case queuing)
+      bool setHeartbeatPhase(const Device &device, uint64_t delayNs);
+      // nullptr - fixed heartbeat period
+      bool setHeartbeatPolicy(const Device &device, HeartbeatPolicy *policy);
+      void setTxQueueMode(TxQueue::Mode mode); // of all devices, PRIORITY by default
+      void setSink(IFrameSink *sink); // gets every frame put on the bus
+      void run(uint64_t durationNs);
+      uint64_t nowNs() const override;
+
+      uint64_t getBusyNs() const;
+      uint64_t getNumOfFrames() const;
+      uint64_t getNumOfDropped() const; // TX queue overflow
+      uint64_t getNumOfUpdates(const Device &device) const;
+      uint64_t getNumOfAlarms() const; // update() calls which ended with lost connection
+
+    private:
+      struct Node {
+        Device *m_device;
+        uint64_t m_nextHeartbeatNs;
+        uint64_t m_nextUpdateNs;
+        uint64_t m_numOfUpdates;
+        HeartbeatPolicy *m_policy;
+        TxQueue m_txQueue;
+      };
+
+      struct OnBus {
+        Protocol::Can::RawMsg m_msg;
+        uint32_t m_node;
+      };
+
+      void startTx();
+      void update(Node &node);
+      void finishTx();
+      uint32_t findNode(const Device &device) const;
+
+      Config m_config;
+      IFrameSink *m_sink;
+      uint64_t m_timeNs;
+      Node ma_nodes[MAX_DEVICES];
+      uint32_t m_numOfNodes;
+      TxQueue::Mode m_txQueueMode;
+      bool m_isBusy;
+      OnBus m_onBus;
+      uint64_t m_txEndNs;
+      uint64_t m_busyNs;
+      uint64_t m_numOfFrames;
+      uint64_t m_numOfDropped;
+      uint64_t m_numOfAlarms;
+  };
+} // end namespace Eet
+
+#endif // EET_SIMULATOR_H
@@ -1,4 +1,5 @@
 #include "Device.h"
+#include "Tracer.h"
 #include "Helpers.h"
 
 namespace Eet {
@@ -9,7 +10,7 @@ namespace Eet {
 
 
   void Slave::setCmdType(Eet::Protocol::CmdType cmdType) {
-    m_cmdType = cmdType;
+    storeCmdType(cmdType);
   }
 
 
@@ -21,6 +22,7 @@ namespace Eet {
 
   void Slave::setDeviceId(char id) {
     m_deviceId = id;
+    clearHeartbeatCache();
   }
 
 
@@ -36,7 +38,7 @@ namespace Eet {
 
   void Slave::pushActivate(const Protocol::Msg::Activate &msg) {
     if(Protocol::DeviceType::SLAVE == msg.m_commonFields.m_deviceType) {
-      m_slaveState = Protocol::SlaveState::NOT_ACTIVE;
+      storeSlaveState(Protocol::SlaveState::NOT_ACTIVE);
     }
   }
 
@@ -45,7 +47,7 @@ namespace Eet {
     switch(msg.m_slaveState) {
       case Protocol::SlaveState::ACTIVE:
         setCmdType(msg.m_cmdType);
-        m_approveState = msg.m_approveState;
+        storeApproveState(msg.m_approveState);
         ma_activeSlaves.set(static_cast<size_t>(msg.m_commonFields.m_deviceId-1));
         break;
       case Protocol::SlaveState::NOT_ACTIVE:
@@ -60,40 +62,40 @@ namespace Eet {
   void Slave::pushCmd(const Protocol::Msg::Cmd &msg) {
     if(Protocol::DeviceType::MASTER == msg.m_commonFields.m_deviceType) {
       setCmdType(msg.m_cmdType);
-      m_approveState = Protocol::ApproveState::NOT_APPROVED;
+      storeApproveState(Protocol::ApproveState::NOT_APPROVED);
+      notifyInput(Input::CMD_RECEIVED, msg.m_cmdType);
     }
   }
 
 
   void Slave::update() {
+    EET_TRACE_SPAN(span, "update", m_deviceId);
     using Protocol::SlaveState;
 
-    m_errors = 0; // wipe errors
-    m_errors |= (isDuplicatedDeviceId() << Protocol::DUPLICATED_DEVICE_ID);
-    m_errors |= (isConWithSomeSlavesLost() << Protocol::CON_WITH_SOME_SLAVES_LOST);
-    m_errors |= (isConWithAllSlavesLost() << Protocol::CON_WITH_ALL_SLAVES_LOST);
-    m_errors |= (isConWithSomeMastersLost() << Protocol::CON_WITH_SOME_MASTERS_LOST);
-    m_errors |= (isConWithAllMastersLost() << Protocol::CON_WITH_ALL_MASTERS_LOST);
-    m_errors |= (isNoConnection() << Protocol::NO_CONNECTION);
+    char errors = 0;
+    errors |= (isDuplicatedDeviceId() << Protocol::DUPLICATED_DEVICE_ID);
+    errors |= (isConWithSomeSlavesLost() << Protocol::CON_WITH_SOME_SLAVES_LOST);
+    errors |= (isConWithAllSlavesLost() << Protocol::CON_WITH_ALL_SLAVES_LOST);
+    errors |= (isConWithSomeMastersLost() << Protocol::CON_WITH_SOME_MASTERS_LOST);
+    errors |= (isConWithAllMastersLost() << Protocol::CON_WITH_ALL_MASTERS_LOST);
+    errors |= (isNoConnection() << Protocol::NO_CONNECTION);
 
     m_isAnyActiveSlave |= (0UL != ma_activeSlaves.count());
     if(m_isAnyActiveSlave || isNoConnection()) {
-      m_slaveState = SlaveState::NOT_ACTIVE;
+      storeSlaveState(SlaveState::NOT_ACTIVE);
     } else if(m_isActivating) {
-      m_slaveState = SlaveState::ACTIVE;
+      storeSlaveState(SlaveState::ACTIVE);
     }
     m_isActivating = false;
-    m_errors |= (isNoActiveSlave() << Protocol::NO_ACTIVE_SLAVE);
+    errors |= (isNoActiveSlave() << Protocol::NO_ACTIVE_SLAVE);
+    storeErrors(filterDiscoveryErrors(errors));
 
-    ma_activeSlaves.reset();
-    ma_respondedMasters.reset();
-    ma_respondedSlaves.reset();
-    m_isAnyDuplicatedId = false;
-    m_isAnyActiveSlave = false;
+    startPeriod();
   }
 
 
   void Slave::activate() {
+    notifyInput(Input::ACTIVATE, m_cmdType);
     m_isActivating = ((Protocol::SlaveState::NOT_ACTIVE == m_slaveState) && isAnyCon());
   }
 
@@ -112,9 +114,26 @@ namespace Eet {
   }
 
 
+  Snapshot Slave::getSnapshot() const {
+    auto snapshot = Device::getSnapshot();
+    snapshot.m_flags |= (m_isActivating << Snapshot::IS_ACTIVATING);
+    return snapshot;
+  }
+
+
+  bool Slave::restore(const Snapshot &snapshot) {
+    bool ret = Device::restore(snapshot);
+    if(ret) {
+      m_isActivating = (snapshot.m_flags >> Snapshot::IS_ACTIVATING) & 0x01;
+    }
+    return ret;
+  }
+
+
   void Slave::approve(Protocol::CmdType cmdType) {
+    notifyInput(Input::APPROVE, cmdType);
     if((Protocol::SlaveState::ACTIVE == m_slaveState) && (cmdType == m_cmdType)) {
-      m_approveState = Protocol::ApproveState::APPROVED;
+      storeApproveState(Protocol::ApproveState::APPROVED);
     }
   }
 
@@ -0,0 +1,145 @@
+#include "Snapshot.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr uint8_t MAGIC_0 = 'E';
+    constexpr uint8_t MAGIC_1 = 'S';
+    constexpr uint32_t CHECKSUM_POS = Snapshot::SIZE - 4U;
+    constexpr uint32_t MAX_PEERS = Protocol::DeviceId::MAX_DEVICE_ID;
+    constexpr uint32_t SLAVES_LIVENESS_POS = 24U;
+    constexpr uint32_t MASTERS_LIVENESS_POS = SLAVES_LIVENESS_POS + MAX_PEERS;
+    static_assert(MASTERS_LIVENESS_POS + MAX_PEERS == Snapshot::SEQUENCE_POS &&
+                  Snapshot::SEQUENCE_POS + 4U == CHECKSUM_POS, "Snapshot layout");
+
+    uint32_t fnv1a(const uint8_t *buf, uint32_t size) {
+      uint32_t hash = 2166136261UL;
+      for(uint32_t i = 0U; i < size; ++i) {
+        hash ^= buf[i];
+        hash *= 16777619UL;
+      }
+      return hash;
+    }
+
+    void putU16(uint8_t *buf, uint16_t value) {
+      buf[0] = static_cast<uint8_t>(value);
+      buf[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    void putU32(uint8_t *buf, uint32_t value) {
+      putU16(buf, static_cast<uint16_t>(value));
+      putU16(buf + 2, static_cast<uint16_t>(value >> 16));
+    }
+
+    uint16_t getU16(const uint8_t *buf) {
+      return static_cast<uint16_t>(buf[0] | (buf[1] << 8));
+    }
+
+    uint32_t getU32(const uint8_t *buf) {
+      return getU16(buf) | (static_cast<uint32_t>(getU16(buf + 2)) << 16);
+    }
+
+    template<typename T>
+    T byte2enum(uint8_t val, T lowerBound, T upperBound) {
+      T ret = T::INVALID;
+      if((val >= static_cast<uint8_t>(lowerBound)) &&
+         (val <= static_cast<uint8_t>(upperBound))) {
+        ret = static_cast<T>(val);
+      }
+      return ret;
+    }
+  }
+
+
+  uint32_t Snapshot::encode(uint8_t *buf, uint32_t size) const {
+    if(size < SIZE) {
+      return 0U;
+    }
+    buf[0] = MAGIC_0;
+    buf[1] = MAGIC_1;
+    buf[2] = VERSION;
+    buf[3] = static_cast<uint8_t>(SIZE);
+    buf[4] = static_cast<uint8_t>(m_deviceType);
+    buf[5] = static_cast<uint8_t>(m_deviceId);
+    buf[6] = static_cast<uint8_t>(m_errors);
+    buf[7] = m_numOfMasters;
+    buf[8] = m_numOfSlaves;
+    buf[9] = m_flags;
+    buf[10] = static_cast<uint8_t>(m_slaveState);
+    buf[11] = static_cast<uint8_t>(m_approveState);
+    buf[12] = static_cast<uint8_t>(m_cmdType);
+    buf[13] = static_cast<uint8_t>(m_idScheme);
+    putU16(buf + 14, ma_activeSlaves);
+    putU16(buf + 16, ma_respondedSlaves);
+    putU16(buf + 18, ma_respondedMasters);
+    buf[20] = m_liveness;
+    buf[21] = 0U;
+    putU16(buf + 22, m_numOfDiscoveryUpdates);
+    for(uint32_t i = 0U; i < MAX_PEERS; ++i) {
+      buf[SLAVES_LIVENESS_POS + i] = ma_slavesLiveness[i];
+      buf[MASTERS_LIVENESS_POS + i] = ma_mastersLiveness[i];
+    }
+    putU32(buf + SEQUENCE_POS, m_sequence);
+    putU32(buf + CHECKSUM_POS, fnv1a(buf, CHECKSUM_POS));
+    return SIZE;
+  }
+
+
+  uint16_t Snapshot::decode(const uint8_t *buf, uint32_t size) {
+    uint16_t ret = 0U;
+    if((size < SIZE) || (SIZE != buf[3])) {
+      return (1U << INVALID_SIZE);
+    }
+    ret |= (((MAGIC_0 != buf[0]) || (MAGIC_1 != buf[1])) << INVALID_MAGIC);
+    ret |= ((VERSION != buf[2]) << INVALID_VERSION);
+    ret |= ((getU32(buf + CHECKSUM_POS) != fnv1a(buf, CHECKSUM_POS)) << INVALID_CHECKSUM);
+    if(ret) {
+      return ret;
+    }
+
+    m_deviceType = byte2enum(buf[4], Protocol::DeviceType::MASTER,
+                             Protocol::DeviceType::SLAVE);
+    m_deviceId = static_cast<char>(buf[5]);
+    m_errors = static_cast<char>(buf[6]);
+    m_numOfMasters = buf[7];
+    m_numOfSlaves = buf[8];
+    m_flags = buf[9];
+    m_slaveState = byte2enum(buf[10], Protocol::SlaveState::NOT_ACTIVE,
+                             Protocol::SlaveState::ACTIVE);
+    m_approveState = byte2enum(buf[11], Protocol::ApproveState::NOT_APPROVED,
+                               Protocol::ApproveState::APPROVED);
+    // INVALID is a legal cmd type - device has not got any command yet
+    m_cmdType = static_cast<Protocol::CmdType>(buf[12]);
+    m_idScheme = static_cast<Protocol::Can::IdScheme>(buf[13]);
+    ma_activeSlaves = getU16(buf + 14);
+    ma_respondedSlaves = getU16(buf + 16);
+    ma_respondedMasters = getU16(buf + 18);
+    m_liveness = buf[20];
+    m_numOfDiscoveryUpdates = getU16(buf + 22);
+    for(uint32_t i = 0U; i < MAX_PEERS; ++i) {
+      ma_slavesLiveness[i] = buf[SLAVES_LIVENESS_POS + i];
+      ma_mastersLiveness[i] = buf[MASTERS_LIVENESS_POS + i];
+    }
+    m_sequence = getU32(buf + SEQUENCE_POS);
+
+    ret |= ((Protocol::DeviceType::INVALID == m_deviceType) << INVALID_DEVICE_TYPE);
+    ret |= ((Protocol::SlaveState::INVALID == m_slaveState) << INVALID_SLAVE_STATE);
+    ret |= ((Protocol::ApproveState::INVALID == m_approveState) << INVALID_APPROVE_STATE);
+    ret |= (((Protocol::CmdType::INVALID != m_cmdType) &&
+             (m_cmdType > Protocol::CmdType::FULL_ASTERN)) << INVALID_CMD_TYPE);
+    ret |= ((not Protocol::DeviceId::isCorrectId(m_deviceId)) << INVALID_DEVICE_ID);
+    ret |= (((Protocol::Can::IdScheme::V1 != m_idScheme) &&
+             (Protocol::Can::IdScheme::V2 != m_idScheme) &&
+             (Protocol::Can::IdScheme::COMPAT != m_idScheme)) << INVALID_ID_SCHEME);
+    ret |= (((m_numOfMasters > MAX_PEERS) || (m_numOfSlaves > MAX_PEERS)) <<
+            INVALID_NUM_OF_DEVICES);
+    bool isValidLiveness = (0U != m_liveness);
+    for(uint32_t i = 0U; i < MAX_PEERS; ++i) {
+      isValidLiveness = isValidLiveness && (ma_slavesLiveness[i] <= m_liveness) &&
+                        (ma_mastersLiveness[i] <= m_liveness);
+    }
+    ret |= ((not isValidLiveness) << INVALID_LIVENESS);
+    return ret;
+  }
+
+} // end namespace Eet
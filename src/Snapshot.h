@@ -0,0 +1,94 @@
+#ifndef EET_SNAPSHOT_H
+#define EET_SNAPSHOT_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Runtime state of Master/Slave which is needed to continue operation
+ * after restart without waiting for several update() cycles.
+ *
+ * Binary form (little-endian, SIZE bytes):
+ *   0-1   magic "ES"
+ *   2     VERSION
+ *   3     SIZE
+ *   4     DeviceType
+ *   5     Device ID
+ *   6     Errors byte
+ *   7     Number of Masters
+ *   8     Number of Slaves
+ *   9     Flags (see Flags)
+ *   10    SlaveState
+ *   11    ApproveState
+ *   12    CmdType
+ *   13    Can::IdScheme
+ *   14-15 Active Slaves bits
+ *   16-17 Responded Slaves bits
+ *   18-19 Responded Masters bits
+ *   20    Liveness, update() periods (see Device::setLiveness())
+ *   21    RESERVE
+ *   22-23 update() periods left of discovery, at most 0xFFFF
+ *   24-35 update() periods left until Slave is lost, by Device ID - 1
+ *   36-47 update() periods left until Master is lost, by Device ID - 1
+ *   48-51 Sequence number
+ *   52-55 FNV-1a checksum of bytes 0-51
+ * Version 1 (28 bytes, no liveness, discovery and ID scheme) is not
+ * accepted, device starts from scratch as on the first boot.
+ * HeartbeatPolicy is not a part of it: a new policy sends a heartbeat at
+ * once, which is what peers of a restarted device should get anyway.
+ */
+  struct Snapshot {
+    enum Errors {
+        INVALID_SIZE = 0,
+        INVALID_MAGIC,
+        INVALID_VERSION,
+        INVALID_CHECKSUM,
+        INVALID_DEVICE_TYPE,
+        INVALID_SLAVE_STATE,
+        INVALID_APPROVE_STATE,
+        INVALID_CMD_TYPE,
+        INVALID_DEVICE_ID,
+        INVALID_ID_SCHEME,
+        INVALID_NUM_OF_DEVICES, // of Masters or Slaves over MAX_DEVICE_ID
+        INVALID_LIVENESS        // 0 or a peer counter over it
+    };
+
+    enum Flags {
+        IS_ANY_DUPLICATED_ID = 0,
+        IS_ANY_ACTIVE_SLAVE,
+        IS_ACTIVATING,
+        IS_DISCOVERING,
+        IS_HEARTBEAT_REQUESTED
+    };
+
+    static constexpr uint8_t VERSION = 2U;
+    static constexpr uint32_t SIZE = 56U;
+    static constexpr uint32_t SEQUENCE_POS = 48U; // state is in the bytes before it
+
+    uint32_t encode(uint8_t *buf, uint32_t size) const;
+    uint16_t decode(const uint8_t *buf, uint32_t size);
+
+    Protocol::DeviceType m_deviceType;
+    char m_deviceId;
+    char m_errors;
+    uint8_t m_numOfMasters;
+    uint8_t m_numOfSlaves;
+    uint8_t m_flags;
+    Protocol::SlaveState m_slaveState;
+    Protocol::ApproveState m_approveState;
+    Protocol::CmdType m_cmdType;
+    uint16_t ma_activeSlaves;
+    uint16_t ma_respondedSlaves;
+    uint16_t ma_respondedMasters;
+    Protocol::Can::IdScheme m_idScheme;
+    uint8_t m_liveness;
+    uint16_t m_numOfDiscoveryUpdates;
+    uint8_t ma_slavesLiveness[Protocol::DeviceId::MAX_DEVICE_ID];
+    uint8_t ma_mastersLiveness[Protocol::DeviceId::MAX_DEVICE_ID];
+    uint32_t m_sequence;
+  };
+} // end namespace Eet
+
+#endif // EET_SNAPSHOT_H
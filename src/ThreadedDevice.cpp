@@ -0,0 +1,124 @@
+#include "ThreadedDevice.h"
+
+namespace Eet {
+
+  ThreadedDevice::ThreadedDevice(Device &device) :
+    m_device(device),
+    m_numOfDroppedInputs(0U) {
+    publish();
+  }
+
+
+  uint16_t ThreadedDevice::pushMsg(const Protocol::Can::RawMsg &rawMsg) {
+    processInputs();
+    auto ret = m_device.pushMsg(rawMsg);
+    publish();
+    return ret;
+  }
+
+
+  void ThreadedDevice::update() {
+    processInputs();
+    m_device.update();
+    publish();
+  }
+
+
+  uint32_t ThreadedDevice::processInputs() {
+    uint32_t ret = 0U;
+    Command command{};
+    while(m_mailbox.pop(command)) {
+      switch(command.m_input) {
+        case Input::SET_CMD_TYPE:
+          static_cast<Master &>(m_device).setCmdType(command.m_cmdType);
+          break;
+        case Input::APPROVE:
+          static_cast<Slave &>(m_device).approve(command.m_cmdType);
+          break;
+        case Input::ACTIVATE:
+          static_cast<Slave &>(m_device).activate();
+          break;
+        case Input::CMD_RECEIVED:
+          break; // not an operator action
+      }
+      ++ret;
+    }
+    if(ret) {
+      publish();
+    }
+    return ret;
+  }
+
+
+  bool ThreadedDevice::post(Input input, Protocol::CmdType cmdType) {
+    bool ret = m_mailbox.push({input, cmdType});
+    if(not ret) {
+      m_numOfDroppedInputs.fetch_add(1U, std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
+
+  bool ThreadedDevice::postCmdType(Protocol::CmdType cmdType) {
+    return (Protocol::DeviceType::MASTER == m_device.getDeviceType()) &&
+           post(Input::SET_CMD_TYPE, cmdType);
+  }
+
+
+  bool ThreadedDevice::postApprove(Protocol::CmdType cmdType) {
+    return (Protocol::DeviceType::SLAVE == m_device.getDeviceType()) &&
+           post(Input::APPROVE, cmdType);
+  }
+
+
+  bool ThreadedDevice::postActivate() {
+    return (Protocol::DeviceType::SLAVE == m_device.getDeviceType()) &&
+           post(Input::ACTIVATE, Protocol::CmdType::INVALID);
+  }
+
+
+  void ThreadedDevice::publish() {
+    m_state.store(m_device.getSnapshot());
+  }
+
+
+  Snapshot ThreadedDevice::getSnapshot() const {
+    return m_state.load();
+  }
+
+
+  char ThreadedDevice::getErrors() const {
+    return m_state.load().m_errors;
+  }
+
+
+  Protocol::SlaveState ThreadedDevice::getSlaveState() const {
+    return m_state.load().m_slaveState;
+  }
+
+
+  Protocol::ApproveState ThreadedDevice::getApproveState() const {
+    return m_state.load().m_approveState;
+  }
+
+
+  Protocol::CmdType ThreadedDevice::getCmdType() const {
+    return m_state.load().m_cmdType;
+  }
+
+
+  bool ThreadedDevice::isAnyActiveSlave() const {
+    return not ((getErrors() >> Protocol::NO_ACTIVE_SLAVE) & 0x01);
+  }
+
+
+  bool ThreadedDevice::isAnyCon() const {
+    return not ((getErrors() >> Protocol::NO_CONNECTION) & 0x01);
+  }
+
+
+  uint64_t ThreadedDevice::getNumOfDroppedInputs() const {
+    return m_numOfDroppedInputs.load(std::memory_order_relaxed);
+  }
+
+} // end namespace Eet
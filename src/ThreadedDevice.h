@@ -0,0 +1,67 @@
+#ifndef EET_THREADED_DEVICE_H
+#define EET_THREADED_DEVICE_H
+
+#include <cstdint>
+
+#include "Device.h"
+#include "Mailbox.h"
+#include "SeqLock.h"
+
+namespace Eet {
+/**
+ * Single-writer wrapper for Device shared between threads.
+ *
+ * Owner thread (the only one which touches Device itself):
+ *   pushMsg(), update(), processInputs()
+ * Any thread:
+ *   post*() - operator inputs, applied by owner thread in order
+ *   get*()  - lock-free reads of the state published by owner thread
+ *
+ * Inputs are applied on the next pushMsg()/update()/processInputs() of
+ * the owner, so their effect (e.g. Master cmd msg which should be sent
+ * after setCmdType) is seen by Device observer on the owner thread.
+ */
+  class ThreadedDevice {
+    public:
+      struct Command {
+        Input m_input;
+        Protocol::CmdType m_cmdType;
+      };
+
+      static constexpr uint32_t MAILBOX_SIZE = 64U;
+
+      explicit ThreadedDevice(Device &device);
+
+      // owner thread
+      uint16_t pushMsg(const Protocol::Can::RawMsg &rawMsg);
+      void update();
+      uint32_t processInputs(); // returns number of applied inputs
+
+      // any thread, false if mailbox is full or input is not for this device type
+      bool postCmdType(Protocol::CmdType cmdType); // Master::setCmdType()
+      bool postApprove(Protocol::CmdType cmdType); // Slave::approve()
+      bool postActivate();                         // Slave::activate()
+
+      // any thread, each call is consistent on its own,
+      // use getSnapshot() to read several fields at once
+      Snapshot getSnapshot() const;
+      char getErrors() const;
+      Protocol::SlaveState getSlaveState() const;
+      Protocol::ApproveState getApproveState() const;
+      Protocol::CmdType getCmdType() const;
+      bool isAnyActiveSlave() const;
+      bool isAnyCon() const;
+      uint64_t getNumOfDroppedInputs() const;
+
+    private:
+      bool post(Input input, Protocol::CmdType cmdType);
+      void publish();
+
+      Device &m_device;
+      Mailbox<Command, MAILBOX_SIZE> m_mailbox;
+      alignas(CACHE_LINE_SIZE) SeqLock<Snapshot> m_state;
+      alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_numOfDroppedInputs;
+  };
+} // end namespace Eet
+
+#endif // EET_THREADED_DEVICE_H
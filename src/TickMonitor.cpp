@@ -0,0 +1,117 @@
+#include <cerrno>
+#include <ctime>
+
+#include "TickMonitor.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr TickMonitor::Config DEFAULT_CONFIG = {
+      300000000U, // update each 300 ms
+      5000000U    // 5 ms of jitter
+    };
+  }
+
+
+  TickMonitor::TickMonitor() :
+    TickMonitor(DEFAULT_CONFIG) {}
+
+
+  TickMonitor::TickMonitor(const Config &config) :
+    m_config(config),
+    m_deadlineNs(0U),
+    m_lastTickNs(0U),
+    m_lastJitterNs(0U),
+    m_numOfTicks(0U),
+    m_numOfOverBudget(0U),
+    m_numOfMissed(0U) {
+    m_config.m_periodNs = (0U != config.m_periodNs) ? config.m_periodNs : 1U;
+  }
+
+
+  void TickMonitor::start(uint64_t nowNs) {
+    m_lastTickNs = nowNs;
+    m_deadlineNs = nowNs + m_config.m_periodNs;
+  }
+
+
+  uint64_t TickMonitor::getDeadlineNs() const {
+    return m_deadlineNs;
+  }
+
+
+  bool TickMonitor::isDue(uint64_t nowNs) const {
+    return nowNs >= m_deadlineNs;
+  }
+
+
+  bool TickMonitor::onTick(uint64_t nowNs) {
+    auto periodNs = m_config.m_periodNs;
+    m_wakeUpLatencyNs.record((nowNs > m_deadlineNs) ? (nowNs - m_deadlineNs) : 0U);
+    auto intervalNs = nowNs - m_lastTickNs;
+    auto jitterNs = (intervalNs > periodNs) ? (intervalNs - periodNs) : (periodNs - intervalNs);
+    m_jitterNs.record(jitterNs);
+    m_lastJitterNs = jitterNs;
+    ++m_numOfTicks;
+    m_lastTickNs = nowNs;
+
+    m_deadlineNs += periodNs;
+    if(nowNs >= m_deadlineNs) {
+      auto numOfMissed = (nowNs - m_deadlineNs) / periodNs + 1U;
+      m_numOfMissed += numOfMissed;
+      m_deadlineNs += numOfMissed * periodNs;
+    }
+
+    bool isInBudget = (jitterNs <= m_config.m_jitterBudgetNs);
+    m_numOfOverBudget += (not isInBudget);
+    return isInBudget;
+  }
+
+
+  void TickMonitor::sleep() const {
+    timespec deadline = {static_cast<time_t>(m_deadlineNs / 1000000000U),
+                         static_cast<long>(m_deadlineNs % 1000000000U)};
+    while(EINTR == ::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr)) {}
+  }
+
+
+  const Histogram &TickMonitor::getWakeUpLatencyNs() const {
+    return m_wakeUpLatencyNs;
+  }
+
+
+  const Histogram &TickMonitor::getJitterNs() const {
+    return m_jitterNs;
+  }
+
+
+  uint64_t TickMonitor::getLastJitterNs() const {
+    return m_lastJitterNs;
+  }
+
+
+  uint64_t TickMonitor::getNumOfTicks() const {
+    return m_numOfTicks;
+  }
+
+
+  uint64_t TickMonitor::getNumOfOverBudget() const {
+    return m_numOfOverBudget;
+  }
+
+
+  uint64_t TickMonitor::getNumOfMissed() const {
+    return m_numOfMissed;
+  }
+
+
+  void TickMonitor::resetStats() {
+    m_wakeUpLatencyNs.reset();
+    m_jitterNs.reset();
+    m_lastJitterNs = 0U;
+    m_numOfTicks = 0U;
+    m_numOfOverBudget = 0U;
+    m_numOfMissed = 0U;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,65 @@
+#ifndef EET_TICK_MONITOR_H
+#define EET_TICK_MONITOR_H
+
+#include <cstdint>
+
+#include "Histogram.h"
+
+namespace Eet {
+/**
+ * Deadlines of periodic update() ticks and their timing.
+ *
+ * Responders are counted per update() window, so a tick which comes late
+ * makes the window longer and the next one shorter, and peers which
+ * answered on time may look lost (CON_WITH_SOME_SLAVES_LOST false alarm).
+ * The monitor measures per tick:
+ *   wake-up latency - from the deadline to onTick()
+ *   jitter          - |interval between two ticks - period|
+ * Ticks with jitter over the budget are counted and reported by onTick().
+ * A tick later than a whole period skips the missed deadlines (counted),
+ * the period stays aligned to start().
+ *
+ * 1. start() at the first tick
+ * 2. wait until getDeadlineNs() (sleep() or poll() with timeout)
+ * 3. when isDue(), call onTick() then update()
+ */
+  class TickMonitor {
+    public:
+      struct Config {
+        uint64_t m_periodNs;
+        uint64_t m_jitterBudgetNs;
+      };
+
+      TickMonitor();
+      explicit TickMonitor(const Config &config);
+
+      void start(uint64_t nowNs);
+      uint64_t getDeadlineNs() const;
+      bool isDue(uint64_t nowNs) const;
+      // false if jitter of this tick is over the budget
+      bool onTick(uint64_t nowNs);
+      // clock_nanosleep() until the deadline (CLOCK_MONOTONIC, see Clock)
+      void sleep() const;
+
+      const Histogram &getWakeUpLatencyNs() const;
+      const Histogram &getJitterNs() const;
+      uint64_t getLastJitterNs() const;
+      uint64_t getNumOfTicks() const;
+      uint64_t getNumOfOverBudget() const;
+      uint64_t getNumOfMissed() const;
+      void resetStats();
+
+    private:
+      Config m_config;
+      uint64_t m_deadlineNs;
+      uint64_t m_lastTickNs;
+      Histogram m_wakeUpLatencyNs;
+      Histogram m_jitterNs;
+      uint64_t m_lastJitterNs;
+      uint64_t m_numOfTicks;
+      uint64_t m_numOfOverBudget;
+      uint64_t m_numOfMissed;
+  };
+} // end namespace Eet
+
+#endif // EET_TICK_MONITOR_H
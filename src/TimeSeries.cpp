@@ -0,0 +1,328 @@
+#include <cstring>
+
+#include "TimeSeries.h"
+#include "Device.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr uint8_t INVALID_VALUE = 0x0FU; // encoded INVALID and values which do not fit
+
+    uint8_t encode(uint8_t value) {
+      return (value < INVALID_VALUE) ? value : INVALID_VALUE;
+    }
+
+    uint8_t decode(uint8_t value) {
+      return (INVALID_VALUE == value) ? UINT8_MAX : value;
+    }
+
+    // the same protocol as SeqLock, data is written in place
+    uint32_t beginWrite(std::atomic<uint32_t> &sequence) {
+      auto value = sequence.load(std::memory_order_relaxed);
+      sequence.store(value + 1U, std::memory_order_relaxed); // odd - writing
+      std::atomic_thread_fence(std::memory_order_release);
+      return value;
+    }
+
+    void endWrite(std::atomic<uint32_t> &sequence, uint32_t value) {
+      sequence.store(value + 2U, std::memory_order_release);
+    }
+
+    uint32_t putVarint(uint8_t *buf, uint64_t value) {
+      uint32_t size = 0U;
+      while(value >= 0x80U) {
+        buf[size++] = static_cast<uint8_t>(value | 0x80U);
+        value >>= 7U;
+      }
+      buf[size++] = static_cast<uint8_t>(value);
+      return size;
+    }
+
+    // f(timeNs, signal, encoded value) returns false to stop
+    template<typename F>
+    void forEachEvent(const TimeSeries::ChunkHeader &header, const uint8_t *data, F f) {
+      uint32_t size = (header.m_size < TimeSeries::CHUNK_DATA_SIZE) ? header.m_size :
+                                                                      TimeSeries::CHUNK_DATA_SIZE;
+      uint64_t timeNs = header.m_startNs;
+      uint32_t pos = 0U;
+      while(pos < size) {
+        uint64_t delta = 0U;
+        uint32_t shift = 0U;
+        uint8_t byte = 0U;
+        do {
+          byte = data[pos++];
+          delta |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+          shift += 7U;
+        } while((byte & 0x80U) && (pos < size) && (shift < 64U));
+        if(pos >= size) {
+          return;
+        }
+        timeNs += delta;
+        auto event = data[pos++];
+        if(not f(timeNs, static_cast<uint32_t>(event >> 4U), static_cast<uint8_t>(event & 0x0FU))) {
+          return;
+        }
+      }
+    }
+  }
+
+
+  TimeSeries::TimeSeries(Chunk *chunks, uint32_t numOfChunks, const IClock &clock) :
+    ma_chunks(chunks),
+    m_numOfChunks((nullptr != chunks) ? numOfChunks : 0U),
+    m_clock(clock),
+    ma_state{},
+    m_chunk(nullptr),
+    m_numOfChunksWritten(0U),
+    m_numOfEvents(0U) {
+    ma_state[CMD_TYPE] = INVALID_VALUE;
+    ma_state[APPROVE_STATE] = INVALID_VALUE;
+    ma_state[SLAVE_STATE] = INVALID_VALUE;
+    for(uint32_t i = 0U; i < m_numOfChunks; ++i) {
+      ma_chunks[i].m_sequence.store(0U, std::memory_order_relaxed);
+      ma_chunks[i].m_header = ChunkHeader{};
+      ma_chunks[i].m_header.m_generation = UINT64_MAX;
+    }
+  }
+
+
+  void TimeSeries::onTransition(const Device &, StateField field, uint8_t from, uint8_t to) {
+    switch(field) {
+      case StateField::CMD_TYPE: append(CMD_TYPE, to); break;
+      case StateField::APPROVE_STATE: append(APPROVE_STATE, to); break;
+      case StateField::SLAVE_STATE: append(SLAVE_STATE, to); break;
+      case StateField::ERRORS: {
+        auto changed = static_cast<uint8_t>(from ^ to);
+        for(uint32_t bit = 0U; bit + ERROR_BITS < NUM_OF_SIGNALS; ++bit) {
+          if((changed >> bit) & 0x01U) {
+            append(static_cast<Signal>(ERROR_BITS + bit), (to >> bit) & 0x01U);
+          }
+        }
+        break;
+      }
+    }
+  }
+
+
+  void TimeSeries::sync(const Device &device) {
+    append(CMD_TYPE, static_cast<uint8_t>(device.getCmdType()));
+    append(APPROVE_STATE, static_cast<uint8_t>(device.getApproveState()));
+    append(SLAVE_STATE, static_cast<uint8_t>(device.getSlaveState()));
+    auto errors = static_cast<uint8_t>(device.getErrors());
+    for(uint32_t bit = 0U; bit + ERROR_BITS < NUM_OF_SIGNALS; ++bit) {
+      append(static_cast<Signal>(ERROR_BITS + bit), (errors >> bit) & 0x01U);
+    }
+  }
+
+
+  uint64_t TimeSeries::getTimeInState(Signal signal, uint8_t value, uint64_t fromNs,
+                                      uint64_t toNs) const {
+    auto numOfChunks = m_numOfChunksWritten.load(std::memory_order_acquire);
+    if((fromNs >= toNs) || (0U == numOfChunks) || (signal >= NUM_OF_SIGNALS)) {
+      return 0U;
+    }
+    auto encoded = encode(value);
+    uint64_t sumNs = 0U;
+    uint64_t segmentNs = 0U; // since when current value holds
+    uint8_t current = INVALID_VALUE;
+    bool isStarted = false;
+    bool isDone = false; // events at or after toNs have been reached
+    auto add = [&](uint64_t endNs) {
+      auto lowNs = (segmentNs > fromNs) ? segmentNs : fromNs;
+      auto highNs = (endNs < toNs) ? endNs : toNs;
+      sumNs += ((encoded == current) && (highNs > lowNs)) ? (highNs - lowNs) : 0U;
+    };
+
+    ChunkCopy copy;
+    const auto &header = copy.m_header;
+    for(auto generation = getFirstGeneration(numOfChunks);
+        (generation < numOfChunks) && not isDone; ++generation) {
+      if(not read(generation, copy, true)) {
+        continue;
+      }
+      if(not isStarted) {
+        segmentNs = header.m_startNs;
+        isStarted = true;
+      }
+      current = header.ma_initial[signal];
+      if(header.m_startNs >= toNs) {
+        break;
+      }
+      // value after the last event is initial one of the next chunk
+      bool isLast = (generation + 1U == numOfChunks);
+      if(((header.m_endNs < fromNs) && not isLast) || not read(generation, copy, false)) {
+        continue;
+      }
+      forEachEvent(header, copy.ma_data, [&](uint64_t timeNs, uint32_t eventSignal, uint8_t eventValue) {
+        if(eventSignal == static_cast<uint32_t>(signal)) {
+          add(timeNs);
+          segmentNs = timeNs;
+          current = eventValue;
+        }
+        isDone = (timeNs >= toNs);
+        return not isDone;
+      });
+    }
+    if(isStarted) {
+      add(toNs);
+    }
+    return sumNs;
+  }
+
+
+  uint32_t TimeSeries::getNumOfTransitions(Signal signal, uint64_t fromNs, uint64_t toNs) const {
+    auto numOfChunks = m_numOfChunksWritten.load(std::memory_order_acquire);
+    if(signal >= NUM_OF_SIGNALS) {
+      return 0U;
+    }
+    uint32_t ret = 0U;
+    ChunkCopy copy;
+    const auto &header = copy.m_header;
+    for(auto generation = getFirstGeneration(numOfChunks); generation < numOfChunks; ++generation) {
+      if(not read(generation, copy, true)) {
+        continue;
+      }
+      if(header.m_startNs >= toNs) {
+        break;
+      }
+      if(header.m_endNs < fromNs) {
+        continue;
+      }
+      if((header.m_startNs >= fromNs) && (header.m_endNs < toNs)) {
+        ret += header.ma_numOfTransitions[signal];
+        continue;
+      }
+      if(not read(generation, copy, false)) {
+        continue;
+      }
+      forEachEvent(header, copy.ma_data, [&](uint64_t timeNs, uint32_t eventSignal, uint8_t) {
+        ret += (eventSignal == static_cast<uint32_t>(signal)) && (timeNs >= fromNs) &&
+               (timeNs < toNs);
+        return timeNs < toNs;
+      });
+    }
+    return ret;
+  }
+
+
+  uint32_t TimeSeries::getLast(Signal signal, Transition *transitions,
+                               uint32_t numOfTransitions) const {
+    auto numOfChunks = m_numOfChunksWritten.load(std::memory_order_acquire);
+    if(signal >= NUM_OF_SIGNALS) {
+      return 0U;
+    }
+    uint32_t ret = 0U;
+    ChunkCopy copy;
+    const auto &header = copy.m_header;
+    Transition chunkTransitions[CHUNK_DATA_SIZE / 2U]; // event takes 2 bytes at least
+    auto firstGeneration = getFirstGeneration(numOfChunks);
+    for(auto generation = numOfChunks; (generation > firstGeneration) && (ret < numOfTransitions);
+        --generation) {
+      if(not read(generation - 1U, copy, true) || (0U == header.ma_numOfTransitions[signal]) ||
+         not read(generation - 1U, copy, false)) {
+        continue;
+      }
+      uint32_t numOfChunkTransitions = 0U;
+      forEachEvent(header, copy.ma_data, [&](uint64_t timeNs, uint32_t eventSignal, uint8_t eventValue) {
+        if(eventSignal == static_cast<uint32_t>(signal)) {
+          chunkTransitions[numOfChunkTransitions++] = Transition{timeNs, decode(eventValue)};
+        }
+        return true;
+      });
+      while((numOfChunkTransitions > 0U) && (ret < numOfTransitions)) {
+        transitions[ret++] = chunkTransitions[--numOfChunkTransitions];
+      }
+    }
+    return ret;
+  }
+
+
+  uint64_t TimeSeries::getOldestNs() const {
+    auto numOfChunks = m_numOfChunksWritten.load(std::memory_order_acquire);
+    ChunkCopy copy;
+    for(auto generation = getFirstGeneration(numOfChunks); generation < numOfChunks; ++generation) {
+      if(read(generation, copy, true)) {
+        return copy.m_header.m_startNs;
+      }
+    }
+    return 0U;
+  }
+
+
+  uint64_t TimeSeries::getNumOfEvents() const {
+    return m_numOfEvents.load(std::memory_order_relaxed);
+  }
+
+
+  void TimeSeries::append(Signal signal, uint8_t value) {
+    auto encoded = encode(value);
+    if((0U == m_numOfChunks) || (encoded == ma_state[signal])) {
+      return;
+    }
+    auto timeNs = m_clock.nowNs();
+    if(nullptr == m_chunk) {
+      openChunk(timeNs);
+    }
+    // time must not decrease, it is clamped otherwise
+    timeNs = (timeNs > m_chunk->m_header.m_endNs) ? timeNs : m_chunk->m_header.m_endNs;
+    if(m_chunk->m_header.m_size + MAX_EVENT_SIZE > CHUNK_DATA_SIZE) {
+      openChunk(timeNs);
+    }
+
+    auto &header = m_chunk->m_header;
+    auto sequence = beginWrite(m_chunk->m_sequence);
+    auto size = header.m_size;
+    size += putVarint(m_chunk->ma_data + size, timeNs - header.m_endNs);
+    m_chunk->ma_data[size++] = static_cast<uint8_t>((signal << 4U) | encoded);
+    header.m_size = size;
+    header.m_endNs = timeNs;
+    ++header.ma_numOfTransitions[signal];
+    endWrite(m_chunk->m_sequence, sequence);
+
+    ma_state[signal] = encoded;
+    m_numOfEvents.fetch_add(1U, std::memory_order_relaxed);
+  }
+
+
+  void TimeSeries::openChunk(uint64_t timeNs) {
+    auto generation = m_numOfChunksWritten.load(std::memory_order_relaxed);
+    auto &chunk = ma_chunks[generation % m_numOfChunks];
+    auto sequence = beginWrite(chunk.m_sequence);
+    chunk.m_header = ChunkHeader{};
+    chunk.m_header.m_generation = generation;
+    chunk.m_header.m_startNs = timeNs;
+    chunk.m_header.m_endNs = timeNs;
+    std::memcpy(chunk.m_header.ma_initial, ma_state, sizeof(ma_state));
+    endWrite(chunk.m_sequence, sequence);
+    m_numOfChunksWritten.store(generation + 1U, std::memory_order_release);
+    m_chunk = &chunk;
+  }
+
+
+  bool TimeSeries::read(uint64_t generation, ChunkCopy &copy, bool isHeaderOnly) const {
+    const auto &chunk = ma_chunks[generation % m_numOfChunks];
+    for(uint32_t i = 0U; i < MAX_RETRIES; ++i) {
+      auto before = chunk.m_sequence.load(std::memory_order_acquire);
+      if(before & 1U) {
+        continue;
+      }
+      std::memcpy(&copy.m_header, &chunk.m_header, sizeof(ChunkHeader));
+      if(not isHeaderOnly) {
+        auto size = (copy.m_header.m_size < CHUNK_DATA_SIZE) ? copy.m_header.m_size :
+                                                               CHUNK_DATA_SIZE;
+        std::memcpy(copy.ma_data, chunk.ma_data, size);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if(before == chunk.m_sequence.load(std::memory_order_relaxed)) {
+        return generation == copy.m_header.m_generation;
+      }
+    }
+    return false;
+  }
+
+
+  uint64_t TimeSeries::getFirstGeneration(uint64_t numOfChunks) const {
+    return (numOfChunks > m_numOfChunks) ? (numOfChunks - m_numOfChunks) : 0U;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,111 @@
+#ifndef EET_TIME_SERIES_H
+#define EET_TIME_SERIES_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Observer.h"
+#include "Clock.h"
+
+namespace Eet {
+/**
+ * In-memory history of state transitions of one device for trends:
+ * cmd type, approve state, slave state and every ErrorBit are separate
+ * signals.
+ *
+ * Transitions are appended to chunks of CHUNK_DATA_SIZE bytes, an event is
+ * a varint time delta from the previous event of the chunk and one byte
+ * (signal in the high nibble, value in the low one, INVALID is 15). Chunks
+ * form a ring in memory given by the caller, so footprint is fixed
+ * (numOfChunks * sizeof(Chunk)) and the oldest chunk is overwritten when
+ * the ring is full. Header of each chunk holds values of all signals before
+ * its first event and number of transitions per signal, so queries skip
+ * chunks outside of the range and count whole chunks without decoding.
+ *
+ * Owner thread (the one which calls Device, e.g. set as its observer):
+ * onTransition(), sync(). Append is O(1) and never waits.
+ * Any thread: get*() queries. Each chunk is guarded by a sequence like
+ * SeqLock, readers copy a chunk and retry when they have raced with the
+ * writer, a chunk overwritten during a query is skipped.
+ * History before the oldest chunk is unknown and is not counted.
+ */
+  class TimeSeries final : public IObserver {
+    public:
+      enum Signal {
+          CMD_TYPE = 0,
+          APPROVE_STATE,
+          SLAVE_STATE,
+          ERROR_BITS, // + Protocol::ErrorBit, values 0 and 1
+          NUM_OF_SIGNALS = ERROR_BITS + Protocol::NO_ACTIVE_SLAVE + 1
+      };
+
+      struct Transition {
+        uint64_t m_timeNs;
+        uint8_t m_value; // Protocol.h code, 0 or 1 for error bits
+      };
+
+      static constexpr uint32_t CHUNK_DATA_SIZE = 1024U;
+
+      struct ChunkHeader {
+        uint64_t m_generation; // number of the chunk since start
+        uint64_t m_startNs;    // time of the first event
+        uint64_t m_endNs;      // time of the last event
+        uint32_t m_size;       // of data
+        uint16_t ma_numOfTransitions[NUM_OF_SIGNALS];
+        uint8_t ma_initial[NUM_OF_SIGNALS]; // encoded values before the first event
+      };
+
+      struct Chunk {
+        std::atomic<uint32_t> m_sequence;
+        ChunkHeader m_header;
+        uint8_t ma_data[CHUNK_DATA_SIZE];
+      };
+
+      // chunks - storage of the ring, at least 2
+      TimeSeries(Chunk *chunks, uint32_t numOfChunks,
+                 const IClock &clock = Clock::monotonic());
+      TimeSeries(const TimeSeries &) = delete;
+      TimeSeries &operator=(const TimeSeries &) = delete;
+
+      // owner thread
+      void onTransition(const Device &device, StateField field,
+                        uint8_t from, uint8_t to) override;
+      // records current values of the device which differ from the history,
+      // call once after setObserver()
+      void sync(const Device &device);
+
+      // any thread, range is [fromNs, toNs), toNs past the last transition
+      // means that the last value lasts until toNs
+      uint64_t getTimeInState(Signal signal, uint8_t value, uint64_t fromNs, uint64_t toNs) const;
+      uint32_t getNumOfTransitions(Signal signal, uint64_t fromNs, uint64_t toNs) const;
+      // the latest transitions of signal, newest first, returns their number
+      uint32_t getLast(Signal signal, Transition *transitions, uint32_t numOfTransitions) const;
+      uint64_t getOldestNs() const; // start of the history, 0 if it is empty
+      uint64_t getNumOfEvents() const; // appended since start
+
+    private:
+      struct ChunkCopy {
+        ChunkHeader m_header;
+        uint8_t ma_data[CHUNK_DATA_SIZE];
+      };
+
+      static constexpr uint32_t MAX_RETRIES = 100000U;
+      static constexpr uint32_t MAX_EVENT_SIZE = 11U; // varint of uint64_t and one byte
+
+      void append(Signal signal, uint8_t value);
+      void openChunk(uint64_t timeNs);
+      // false if chunk of the generation has been overwritten
+      bool read(uint64_t generation, ChunkCopy &copy, bool isHeaderOnly) const;
+      uint64_t getFirstGeneration(uint64_t numOfChunks) const;
+
+      Chunk *ma_chunks;
+      uint32_t m_numOfChunks;
+      const IClock &m_clock;
+      uint8_t ma_state[NUM_OF_SIGNALS]; // encoded current values
+      Chunk *m_chunk; // being written, nullptr before the first event
+      std::atomic<uint64_t> m_numOfChunksWritten;
+      std::atomic<uint64_t> m_numOfEvents;
+  };
+} // end namespace Eet
+
+#endif // EET_TIME_SERIES_H
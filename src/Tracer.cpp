@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Clock.h"
+#include "Tracer.h"
+
+namespace Eet {
+
+  namespace {
+    struct Buffer {
+      std::atomic<uint32_t> m_numOfEvents;
+      uint32_t m_tid;
+      Tracer::Event ma_events[Tracer::EVENTS_PER_THREAD];
+    };
+
+    struct Thread {
+      uint32_t m_tid;
+      std::vector<Tracer::Event> m_events;
+    };
+
+    // buffers of the first MAX_THREADS recording threads, never reused
+    Buffer buffers[Tracer::MAX_THREADS];
+    std::atomic<uint32_t> numOfBuffers{0U};
+    std::atomic<uint64_t> numOfLost{0U};
+    thread_local Buffer *threadBuffer = nullptr;
+    thread_local bool isThreadRegistered = false;
+
+    void record(const Tracer::Event &event) {
+      if(not isThreadRegistered) {
+        isThreadRegistered = true;
+        auto index = numOfBuffers.fetch_add(1U, std::memory_order_relaxed);
+        if(index < Tracer::MAX_THREADS) {
+          threadBuffer = &buffers[index];
+          threadBuffer->m_tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+        }
+      }
+      auto num = (nullptr != threadBuffer) ?
+                 threadBuffer->m_numOfEvents.load(std::memory_order_relaxed) :
+                 Tracer::EVENTS_PER_THREAD;
+      if(num >= Tracer::EVENTS_PER_THREAD) {
+        numOfLost.fetch_add(1U, std::memory_order_relaxed);
+        return;
+      }
+      threadBuffer->ma_events[num] = event;
+      threadBuffer->m_numOfEvents.store(num + 1U, std::memory_order_release);
+    }
+
+    // published events of every thread, spans before nested ones
+    std::vector<Thread> collect() {
+      std::vector<Thread> threads;
+      auto num = numOfBuffers.load(std::memory_order_acquire);
+      num = (num > Tracer::MAX_THREADS) ? Tracer::MAX_THREADS : num;
+      for(uint32_t i = 0U; i < num; ++i) {
+        const auto &buffer = buffers[i];
+        auto numOfEvents = buffer.m_numOfEvents.load(std::memory_order_acquire);
+        Thread thread{buffer.m_tid, std::vector<Tracer::Event>(buffer.ma_events,
+                                                              buffer.ma_events + numOfEvents)};
+        std::stable_sort(thread.m_events.begin(), thread.m_events.end(),
+                         [](const Tracer::Event &a, const Tracer::Event &b) {
+                           return (a.m_startNs < b.m_startNs) ||
+                                  ((a.m_startNs == b.m_startNs) &&
+                                   (a.m_durationNs > b.m_durationNs));
+                         });
+        threads.push_back(std::move(thread));
+      }
+      return threads;
+    }
+
+    // protobuf wire format, only what TracePacket needs
+    enum WireType {
+        VARINT = 0,
+        LENGTH_DELIMITED = 2
+    };
+
+    void putVarint(std::string &out, uint64_t value) {
+      while(value >= 0x80U) {
+        out.push_back(static_cast<char>((value & 0x7FU) | 0x80U));
+        value >>= 7U;
+      }
+      out.push_back(static_cast<char>(value));
+    }
+
+    void putTag(std::string &out, uint32_t field, WireType type) {
+      putVarint(out, (static_cast<uint64_t>(field) << 3U) | type);
+    }
+
+    void putUint(std::string &out, uint32_t field, uint64_t value) {
+      putTag(out, field, VARINT);
+      putVarint(out, value);
+    }
+
+    void putBytes(std::string &out, uint32_t field, const std::string &value) {
+      putTag(out, field, LENGTH_DELIMITED);
+      putVarint(out, value.size());
+      out += value;
+    }
+
+    // field numbers of perfetto/trace/trace_packet.proto and track_event.proto
+    constexpr uint32_t TRACE_PACKET = 1U;
+    constexpr uint32_t PACKET_TIMESTAMP = 8U;
+    constexpr uint32_t PACKET_SEQUENCE_ID = 10U;
+    constexpr uint32_t PACKET_TRACK_EVENT = 11U;
+    constexpr uint32_t PACKET_SEQUENCE_FLAGS = 13U;
+    constexpr uint32_t PACKET_TRACK_DESCRIPTOR = 60U;
+    constexpr uint32_t TRACK_UUID = 1U;
+    constexpr uint32_t TRACK_THREAD = 4U;
+    constexpr uint32_t THREAD_PID = 1U;
+    constexpr uint32_t THREAD_TID = 2U;
+    constexpr uint32_t EVENT_DEBUG_ANNOTATIONS = 4U;
+    constexpr uint32_t EVENT_TYPE = 9U;
+    constexpr uint32_t EVENT_TRACK_UUID = 11U;
+    constexpr uint32_t EVENT_NAME = 23U;
+    constexpr uint32_t ANNOTATION_UINT_VALUE = 3U;
+    constexpr uint32_t ANNOTATION_NAME = 10U;
+    constexpr uint32_t SLICE_BEGIN = 1U;
+    constexpr uint32_t SLICE_END = 2U;
+    constexpr uint32_t INSTANT = 3U;
+    constexpr uint32_t SEQUENCE_ID = 1U;
+    constexpr uint32_t SEQ_INCREMENTAL_STATE_CLEARED = 1U;
+
+    void putAnnotation(std::string &out, const char *name, uint64_t value) {
+      std::string annotation;
+      putBytes(annotation, ANNOTATION_NAME, name);
+      putUint(annotation, ANNOTATION_UINT_VALUE, value);
+      putBytes(out, EVENT_DEBUG_ANNOTATIONS, annotation);
+    }
+
+    void putEvent(std::string &out, uint64_t uuid, uint64_t timeNs, uint32_t type,
+                  const Tracer::Event *event) {
+      std::string trackEvent;
+      putUint(trackEvent, EVENT_TYPE, type);
+      putUint(trackEvent, EVENT_TRACK_UUID, uuid);
+      if(nullptr != event) {
+        putBytes(trackEvent, EVENT_NAME, event->m_name);
+        putAnnotation(trackEvent, "device", static_cast<uint8_t>(event->m_deviceId));
+        if(Tracer::INSTANT == event->m_type) {
+          putAnnotation(trackEvent, "from", event->m_from);
+          putAnnotation(trackEvent, "to", event->m_to);
+        }
+      }
+      std::string packet;
+      putUint(packet, PACKET_TIMESTAMP, timeNs);
+      putUint(packet, PACKET_SEQUENCE_ID, SEQUENCE_ID);
+      putBytes(packet, PACKET_TRACK_EVENT, trackEvent);
+      putBytes(out, TRACE_PACKET, packet);
+    }
+
+    bool writeFile(const char *path, const std::string &data) {
+      auto *file = std::fopen(path, "wb");
+      if(nullptr == file) {
+        return false;
+      }
+      bool isWritten = (data.size() == std::fwrite(data.data(), 1U, data.size(), file));
+      return (0 == std::fclose(file)) && isWritten;
+    }
+  }
+
+
+  std::atomic<bool> Tracer::s_isEnabled{false};
+
+
+  void Tracer::enable(bool isEnabled) {
+    s_isEnabled.store(isEnabled, std::memory_order_relaxed);
+  }
+
+
+  uint64_t Tracer::nowNs() {
+    return Clock::monotonicNs();
+  }
+
+
+  void Tracer::span(const char *name, char deviceId, uint64_t startNs, uint64_t endNs) {
+    record(Event{startNs, endNs - startNs, name, SPAN, deviceId, 0U, 0U});
+  }
+
+
+  void Tracer::instant(const char *name, char deviceId, uint8_t from, uint8_t to) {
+    record(Event{nowNs(), 0U, name, INSTANT, deviceId, from, to});
+  }
+
+
+  uint64_t Tracer::getNumOfEvents() {
+    uint64_t ret = 0U;
+    auto num = numOfBuffers.load(std::memory_order_acquire);
+    num = (num > MAX_THREADS) ? MAX_THREADS : num;
+    for(uint32_t i = 0U; i < num; ++i) {
+      ret += buffers[i].m_numOfEvents.load(std::memory_order_acquire);
+    }
+    return ret;
+  }
+
+
+  uint64_t Tracer::getNumOfLost() {
+    return numOfLost.load(std::memory_order_relaxed);
+  }
+
+
+  void Tracer::reset() {
+    for(auto &buffer : buffers) {
+      buffer.m_numOfEvents.store(0U, std::memory_order_release);
+    }
+    numOfLost.store(0U, std::memory_order_relaxed);
+  }
+
+
+  bool Tracer::exportJson(const char *path) {
+    auto pid = static_cast<unsigned>(::getpid());
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    char line[256];
+    bool isFirst = true;
+    for(const auto &thread : collect()) {
+      std::snprintf(line, sizeof(line),
+                    "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+                    "\"args\":{\"name\":\"eet %u\"}}",
+                    isFirst ? "" : ",\n", pid, thread.m_tid, thread.m_tid);
+      out += line;
+      isFirst = false;
+      for(const auto &event : thread.m_events) {
+        if(SPAN == event.m_type) {
+          std::snprintf(line, sizeof(line),
+                        ",\n{\"name\":\"%s\",\"cat\":\"eet\",\"ph\":\"X\",\"ts\":%.3f,"
+                        "\"dur\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"device\":%d}}",
+                        event.m_name, event.m_startNs / 1e3, event.m_durationNs / 1e3,
+                        pid, thread.m_tid, static_cast<int>(event.m_deviceId));
+        } else {
+          std::snprintf(line, sizeof(line),
+                        ",\n{\"name\":\"%s\",\"cat\":\"eet\",\"ph\":\"i\",\"s\":\"t\","
+                        "\"ts\":%.3f,\"pid\":%u,\"tid\":%u,"
+                        "\"args\":{\"device\":%d,\"from\":%u,\"to\":%u}}",
+                        event.m_name, event.m_startNs / 1e3, pid, thread.m_tid,
+                        static_cast<int>(event.m_deviceId), event.m_from, event.m_to);
+        }
+        out += line;
+      }
+    }
+    out += "\n]}\n";
+    return writeFile(path, out);
+  }
+
+
+  bool Tracer::exportPerfetto(const char *path) {
+    auto pid = static_cast<uint64_t>(::getpid());
+    std::string out;
+    for(const auto &thread : collect()) {
+      uint64_t uuid = (pid << 32U) | thread.m_tid;
+      std::string threadDescriptor;
+      putUint(threadDescriptor, THREAD_PID, pid);
+      putUint(threadDescriptor, THREAD_TID, thread.m_tid);
+      std::string trackDescriptor;
+      putUint(trackDescriptor, TRACK_UUID, uuid);
+      putBytes(trackDescriptor, TRACK_THREAD, threadDescriptor);
+      std::string packet;
+      putUint(packet, PACKET_SEQUENCE_ID, SEQUENCE_ID);
+      if(out.empty()) {
+        putUint(packet, PACKET_SEQUENCE_FLAGS, SEQ_INCREMENTAL_STATE_CLEARED);
+      }
+      putBytes(packet, PACKET_TRACK_DESCRIPTOR, trackDescriptor);
+      putBytes(out, TRACE_PACKET, packet);
+
+      // spans are nested on one thread, ends of enclosing ones wait on stack
+      std::vector<uint64_t> endsNs;
+      for(const auto &event : thread.m_events) {
+        while((not endsNs.empty()) && (endsNs.back() <= event.m_startNs)) {
+          putEvent(out, uuid, endsNs.back(), SLICE_END, nullptr);
+          endsNs.pop_back();
+        }
+        if(SPAN == event.m_type) {
+          putEvent(out, uuid, event.m_startNs, SLICE_BEGIN, &event);
+          endsNs.push_back(event.m_startNs + event.m_durationNs);
+        } else {
+          putEvent(out, uuid, event.m_startNs, INSTANT, &event);
+        }
+      }
+      while(not endsNs.empty()) {
+        putEvent(out, uuid, endsNs.back(), SLICE_END, nullptr);
+        endsNs.pop_back();
+      }
+    }
+    return writeFile(path, out);
+  }
+
+} // end namespace Eet
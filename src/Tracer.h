@@ -0,0 +1,112 @@
+#ifndef EET_TRACER_H
+#define EET_TRACER_H
+
+/**
+ * Optional timeline tracing (CMake option EET_TRACING, never in eet-core).
+ * Spans: pushMsg() per Can::Id, update(), encoding of messages, LogMsg
+ * formatting and CanSocket TX. Instant events: transitions of slave state,
+ * approve state, cmd type and every error bit of a device.
+ *
+ * Every thread records into its own fixed buffer (single writer, published
+ * with a release store), events which do not fit are counted as lost.
+ * Recording is off until enable(true); compiled in but disabled, a span
+ * costs one relaxed atomic load. Export after recording threads are
+ * stopped or idle:
+ *   exportJson()     - Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+ *   exportPerfetto() - Perfetto protobuf trace (ui.perfetto.dev)
+ * Without EET_TRACING the macros below expand to nothing and
+ * EET_TRACE_ENABLED is not defined.
+ */
+#if defined(EET_TRACING) && !defined(EET_FREESTANDING)
+#define EET_TRACE_ENABLED
+
+#include <atomic>
+#include <cstdint>
+
+namespace Eet {
+  class Tracer {
+    public:
+      enum Type : uint8_t {
+          SPAN = 0,
+          INSTANT
+      };
+
+      struct Event {
+        uint64_t m_startNs;
+        uint64_t m_durationNs;
+        const char *m_name; // string literal
+        Type m_type;
+        char m_deviceId;
+        uint8_t m_from; // INSTANT only
+        uint8_t m_to;
+      };
+
+      // RAII span, name may be refined before the end
+      class Span {
+        public:
+          Span(const char *name, char deviceId) :
+            m_name(name),
+            m_deviceId(deviceId),
+            m_startNs(isEnabled() ? nowNs() : 0U) {}
+          ~Span() {
+            if(0U != m_startNs) {
+              span(m_name, m_deviceId, m_startNs, nowNs());
+            }
+          }
+          Span(const Span &) = delete;
+          Span &operator=(const Span &) = delete;
+
+          void setName(const char *name) {
+            m_name = name;
+          }
+
+        private:
+          const char *m_name;
+          char m_deviceId;
+          uint64_t m_startNs;
+      };
+
+      static constexpr uint32_t MAX_THREADS = 16U;
+      static constexpr uint32_t EVENTS_PER_THREAD = 1U << 16U;
+
+      static void enable(bool isEnabled);
+      static bool isEnabled() {
+        return s_isEnabled.load(std::memory_order_relaxed);
+      }
+      static uint64_t nowNs();
+
+      static void span(const char *name, char deviceId, uint64_t startNs, uint64_t endNs);
+      static void instant(const char *name, char deviceId, uint8_t from, uint8_t to);
+
+      static uint64_t getNumOfEvents();
+      static uint64_t getNumOfLost();
+      // drops recorded events, recording threads must be idle
+      static void reset();
+
+      // false on I/O error
+      static bool exportJson(const char *path);
+      static bool exportPerfetto(const char *path);
+
+    private:
+      static std::atomic<bool> s_isEnabled;
+  };
+} // end namespace Eet
+
+#define EET_TRACE_SPAN(var, name, deviceId) Eet::Tracer::Span var(name, deviceId)
+#define EET_TRACE_SPAN_NAME(var, name) var.setName(name)
+#define EET_TRACE_INSTANT(name, deviceId, from, to) \
+  do { \
+    if(Eet::Tracer::isEnabled()) { \
+      Eet::Tracer::instant(name, deviceId, from, to); \
+    } \
+  } while(0)
+
+#else
+
+#define EET_TRACE_SPAN(var, name, deviceId)
+#define EET_TRACE_SPAN_NAME(var, name)
+#define EET_TRACE_INSTANT(name, deviceId, from, to) do {} while(0)
+
+#endif // EET_TRACING
+
+#endif // EET_TRACER_H
@@ -0,0 +1,230 @@
+#include "TrafficGenerator.h"
+
+namespace Eet {
+
+  namespace {
+    constexpr TrafficGenerator::Config DEFAULT_CONFIG = {
+      1U,           // Master
+      4U,           // Slaves
+      0U,           // no duplicated IDs
+      100000000U,   // heartbeat each 100 ms
+      5000000000U,  // lever moves each 5 s
+      TrafficGenerator::Scenario::APPROVE,
+      0U,           // no invalid frames
+      1U,           // seed
+      Protocol::Can::IdScheme::V1
+    };
+
+    constexpr uint32_t SWEEP_LENGTH = 16U; // FULL_AHEAD .. FULL_ASTERN .. HALF_AHEAD
+    constexpr uint32_t STEPS_PER_ACTIVATION = 8U;
+
+    Protocol::CmdType getLever(uint64_t cmdNum) {
+      auto first = static_cast<uint32_t>(Protocol::CmdType::FULL_AHEAD);
+      auto index = static_cast<uint32_t>(cmdNum % SWEEP_LENGTH);
+      index = (index <= SWEEP_LENGTH / 2U) ? index : (SWEEP_LENGTH - index);
+      return static_cast<Protocol::CmdType>(first + index);
+    }
+
+    Protocol::Can::RawMsg toScheme(Protocol::Can::RawMsg msg, Protocol::Can::Id id,
+                                   char deviceId, Protocol::Can::IdScheme scheme) {
+      msg.m_canId = Protocol::Can::toCanId(id, deviceId, scheme);
+      return msg;
+    }
+  }
+
+
+  TrafficGenerator::TrafficGenerator() :
+    TrafficGenerator(DEFAULT_CONFIG) {}
+
+
+  TrafficGenerator::TrafficGenerator(const Config &config) :
+    m_config(config),
+    ma_devices{},
+    m_numOfDevices(config.m_numOfMasters + config.m_numOfSlaves + config.m_numOfDuplicates),
+    m_isValid(false),
+    m_random((0U != config.m_seed) ? config.m_seed : DEFAULT_CONFIG.m_seed),
+    m_heartbeatSlot(0U),
+    m_nextHeartbeatNs(0U),
+    m_stepNum(0U),
+    m_nextStepNs(0U),
+    m_activeSlave(0U),
+    m_numOfFrames(0U),
+    m_numOfInvalid(0U) {
+    auto numOfIds = config.m_numOfMasters + config.m_numOfSlaves;
+    m_isValid = (0U != m_numOfDevices) && (m_numOfDevices <= MAX_DEVICES) &&
+                (numOfIds <= static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID)) &&
+                ((0U == config.m_numOfDuplicates) || (0U != config.m_numOfSlaves)) &&
+                (0U != config.m_heartbeatPeriodNs) &&
+                (config.m_invalidPerMille <= 1000U) &&
+                ((Protocol::Can::IdScheme::V1 == config.m_idScheme) ||
+                 (Protocol::Can::IdScheme::V2 == config.m_idScheme) ||
+                 (Protocol::Can::IdScheme::COMPAT == config.m_idScheme));
+    if(not m_isValid) {
+      m_numOfDevices = 0U;
+      m_nextHeartbeatNs = UINT64_MAX;
+      m_nextStepNs = UINT64_MAX;
+      return;
+    }
+
+    for(uint32_t i = 0U; i < m_numOfDevices; ++i) {
+      auto &device = ma_devices[i];
+      bool isMaster = (i < config.m_numOfMasters);
+      uint32_t id = (i < numOfIds) ? (i + 1U) :
+                    (config.m_numOfMasters + 1U + (i - numOfIds) % config.m_numOfSlaves);
+      device.m_deviceId = static_cast<char>(id);
+      device.m_deviceType = isMaster ? Protocol::DeviceType::MASTER :
+                                       Protocol::DeviceType::SLAVE;
+      device.m_slaveState = Protocol::SlaveState::NOT_ACTIVE;
+      device.m_approveState = Protocol::ApproveState::NOT_APPROVED;
+      device.m_cmdType = Protocol::CmdType::STOP;
+      encodeHeartbeat(device);
+    }
+    m_activeSlave = config.m_numOfMasters;
+    bool isScenario = (Scenario::HEARTBEATS_ONLY != config.m_scenario) &&
+                      (config.m_cmdPeriodNs >= 2U) && (0U != config.m_numOfMasters);
+    if(isScenario && (Scenario::APPROVE == config.m_scenario) && (0U != config.m_numOfSlaves)) {
+      ma_devices[m_activeSlave].m_slaveState = Protocol::SlaveState::ACTIVE;
+      encodeHeartbeat(ma_devices[m_activeSlave]);
+    }
+    m_nextStepNs = isScenario ? 0U : UINT64_MAX;
+  }
+
+
+  bool TrafficGenerator::isValid() const {
+    return m_isValid;
+  }
+
+
+  uint32_t TrafficGenerator::generate(uint64_t untilNs, Protocol::Can::RawMsg *msgs,
+                                      uint32_t numOfMsgs) {
+    uint32_t ret = 0U;
+    while((ret < numOfMsgs) && (getNextNs() <= untilNs)) {
+      auto &msg = msgs[ret];
+      if(m_nextStepNs <= m_nextHeartbeatNs) {
+        if(not step(msg)) {
+          continue;
+        }
+      } else {
+        msg = ma_devices[m_heartbeatSlot % m_numOfDevices].m_heartbeat;
+        ++m_heartbeatSlot;
+        // phases spread evenly over the period
+        m_nextHeartbeatNs = m_heartbeatSlot * m_config.m_heartbeatPeriodNs / m_numOfDevices;
+      }
+      if((0U != m_config.m_invalidPerMille) &&
+         (nextRandom() % 1000U < m_config.m_invalidPerMille)) {
+        auto random = nextRandom();
+        msg.m_canId = static_cast<uint32_t>(random) & 0x7FFU;
+        msg.m_dlc = static_cast<uint32_t>(random >> 11U) % 9U;
+        msg.m_dataL = static_cast<uint32_t>(random >> 16U);
+        msg.m_dataH = static_cast<uint32_t>(nextRandom());
+        ++m_numOfInvalid;
+      }
+      ++m_numOfFrames;
+      ++ret;
+    }
+    return ret;
+  }
+
+
+  uint64_t TrafficGenerator::getNextNs() const {
+    return (m_nextStepNs < m_nextHeartbeatNs) ? m_nextStepNs : m_nextHeartbeatNs;
+  }
+
+
+  uint64_t TrafficGenerator::getNumOfFrames() const {
+    return m_numOfFrames;
+  }
+
+
+  uint64_t TrafficGenerator::getNumOfInvalid() const {
+    return m_numOfInvalid;
+  }
+
+
+  uint32_t TrafficGenerator::getNumOfDevices() const {
+    return m_numOfDevices;
+  }
+
+
+  void TrafficGenerator::encodeHeartbeat(VirtualDevice &device) {
+    Protocol::Msg::CommonFields commonFields(device.m_deviceId, device.m_deviceType, 0);
+    Protocol::Msg::Heartbeat heartbeat(commonFields, device.m_slaveState,
+                                       device.m_approveState, device.m_cmdType);
+    device.m_heartbeat = toScheme(static_cast<Protocol::Can::RawMsg>(heartbeat),
+                                  Protocol::Can::Id::HEARTBEAT, device.m_deviceId,
+                                  m_config.m_idScheme);
+  }
+
+
+  Protocol::Can::RawMsg TrafficGenerator::encodeCmd(const VirtualDevice &device) const {
+    Protocol::Msg::CommonFields commonFields(device.m_deviceId, device.m_deviceType, 0);
+    Protocol::Msg::Cmd cmd(commonFields, device.m_cmdType);
+    return toScheme(static_cast<Protocol::Can::RawMsg>(cmd), Protocol::Can::Id::CMD,
+                    device.m_deviceId, m_config.m_idScheme);
+  }
+
+
+  Protocol::Can::RawMsg TrafficGenerator::encodeActivate(const VirtualDevice &device) const {
+    Protocol::Msg::CommonFields commonFields(device.m_deviceId, device.m_deviceType, 0);
+    Protocol::Msg::Activate activate(commonFields);
+    return toScheme(static_cast<Protocol::Can::RawMsg>(activate), Protocol::Can::Id::ACTIVATE,
+                    device.m_deviceId, m_config.m_idScheme);
+  }
+
+
+  bool TrafficGenerator::step(Protocol::Can::RawMsg &msg) {
+    // even steps move the lever, odd ones approve half a period later
+    auto stepNum = m_stepNum++;
+    m_nextStepNs = m_stepNum * (m_config.m_cmdPeriodNs / 2U);
+    auto cmdNum = stepNum / 2U;
+    auto lever = getLever(cmdNum);
+    bool isApprove = (Scenario::APPROVE == m_config.m_scenario) && (0U != m_config.m_numOfSlaves);
+    auto &active = ma_devices[m_activeSlave];
+
+    if(0U == stepNum % 2U) {
+      for(uint32_t i = 0U; i < m_config.m_numOfMasters; ++i) {
+        ma_devices[i].m_cmdType = lever;
+        encodeHeartbeat(ma_devices[i]);
+      }
+      if(isApprove) {
+        active.m_approveState = Protocol::ApproveState::NOT_APPROVED;
+        active.m_cmdType = lever;
+        encodeHeartbeat(active);
+      }
+      msg = encodeCmd(ma_devices[0]);
+      return true;
+    }
+
+    if(not isApprove) {
+      return false;
+    }
+    bool isHandover = (STEPS_PER_ACTIVATION - 1U == cmdNum % STEPS_PER_ACTIVATION) &&
+                      (m_config.m_numOfSlaves > 1U);
+    if(isHandover) {
+      active.m_slaveState = Protocol::SlaveState::NOT_ACTIVE;
+      active.m_approveState = Protocol::ApproveState::NOT_APPROVED;
+      encodeHeartbeat(active);
+      auto first = m_config.m_numOfMasters;
+      m_activeSlave = first + (m_activeSlave - first + 1U) % m_config.m_numOfSlaves;
+    }
+    auto &approving = ma_devices[m_activeSlave];
+    approving.m_slaveState = Protocol::SlaveState::ACTIVE;
+    approving.m_approveState = Protocol::ApproveState::APPROVED;
+    approving.m_cmdType = lever;
+    encodeHeartbeat(approving);
+    if(isHandover) {
+      msg = encodeActivate(approving);
+    }
+    return isHandover;
+  }
+
+
+  uint64_t TrafficGenerator::nextRandom() {
+    // xorshift64
+    m_random ^= m_random << 13U;
+    m_random ^= m_random >> 7U;
+    m_random ^= m_random << 17U;
+    return m_random;
+  }
+
+} // end namespace Eet
@@ -0,0 +1,95 @@
+#ifndef EET_TRAFFIC_GENERATOR_H
+#define EET_TRAFFIC_GENERATOR_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Deterministic synthetic EET traffic for load tests of receivers.
+ *
+ * Virtual devices: Masters 1..m_numOfMasters, Slaves after them and
+ * m_numOfDuplicates more Slaves which reuse IDs of the first Slaves.
+ * Each one sends heartbeat once a heartbeat period, phases are spread
+ * evenly over the period. Scenario steps each command period:
+ *   HEARTBEATS_ONLY - lever stays at STOP
+ *   LEVER_SWEEP     - Master 1 sends Cmd of the next lever position
+ *                     (FULL_AHEAD .. FULL_ASTERN and back)
+ *   APPROVE         - LEVER_SWEEP, active Slave approves each cmd half a
+ *                     period later, activation (Activate msg) moves to the
+ *                     next Slave every 8 steps
+ * Frames are built by Protocol::Msg encoders, heartbeats are re-encoded
+ * when state of the device changes. m_invalidPerMille of frames are
+ * replaced by random ones (random CAN ID, DLC and data).
+ *
+ * Time is virtual (ns since start), the same Config and seed give the same
+ * frames however generate() calls are split, so the caller paces them
+ * against any clock.
+ */
+  class TrafficGenerator {
+    public:
+      enum class Scenario : uint8_t {
+          HEARTBEATS_ONLY = 0,
+          LEVER_SWEEP,
+          APPROVE
+      };
+
+      struct Config {
+        uint32_t m_numOfMasters;
+        uint32_t m_numOfSlaves;
+        uint32_t m_numOfDuplicates;
+        uint64_t m_heartbeatPeriodNs;
+        uint64_t m_cmdPeriodNs;
+        Scenario m_scenario;
+        uint32_t m_invalidPerMille;
+        uint64_t m_seed;
+        Protocol::Can::IdScheme m_idScheme;
+      };
+
+      static constexpr uint32_t MAX_DEVICES = 64U;
+
+      TrafficGenerator();
+      explicit TrafficGenerator(const Config &config);
+
+      // false if there are no devices, too many of them or IDs do not fit
+      bool isValid() const;
+      // frames due at or before untilNs, at most numOfMsgs
+      uint32_t generate(uint64_t untilNs, Protocol::Can::RawMsg *msgs, uint32_t numOfMsgs);
+      uint64_t getNextNs() const; // time of the next frame
+      uint64_t getNumOfFrames() const;
+      uint64_t getNumOfInvalid() const;
+      uint32_t getNumOfDevices() const;
+
+    private:
+      struct VirtualDevice {
+        char m_deviceId;
+        Protocol::DeviceType m_deviceType;
+        Protocol::SlaveState m_slaveState;
+        Protocol::ApproveState m_approveState;
+        Protocol::CmdType m_cmdType;
+        Protocol::Can::RawMsg m_heartbeat; // encoded state
+      };
+
+      void encodeHeartbeat(VirtualDevice &device);
+      Protocol::Can::RawMsg encodeCmd(const VirtualDevice &device) const;
+      Protocol::Can::RawMsg encodeActivate(const VirtualDevice &device) const;
+      bool step(Protocol::Can::RawMsg &msg); // scenario step, true if it sends msg
+      uint64_t nextRandom();
+
+      Config m_config;
+      VirtualDevice ma_devices[MAX_DEVICES];
+      uint32_t m_numOfDevices;
+      bool m_isValid;
+      uint64_t m_random;
+      uint64_t m_heartbeatSlot;
+      uint64_t m_nextHeartbeatNs;
+      uint64_t m_stepNum;
+      uint64_t m_nextStepNs;
+      uint32_t m_activeSlave;
+      uint64_t m_numOfFrames;
+      uint64_t m_numOfInvalid;
+  };
+} // end namespace Eet
+
+#endif // EET_TRAFFIC_GENERATOR_H
@@ -0,0 +1,78 @@
+#include "TxQueue.h"
+
+namespace Eet {
+
+  TxQueue::TxQueue() :
+    TxQueue(Mode::PRIORITY) {}
+
+
+  TxQueue::TxQueue(Mode mode) :
+    m_mode(mode),
+    ma_entries{},
+    m_size(0U) {}
+
+
+  void TxQueue::setMode(Mode mode) {
+    m_mode = mode;
+  }
+
+
+  TxQueue::Mode TxQueue::getMode() const {
+    return m_mode;
+  }
+
+
+  bool TxQueue::push(const Protocol::Can::RawMsg &msg, uint64_t nowNs) {
+    if(m_size >= CAPACITY) {
+      return false;
+    }
+    ma_entries[m_size++] = {msg, nowNs};
+    return true;
+  }
+
+
+  uint32_t TxQueue::findFront() const {
+    // entries are kept in push() order, the queue is short - linear search
+    uint32_t ret = 0U;
+    if(Mode::PRIORITY == m_mode) {
+      for(uint32_t i = 1U; i < m_size; ++i) {
+        if(ma_entries[i].m_msg.m_canId < ma_entries[ret].m_msg.m_canId) {
+          ret = i;
+        }
+      }
+    }
+    return ret;
+  }
+
+
+  const TxQueue::Entry &TxQueue::front() const {
+    return ma_entries[findFront()];
+  }
+
+
+  void TxQueue::pop() {
+    if(0U == m_size) {
+      return;
+    }
+    for(uint32_t i = findFront() + 1U; i < m_size; ++i) {
+      ma_entries[i - 1U] = ma_entries[i];
+    }
+    --m_size;
+  }
+
+
+  void TxQueue::clear() {
+    m_size = 0U;
+  }
+
+
+  bool TxQueue::isEmpty() const {
+    return 0U == m_size;
+  }
+
+
+  uint32_t TxQueue::getSize() const {
+    return m_size;
+  }
+
+} // end namespace Eet
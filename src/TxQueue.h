@@ -0,0 +1,57 @@
+#ifndef EET_TX_QUEUE_H
+#define EET_TX_QUEUE_H
+
+#include <cstdint>
+
+#include "Protocol.h"
+
+namespace Eet {
+/**
+ * Local transmit queue of one device in front of CAN controller.
+ *
+ * FIFO     - frames leave in push() order, like software FIFO feeding
+ *            single TX mailbox: urgent cmd waits for all queued heartbeats.
+ * PRIORITY - frame with the lowest CAN ID leaves first, FIFO among equal
+ *            IDs. That is the order of bus arbitration, so there is no
+ *            priority inversion inside the device and with V2 IDs
+ *            (see Protocol::Can::IdScheme) pending cmd overtakes queued
+ *            heartbeats.
+ *
+ * Fixed capacity, no allocation, usable on microcontrollers.
+ */
+  class TxQueue {
+    public:
+      enum class Mode : uint8_t {
+          FIFO = 0,
+          PRIORITY
+      };
+
+      struct Entry {
+        Protocol::Can::RawMsg m_msg;
+        uint64_t m_queuedNs;
+      };
+
+      static constexpr uint32_t CAPACITY = 16U;
+
+      TxQueue();
+      explicit TxQueue(Mode mode);
+
+      void setMode(Mode mode);
+      Mode getMode() const;
+      bool push(const Protocol::Can::RawMsg &msg, uint64_t nowNs = 0U); // false if full
+      const Entry &front() const; // the next frame to transmit, queue must not be empty
+      void pop();
+      void clear();
+      bool isEmpty() const;
+      uint32_t getSize() const;
+
+    private:
+      uint32_t findFront() const;
+
+      Mode m_mode;
+      Entry ma_entries[CAPACITY];
+      uint32_t m_size;
+  };
+} // end namespace Eet
+
+#endif // EET_TX_QUEUE_H
@@ -0,0 +1,120 @@
+#include <ctime>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "WallClock.h"
+
+namespace Eet {
+
+  namespace {
+    uint64_t clockNs(clockid_t clockId) {
+      timespec ts{};
+      ::clock_gettime(clockId, &ts);
+      return static_cast<uint64_t>(ts.tv_sec) * 1000000000U + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    // at most 500 ppm slower while catching up, as adjtime() slews
+    constexpr double MAX_SLEW = 0.0005;
+  }
+
+
+  WallClock::WallClock(Source source) :
+    m_source((Source::TSC == source) && not isInvariantTsc() ? Source::MONOTONIC : source),
+    m_baseCounter(0U),
+    m_baseNs(0U),
+    m_baseMonotonicNs(0U),
+    m_nsPerTick(1.0),
+    m_slewedNsPerTick(1.0) {
+    calibrate();
+  }
+
+
+  bool WallClock::isInvariantTsc() {
+#if defined(__x86_64__)
+    unsigned int eax = 0U, ebx = 0U, ecx = 0U, edx = 0U;
+    if((0 == __get_cpuid(0x80000000U, &eax, &ebx, &ecx, &edx)) || (eax < 0x80000007U)) {
+      return false;
+    }
+    __get_cpuid(0x80000007U, &eax, &ebx, &ecx, &edx);
+    return 0U != (edx & (1U << 8)); // TscInvariant
+#else
+    return false;
+#endif
+  }
+
+
+  uint64_t WallClock::realtimeNs() {
+    return clockNs(CLOCK_REALTIME);
+  }
+
+
+  uint64_t WallClock::readCounter() const {
+#if defined(__x86_64__)
+    if(Source::TSC == m_source) {
+      return __rdtsc();
+    }
+#endif
+    return clockNs(CLOCK_MONOTONIC);
+  }
+
+
+  void WallClock::calibrate(uint64_t durationNs) {
+    if(Source::TSC == m_source) {
+      // rate over the time since the previous calibrate() is the most accurate
+      auto startNs = m_baseMonotonicNs;
+      auto startCounter = m_baseCounter;
+      if((0U == startCounter) || (clockNs(CLOCK_MONOTONIC) - startNs < durationNs)) {
+        startNs = clockNs(CLOCK_MONOTONIC);
+        startCounter = readCounter();
+      }
+      uint64_t endNs = clockNs(CLOCK_MONOTONIC);
+      while(endNs - startNs < durationNs) {
+        endNs = clockNs(CLOCK_MONOTONIC);
+      }
+      auto endCounter = readCounter();
+      if(endCounter > startCounter) {
+        m_nsPerTick = static_cast<double>(endNs - startNs) /
+                      static_cast<double>(endCounter - startCounter);
+      }
+    }
+    // base is read back to back, the closer the better
+    auto counter = readCounter();
+    auto baseNs = realtimeNs();
+    auto baseMonotonicNs = clockNs(CLOCK_MONOTONIC);
+    // the last time nowNs() could have returned with the old base
+    auto lastNs = (0U != m_baseCounter) ? toNs(counter) : 0U;
+    auto intervalNs = baseMonotonicNs - m_baseMonotonicNs;
+    m_baseCounter = counter;
+    m_baseNs = baseNs;
+    m_baseMonotonicNs = baseMonotonicNs;
+    m_slewedNsPerTick = m_nsPerTick;
+    if(lastNs > baseNs) {
+      // ahead of the system clock: go on from the last time, slower until
+      // the next calibrate() in about the same interval
+      auto slew = (0U != intervalNs) ? static_cast<double>(lastNs - baseNs) / intervalNs : MAX_SLEW;
+      m_baseNs = lastNs;
+      m_slewedNsPerTick = m_nsPerTick * (1.0 - ((slew < MAX_SLEW) ? slew : MAX_SLEW));
+    }
+  }
+
+
+  uint64_t WallClock::toNs(uint64_t counter) const {
+    // TSC of another core may be a few ticks behind
+    auto ticks = (counter > m_baseCounter) ? counter - m_baseCounter : 0U;
+    return m_baseNs + static_cast<uint64_t>(static_cast<double>(ticks) * m_slewedNsPerTick);
+  }
+
+
+  uint64_t WallClock::nowNs() const {
+    return toNs(readCounter());
+  }
+
+
+  WallClock::Source WallClock::getSource() const {
+    return m_source;
+  }
+
+} // end namespace Eet
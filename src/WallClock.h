@@ -0,0 +1,56 @@
+#ifndef EET_WALL_CLOCK_H
+#define EET_WALL_CLOCK_H
+
+#include <cstdint>
+
+#include "Clock.h"
+
+namespace Eet {
+/**
+ * Cheap wall clock for log timestamps (see LogMsg::setTimeNs()), logs of
+ * several devices may be merged by time then (see LogMerger).
+ *
+ * Reads monotonic counter - TSC if it is invariant (x86-64), otherwise
+ * CLOCK_MONOTONIC through vDSO - and converts it to ns since Unix epoch
+ * with offset and rate measured against CLOCK_REALTIME by calibrate().
+ * Time never goes back, even if NTP steps the system clock; call
+ * calibrate() now and then (e.g. once a second, drift was 2 us/s in a VM)
+ * to follow it. If the clock is behind, calibrate() steps it forward; if it
+ * is ahead, time goes on from the last value at most 500 ppm slower until
+ * the system clock catches up (as adjtime() slews), so logs stay ordered.
+ *
+ * nowNs() is thread safe, calibrate() must not run concurrently with it.
+ */
+  class WallClock final : public IClock {
+    public:
+      enum class Source : uint8_t {
+          TSC = 0,
+          MONOTONIC
+      };
+
+      // TSC falls back to MONOTONIC if there is no invariant TSC
+      explicit WallClock(Source source = Source::TSC);
+
+      uint64_t nowNs() const override;
+      // measures TSC rate since the previous call, busy-waits if it was
+      // less than durationNs ago
+      void calibrate(uint64_t durationNs = 10000000U);
+      Source getSource() const;
+
+      static bool isInvariantTsc();
+      static uint64_t realtimeNs();
+
+    private:
+      uint64_t readCounter() const;
+      uint64_t toNs(uint64_t counter) const;
+
+      Source m_source;
+      uint64_t m_baseCounter;
+      uint64_t m_baseNs;
+      uint64_t m_baseMonotonicNs;
+      double m_nsPerTick;       // measured rate
+      double m_slewedNsPerTick; // used by nowNs()
+  };
+} // end namespace Eet
+
+#endif // EET_WALL_CLOCK_H
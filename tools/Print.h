@@ -0,0 +1,27 @@
+#ifndef EET_TOOLS_PRINT_H
+#define EET_TOOLS_PRINT_H
+
+#include <cstdio>
+
+#include "Histogram.h"
+
+namespace Eet {
+  namespace Tools {
+    inline void printHistogramHeader() {
+      std::printf("%-20s %8s %10s %10s %10s %10s %10s\n",
+                  "stage", "count", "min[us]", "p50[us]", "p99[us]", "p99.9[us]", "max[us]");
+    }
+
+    inline void printHistogram(const char *name, const Histogram &histogram) {
+      std::printf("%-20s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+                  static_cast<unsigned long long>(histogram.getCount()),
+                  histogram.getMin() / 1e3,
+                  histogram.getPercentile(50.0) / 1e3,
+                  histogram.getPercentile(99.0) / 1e3,
+                  histogram.getPercentile(99.9) / 1e3,
+                  histogram.getMax() / 1e3);
+    }
+  } // end namespace Tools
+} // end namespace Eet
+
+#endif // EET_TOOLS_PRINT_H
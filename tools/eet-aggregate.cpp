@@ -0,0 +1,297 @@
+/*
+ * Designated aggregator between a classic CAN segment and a CAN FD one
+ * (see Aggregator), and benchmark of bus load with and without it.
+ *
+ * Usage:
+ *   eet-aggregate [-d max delay ms] [-p stats period s] classic_if fd_if
+ *     frames of classic_if are sent to fd_if in AGGREGATE frames (other
+ *     frames as they are), AGGREGATE frames of fd_if are sent to classic_if
+ *     record by record, classic frames of fd_if as they are
+ *   eet-aggregate -B [-n masters] [-s slaves] [-h heartbeat ms] [-c cmd period ms]
+ *                 [-u update ms] [-d max delay ms] [-N nominal bit/s]
+ *                 [-D data bit/s] [-t seconds]
+ *     generated traffic (see TrafficGenerator) in virtual time: one Slave
+ *     receives classic frames, another one aggregated frames, their states
+ *     are compared after each update()
+ * Example - vcan1 as CAN FD segment:
+ *   ip link add dev vcan1 type vcan && ip link set vcan1 mtu 72 up
+ *   eet-aggregate -d 50 vcan0 vcan1
+ *
+ * Bus time is the worst case (stuffing) of Protocol::Can::getMaxFrameBits()
+ * and getMaxFdFrameNs() with bit rate switch.
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+
+#include "Aggregator.h"
+#include "CanSocket.h"
+#include "Clock.h"
+#include "Device.h"
+#include "TrafficGenerator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint32_t MAX_MSGS = 64U;
+
+  volatile std::sig_atomic_t isStopped = 0;
+
+  struct Options {
+    bool m_isBench = false;
+    uint32_t m_numOfMasters = 2U;
+    uint32_t m_numOfSlaves = 9U;
+    uint64_t m_heartbeatPeriodNs = 100U * MS;
+    uint64_t m_cmdPeriodNs = 1000U * MS;
+    uint64_t m_updatePeriodNs = 300U * MS;
+    uint64_t m_maxDelayNs = 50U * MS;
+    uint32_t m_nominalBitrate = 500000U;
+    uint32_t m_dataBitrate = 2000000U;
+    uint64_t m_durationNs = 60U * SEC;
+    uint64_t m_periodNs = 10U * SEC;
+    const char *m_classicIfName = nullptr;
+    const char *m_fdIfName = nullptr;
+  };
+
+  struct BusTime {
+    uint64_t m_numOfFrames = 0U;
+    uint64_t m_busyNs = 0U;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "Bn:s:h:c:u:d:N:D:t:p:"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'B': options.m_isBench = true; break;
+        case 'n': options.m_numOfMasters = static_cast<uint32_t>(value); break;
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'h': options.m_heartbeatPeriodNs = value * MS; break;
+        case 'c': options.m_cmdPeriodNs = value * MS; break;
+        case 'u': options.m_updatePeriodNs = value * MS; break;
+        case 'd': options.m_maxDelayNs = value * MS; break;
+        case 'N': options.m_nominalBitrate = static_cast<uint32_t>(value); break;
+        case 'D': options.m_dataBitrate = static_cast<uint32_t>(value); break;
+        case 't': options.m_durationNs = value * SEC; break;
+        case 'p': options.m_periodNs = value * SEC; break;
+        default: return false;
+      }
+    }
+    if(not options.m_isBench && (optind + 2 == argc)) {
+      options.m_classicIfName = argv[optind++];
+      options.m_fdIfName = argv[optind++];
+    }
+    // IDs of generated devices and of the listening Slave
+    auto numOfIds = options.m_numOfMasters + options.m_numOfSlaves + 1U;
+    return (optind == argc) && (options.m_isBench || (nullptr != options.m_fdIfName)) &&
+           (numOfIds <= static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID)) &&
+           (options.m_heartbeatPeriodNs > 0U) && (options.m_updatePeriodNs > 0U) &&
+           (options.m_nominalBitrate > 0U) && (options.m_dataBitrate > 0U) &&
+           (options.m_periodNs > 0U);
+  }
+
+  void printStats(const Aggregator &aggregator, uint64_t numOfReceived,
+                  uint64_t numOfFannedOut) {
+    auto numOfRecords = aggregator.getNumOfPushed() - aggregator.getNumOfReplaced();
+    std::printf("classic frames %llu, aggregated %llu (replaced %llu) in %llu frames, "
+                "%.1f records/frame, fanned out %llu\n",
+                static_cast<unsigned long long>(numOfReceived),
+                static_cast<unsigned long long>(aggregator.getNumOfPushed()),
+                static_cast<unsigned long long>(aggregator.getNumOfReplaced()),
+                static_cast<unsigned long long>(aggregator.getNumOfFrames()),
+                aggregator.getNumOfFrames() ?
+                  static_cast<double>(numOfRecords) / aggregator.getNumOfFrames() : 0.0,
+                static_cast<unsigned long long>(numOfFannedOut));
+    std::fflush(stdout);
+  }
+
+  void printBusTime(const char *name, const BusTime &busTime, uint64_t durationNs) {
+    std::printf("%-20s %10llu %12.3f %10.2f%%\n", name,
+                static_cast<unsigned long long>(busTime.m_numOfFrames),
+                busTime.m_busyNs / 1e6, 100.0 * busTime.m_busyNs / durationNs);
+  }
+
+  bool isSameState(const Device &lhs, const Device &rhs) {
+    return (lhs.getErrors() == rhs.getErrors()) &&
+           (lhs.getSlaveState() == rhs.getSlaveState()) &&
+           (lhs.getApproveState() == rhs.getApproveState()) &&
+           (lhs.getCmdType() == rhs.getCmdType());
+  }
+
+  int bench(const Options &options) {
+    TrafficGenerator::Config config = {options.m_numOfMasters, options.m_numOfSlaves, 0U,
+                                       options.m_heartbeatPeriodNs, options.m_cmdPeriodNs,
+                                       TrafficGenerator::Scenario::APPROVE, 0U, 1U,
+                                       Protocol::Can::IdScheme::V1};
+    static TrafficGenerator generator(config);
+    if(not generator.isValid()) {
+      std::fprintf(stderr, "Configuration of devices is not valid\n");
+      return 1;
+    }
+    // both listen as one more Slave after all generated IDs
+    static Slave classicSlave;
+    static Slave fdSlave;
+    Slave *slaves[] = {&classicSlave, &fdSlave};
+    for(auto slave : slaves) {
+      slave->setDeviceId(static_cast<char>(config.m_numOfMasters + config.m_numOfSlaves + 1U));
+      slave->setNumOfMasters(config.m_numOfMasters);
+      slave->setNumOfSlaves(config.m_numOfSlaves + 1U);
+    }
+    static Aggregator aggregator(options.m_maxDelayNs);
+
+    BusTime classic;
+    BusTime fd;
+    auto sendClassic = [&options](const Protocol::Can::RawMsg &msg, BusTime &busTime) {
+      ++busTime.m_numOfFrames;
+      busTime.m_busyNs += static_cast<uint64_t>(Protocol::Can::getMaxFrameBits(msg.m_dlc)) *
+                          SEC / options.m_nominalBitrate;
+    };
+    auto sendAggregate = [&options, &fd]() {
+      Protocol::Can::FdRawMsg frame{};
+      if(aggregator.pop(frame)) {
+        ++fd.m_numOfFrames;
+        fd.m_busyNs += Protocol::Can::getMaxFdFrameNs(frame.m_len, options.m_nominalBitrate,
+                                                      options.m_dataBitrate);
+        fdSlave.pushFdMsg(frame);
+      }
+    };
+
+    Protocol::Can::RawMsg msgs[MAX_MSGS];
+    uint64_t numOfUpdates = 0U;
+    uint64_t numOfMismatches = 0U;
+    uint64_t updateNs = options.m_updatePeriodNs;
+    while(not isStopped) {
+      auto nowNs = generator.getNextNs();
+      nowNs = (aggregator.getDueNs() < nowNs) ? aggregator.getDueNs() : nowNs;
+      nowNs = (updateNs < nowNs) ? updateNs : nowNs;
+      if(nowNs > options.m_durationNs) {
+        break;
+      }
+      auto numOfMsgs = generator.generate(nowNs, msgs, MAX_MSGS);
+      for(uint32_t i = 0U; i < numOfMsgs; ++i) {
+        sendClassic(msgs[i], classic);
+        classicSlave.pushMsg(msgs[i]);
+        if(not aggregator.push(msgs[i], nowNs)) {
+          sendAggregate(); // full
+          if(not aggregator.push(msgs[i], nowNs)) {
+            sendClassic(msgs[i], fd);
+            fdSlave.pushMsg(msgs[i]);
+          }
+        }
+      }
+      if(aggregator.isDue(nowNs)) {
+        sendAggregate();
+      }
+      if(nowNs >= updateNs) {
+        // the last records are on the bus before the period ends
+        sendAggregate();
+        classicSlave.update();
+        fdSlave.update();
+        ++numOfUpdates;
+        numOfMismatches += isSameState(classicSlave, fdSlave) ? 0U : 1U;
+        updateNs += options.m_updatePeriodNs;
+      }
+    }
+
+    std::printf("%u Masters, %u Slaves, heartbeat %.1f ms, cmd every %.1f ms, "
+                "max delay %.1f ms, %u/%u bit/s\n", options.m_numOfMasters,
+                options.m_numOfSlaves, options.m_heartbeatPeriodNs / 1e6,
+                options.m_cmdPeriodNs / 1e6, options.m_maxDelayNs / 1e6,
+                options.m_nominalBitrate, options.m_dataBitrate);
+    printStats(aggregator, generator.getNumOfFrames(), 0U);
+    std::printf("%-20s %10s %12s %11s\n", "bus", "frames", "busy[ms]", "util.");
+    printBusTime("classic", classic, options.m_durationNs);
+    printBusTime("CAN FD aggregated", fd, options.m_durationNs);
+    std::printf("state mismatches %llu of %llu updates\n",
+                static_cast<unsigned long long>(numOfMismatches),
+                static_cast<unsigned long long>(numOfUpdates));
+    return (0U == numOfMismatches) ? 0 : 2;
+  }
+
+  int run(const Options &options) {
+    static CanSocket classicSocket;
+    static CanSocket fdSocket;
+    if(not classicSocket.open(options.m_classicIfName, false, true)) {
+      std::fprintf(stderr, "Cannot open %s\n", options.m_classicIfName);
+      return 1;
+    }
+    if(not fdSocket.open(options.m_fdIfName, true, true)) {
+      std::fprintf(stderr, "Cannot open %s as CAN FD\n", options.m_fdIfName);
+      return 1;
+    }
+    static Aggregator aggregator(options.m_maxDelayNs);
+    pollfd fds[2] = {{classicSocket.getFd(), POLLIN, 0}, {fdSocket.getFd(), POLLIN, 0}};
+    Protocol::Can::FdRawMsg fdMsg{};
+    Protocol::Can::RawMsg msg{};
+    uint64_t numOfReceived = 0U;
+    uint64_t numOfFannedOut = 0U;
+    auto printNs = Clock::monotonicNs() + options.m_periodNs;
+    while(not isStopped) {
+      auto nowNs = Clock::monotonicNs();
+      auto dueNs = aggregator.getDueNs();
+      int timeout = (Aggregator::NEVER == dueNs) ? 100 :
+                    (dueNs > nowNs) ? static_cast<int>((dueNs - nowNs + MS - 1U) / MS) : 0;
+      if(::poll(fds, 2U, timeout) < 0) {
+        continue; // EINTR
+      }
+      nowNs = Clock::monotonicNs();
+      while(classicSocket.recv(fdMsg) && Protocol::Can::toRawMsg(fdMsg, msg)) {
+        ++numOfReceived;
+        if(not aggregator.push(msg, nowNs)) {
+          if(aggregator.pop(fdMsg)) {
+            fdSocket.send(fdMsg); // full
+          }
+          if(not aggregator.push(msg, nowNs)) {
+            fdSocket.send(msg);
+          }
+        }
+      }
+      while(fdSocket.recv(fdMsg)) {
+        if(static_cast<uint32_t>(Protocol::Can::Id::AGGREGATE) == fdMsg.m_canId) {
+          for(uint32_t i = 0U; i < Protocol::Msg::Aggregate::MAX_RECORDS; ++i) {
+            if(Protocol::Msg::Aggregate::getRecord(fdMsg, i, msg)) {
+              classicSocket.send(msg);
+              ++numOfFannedOut;
+            }
+          }
+        } else if(Protocol::Can::toRawMsg(fdMsg, msg)) {
+          classicSocket.send(msg);
+        }
+      }
+      nowNs = Clock::monotonicNs();
+      if(aggregator.isDue(nowNs) && aggregator.pop(fdMsg)) {
+        fdSocket.send(fdMsg);
+      }
+      if(nowNs >= printNs) {
+        printStats(aggregator, numOfReceived, numOfFannedOut);
+        printNs = nowNs + options.m_periodNs;
+      }
+    }
+    printStats(aggregator, numOfReceived, numOfFannedOut);
+    return 0;
+  }
+
+  void onSignal(int) {
+    isStopped = 1;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-d max delay ms] [-p stats period s] classic_if fd_if\n"
+                         "       %s -B [-n masters] [-s slaves] [-h heartbeat ms] "
+                         "[-c cmd period ms] [-u update ms]\n"
+                         "             [-d max delay ms] [-N nominal bit/s] [-D data bit/s] "
+                         "[-t seconds]\n", argv[0], argv[0]);
+    return 1;
+  }
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  return options.m_isBench ? bench(options) : run(options);
+}
@@ -0,0 +1,260 @@
+/*
+ * Bus load and timing analyzer of EET traffic.
+ *
+ * Usage:
+ *   eet-analyze [options] -f <candump -L log>   analyze capture
+ *   eet-analyze [options] -i <ifname>           analyze live traffic for -t seconds
+ *   eet-analyze [options] -S                    analyze simulated network for -t seconds
+ *   eet-analyze [options] -W                    what-if analysis only
+ * Options:
+ *   -b bitrate        (125000)
+ *   -w window ms      (100)
+ *   -t seconds        (10)
+ *   -m masters        (1)    what-if / simulation
+ *   -s slaves         (2)    what-if / simulation
+ *   -h heartbeat ms   (100)  what-if / simulation
+ *   -c cmd period ms  (1000) what-if, minimal time between lever moves
+ *   -v id scheme      (1)    what-if / simulation, 2 - V2 (see Protocol::Can::IdScheme)
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "Analyzer.h"
+#include "CanSocket.h"
+#include "Clock.h"
+#include "Device.h"
+#include "Simulator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint32_t MAX_STREAMS = 256U;
+  const char *KIND_NAMES[Analyzer::NUM_OF_KINDS] = {"ACTIVATE", "HEARTBEAT", "CMD", "OTHER"};
+
+  struct Options {
+    char m_mode = 0;
+    const char *m_source = nullptr;
+    uint32_t m_bitrate = 125000U;
+    uint64_t m_windowNs = 100U * MS;
+    uint64_t m_durationNs = 10000U * MS;
+    uint32_t m_numOfMasters = 1U;
+    uint32_t m_numOfSlaves = 2U;
+    uint64_t m_heartbeatPeriodNs = 100U * MS;
+    uint64_t m_cmdPeriodNs = 1000U * MS;
+    Protocol::Can::IdScheme m_idScheme = Protocol::Can::IdScheme::V1;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "f:i:SWb:w:t:m:s:h:c:v:"))) {
+      auto value = optarg ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'f':
+        case 'i': options.m_mode = static_cast<char>(opt); options.m_source = optarg; break;
+        case 'S':
+        case 'W': options.m_mode = static_cast<char>(opt); break;
+        case 'b': options.m_bitrate = static_cast<uint32_t>(value); break;
+        case 'w': options.m_windowNs = value * MS; break;
+        case 't': options.m_durationNs = value * 1000U * MS; break;
+        case 'm': options.m_numOfMasters = static_cast<uint32_t>(value); break;
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'h': options.m_heartbeatPeriodNs = value * MS; break;
+        case 'c': options.m_cmdPeriodNs = value * MS; break;
+        case 'v': options.m_idScheme = (2U == value) ? Protocol::Can::IdScheme::V2 :
+                                                       Protocol::Can::IdScheme::V1; break;
+        default: return false;
+      }
+    }
+    return (0 != options.m_mode) && (options.m_bitrate > 0U) &&
+           (options.m_windowNs > 0U) && (options.m_heartbeatPeriodNs > 0U) &&
+           (options.m_cmdPeriodNs > 0U);
+  }
+
+  // (1600000000.123456) can0 020#4A0009
+  bool parseCandump(const char *line, Protocol::Can::RawMsg &msg, uint64_t &timeNs) {
+    unsigned long long sec = 0U, usec = 0U;
+    char iface[32];
+    char frame[160];
+    if(4 != std::sscanf(line, " (%llu.%llu) %31s %159s", &sec, &usec, iface, frame)) {
+      return false;
+    }
+    auto hash = std::strchr(frame, '#');
+    if((nullptr == hash) || ('#' == hash[1])) {
+      return false; // not classic frame
+    }
+    *hash = '\0';
+    msg.m_canId = static_cast<uint32_t>(std::strtoul(frame, nullptr, 16));
+    msg.m_dataL = 0UL;
+    msg.m_dataH = 0UL;
+    uint32_t len = 0U;
+    for(auto p = hash + 1; (p[0] && p[1]) && (len < 8U); p += 2, ++len) {
+      char byte[3] = {p[0], p[1], '\0'};
+      auto value = static_cast<uint32_t>(std::strtoul(byte, nullptr, 16));
+      (len < 4U ? msg.m_dataL : msg.m_dataH) |= value << (8U * (len % 4U));
+    }
+    msg.m_dlc = len;
+    timeNs = sec * 1000000000ULL + usec * 1000ULL;
+    return true;
+  }
+
+  bool readCapture(const char *path, Analyzer &analyzer) {
+    auto file = std::fopen(path, "r");
+    if(nullptr == file) {
+      return false;
+    }
+    char line[256];
+    Protocol::Can::RawMsg msg{};
+    uint64_t timeNs = 0U;
+    while(std::fgets(line, sizeof(line), file)) {
+      if(parseCandump(line, msg, timeNs)) {
+        analyzer.onFrame(msg, timeNs);
+      }
+    }
+    std::fclose(file);
+    return true;
+  }
+
+  bool readLive(const char *ifName, uint64_t durationNs, Analyzer &analyzer) {
+    CanSocket socket;
+    if(not socket.open(ifName, false, true)) {
+      return false;
+    }
+    Protocol::Can::FdRawMsg fdMsg{};
+    Protocol::Can::RawMsg msg{};
+    auto startNs = Clock::monotonicNs();
+    while(Clock::monotonicNs() - startNs < durationNs) {
+      if(socket.recv(fdMsg) && Protocol::Can::toRawMsg(fdMsg, msg)) {
+        analyzer.onFrame(msg, Clock::monotonicNs());
+      } else {
+        usleep(100);
+      }
+    }
+    return true;
+  }
+
+  void simulate(const Options &options, Analyzer &analyzer) {
+    Simulator::Config config = {options.m_bitrate, options.m_heartbeatPeriodNs,
+                                3U * options.m_heartbeatPeriodNs};
+    Simulator sim(config);
+    static Master masters[Simulator::MAX_DEVICES];
+    static Slave slaves[Simulator::MAX_DEVICES];
+    char id = Protocol::DeviceId::MIN_DEVICE_ID;
+    for(uint32_t i = 0U; i < options.m_numOfMasters; ++i) {
+      masters[i].setDeviceId(id++);
+      masters[i].setIdScheme(options.m_idScheme);
+      sim.attach(masters[i]);
+    }
+    for(uint32_t i = 0U; i < options.m_numOfSlaves; ++i) {
+      slaves[i].setDeviceId(id++);
+      slaves[i].setIdScheme(options.m_idScheme);
+      sim.attach(slaves[i]);
+    }
+    sim.setSink(&analyzer);
+    sim.run(options.m_durationNs);
+  }
+
+  void printStreams(const Analyzer::Stream *streams, uint32_t numOfStreams, uint32_t bitrate) {
+    std::printf("utilization %.2f%%\n", 100.0 * Analyzer::getUtilization(streams, numOfStreams, bitrate));
+    // one line per kind, the worst stream of the kind
+    std::printf("%-10s %8s %14s %16s\n", "kind", "streams", "min period[ms]", "worst resp.[ms]");
+    for(uint32_t kind = 0U; kind < Analyzer::OTHER; ++kind) {
+      uint32_t count = 0U;
+      uint64_t minPeriodNs = UINT64_MAX;
+      uint64_t worstNs = 0U;
+      for(uint32_t i = 0U; i < numOfStreams; ++i) {
+        if(kind != Analyzer::getKind(streams[i].m_canId)) {
+          continue;
+        }
+        ++count;
+        minPeriodNs = (streams[i].m_periodNs < minPeriodNs) ? streams[i].m_periodNs : minPeriodNs;
+        auto responseNs = Analyzer::getResponseNs(streams, numOfStreams, i, bitrate);
+        worstNs = (responseNs > worstNs) ? responseNs : worstNs;
+      }
+      if(0U == count) {
+        continue;
+      }
+      if(Analyzer::UNBOUNDED == worstNs) {
+        std::printf("%-10s %8u %14.2f %16s\n", KIND_NAMES[kind], count, minPeriodNs / 1e6, "UNBOUNDED");
+      } else {
+        std::printf("%-10s %8u %14.2f %16.3f%s\n", KIND_NAMES[kind], count, minPeriodNs / 1e6,
+                    worstNs / 1e6, (worstNs > minPeriodNs) ? " DEADLINE MISS" : "");
+      }
+    }
+  }
+
+  void printAnalyzer(const Analyzer &analyzer, uint32_t bitrate) {
+    std::printf("frames %" PRIu64 ", utilization mean %.2f%%, max over window %.2f%%\n",
+                analyzer.getNumOfFrames(), 100.0 * analyzer.getMeanUtilization(),
+                100.0 * analyzer.getMaxUtilization());
+    std::printf("%-6s %-10s %8s %12s %12s %12s %12s\n", "sender", "kind", "frames",
+                "mean[ms]", "min[ms]", "max[ms]", "jitter[ms]");
+    for(uint32_t sender = 0U; sender < Analyzer::MAX_SENDERS; ++sender) {
+      for(uint32_t kind = 0U; kind < Analyzer::NUM_OF_KINDS; ++kind) {
+        const auto &stats = analyzer.getSenderStats(static_cast<char>(sender),
+                                                    static_cast<Analyzer::Kind>(kind));
+        if(0U == stats.m_numOfFrames) {
+          continue;
+        }
+        const auto &interval = stats.m_intervalNs;
+        std::printf("%-6u %-10s %8" PRIu64 " %12.3f %12.3f %12.3f %12.3f\n",
+                    sender, KIND_NAMES[kind], stats.m_numOfFrames,
+                    interval.getMean() / 1e6, interval.getMin() / 1e6,
+                    interval.getMax() / 1e6, (interval.getMax() - interval.getMin()) / 1e6);
+      }
+    }
+    static Analyzer::Stream streams[MAX_STREAMS];
+    auto numOfStreams = analyzer.getStreams(streams, MAX_STREAMS);
+    std::printf("\nobserved streams:\n");
+    printStreams(streams, numOfStreams, bitrate);
+  }
+}
+
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-b bitrate] [-w window ms] [-t seconds] [-m masters] [-s slaves]\n"
+                         "          [-h heartbeat ms] [-c cmd period ms] [-v id scheme]\n"
+                         "          (-f log | -i ifname | -S | -W)\n",
+                 argv[0]);
+    return 1;
+  }
+
+  static Analyzer analyzer(options.m_bitrate, options.m_windowNs);
+  bool ok = true;
+  switch(options.m_mode) {
+    case 'f': ok = readCapture(options.m_source, analyzer); break;
+    case 'i': ok = readLive(options.m_source, options.m_durationNs, analyzer); break;
+    case 'S':
+      if(options.m_numOfMasters + options.m_numOfSlaves > Simulator::MAX_DEVICES) {
+        std::fprintf(stderr, "Simulator supports up to %u devices, use -W\n", Simulator::MAX_DEVICES);
+        return 1;
+      }
+      simulate(options, analyzer);
+      break;
+    default: break;
+  }
+  if(not ok) {
+    std::perror(options.m_source);
+    return 1;
+  }
+  if('W' != options.m_mode) {
+    printAnalyzer(analyzer, options.m_bitrate);
+  }
+
+  static Analyzer::Stream streams[MAX_STREAMS];
+  auto numOfStreams = Analyzer::makeStreams(options.m_numOfMasters, options.m_numOfSlaves,
+                                            options.m_heartbeatPeriodNs, options.m_cmdPeriodNs,
+                                            streams, MAX_STREAMS, options.m_idScheme);
+  std::printf("\nwhat-if: %u Masters, %u Slaves, heartbeat %.1f ms, cmd every %.1f ms, %u bit/s, "
+              "IDs V%u\n",
+              options.m_numOfMasters, options.m_numOfSlaves, options.m_heartbeatPeriodNs / 1e6,
+              options.m_cmdPeriodNs / 1e6, options.m_bitrate,
+              static_cast<uint32_t>(options.m_idScheme));
+  printStreams(streams, numOfStreams, options.m_bitrate);
+  return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * Records traffic of one Master and several Slaves in the simulator (the
+ * operator moves the lever every few seconds, active Slave approves),
+ * injects anomalies into a copy of it and replays both through
+ * AnomalyDetector. Prints detected events and cost per frame.
+ * Injected anomalies:
+ *   HEARTBEAT_JITTER    - heartbeats of Device 3 jitter more and more
+ *                         since 1/3 of the run
+ *   DUPLICATED_ID_FLAP  - Device 4 reports DUPLICATED_DEVICE_ID on and off
+ *                         since 1/2 of the run
+ *   CMD_OSCILLATION     - extra Master cmds FULL_AHEAD/FULL_ASTERN each
+ *                         100 ms at 2/3 of the run
+ *   UNCOMMANDED_APPROVE - not active Device 5 approves HALF_ASTERN which
+ *                         is never commanded at 5/6 of the run
+ * Observer column is the same detector fed by transitions of simulated
+ * devices while recording (clean traffic).
+ *
+ * Usage: eet-anomaly [-s slaves] [-t seconds] [-r replays] [-b bitrate] [-h heartbeat ms]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Device.h"
+#include "Simulator.h"
+#include "AnomalyDetector.h"
+#include "Helpers.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint32_t MAX_FRAMES = 1U << 20U;
+  constexpr uint32_t NUM_OF_OSCILLATIONS = 6U;
+  const char *const NAMES[] = {"HEARTBEAT_JITTER", "DUPLICATED_ID_FLAP", "CMD_OSCILLATION",
+                               "UNCOMMANDED_APPROVE", "INVALID_FRAMES"};
+
+  struct Options {
+    uint32_t m_numOfSlaves = 4U;
+    uint64_t m_durationNs = 60U * SEC;
+    uint32_t m_numOfReplays = 100U;
+    Simulator::Config m_config = {125000U, 100U * MS, 300U * MS};
+  };
+
+  struct Frame {
+    Protocol::Can::RawMsg m_msg;
+    uint64_t m_timeNs;
+  };
+
+  class Recorder final : public IFrameSink {
+    public:
+      void onFrame(const Protocol::Can::RawMsg &msg, uint64_t timeNs) override {
+        if(m_numOfFrames < MAX_FRAMES) {
+          ma_frames[m_numOfFrames++] = Frame{msg, timeNs};
+        }
+      }
+
+      Frame ma_frames[MAX_FRAMES];
+      uint32_t m_numOfFrames = 0U;
+  };
+
+  class Printer final : public AnomalyDetector::IListener {
+    public:
+      void onAnomaly(const AnomalyDetector::Event &event) override {
+        std::printf("  %10.3f s  %-20s device %2d cmd %3u value %llu\n",
+                    event.m_timeNs / 1e9, NAMES[event.m_type],
+                    static_cast<int>(event.m_deviceId),
+                    static_cast<uint32_t>(event.m_cmdType),
+                    static_cast<unsigned long long>(event.m_value));
+      }
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "s:t:r:b:h:"))) {
+      auto value = std::strtoull(optarg, nullptr, 10);
+      switch(opt) {
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 't': options.m_durationNs = value * SEC; break;
+        case 'r': options.m_numOfReplays = static_cast<uint32_t>(value); break;
+        case 'b': options.m_config.m_bitrate = static_cast<uint32_t>(value); break;
+        case 'h': options.m_config.m_heartbeatPeriodNs = value * MS; break;
+        default: return false;
+      }
+    }
+    // Devices 3, 4 and 5 are Slaves
+    return (options.m_numOfSlaves >= 4U) &&
+           (options.m_numOfSlaves < Simulator::MAX_DEVICES) &&
+           (options.m_durationNs >= 12U * SEC) && (options.m_numOfReplays > 0U) &&
+           (options.m_config.m_bitrate > 0U) && (options.m_config.m_heartbeatPeriodNs > 0U);
+  }
+
+  void record(const Options &options, Recorder &recorder, AnomalyDetector &live,
+              Simulator &sim) {
+    Master master;
+    static Slave slaves[Simulator::MAX_DEVICES];
+    const Protocol::CmdType lever[] = {Protocol::CmdType::STOP,
+                                       Protocol::CmdType::DEAD_SLOW_AHEAD,
+                                       Protocol::CmdType::SLOW_AHEAD,
+                                       Protocol::CmdType::HALF_AHEAD};
+
+    master.setDeviceId(1);
+    master.setNumOfMasters(0U);
+    master.setNumOfSlaves(options.m_numOfSlaves);
+    master.setObserver(&live);
+    sim.attach(master);
+    for(uint32_t i = 0U; i < options.m_numOfSlaves; ++i) {
+      slaves[i].setDeviceId(static_cast<char>(i + 2U));
+      slaves[i].setNumOfMasters(1U);
+      slaves[i].setNumOfSlaves(options.m_numOfSlaves - 1U);
+      slaves[i].setObserver(&live);
+      sim.attach(slaves[i]);
+    }
+    sim.setSink(&recorder);
+
+    auto &active = slaves[0];
+    sim.run(2U * options.m_config.m_updatePeriodNs);
+    active.activate();
+    for(uint32_t i = 0U; sim.nowNs() + 5U * SEC < options.m_durationNs; ++i) {
+      sim.run(2U * SEC);
+      auto cmdType = lever[i % (sizeof(lever) / sizeof(lever[0]))];
+      master.setCmdType(cmdType);
+      sim.send(master, master.getCmdMsg());
+      sim.run(3U * SEC);
+      active.approve(cmdType);
+    }
+    sim.run(options.m_durationNs - sim.nowNs());
+  }
+
+  uint64_t xorshift(uint64_t &state) {
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    return state;
+  }
+
+  // copies clean frames to faulty ones and injects anomalies, see above
+  void inject(const Options &options, const Recorder &clean, Recorder &faulty) {
+    auto durationNs = options.m_durationNs;
+    auto periodNs = options.m_config.m_heartbeatPeriodNs;
+    uint64_t random = 0x9E3779B97F4A7C15ULL;
+    uint32_t numOfFlapped = 0U;
+    bool isApproveInjected = false;
+    faulty.m_numOfFrames = 0U;
+    for(uint32_t i = 0U; i < clean.m_numOfFrames; ++i) {
+      auto frame = clean.ma_frames[i];
+      auto &msg = frame.m_msg;
+      auto deviceId = Helpers::bits2type<char>(msg.m_dataL, 0U, 0U, 6U);
+      bool isHeartbeat = (static_cast<uint32_t>(Protocol::Can::Id::HEARTBEAT) == msg.m_canId);
+      if(isHeartbeat && (3 == deviceId) && (frame.m_timeNs > durationNs / 3U)) {
+        // amplitude grows up to 40% of period by the end of the run
+        auto amplitudeNs = 2U * periodNs / 5U * (frame.m_timeNs - durationNs / 3U) /
+                           (durationNs - durationNs / 3U);
+        if(amplitudeNs > 0U) {
+          frame.m_timeNs += xorshift(random) % amplitudeNs;
+        }
+      }
+      if(isHeartbeat && (4 == deviceId) && (frame.m_timeNs > durationNs / 2U) &&
+         (numOfFlapped < 30U)) {
+        // 3 heartbeats with error, 3 without
+        uint32_t isDuplicated = (numOfFlapped++ / 3U) % 2U;
+        Helpers::setBits(msg.m_dataL, isDuplicated, 1U,
+                         static_cast<uint32_t>(Protocol::ErrorBit::DUPLICATED_DEVICE_ID), 1U);
+      }
+      if(isHeartbeat && (5 == deviceId) && (frame.m_timeNs > 5U * durationNs / 6U) &&
+         not isApproveInjected) {
+        isApproveInjected = true;
+        Helpers::setBits(msg.m_dataL, Protocol::ApproveState::APPROVED, 2U, 1U, 1U);
+        Helpers::setBits(msg.m_dataL, Protocol::CmdType::HALF_ASTERN, 2U, 2U, 7U);
+      }
+      faulty.onFrame(msg, frame.m_timeNs);
+    }
+
+    Protocol::Msg::CommonFields master(1, Protocol::DeviceType::MASTER, 0U);
+    for(uint32_t i = 0U; i < NUM_OF_OSCILLATIONS; ++i) {
+      auto cmdType = (i % 2U) ? Protocol::CmdType::FULL_ASTERN : Protocol::CmdType::FULL_AHEAD;
+      Protocol::Msg::Cmd cmdMsg(master, cmdType);
+      faulty.onFrame(static_cast<Protocol::Can::RawMsg>(cmdMsg),
+                     2U * durationNs / 3U + i * 100U * MS);
+    }
+    std::stable_sort(faulty.ma_frames, faulty.ma_frames + faulty.m_numOfFrames,
+                     [](const Frame &a, const Frame &b) { return a.m_timeNs < b.m_timeNs; });
+  }
+
+  // replays frames several times, returns ns per frame
+  double replay(const Options &options, const Recorder &recorder,
+                AnomalyDetector &detector) {
+    auto startNs = Clock::monotonicNs();
+    for(uint32_t r = 0U; r < options.m_numOfReplays; ++r) {
+      detector.reset();
+      for(uint32_t i = 0U; i < recorder.m_numOfFrames; ++i) {
+        detector.onFrame(recorder.ma_frames[i].m_msg, recorder.ma_frames[i].m_timeNs);
+      }
+    }
+    auto elapsedNs = Clock::monotonicNs() - startNs;
+    return static_cast<double>(elapsedNs) /
+           (static_cast<double>(recorder.m_numOfFrames) * options.m_numOfReplays);
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-s slaves(>=4)] [-t seconds(>=12)] [-r replays] "
+                         "[-b bitrate] [-h heartbeat ms]\n", argv[0]);
+    return 1;
+  }
+
+  static Simulator sim(options.m_config);
+  static Recorder clean;
+  static Recorder faulty;
+  static AnomalyDetector live(sim);
+  record(options, clean, live, sim);
+  inject(options, clean, faulty);
+
+  // events of the faulty traffic are printed once, then cost is measured
+  static Printer printer;
+  static AnomalyDetector detector;
+  std::printf("events of faulty traffic:\n");
+  detector.setListener(&printer);
+  for(uint32_t i = 0U; i < faulty.m_numOfFrames; ++i) {
+    detector.onFrame(faulty.ma_frames[i].m_msg, faulty.ma_frames[i].m_timeNs);
+  }
+  uint64_t numOfFaulty[AnomalyDetector::NUM_OF_TYPES];
+  for(uint32_t type = 0U; type < AnomalyDetector::NUM_OF_TYPES; ++type) {
+    numOfFaulty[type] = detector.getNumOfEvents(static_cast<AnomalyDetector::Type>(type));
+  }
+  detector.setListener(nullptr);
+  auto faultyNs = replay(options, faulty, detector);
+  auto cleanNs = replay(options, clean, detector);
+
+  std::printf("%-20s %8s %8s %8s\n", "anomaly", "faulty", "clean", "observer");
+  for(uint32_t type = 0U; type < AnomalyDetector::NUM_OF_TYPES; ++type) {
+    auto anomaly = static_cast<AnomalyDetector::Type>(type);
+    std::printf("%-20s %8llu %8llu %8llu\n", NAMES[type],
+                static_cast<unsigned long long>(numOfFaulty[type]),
+                static_cast<unsigned long long>(detector.getNumOfEvents(anomaly)),
+                static_cast<unsigned long long>(live.getNumOfEvents(anomaly)));
+  }
+  std::printf("frames %u, replays %u, faulty %.1f ns/frame, clean %.1f ns/frame\n",
+              faulty.m_numOfFrames, options.m_numOfReplays, faultyNs, cleanNs);
+  return 0;
+}
@@ -0,0 +1,531 @@
+/*
+ * Allocation and syscall audit of the hot paths of Master and Slave:
+ * pushMsg(), update(), operator inputs, encoding of messages (get*Msg())
+ * and LogMsg formatting.
+ *
+ * Records traffic of one Master and several Slaves in the simulator (every
+ * 50th frame is replaced by a corrupted one) and replays it into a listening
+ * Master and Slave in a child process. Global operator new/delete and
+ * malloc() family are replaced by counting ones, counts are kept per
+ * operation. After warm-up replays a seccomp filter traps every syscall
+ * except clock_gettime() (vDSO fallback), rt_sigreturn() and exit(); trapped
+ * ones are counted per operation and fail with ENOSYS. Prints allocations of
+ * warm-up and audited replays and syscalls per operation, exits with 1 if
+ * anything allocated or made a syscall after warm-up.
+ *
+ * Usage: eet-audit [-s slaves] [-t seconds] [-w warm-up replays] [-r replays]
+ */
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define EET_AUDIT_SECCOMP
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <ucontext.h>
+#endif
+
+#include "Device.h"
+#include "Simulator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint32_t MAX_FRAMES = 1U << 18U;
+  constexpr uint32_t CORRUPTED_EACH = 50U;
+
+  enum Op : uint32_t {
+      MASTER_PUSH = 0,
+      MASTER_UPDATE,
+      SLAVE_PUSH,
+      SLAVE_UPDATE,
+      INPUT,
+      ENCODE,
+      LOG_FRAME,
+      LOG_STATE,
+      HARNESS, // outside of any operation
+      NUM_OF_OPS
+  };
+
+  const char *const OP_NAMES[] = {"Master pushMsg", "Master update", "Slave pushMsg",
+                                  "Slave update", "operator input", "encode", "LogMsg O",
+                                  "LogMsg T", "harness"};
+
+  struct Counters {
+    uint64_t m_numOfCalls;
+    uint64_t m_numOfNews;
+    uint64_t m_numOfMallocs;
+    uint64_t m_numOfBytes;
+    uint64_t m_numOfFrees;
+    uint64_t m_numOfSyscalls;
+    int32_t m_lastSyscall;
+  };
+
+  // shared with the audited child process
+  struct Report {
+    Counters ma_warmUp[NUM_OF_OPS];
+    Counters ma_audited[NUM_OF_OPS];
+    int m_seccompErrno; // 0 - syscalls are audited
+    uint32_t m_digest;
+    bool m_isDone;
+  };
+
+  struct Options {
+    uint32_t m_numOfSlaves = 4U;
+    uint64_t m_durationNs = 30U * SEC;
+    uint32_t m_numOfWarmUps = 1U;
+    uint32_t m_numOfReplays = 20U;
+  };
+
+  struct Frame {
+    Protocol::Can::RawMsg m_msg;
+    uint64_t m_timeNs;
+  };
+
+  class Recorder final : public IFrameSink {
+    public:
+      void onFrame(const Protocol::Can::RawMsg &msg, uint64_t timeNs) override {
+        if(m_numOfFrames < MAX_FRAMES) {
+          ma_frames[m_numOfFrames++] = Frame{msg, timeNs};
+        }
+      }
+
+      Frame ma_frames[MAX_FRAMES];
+      uint32_t m_numOfFrames = 0U;
+  };
+
+  // nullptr until the child starts, counting is off
+  Report *report = nullptr;
+  Counters *counters = nullptr; // of the current phase
+  volatile Op currentOp = HARNESS;
+
+  class Scope {
+    public:
+      explicit Scope(Op op) {
+        currentOp = op;
+        ++counters[op].m_numOfCalls;
+      }
+      ~Scope() {
+        currentOp = HARNESS;
+      }
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+  };
+
+  inline void onAlloc(bool isNew, size_t size) {
+    if(nullptr != counters) {
+      auto &current = counters[currentOp];
+      ++(isNew ? current.m_numOfNews : current.m_numOfMallocs);
+      current.m_numOfBytes += size;
+    }
+  }
+
+  inline void onFree(void *ptr) {
+    if((nullptr != counters) && (nullptr != ptr)) {
+      ++counters[currentOp].m_numOfFrees;
+    }
+  }
+} // end namespace
+
+
+// glibc allocator under the replaced malloc() family
+extern "C" {
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t num, size_t size);
+  void *__libc_realloc(void *ptr, size_t size);
+  void *__libc_memalign(size_t alignment, size_t size);
+  void __libc_free(void *ptr);
+
+  void *malloc(size_t size) {
+    onAlloc(false, size);
+    return __libc_malloc(size);
+  }
+
+  void *calloc(size_t num, size_t size) {
+    onAlloc(false, num * size);
+    return __libc_calloc(num, size);
+  }
+
+  void *realloc(void *ptr, size_t size) {
+    onAlloc(false, size);
+    return __libc_realloc(ptr, size);
+  }
+
+  void *memalign(size_t alignment, size_t size) {
+    onAlloc(false, size);
+    return __libc_memalign(alignment, size);
+  }
+
+  void *aligned_alloc(size_t alignment, size_t size) {
+    onAlloc(false, size);
+    return __libc_memalign(alignment, size);
+  }
+
+  int posix_memalign(void **ptr, size_t alignment, size_t size) {
+    onAlloc(false, size);
+    *ptr = __libc_memalign(alignment, size);
+    return (nullptr != *ptr) ? 0 : ENOMEM;
+  }
+
+  void free(void *ptr) {
+    onFree(ptr);
+    __libc_free(ptr);
+  }
+}
+
+void *operator new(size_t size) {
+  onAlloc(true, size);
+  auto *ptr = __libc_malloc((0U != size) ? size : 1U);
+  if(nullptr == ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  onAlloc(true, size);
+  return __libc_malloc((0U != size) ? size : 1U);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept {
+  onFree(ptr);
+  __libc_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  operator delete(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  operator delete(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  operator delete(ptr);
+}
+
+
+namespace {
+#ifdef EET_AUDIT_SECCOMP
+#if defined(__x86_64__)
+  constexpr uint32_t SYSCALL_ARCH = AUDIT_ARCH_X86_64;
+  inline void setSyscallResult(ucontext_t &context, long result) {
+    context.uc_mcontext.gregs[REG_RAX] = result;
+  }
+#else
+  constexpr uint32_t SYSCALL_ARCH = AUDIT_ARCH_AARCH64;
+  inline void setSyscallResult(ucontext_t &context, long result) {
+    context.uc_mcontext.regs[0] = static_cast<unsigned long long>(result);
+  }
+#endif
+
+  void onSyscall(int, siginfo_t *info, void *context) {
+    auto &current = report->ma_audited[currentOp];
+    ++current.m_numOfSyscalls;
+    current.m_lastSyscall = info->si_syscall;
+    setSyscallResult(*static_cast<ucontext_t *>(context), -ENOSYS);
+  }
+
+  // 0 or errno, the filter stays until the process exits
+  int startSyscallAudit() {
+    struct sigaction action = {};
+    action.sa_sigaction = onSyscall;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    if(0 != ::sigaction(SIGSYS, &action, nullptr)) {
+      return errno;
+    }
+    sock_filter filter[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, arch)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYSCALL_ARCH, 1, 0),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRAP),
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_clock_gettime, 4, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_rt_sigreturn, 3, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_exit_group, 2, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_exit, 1, 0),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRAP),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW)
+    };
+    sock_fprog program = {static_cast<unsigned short>(sizeof(filter) / sizeof(filter[0])),
+                          filter};
+    if((0 != ::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0)) ||
+       (0 != ::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program))) {
+      return errno;
+    }
+    return 0;
+  }
+#else
+  int startSyscallAudit() {
+    return ENOSYS;
+  }
+#endif
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "s:t:w:r:"))) {
+      auto value = std::strtoull(optarg, nullptr, 10);
+      switch(opt) {
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 't': options.m_durationNs = value * SEC; break;
+        case 'w': options.m_numOfWarmUps = static_cast<uint32_t>(value); break;
+        case 'r': options.m_numOfReplays = static_cast<uint32_t>(value); break;
+        default: return false;
+      }
+    }
+    // network Devices and the two listeners
+    return (options.m_numOfSlaves > 0U) &&
+           (options.m_numOfSlaves + 3U <= Simulator::MAX_DEVICES) &&
+           (options.m_durationNs >= SEC) && (options.m_numOfWarmUps > 0U) &&
+           (options.m_numOfReplays > 0U);
+  }
+
+  void record(const Options &options, Recorder &recorder) {
+    const Protocol::CmdType lever[] = {Protocol::CmdType::STOP,
+                                       Protocol::CmdType::DEAD_SLOW_AHEAD,
+                                       Protocol::CmdType::HALF_ASTERN,
+                                       Protocol::CmdType::FULL_AHEAD};
+    Simulator sim;
+    Master master;
+    static Slave slaves[Simulator::MAX_DEVICES];
+    master.setDeviceId(1);
+    master.setNumOfMasters(1U);
+    master.setNumOfSlaves(options.m_numOfSlaves + 1U);
+    sim.attach(master);
+    for(uint32_t i = 0U; i < options.m_numOfSlaves; ++i) {
+      slaves[i].setDeviceId(static_cast<char>(i + 2U));
+      slaves[i].setNumOfMasters(2U);
+      slaves[i].setNumOfSlaves(options.m_numOfSlaves);
+      sim.attach(slaves[i]);
+    }
+    sim.setSink(&recorder);
+
+    auto &active = slaves[0];
+    sim.run(SEC);
+    active.activate();
+    for(uint32_t i = 0U; sim.nowNs() + 2U * SEC < options.m_durationNs; ++i) {
+      auto cmdType = lever[i % (sizeof(lever) / sizeof(lever[0]))];
+      master.setCmdType(cmdType);
+      sim.send(master, master.getCmdMsg());
+      sim.run(SEC);
+      active.approve(cmdType);
+      sim.run(SEC);
+    }
+
+    uint32_t state = 0x12345678U;
+    for(uint32_t i = CORRUPTED_EACH - 1U; i < recorder.m_numOfFrames; i += CORRUPTED_EACH) {
+      auto &msg = recorder.ma_frames[i].m_msg;
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      msg.m_canId = state & 0x7FFU;
+      msg.m_dlc = (state >> 11) % 9U;
+      msg.m_dataL ^= state;
+      msg.m_dataH ^= state * 2654435761U;
+    }
+  }
+
+  inline void addDigest(uint32_t &digest, const void *data, uint32_t size) {
+    auto *bytes = static_cast<const uint8_t *>(data);
+    for(uint32_t i = 0U; i < size; ++i) {
+      digest = (digest ^ bytes[i]) * 16777619UL;
+    }
+  }
+
+  void logState(Device &device, uint64_t timeNs, uint32_t &digest) {
+    Scope scope(LOG_STATE);
+    Protocol::Msg::LogMsg logMsg(device.getDeviceId(), device.getDeviceType(),
+                                 device.getErrors(), device.getSlaveState(),
+                                 device.getApproveState(), device.getCmdType());
+    logMsg.setTimeNs(timeNs);
+    addDigest(digest, logMsg.m_msg, logMsg.m_msgSize);
+  }
+
+  void push(Device &device, Op op, const Frame &frame, uint32_t &digest) {
+    uint16_t errors = 0U;
+    {
+      Scope scope(op);
+      errors = device.pushMsg(frame.m_msg);
+    }
+    Scope scope(LOG_FRAME);
+    Protocol::Msg::LogMsg logMsg(device.getDeviceId(), errors, frame.m_msg);
+    logMsg.setTimeNs(frame.m_timeNs);
+    addDigest(digest, logMsg.m_msg, logMsg.m_msgSize);
+  }
+
+  // Master 1 + 2 and Slave 2 + numOfSlaves + 1 listen to recorded traffic
+  void replay(const Recorder &recorder, Master &master, Slave &slave, uint32_t &digest) {
+    constexpr uint64_t UPDATE_PERIOD_NS = 300U * MS;
+    uint64_t nextUpdateNs = UPDATE_PERIOD_NS;
+    uint32_t numOfUpdates = 0U;
+    for(uint32_t i = 0U; i < recorder.m_numOfFrames; ++i) {
+      const auto &frame = recorder.ma_frames[i];
+      push(master, MASTER_PUSH, frame, digest);
+      push(slave, SLAVE_PUSH, frame, digest);
+      if(frame.m_timeNs < nextUpdateNs) {
+        continue;
+      }
+      nextUpdateNs += UPDATE_PERIOD_NS;
+      ++numOfUpdates;
+      {
+        Scope scope(INPUT);
+        auto cmdType = static_cast<Protocol::CmdType>((numOfUpdates / 4U) % 11U);
+        master.setCmdType(cmdType);
+        if(0U == numOfUpdates % 16U) {
+          slave.activate();
+        } else if(2U == numOfUpdates % 4U) {
+          slave.approve(cmdType);
+        }
+      }
+      {
+        Scope scope(MASTER_UPDATE);
+        master.update();
+      }
+      {
+        Scope scope(SLAVE_UPDATE);
+        slave.update();
+      }
+      Protocol::Can::RawMsg msgs[5];
+      {
+        Scope scope(ENCODE);
+        msgs[0] = master.getHeartbeatMsg();
+        msgs[1] = master.getCmdMsg();
+        msgs[2] = slave.getHeartbeatMsg();
+        msgs[3] = slave.getActivateMsg();
+        msgs[4] = slave.getDiscoverMsg();
+      }
+      addDigest(digest, msgs, sizeof(msgs));
+      logState(master, frame.m_timeNs, digest);
+      logState(slave, frame.m_timeNs, digest);
+    }
+  }
+
+  void audit(const Options &options, const Recorder &recorder) {
+    static Master master;
+    static Slave slave;
+    master.setDeviceId(2);
+    master.setNumOfMasters(1U);
+    master.setNumOfSlaves(options.m_numOfSlaves + 1U);
+    slave.setDeviceId(static_cast<char>(options.m_numOfSlaves + 2U));
+    slave.setNumOfMasters(2U);
+    slave.setNumOfSlaves(options.m_numOfSlaves);
+
+    uint32_t digest = 2166136261UL;
+    counters = report->ma_warmUp;
+    for(uint32_t i = 0U; i < options.m_numOfWarmUps; ++i) {
+      replay(recorder, master, slave, digest);
+    }
+    report->m_seccompErrno = startSyscallAudit();
+    counters = report->ma_audited;
+    for(uint32_t i = 0U; i < options.m_numOfReplays; ++i) {
+      replay(recorder, master, slave, digest);
+    }
+    report->m_digest = digest;
+    report->m_isDone = true;
+  }
+
+  uint64_t getNumOfAllocs(const Counters &counters) {
+    return counters.m_numOfNews + counters.m_numOfMallocs;
+  }
+
+  void print(const char *phase, const Counters *phaseCounters, bool isSyscallAudited) {
+    std::printf("%s:\n%-16s %10s %8s %8s %10s %8s %8s\n", phase, "op", "calls",
+                "new", "malloc", "bytes", "free", "syscall");
+    for(uint32_t op = 0U; op < NUM_OF_OPS; ++op) {
+      const auto &c = phaseCounters[op];
+      std::printf("%-16s %10llu %8llu %8llu %10llu %8llu ", OP_NAMES[op],
+                  static_cast<unsigned long long>(c.m_numOfCalls),
+                  static_cast<unsigned long long>(c.m_numOfNews),
+                  static_cast<unsigned long long>(c.m_numOfMallocs),
+                  static_cast<unsigned long long>(c.m_numOfBytes),
+                  static_cast<unsigned long long>(c.m_numOfFrees));
+      if(not isSyscallAudited) {
+        std::printf("%8s\n", "-");
+      } else if(0U == c.m_numOfSyscalls) {
+        std::printf("%8u\n", 0U);
+      } else {
+        std::printf("%8llu (last nr %d)\n", static_cast<unsigned long long>(c.m_numOfSyscalls),
+                    c.m_lastSyscall);
+      }
+    }
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-s slaves] [-t seconds] [-w warm-up replays] "
+                         "[-r replays]\n", argv[0]);
+    return 1;
+  }
+  static Recorder recorder;
+  record(options, recorder);
+
+  auto *shared = ::mmap(nullptr, sizeof(Report), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if(MAP_FAILED == shared) {
+    std::perror("mmap");
+    return 1;
+  }
+  std::fflush(stdout);
+  auto pid = ::fork();
+  if(pid < 0) {
+    std::perror("fork");
+    return 1;
+  }
+  if(0 == pid) {
+    report = static_cast<Report *>(shared);
+    audit(options, recorder);
+    ::_exit(0);
+  }
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  const auto &result = *static_cast<const Report *>(shared);
+  if(not result.m_isDone) {
+    std::fprintf(stderr, "Audited process failed, status %d\n", status);
+    return 1;
+  }
+
+  bool isSyscallAudited = (0 == result.m_seccompErrno);
+  std::printf("%u frames x %u warm-up + %u audited replays, digest %08x\n",
+              recorder.m_numOfFrames, options.m_numOfWarmUps, options.m_numOfReplays,
+              result.m_digest);
+  if(not isSyscallAudited) {
+    std::printf("syscalls are not audited: seccomp: %s\n", std::strerror(result.m_seccompErrno));
+  }
+  print("warm-up", result.ma_warmUp, false);
+  print("audited", result.ma_audited, isSyscallAudited);
+
+  uint64_t numOfAllocs = 0U;
+  uint64_t numOfSyscalls = 0U;
+  for(const auto &c : result.ma_audited) {
+    numOfAllocs += getNumOfAllocs(c);
+    numOfSyscalls += c.m_numOfSyscalls;
+  }
+  bool isPassed = (0U == numOfAllocs) && (0U == numOfSyscalls);
+  std::printf("%s: %llu allocations, %llu syscalls after warm-up\n", isPassed ? "PASS" : "FAIL",
+              static_cast<unsigned long long>(numOfAllocs),
+              static_cast<unsigned long long>(numOfSyscalls));
+  return isPassed ? 0 : 1;
+}
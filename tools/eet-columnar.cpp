@@ -0,0 +1,120 @@
+/*
+ * Converts ASCII logs into columnar file (see Columnar.h) and runs
+ * example fleet queries over it.
+ *
+ * Usage:
+ *   eet-columnar convert <columnar file> <log>...
+ *   eet-columnar scan <columnar file>
+ *     rows with errors per device, E_SOME_SLAVES_LOST flaps per device,
+ *     time from FULL_AHEAD to APPROVED and scan throughput
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "Clock.h"
+#include "Columnar.h"
+#include "Print.h"
+
+namespace {
+  using namespace Eet;
+
+  int convert(const char *path, int argc, char *argv[]) {
+    static Columnar::Writer writer;
+    if(not writer.open(path)) {
+      std::fprintf(stderr, "Can not open %s\n", path);
+      return 1;
+    }
+    static char line[Protocol::Msg::LogMsg::LOG_MSG_MAX_SIZE];
+    uint64_t numOfRows = 0U;
+    for(int i = 0; i < argc; ++i) {
+      FILE *log = std::fopen(argv[i], "rb");
+      if(nullptr == log) {
+        std::fprintf(stderr, "Can not open %s\n", argv[i]);
+        return 1;
+      }
+      while(nullptr != std::fgets(line, sizeof(line), log)) {
+        LogRecord record{};
+        if(LogParser::parse(line, static_cast<uint32_t>(std::strlen(line)), record)) {
+          numOfRows += writer.add(record);
+        }
+      }
+      std::fclose(log);
+    }
+    if(not writer.close()) {
+      std::fprintf(stderr, "Can not write %s\n", path);
+      return 1;
+    }
+    std::printf("Converted %llu rows\n", static_cast<unsigned long long>(numOfRows));
+    return 0;
+  }
+
+  int scan(const char *path) {
+    static Columnar::Reader reader;
+    static Columnar::Chunk chunk;
+    static uint8_t all[Columnar::MAX_ROWS];
+    static uint8_t errors[Columnar::MAX_ROWS];
+    static uint8_t start[Columnar::MAX_ROWS];
+    static uint8_t end[Columnar::MAX_ROWS];
+    if(not reader.open(path)) {
+      std::fprintf(stderr, "Can not open %s\n", path);
+      return 1;
+    }
+
+    uint64_t counts[256] = {};
+    static Columnar::Transitions flaps(Columnar::ERRORS,
+                                       1U << Protocol::CON_WITH_SOME_SLAVES_LOST);
+    static Columnar::Durations approval;
+    uint64_t numOfRows = 0U;
+    uint64_t startNs = Clock::monotonicNs();
+    while(nullptr != reader.next()) {
+      if(not reader.load(chunk)) {
+        std::fprintf(stderr, "Corrupted chunk\n");
+        return 1;
+      }
+      numOfRows += chunk.m_numOfRows;
+      Columnar::selectAll(chunk, all);
+      std::memcpy(errors, all, chunk.m_numOfRows);
+      Columnar::selectBits(chunk, Columnar::ERRORS, 0x7FU, errors);
+      Columnar::groupCount(chunk, Columnar::SUBJECT_ID, errors, counts);
+
+      flaps.scan(chunk, all);
+
+      std::memcpy(start, all, chunk.m_numOfRows);
+      Columnar::selectEq(chunk, Columnar::CMD_TYPE,
+                         static_cast<uint8_t>(Protocol::CmdType::FULL_AHEAD), start);
+      Columnar::selectEq(chunk, Columnar::APPROVE_STATE,
+                         static_cast<uint8_t>(Protocol::ApproveState::NOT_APPROVED), start);
+      std::memcpy(end, all, chunk.m_numOfRows);
+      Columnar::selectEq(chunk, Columnar::APPROVE_STATE,
+                         static_cast<uint8_t>(Protocol::ApproveState::APPROVED), end);
+      approval.scan(chunk, start, end);
+    }
+    uint64_t elapsedNs = Clock::monotonicNs() - startNs;
+
+    std::printf("%-10s %12s %12s\n", "device", "with errors", "flaps");
+    for(uint32_t id = Protocol::DeviceId::MIN_DEVICE_ID;
+        id <= static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID); ++id) {
+      std::printf("%-10u %12llu %12llu\n", id,
+                  static_cast<unsigned long long>(counts[id]),
+                  static_cast<unsigned long long>(flaps.getCount(static_cast<uint8_t>(id))));
+    }
+    Tools::printHistogramHeader();
+    Tools::printHistogram("FULL_AHEAD->APPROVED", approval.getHistogram());
+    std::printf("Scanned %llu rows in %.1f ms, %.1f Mrows/s\n",
+                static_cast<unsigned long long>(numOfRows), elapsedNs / 1e6,
+                (elapsedNs > 0U) ? numOfRows * 1e3 / elapsedNs : 0.0);
+    return 0;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if((argc >= 4) && (0 == std::strcmp(argv[1], "convert"))) {
+    return convert(argv[2], argc - 3, argv + 3);
+  }
+  if((3 == argc) && (0 == std::strcmp(argv[1], "scan"))) {
+    return scan(argv[2]);
+  }
+  std::fprintf(stderr, "Usage: %s convert <columnar file> <log>...\n"
+                       "       %s scan <columnar file>\n", argv[0], argv[0]);
+  return 1;
+}
@@ -0,0 +1,253 @@
+/*
+ * Cycle-count harness of pushMsg()/update() of Master and Slave.
+ *
+ * Feeds the same pseudo-random mix of valid and corrupted frames, operator
+ * actions and update() calls to both devices, prints cycles (ns where there
+ * is no cycle counter) per call and digest of all device outputs.
+ * The harness is built against eet-core (eet-cycles) and against hosted eet
+ * (eet-cycles-hosted), equal digests mean both builds behave the same.
+ * Steady rows: the same devices get steady traffic - every peer repeats
+ * its heartbeat, lever moves each STEADY_FRAMES_PER_CMD frames.
+ *
+ * Usage: eet-cycles [frames]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Clock.h"
+#include "Device.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint32_t FRAMES_PER_UPDATE = 12U;
+  constexpr uint32_t MAX_SAMPLES = 1U << 20;
+  constexpr uint32_t NUM_OF_PEERS = 6U; // Masters 1, 2 and Slaves 3 - 6
+  constexpr uint32_t ACTIVE_SLAVE = 4U;
+  constexpr uint32_t STEADY_FRAMES_PER_CMD = 600U;
+
+#if defined(__x86_64__) || defined(__i386__)
+  const char UNIT[] = "cycles";
+  inline uint64_t now() {
+    return __rdtsc();
+  }
+#else
+  const char UNIT[] = "ns";
+  inline uint64_t now() {
+    return Clock::monotonicNs();
+  }
+#endif
+
+  struct Samples {
+    uint64_t ma_values[MAX_SAMPLES];
+    uint32_t m_size;
+
+    void add(uint64_t value) {
+      if(m_size < MAX_SAMPLES) {
+        ma_values[m_size++] = value;
+      }
+    }
+
+    void print(const char *name) {
+      if(0U == m_size) {
+        return;
+      }
+      std::sort(ma_values, ma_values + m_size);
+      std::printf("%-16s %10u %10llu %10llu %10llu %10llu\n", name, m_size,
+                  static_cast<unsigned long long>(ma_values[0]),
+                  static_cast<unsigned long long>(ma_values[m_size / 2U]),
+                  static_cast<unsigned long long>(ma_values[m_size / 100U * 99U]),
+                  static_cast<unsigned long long>(ma_values[m_size - 1U]));
+    }
+  };
+
+  struct Digest {
+    uint32_t m_hash = 2166136261UL;
+
+    void add(const void *data, uint32_t size) {
+      auto *bytes = static_cast<const uint8_t *>(data);
+      for(uint32_t i = 0U; i < size; ++i) {
+        m_hash ^= bytes[i];
+        m_hash *= 16777619UL;
+      }
+    }
+
+    void add(uint32_t value) {
+      add(&value, sizeof(value));
+    }
+  };
+
+  uint32_t nextRandom(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  Protocol::Can::RawMsg makeFrame(uint32_t &state) {
+    uint32_t r = nextRandom(state);
+    auto deviceId = static_cast<char>(Protocol::DeviceId::MIN_DEVICE_ID + r % 6U);
+    auto deviceType = (deviceId <= 2) ? Protocol::DeviceType::MASTER :
+                                        Protocol::DeviceType::SLAVE;
+    Protocol::Msg::CommonFields commonFields(deviceId, deviceType,
+                                             static_cast<char>((r >> 8) & 0x7FU));
+    auto cmdType = static_cast<Protocol::CmdType>((r >> 16) % 11U);
+    Protocol::Can::RawMsg msg{};
+    switch((r >> 20) % 8U) {
+      case 0U: {
+        Protocol::Msg::Activate activate(commonFields);
+        msg = static_cast<Protocol::Can::RawMsg>(activate);
+        break;
+      }
+      case 1U: {
+        Protocol::Msg::Cmd cmd(commonFields, cmdType);
+        msg = static_cast<Protocol::Can::RawMsg>(cmd);
+        break;
+      }
+      case 2U: {
+        // corrupted frame
+        msg = {nextRandom(state) & 0x7FFU, nextRandom(state) % 9U,
+               nextRandom(state), nextRandom(state)};
+        break;
+      }
+      default: {
+        Protocol::Msg::Heartbeat heartbeat(commonFields,
+                                           static_cast<Protocol::SlaveState>((r >> 24) & 1U),
+                                           static_cast<Protocol::ApproveState>((r >> 25) & 1U),
+                                           cmdType);
+        msg = static_cast<Protocol::Can::RawMsg>(heartbeat);
+        break;
+      }
+    }
+    return msg;
+  }
+
+  void addState(Digest &digest, Device &device) {
+    digest.add(static_cast<uint32_t>(device.getErrors()));
+    digest.add(static_cast<uint32_t>(device.getSlaveState()));
+    digest.add(static_cast<uint32_t>(device.getApproveState()));
+    digest.add(static_cast<uint32_t>(device.getCmdType()));
+    auto heartbeat = device.getHeartbeatMsg();
+    digest.add(&heartbeat, sizeof(heartbeat));
+    Protocol::Msg::LogMsg logMsg(device.getDeviceId(), device.getDeviceType(),
+                                 device.getErrors(), device.getSlaveState(),
+                                 device.getApproveState(), device.getCmdType());
+    digest.add(logMsg.m_msg, logMsg.m_msgSize);
+  }
+
+  // heartbeat of peer in steady traffic when Master commands cmdType
+  Protocol::Can::RawMsg makeSteadyFrame(uint32_t peerId, Protocol::CmdType cmdType) {
+    auto deviceType = (peerId <= 2U) ? Protocol::DeviceType::MASTER :
+                                       Protocol::DeviceType::SLAVE;
+    bool isActive = (ACTIVE_SLAVE == peerId);
+    Protocol::Msg::CommonFields commonFields(static_cast<char>(peerId), deviceType, 0U);
+    Protocol::Msg::Heartbeat heartbeat(commonFields,
+                                       isActive ? Protocol::SlaveState::ACTIVE :
+                                                  Protocol::SlaveState::NOT_ACTIVE,
+                                       isActive ? Protocol::ApproveState::APPROVED :
+                                                  Protocol::ApproveState::NOT_APPROVED,
+                                       cmdType);
+    return static_cast<Protocol::Can::RawMsg>(heartbeat);
+  }
+
+  void runSteady(Device &device, uint32_t numOfFrames, Samples &pushCycles) {
+    Protocol::Can::RawMsg msgs[NUM_OF_PEERS];
+    uint32_t numOfMsgs = 0U;
+    uint32_t peer = 0U;
+    for(uint32_t i = 0U; i < numOfFrames; ++i) {
+      if(0U == i % STEADY_FRAMES_PER_CMD) {
+        auto cmdType = static_cast<Protocol::CmdType>((i / STEADY_FRAMES_PER_CMD) % 11U);
+        numOfMsgs = 0U;
+        for(uint32_t id = 1U; id <= NUM_OF_PEERS; ++id) {
+          if(static_cast<char>(id) != device.getDeviceId()) {
+            msgs[numOfMsgs++] = makeSteadyFrame(id, cmdType);
+          }
+        }
+      }
+      const auto &msg = msgs[peer++ % numOfMsgs];
+      uint64_t start = now();
+      device.pushMsg(msg);
+      pushCycles.add(now() - start);
+      if(0U == i % FRAMES_PER_UPDATE) {
+        device.update();
+      }
+    }
+  }
+
+  template<typename Tap>
+  uint32_t run(Device &device, uint32_t numOfFrames, Samples &pushCycles,
+               Samples &updateCycles, Tap tap) {
+    Digest digest;
+    uint32_t state = 0x12345678U;
+    for(uint32_t i = 1U; i <= numOfFrames; ++i) {
+      auto msg = makeFrame(state);
+      uint64_t start = now();
+      uint16_t errors = device.pushMsg(msg);
+      pushCycles.add(now() - start);
+      digest.add(errors);
+      Protocol::Msg::LogMsg logMsg(device.getDeviceId(), errors, msg);
+      digest.add(logMsg.m_msg, logMsg.m_msgSize);
+
+      if(0U == i % FRAMES_PER_UPDATE) {
+        tap(nextRandom(state));
+        start = now();
+        device.update();
+        updateCycles.add(now() - start);
+        addState(digest, device);
+      }
+    }
+    return digest.m_hash;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t numOfFrames = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) :
+                                      120000U;
+  static Samples pushCycles;
+  static Samples updateCycles;
+
+  Master master;
+  master.setDeviceId(1);
+  master.setNumOfMasters(2U);
+  master.setNumOfSlaves(4U);
+  uint32_t masterDigest = run(master, numOfFrames, pushCycles, updateCycles,
+                              [&master](uint32_t r) {
+                                if(0U == r % 4U) {
+                                  master.setCmdType(static_cast<Protocol::CmdType>(r % 11U));
+                                }
+                              });
+
+  static Samples slavePushCycles;
+  static Samples slaveUpdateCycles;
+  Slave slave;
+  slave.setDeviceId(3);
+  slave.setNumOfMasters(2U);
+  slave.setNumOfSlaves(4U);
+  uint32_t slaveDigest = run(slave, numOfFrames, slavePushCycles, slaveUpdateCycles,
+                             [&slave](uint32_t r) {
+                               if(0U == r % 8U) {
+                                 slave.activate();
+                               } else if(0U == r % 3U) {
+                                 slave.approve(static_cast<Protocol::CmdType>(r % 11U));
+                               }
+                             });
+
+  std::printf("%-16s %10s %10s %10s %10s %10s [%s]\n",
+              "call", "count", "min", "p50", "p99", "max", UNIT);
+  pushCycles.print("Master pushMsg");
+  updateCycles.print("Master update");
+  slavePushCycles.print("Slave pushMsg");
+  slaveUpdateCycles.print("Slave update");
+  pushCycles.m_size = 0U;
+  slavePushCycles.m_size = 0U;
+  runSteady(master, numOfFrames, pushCycles);
+  runSteady(slave, numOfFrames, slavePushCycles);
+  pushCycles.print("Master steady");
+  slavePushCycles.print("Slave steady");
+  std::printf("digest %08x %08x\n", masterDigest, slaveDigest);
+  return 0;
+}
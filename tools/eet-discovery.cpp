@@ -0,0 +1,142 @@
+/*
+ * Measures time-to-operational of a Slave which boots into running
+ * network (one Master and several Slaves, one of them active) with and
+ * without discovery. Device is operational after its first update() which
+ * reports no errors after discovery. Boot moments and the first periodic update() of the
+ * booting Slave are spread over the update period.
+ *
+ * Usage: eet-discovery [-s slaves] [-n boots] [-b bitrate] [-h heartbeat ms] [-u update ms]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Device.h"
+#include "Simulator.h"
+#include "Print.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t STEP_NS = MS / 10U;
+
+  struct Options {
+    uint32_t m_numOfSlaves = 4U; // including booting one
+    uint32_t m_numOfBoots = 200U;
+    Simulator::Config m_config = {125000U, 100U * MS, 300U * MS};
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "s:n:b:h:u:"))) {
+      auto value = std::strtoull(optarg, nullptr, 10);
+      switch(opt) {
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'n': options.m_numOfBoots = static_cast<uint32_t>(value); break;
+        case 'b': options.m_config.m_bitrate = static_cast<uint32_t>(value); break;
+        case 'h': options.m_config.m_heartbeatPeriodNs = value * MS; break;
+        case 'u': options.m_config.m_updatePeriodNs = value * MS; break;
+        default: return false;
+      }
+    }
+    return (options.m_numOfSlaves > 1U) &&
+           (options.m_numOfSlaves < Simulator::MAX_DEVICES) &&
+           (options.m_numOfBoots > 0U) && (options.m_config.m_bitrate > 0U);
+  }
+
+  // counts updates which raised errors
+  class AlarmCounter : public IObserver {
+    public:
+      void onTransition(const Device &, StateField field, uint8_t, uint8_t to) override {
+        m_numOfAlarms += ((StateField::ERRORS == field) && (0U != to));
+      }
+
+      uint32_t m_numOfAlarms = 0U;
+  };
+
+  struct Result {
+    Histogram m_operationalNs;
+    uint32_t m_numOfAlarms = 0U;
+    uint32_t m_numOfFailed = 0U;
+    uint64_t m_numOfFrames = 0U;
+  };
+
+  void boot(const Options &options, uint64_t offsetNs, uint64_t phaseNs, bool isDiscovery,
+            Result &result) {
+    Simulator sim(options.m_config);
+    Master master;
+    Slave slaves[Simulator::MAX_DEVICES];
+    auto numOfSlaves = options.m_numOfSlaves;
+
+    master.setDeviceId(1);
+    master.setNumOfMasters(0U);
+    master.setNumOfSlaves(numOfSlaves);
+    sim.attach(master);
+    for(uint32_t i = 0U; i < numOfSlaves; ++i) {
+      slaves[i].setDeviceId(static_cast<char>(i + 2U));
+      slaves[i].setNumOfMasters(1U);
+      slaves[i].setNumOfSlaves(numOfSlaves - 1U);
+    }
+    for(uint32_t i = 0U; i + 1U < numOfSlaves; ++i) {
+      sim.attach(slaves[i]);
+    }
+    sim.run(2U * options.m_config.m_updatePeriodNs);
+    slaves[0].activate();
+    // heartbeats with INVALID cmd type are rejected, give active Slave a command
+    master.setCmdType(Protocol::CmdType::STOP);
+    sim.send(master, master.getCmdMsg());
+    sim.run(2U * options.m_config.m_updatePeriodNs + offsetNs);
+
+    auto &booting = slaves[numOfSlaves - 1U];
+    AlarmCounter alarms;
+    booting.setObserver(&alarms);
+    auto framesBefore = sim.getNumOfFrames();
+    sim.attach(booting, isDiscovery);
+    sim.setUpdatePhase(booting, phaseNs);
+    uint64_t elapsedNs = 0U;
+    const uint64_t timeoutNs = 5U * options.m_config.m_updatePeriodNs;
+    while(((0U == sim.getNumOfUpdates(booting)) || booting.isDiscovering() ||
+           (0 != booting.getErrors())) && (elapsedNs < timeoutNs)) {
+      sim.run(STEP_NS);
+      elapsedNs += STEP_NS;
+    }
+    if(elapsedNs < timeoutNs) {
+      result.m_operationalNs.record(elapsedNs);
+    } else {
+      ++result.m_numOfFailed;
+    }
+    result.m_numOfAlarms += alarms.m_numOfAlarms;
+    result.m_numOfFrames += sim.getNumOfFrames() - framesBefore;
+  }
+}
+
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-s slaves] [-n boots] [-b bitrate] "
+                         "[-h heartbeat ms] [-u update ms]\n", argv[0]);
+    return 1;
+  }
+
+  static Result results[2];
+  for(uint32_t i = 0U; i < options.m_numOfBoots; ++i) {
+    auto periodNs = options.m_config.m_updatePeriodNs;
+    auto offsetNs = periodNs * i / options.m_numOfBoots;
+    auto phaseNs = STEP_NS + periodNs * ((i * 7919U) % options.m_numOfBoots) / options.m_numOfBoots;
+    boot(options, offsetNs, phaseNs, false, results[0]);
+    boot(options, offsetNs, phaseNs, true, results[1]);
+  }
+
+  Tools::printHistogramHeader();
+  Tools::printHistogram("boot", results[0].m_operationalNs);
+  Tools::printHistogram("boot+discovery", results[1].m_operationalNs);
+  const char *names[] = {"boot", "boot+discovery"};
+  for(uint32_t i = 0U; i < 2U; ++i) {
+    std::printf("%-20s false alarms %u, not operational %u, frames until operational %.1f\n",
+                names[i], results[i].m_numOfAlarms, results[i].m_numOfFailed,
+                static_cast<double>(results[i].m_numOfFrames) / options.m_numOfBoots);
+  }
+  return 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * Failover benchmark of Replication: primary Master in a child process
+ * publishes its state after every update(), standby Master in this process
+ * polls Replication::Standby. After a random time the primary is killed
+ * (SIGKILL, closed connection) or frozen (SIGSTOP, -S, silence timeout)
+ * and the time from kill() to takeover is measured. Primary has a pending
+ * HALF_AHEAD cmd, every takeover checks that the standby has it. A frozen
+ * primary is resumed after takeover and must see it has been fenced off
+ * (it exits instead of transmitting).
+ * With -P the standby stalls instead: it does not poll for the given time
+ * while the primary keeps publishing and sending keepalives into the full
+ * socket buffer. Standby must not take over and must stay connected.
+ *
+ * Usage:
+ *   eet-failover [-r rounds] [-u update ms] [-p poll us] [-T timeout ms] [-S]
+ *                [-P stall ms] [path]
+ * Example - 100 rounds with 10 ms updates, standby polls every 100 us:
+ *   eet-failover -r 100 -u 10 -p 100
+ * Example - standby stalled for 500 ms, 4 times the timeout:
+ *   eet-failover -r 10 -T 125 -P 500
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Clock.h"
+#include "Device.h"
+#include "Histogram.h"
+#include "Print.h"
+#include "Replication.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t US = 1000U;
+  constexpr uint64_t MS = 1000U * US;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint64_t START_TIMEOUT_NS = 5U * SEC;
+  constexpr uint64_t FENCE_TIMEOUT_NS = 1U * SEC;
+  constexpr uint64_t KEEPALIVE_PERIOD_NS = 1U * MS;
+  constexpr int FENCED = 3; // exit status of a replaced primary
+
+  struct Options {
+    uint32_t m_numOfRounds = 20U;
+    uint64_t m_updatePeriodNs = 10U * MS;
+    uint32_t m_pollPeriodUs = 100U;
+    uint64_t m_timeoutNs = 50U * MS;
+    bool m_isFrozen = false;
+    uint64_t m_stallNs = 0U;
+    const char *m_path = "/tmp/eet-failover";
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "r:u:p:T:SP:"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'r': options.m_numOfRounds = static_cast<uint32_t>(value); break;
+        case 'u': options.m_updatePeriodNs = value * MS; break;
+        case 'p': options.m_pollPeriodUs = static_cast<uint32_t>(value); break;
+        case 'T': options.m_timeoutNs = value * MS; break;
+        case 'S': options.m_isFrozen = true; break;
+        case 'P': options.m_stallNs = value * MS; break;
+        default: return false;
+      }
+    }
+    if(optind < argc) {
+      options.m_path = argv[optind++];
+    }
+    return (optind == argc) && (options.m_updatePeriodNs > 0U) &&
+           (options.m_timeoutNs > options.m_updatePeriodNs);
+  }
+
+  void configure(Master &master) {
+    master.setDeviceId(1);
+    master.setNumOfMasters(1U);
+    master.setNumOfSlaves(2U);
+  }
+
+  // child process, never returns, exits with FENCED once replaced
+  void runPrimary(const Options &options) {
+    static Master master;
+    configure(master);
+    master.setCmdType(Protocol::CmdType::HALF_AHEAD);
+    Replication::Primary primary;
+    if(not primary.open(options.m_path)) {
+      ::_exit(1);
+    }
+    while(true) {
+      if(not primary.isActive()) {
+        ::_exit(FENCED); // would stop transmitting to the bus
+      }
+      master.update();
+      primary.publish(master);
+      // keepalives between updates fill the buffer of a stalled standby soon
+      for(uint64_t ns = 0U; ns < options.m_updatePeriodNs; ns += KEEPALIVE_PERIOD_NS) {
+        ::usleep(static_cast<useconds_t>(KEEPALIVE_PERIOD_NS / US));
+        primary.keepalive();
+      }
+    }
+  }
+
+  pid_t startPrimary(const Options &options) {
+    auto pid = ::fork();
+    if(pid < 0) {
+      std::perror("fork");
+    } else if(0 == pid) {
+      runPrimary(options);
+    }
+    return pid;
+  }
+
+  // true if the resumed primary has exited as fenced
+  bool isFenced(pid_t pid) {
+    ::kill(pid, SIGCONT);
+    auto startNs = Clock::monotonicNs();
+    while(Clock::monotonicNs() - startNs < FENCE_TIMEOUT_NS) {
+      int status = 0;
+      if(pid == ::waitpid(pid, &status, WNOHANG)) {
+        return WIFEXITED(status) && (FENCED == WEXITSTATUS(status));
+      }
+      ::usleep(1000U);
+    }
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+    return false;
+  }
+
+  // takeover delay after kill(), 0 if round has failed
+  uint64_t runRound(const Options &options, bool &isCmdPreserved, bool &isPrimaryFenced) {
+    static Master backup;
+    configure(backup);
+    Replication::Standby standby;
+    if(not standby.open(options.m_path, options.m_timeoutNs)) {
+      std::perror("standby");
+      return 0U;
+    }
+    auto pid = startPrimary(options);
+    if(pid < 0) {
+      return 0U;
+    }
+
+    // kill at a random point of the update period, after a few of them
+    auto startNs = Clock::monotonicNs();
+    auto killNs = UINT64_MAX;
+    auto runNs = 3U * options.m_updatePeriodNs +
+                 static_cast<uint64_t>(std::rand()) % options.m_updatePeriodNs;
+    while(not standby.isActive()) {
+      standby.poll(backup);
+      auto nowNs = Clock::monotonicNs();
+      if((UINT64_MAX == killNs) && (0U != standby.getNumOfUpdates()) &&
+         (nowNs - startNs >= runNs)) {
+        killNs = Clock::monotonicNs();
+        ::kill(pid, options.m_isFrozen ? SIGSTOP : SIGKILL);
+      }
+      if((UINT64_MAX == killNs) && (nowNs - startNs > START_TIMEOUT_NS)) {
+        break; // primary has not connected
+      }
+      ::usleep(options.m_pollPeriodUs);
+    }
+    isCmdPreserved = (Protocol::CmdType::HALF_AHEAD == backup.getCmdType());
+    if(options.m_isFrozen && standby.isActive()) {
+      isPrimaryFenced = isFenced(pid);
+    } else {
+      ::kill(pid, SIGKILL);
+      ::waitpid(pid, nullptr, 0);
+    }
+    if(not standby.isActive() || (UINT64_MAX == killNs)) {
+      return 0U;
+    }
+    return standby.getTakeoverTimeNs() - killNs;
+  }
+
+  // true if standby has neither taken over nor lost primary after the stall
+  bool runStallRound(const Options &options) {
+    static Master backup;
+    configure(backup);
+    Replication::Standby standby;
+    if(not standby.open(options.m_path, options.m_timeoutNs)) {
+      std::perror("standby");
+      return false;
+    }
+    auto pid = startPrimary(options);
+    if(pid < 0) {
+      return false;
+    }
+    auto startNs = Clock::monotonicNs();
+    while((0U == standby.getNumOfUpdates()) &&
+          (Clock::monotonicNs() - startNs < START_TIMEOUT_NS)) {
+      standby.poll(backup);
+      ::usleep(options.m_pollPeriodUs);
+    }
+    bool isStarted = (0U != standby.getNumOfUpdates());
+    ::usleep(static_cast<useconds_t>(options.m_stallNs / US));
+    // a few update periods after the stall, primary must still be there
+    startNs = Clock::monotonicNs();
+    while(Clock::monotonicNs() - startNs < 3U * options.m_updatePeriodNs) {
+      standby.poll(backup);
+      ::usleep(options.m_pollPeriodUs);
+    }
+    bool isOk = isStarted && (not standby.isActive()) && standby.isPrimaryConnected() &&
+                (Protocol::CmdType::HALF_AHEAD == backup.getCmdType());
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+    return isOk;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-r rounds] [-u update ms] [-p poll us] "
+                         "[-T timeout ms] [-S]\n"
+                         "          [-P stall ms] [path]\n", argv[0]);
+    return 1;
+  }
+  std::srand(1U);
+  if(0U != options.m_stallNs) {
+    uint32_t numOfFailed = 0U;
+    for(uint32_t i = 0U; i < options.m_numOfRounds; ++i) {
+      numOfFailed += runStallRound(options) ? 0U : 1U;
+    }
+    std::printf("%u rounds, standby stalled %.1f ms, update %.1f ms, timeout %.1f ms\n",
+                options.m_numOfRounds, options.m_stallNs / 1e6,
+                options.m_updatePeriodNs / 1e6, options.m_timeoutNs / 1e6);
+    std::printf("failed rounds %u (takeover or lost primary)\n", numOfFailed);
+    return (0U == numOfFailed) ? 0 : 2;
+  }
+  static Histogram takeoverNs;
+  uint32_t numOfFailed = 0U;
+  uint32_t numOfPreserved = 0U;
+  uint32_t numOfFenced = 0U;
+  for(uint32_t i = 0U; i < options.m_numOfRounds; ++i) {
+    bool isCmdPreserved = false;
+    bool isPrimaryFenced = false;
+    auto delayNs = runRound(options, isCmdPreserved, isPrimaryFenced);
+    if(0U == delayNs) {
+      ++numOfFailed;
+      continue;
+    }
+    takeoverNs.record(delayNs);
+    numOfPreserved += isCmdPreserved ? 1U : 0U;
+    numOfFenced += isPrimaryFenced ? 1U : 0U;
+  }
+  std::printf("%u rounds, primary %s, update %.1f ms, poll %u us, timeout %.1f ms\n",
+              options.m_numOfRounds, options.m_isFrozen ? "frozen" : "killed",
+              options.m_updatePeriodNs / 1e6, options.m_pollPeriodUs,
+              options.m_timeoutNs / 1e6);
+  std::printf("takeovers %llu, failed rounds %u, cmd preserved %u, old primary fenced %u\n",
+              static_cast<unsigned long long>(takeoverNs.getCount()), numOfFailed,
+              numOfPreserved, numOfFenced);
+  Tools::printHistogramHeader();
+  Tools::printHistogram("kill to takeover", takeoverNs);
+  bool isFencingOk = (not options.m_isFrozen) || (numOfFenced == takeoverNs.getCount());
+  return ((0U == numOfFailed) && isFencingOk) ? 0 : 2;
+}
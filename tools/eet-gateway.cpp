@@ -0,0 +1,237 @@
+/*
+ * Gateway between EET networks on separate CAN interfaces, see Gateway.
+ *
+ * Usage:
+ *   eet-gateway [-p stats period s] -r route [-r route ...] if0 if1 [if2 if3]
+ *   eet-gateway -B frames -r route [-r route ...]   in-memory benchmark
+ * Route: fromBus:toBus:kinds:fromId:toId[:toScheme]
+ *   bus - index of interface in the list, kinds - h (HEARTBEAT), c (CMD)
+ *   or hc, toScheme - 1 (V1, default), 2 (V2) or 3 (COMPAT).
+ * Example - Master 1 of vcan0 is Master 5 of vcan1, Slave 4 of vcan1 is
+ * Slave 7 of vcan0:
+ *   eet-gateway -r 0:1:hc:1:5 -r 1:0:h:4:7 vcan0 vcan1
+ *
+ * Latency is measured from return of recvmmsg() to return of sendmmsg()
+ * (time spent in the gateway). The benchmark forwards batches of
+ * CanSocket::MAX_BATCH frames of the first route's sender without sockets.
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+#include "CanSocket.h"
+#include "Clock.h"
+#include "Gateway.h"
+#include "Print.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t SEC = 1000000000U;
+
+  volatile std::sig_atomic_t isStopped = 0;
+
+  struct Options {
+    const char *ma_ifNames[Gateway::MAX_BUSES] = {};
+    uint32_t m_numOfBuses = 0U;
+    Gateway::Route ma_routes[Gateway::MAX_ROUTES] = {};
+    uint32_t m_numOfRoutes = 0U;
+    uint64_t m_periodNs = 10U * SEC;
+    uint64_t m_numOfBenchFrames = 0U;
+  };
+
+  bool parseRoute(const char *str, Gateway::Route &route) {
+    unsigned fromBus = 0U;
+    unsigned toBus = 0U;
+    char kinds[3] = {};
+    int fromId = 0;
+    int toId = 0;
+    unsigned scheme = 1U;
+    int num = std::sscanf(str, "%u:%u:%2[hc]:%d:%d:%u", &fromBus, &toBus, kinds,
+                          &fromId, &toId, &scheme);
+    if((num < 5) || (scheme < 1U) || (scheme > 3U)) {
+      return false;
+    }
+    route.m_fromBus = fromBus;
+    route.m_toBus = toBus;
+    route.m_kinds = 0U;
+    route.m_kinds |= (nullptr != std::strchr(kinds, 'h')) ?
+                     static_cast<uint8_t>(Gateway::HEARTBEAT) : static_cast<uint8_t>(0U);
+    route.m_kinds |= (nullptr != std::strchr(kinds, 'c')) ?
+                     static_cast<uint8_t>(Gateway::CMD) : static_cast<uint8_t>(0U);
+    route.m_fromDeviceId = static_cast<char>(fromId);
+    route.m_toDeviceId = static_cast<char>(toId);
+    route.m_toIdScheme = static_cast<Protocol::Can::IdScheme>(scheme);
+    return true;
+  }
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "r:p:B:"))) {
+      switch(opt) {
+        case 'r':
+          if((options.m_numOfRoutes >= Gateway::MAX_ROUTES) ||
+             not parseRoute(optarg, options.ma_routes[options.m_numOfRoutes++])) {
+            return false;
+          }
+          break;
+        case 'p': options.m_periodNs = std::strtoull(optarg, nullptr, 10) * SEC; break;
+        case 'B': options.m_numOfBenchFrames = std::strtoull(optarg, nullptr, 10); break;
+        default: return false;
+      }
+    }
+    for(int i = optind; i < argc; ++i) {
+      if(options.m_numOfBuses >= Gateway::MAX_BUSES) {
+        return false;
+      }
+      options.ma_ifNames[options.m_numOfBuses++] = argv[i];
+    }
+    bool isBench = (0U != options.m_numOfBenchFrames);
+    return (options.m_numOfRoutes > 0U) && (options.m_periodNs > 0U) &&
+           (isBench || (options.m_numOfBuses > 1U));
+  }
+
+  void printStats(const Gateway &gateway, uint32_t numOfBuses, uint64_t elapsedNs) {
+    std::printf("%-5s %-16s %10s %10s %10s\n", "route", "path", "frames", "fps", "dropped");
+    for(uint32_t i = 0U; i < gateway.getNumOfRoutes(); ++i) {
+      const auto &route = gateway.getRoute(i);
+      const auto &stats = gateway.getRouteStats(i);
+      char path[32];
+      std::snprintf(path, sizeof(path), "%u:%d->%u:%d", route.m_fromBus,
+                    static_cast<int>(route.m_fromDeviceId), route.m_toBus,
+                    static_cast<int>(route.m_toDeviceId));
+      std::printf("%-5u %-16s %10llu %10.0f %10llu\n", i, path,
+                  static_cast<unsigned long long>(stats.m_numOfFrames),
+                  (elapsedNs > 0U) ? 1e9 * stats.m_numOfFrames / elapsedNs : 0.0,
+                  static_cast<unsigned long long>(stats.m_numOfDropped));
+    }
+    Tools::printHistogramHeader();
+    for(uint32_t i = 0U; i < gateway.getNumOfRoutes(); ++i) {
+      char name[20]; // "route " and any uint32_t
+      std::snprintf(name, sizeof(name), "route %u", i);
+      Tools::printHistogram(name, gateway.getRouteStats(i).m_latencyNs);
+    }
+    for(uint32_t bus = 0U; bus < numOfBuses; ++bus) {
+      const auto &stats = gateway.getBusStats(bus);
+      std::printf("bus %u: received %llu, looped %llu, unrouted %llu\n", bus,
+                  static_cast<unsigned long long>(stats.m_numOfFrames),
+                  static_cast<unsigned long long>(stats.m_numOfLooped),
+                  static_cast<unsigned long long>(stats.m_numOfUnrouted));
+    }
+  }
+
+  void bench(const Options &options, Gateway &gateway) {
+    // heartbeats and cmds of the first route's sender
+    const auto &route = options.ma_routes[0];
+    Protocol::Msg::CommonFields sender(route.m_fromDeviceId, Protocol::DeviceType::MASTER, 0U);
+    Protocol::Msg::Heartbeat heartbeatMsg(sender, Protocol::SlaveState::NOT_ACTIVE,
+                                          Protocol::ApproveState::NOT_APPROVED,
+                                          Protocol::CmdType::STOP);
+    Protocol::Msg::Cmd cmdMsg(sender, Protocol::CmdType::STOP);
+    CanSocket::Frame frames[CanSocket::MAX_BATCH];
+    for(uint32_t i = 0U; i < CanSocket::MAX_BATCH; ++i) {
+      frames[i] = CanSocket::toFrame((0U != (i % 2U)) ?
+                                     static_cast<Protocol::Can::RawMsg>(cmdMsg) :
+                                     static_cast<Protocol::Can::RawMsg>(heartbeatMsg));
+    }
+
+    auto startNs = Clock::monotonicNs();
+    uint64_t numOfFrames = 0U;
+    while(numOfFrames < options.m_numOfBenchFrames) {
+      auto rxNs = Clock::monotonicNs();
+      gateway.forward(route.m_fromBus, frames, CanSocket::MAX_BATCH, rxNs);
+      numOfFrames += CanSocket::MAX_BATCH;
+      auto txNs = Clock::monotonicNs();
+      for(uint32_t bus = 0U; bus < Gateway::MAX_BUSES; ++bus) {
+        const CanSocket::Frame *tx = nullptr;
+        gateway.commitTx(bus, gateway.getTx(bus, tx), txNs);
+      }
+    }
+    auto elapsedNs = Clock::monotonicNs() - startNs;
+    printStats(gateway, Gateway::MAX_BUSES, elapsedNs);
+    std::printf("received %llu frames in %.3f s, %.1f ns/frame, %.0f frames/s\n",
+                static_cast<unsigned long long>(numOfFrames), elapsedNs / 1e9,
+                static_cast<double>(elapsedNs) / numOfFrames, 1e9 * numOfFrames / elapsedNs);
+  }
+
+  int run(const Options &options, Gateway &gateway) {
+    static CanSocket sockets[Gateway::MAX_BUSES];
+    pollfd fds[Gateway::MAX_BUSES];
+    auto numOfBuses = options.m_numOfBuses;
+    for(uint32_t bus = 0U; bus < numOfBuses; ++bus) {
+      if(not sockets[bus].open(options.ma_ifNames[bus], false, true)) {
+        std::fprintf(stderr, "Cannot open %s\n", options.ma_ifNames[bus]);
+        return 1;
+      }
+      fds[bus] = pollfd{sockets[bus].getFd(), POLLIN, 0};
+    }
+
+    CanSocket::Frame frames[CanSocket::MAX_BATCH];
+    auto startNs = Clock::monotonicNs();
+    auto printNs = startNs + options.m_periodNs;
+    while(not isStopped) {
+      if(::poll(fds, numOfBuses, 100) < 0) {
+        continue; // EINTR
+      }
+      for(uint32_t bus = 0U; bus < numOfBuses; ++bus) {
+        if(fds[bus].revents & POLLIN) {
+          uint32_t numOfFrames = 0U;
+          while(0U != (numOfFrames = sockets[bus].recv(frames, CanSocket::MAX_BATCH))) {
+            gateway.forward(bus, frames, numOfFrames, Clock::monotonicNs());
+          }
+        }
+      }
+      for(uint32_t bus = 0U; bus < numOfBuses; ++bus) {
+        const CanSocket::Frame *tx = nullptr;
+        uint32_t numOfTx = 0U;
+        uint32_t numOfSent = 0U;
+        while((0U != (numOfTx = gateway.getTx(bus, tx))) &&
+              (0U != (numOfSent = sockets[bus].send(tx, numOfTx)))) {
+          gateway.commitTx(bus, numOfSent, Clock::monotonicNs());
+        }
+        // wait for room in TX buffer of the interface
+        fds[bus].events = POLLIN | ((0U != numOfTx) ? POLLOUT : 0);
+      }
+      auto nowNs = Clock::monotonicNs();
+      if(nowNs >= printNs) {
+        printStats(gateway, numOfBuses, nowNs - startNs);
+        printNs = nowNs + options.m_periodNs;
+      }
+    }
+    printStats(gateway, numOfBuses, Clock::monotonicNs() - startNs);
+    return 0;
+  }
+
+  void onSignal(int) {
+    isStopped = 1;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-p stats period s] -r fromBus:toBus:kinds:fromId:toId"
+                         "[:toScheme] ... if0 if1 [if2 if3]\n"
+                         "       %s -B frames -r ...\n", argv[0], argv[0]);
+    return 1;
+  }
+  bool isBench = (0U != options.m_numOfBenchFrames);
+  static Gateway gateway(isBench ? Gateway::MAX_BUSES : options.m_numOfBuses);
+  for(uint32_t i = 0U; i < options.m_numOfRoutes; ++i) {
+    if(not gateway.addRoute(options.ma_routes[i])) {
+      std::fprintf(stderr, "Route %u is not valid or makes a loop\n", i + 1U);
+      return 1;
+    }
+  }
+  if(isBench) {
+    bench(options, gateway);
+    return 0;
+  }
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  return run(options, gateway);
+}
@@ -0,0 +1,279 @@
+/*
+ * Synthetic EET traffic for load tests, see TrafficGenerator.
+ *
+ * Usage: eet-gen [-m masters] [-s slaves] [-D duplicates] [-f frames/s] [-c cmd period ms]
+ *                [-S scenario] [-i invalid per mille] [-x seed] [-I id scheme]
+ *                [-t seconds] [-P pacing] [-R] [if]
+ *   -f         - heartbeat frames/s of all devices together (50 per device by default)
+ *   -S         - 0 heartbeats only, 1 lever sweep, 2 lever sweep with approvals (default)
+ *   -I         - 1 (V1, default), 2 (V2) or 3 (COMPAT)
+ *   -t         - virtual duration of the run
+ *   -P         - busy (busy-poll, default), timer (timerfd) or none (as fast as possible)
+ *   -R         - in-process sink pushes frames into a listening Slave, otherwise
+ *                frames are only hashed
+ *   if         - CAN interface (e.g. vcan0), in-process sink without it
+ * Example - 1M frames/s in-process, 2% invalid frames, one duplicated ID:
+ *   eet-gen -f 1000000 -i 20 -D 1 -t 5
+ *
+ * Frames go out in batches of up to CanSocket::MAX_BATCH frames which are due.
+ * Prints digest of all generated frames (equal for equal options whatever the
+ * pacing is), achieved rate and lateness of batches against their schedule.
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "CanSocket.h"
+#include "Clock.h"
+#include "Device.h"
+#include "Histogram.h"
+#include "Print.h"
+#include "TrafficGenerator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint64_t HEARTBEATS_PER_DEVICE = 50U; // per s, without -f
+
+  enum class Pacing : uint8_t {
+      BUSY = 0,
+      TIMER,
+      NONE
+  };
+
+  volatile std::sig_atomic_t isStopped = 0;
+
+  struct Options {
+    TrafficGenerator::Config m_config = {1U, 4U, 0U, 0U, 5U * SEC,
+                                         TrafficGenerator::Scenario::APPROVE, 0U, 1U,
+                                         Protocol::Can::IdScheme::V1};
+    uint64_t m_fps = 0U;
+    uint64_t m_durationNs = 10U * SEC;
+    Pacing m_pacing = Pacing::BUSY;
+    bool m_isReceiver = false;
+    const char *m_ifName = nullptr;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    auto &config = options.m_config;
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "m:s:D:f:c:S:i:x:I:t:P:R"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'm': config.m_numOfMasters = static_cast<uint32_t>(value); break;
+        case 's': config.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'D': config.m_numOfDuplicates = static_cast<uint32_t>(value); break;
+        case 'f': options.m_fps = value; break;
+        case 'c': config.m_cmdPeriodNs = value * MS; break;
+        case 'S':
+          if(value > 2U) {
+            return false;
+          }
+          config.m_scenario = static_cast<TrafficGenerator::Scenario>(value);
+          break;
+        case 'i': config.m_invalidPerMille = static_cast<uint32_t>(value); break;
+        case 'x': config.m_seed = value; break;
+        case 'I': config.m_idScheme = static_cast<Protocol::Can::IdScheme>(value); break;
+        case 't': options.m_durationNs = value * SEC; break;
+        case 'P':
+          if(0 == std::strcmp(optarg, "busy")) {
+            options.m_pacing = Pacing::BUSY;
+          } else if(0 == std::strcmp(optarg, "timer")) {
+            options.m_pacing = Pacing::TIMER;
+          } else if(0 == std::strcmp(optarg, "none")) {
+            options.m_pacing = Pacing::NONE;
+          } else {
+            return false;
+          }
+          break;
+        case 'R': options.m_isReceiver = true; break;
+        default: return false;
+      }
+    }
+    if(optind < argc) {
+      options.m_ifName = argv[optind++];
+    }
+    uint64_t numOfDevices = config.m_numOfMasters + config.m_numOfSlaves +
+                            config.m_numOfDuplicates;
+    auto fps = (0U != options.m_fps) ? options.m_fps : numOfDevices * HEARTBEATS_PER_DEVICE;
+    config.m_heartbeatPeriodNs = (0U != fps) ? numOfDevices * SEC / fps : 0U;
+    return (optind == argc) && (options.m_durationNs > 0U);
+  }
+
+  class Sink {
+    public:
+      explicit Sink(const Options &options) :
+        m_socket(),
+        m_slave(),
+        m_isReceiver(options.m_isReceiver),
+        m_digest(2166136261UL),
+        m_numOfErrors(0U) {
+        const auto &config = options.m_config;
+        // listens as one more Slave after all generated IDs
+        m_slave.setDeviceId(static_cast<char>(config.m_numOfMasters + config.m_numOfSlaves + 1U));
+        m_slave.setNumOfMasters(config.m_numOfMasters);
+        m_slave.setNumOfSlaves(config.m_numOfSlaves);
+        m_slave.setIdScheme(config.m_idScheme);
+      }
+
+      bool open(const char *ifName) {
+        return m_socket.open(ifName, false, true);
+      }
+
+      void put(const Protocol::Can::RawMsg *msgs, uint32_t numOfMsgs) {
+        for(uint32_t i = 0U; i < numOfMsgs; ++i) {
+          const auto &msg = msgs[i];
+          addDigest(msg.m_canId);
+          addDigest(msg.m_dlc);
+          addDigest(msg.m_dataL);
+          addDigest(msg.m_dataH);
+        }
+        if(m_isReceiver) {
+          for(uint32_t i = 0U; i < numOfMsgs; ++i) {
+            m_numOfErrors += (0U != m_slave.pushMsg(msgs[i]));
+          }
+        }
+        if(m_socket.isOpen()) {
+          send(msgs, numOfMsgs);
+        }
+      }
+
+      uint32_t getDigest() const {
+        return m_digest;
+      }
+
+      uint64_t getNumOfErrors() const {
+        return m_numOfErrors;
+      }
+
+    private:
+      void addDigest(uint32_t value) {
+        m_digest = (m_digest ^ value) * 16777619UL;
+      }
+
+      void send(const Protocol::Can::RawMsg *msgs, uint32_t numOfMsgs) {
+        for(uint32_t i = 0U; i < numOfMsgs; ++i) {
+          ma_frames[i] = CanSocket::toFrame(msgs[i]);
+        }
+        // waits for room in TX buffer of the interface
+        uint32_t numOfSent = 0U;
+        while((numOfSent < numOfMsgs) && not isStopped) {
+          auto num = m_socket.send(ma_frames + numOfSent, numOfMsgs - numOfSent);
+          if(0U == num) {
+            pollfd fd = {m_socket.getFd(), POLLOUT, 0};
+            ::poll(&fd, 1U, 100);
+          }
+          numOfSent += num;
+        }
+      }
+
+      CanSocket m_socket;
+      Slave m_slave;
+      bool m_isReceiver;
+      uint32_t m_digest;
+      uint64_t m_numOfErrors;
+      CanSocket::Frame ma_frames[CanSocket::MAX_BATCH];
+  };
+
+  // busy-poll or timerfd until monotonic time dueNs
+  void wait(Pacing pacing, int timerFd, uint64_t dueNs) {
+    if(Pacing::BUSY == pacing) {
+      while((Clock::monotonicNs() < dueNs) && not isStopped) {}
+    } else if(Pacing::TIMER == pacing) {
+      itimerspec spec = {};
+      spec.it_value.tv_sec = static_cast<time_t>(dueNs / SEC);
+      spec.it_value.tv_nsec = static_cast<long>(dueNs % SEC);
+      uint64_t numOfExpirations = 0U;
+      if(0 == ::timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr)) {
+        auto ret = ::read(timerFd, &numOfExpirations, sizeof(numOfExpirations));
+        static_cast<void>(ret);
+      }
+    }
+  }
+
+  int run(const Options &options, TrafficGenerator &generator, Sink &sink) {
+    int timerFd = -1;
+    if(Pacing::TIMER == options.m_pacing) {
+      timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+      if(timerFd < 0) {
+        std::perror("timerfd_create");
+        return 1;
+      }
+    }
+    static Histogram latenessNs;
+    Protocol::Can::RawMsg msgs[CanSocket::MAX_BATCH];
+    bool isPaced = (Pacing::NONE != options.m_pacing);
+    auto endNs = options.m_durationNs - 1U;
+    auto startNs = Clock::monotonicNs();
+    while((generator.getNextNs() <= endNs) && not isStopped) {
+      auto untilNs = endNs;
+      if(isPaced) {
+        auto dueNs = startNs + generator.getNextNs();
+        wait(options.m_pacing, timerFd, dueNs);
+        auto nowNs = Clock::monotonicNs();
+        latenessNs.record((nowNs > dueNs) ? (nowNs - dueNs) : 0U);
+        untilNs = (nowNs - startNs < endNs) ? (nowNs - startNs) : endNs;
+      }
+      sink.put(msgs, generator.generate(untilNs, msgs, CanSocket::MAX_BATCH));
+    }
+    auto elapsedNs = Clock::monotonicNs() - startNs;
+    if(timerFd >= 0) {
+      ::close(timerFd);
+    }
+
+    auto numOfFrames = generator.getNumOfFrames();
+    std::printf("%llu frames (%llu invalid) of %u devices in %.3f s, %.0f frames/s, "
+                "%.1f ns/frame\n",
+                static_cast<unsigned long long>(numOfFrames),
+                static_cast<unsigned long long>(generator.getNumOfInvalid()),
+                generator.getNumOfDevices(), elapsedNs / 1e9,
+                (elapsedNs > 0U) ? 1e9 * numOfFrames / elapsedNs : 0.0,
+                (numOfFrames > 0U) ? static_cast<double>(elapsedNs) / numOfFrames : 0.0);
+    if(options.m_isReceiver) {
+      std::printf("receiver: %llu frames with errors\n",
+                  static_cast<unsigned long long>(sink.getNumOfErrors()));
+    }
+    if(isPaced) {
+      Tools::printHistogramHeader();
+      Tools::printHistogram("batch lateness", latenessNs);
+    }
+    std::printf("digest %08x\n", sink.getDigest());
+    return 0;
+  }
+
+  void onSignal(int) {
+    isStopped = 1;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-m masters] [-s slaves] [-D duplicates] [-f frames/s] "
+                         "[-c cmd period ms]\n"
+                         "       [-S scenario] [-i invalid per mille] [-x seed] [-I id scheme] "
+                         "[-t seconds]\n"
+                         "       [-P busy|timer|none] [-R] [if]\n", argv[0]);
+    return 1;
+  }
+  static TrafficGenerator generator(options.m_config);
+  if(not generator.isValid()) {
+    std::fprintf(stderr, "Configuration of devices is not valid\n");
+    return 1;
+  }
+  static Sink sink(options);
+  if((nullptr != options.m_ifName) && not sink.open(options.m_ifName)) {
+    std::fprintf(stderr, "Cannot open %s\n", options.m_ifName);
+    return 1;
+  }
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  return run(options, generator, sink);
+}
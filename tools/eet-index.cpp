@@ -0,0 +1,124 @@
+/*
+ * Builds and queries sidecar index (see LogIndex.h) of ASCII log files.
+ *
+ * Usage:
+ *   eet-index build <log> <index>
+ *     indexes lines appended to the log since the previous build
+ *   eet-index query <log> <index> [-f <from ns>] [-t <to ns>] [-d <device id>]
+ *                                 [-c <cmd type>] [-e <error bit>]
+ *     prints matching lines, options may be repeated to match any of values
+ *
+ * Lines without timestamp are indexed with time 0.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "LogIndex.h"
+
+namespace {
+  int build(const char *logPath, const char *indexPath) {
+    Eet::LogIndex::Writer writer;
+    if(not writer.open(indexPath)) {
+      std::fprintf(stderr, "Can not open index %s\n", indexPath);
+      return 1;
+    }
+    FILE *log = std::fopen(logPath, "rb");
+    if((nullptr == log) ||
+       (0 != std::fseek(log, static_cast<long>(writer.getEndOffset()), SEEK_SET))) {
+      std::fprintf(stderr, "Can not open log %s\n", logPath);
+      return 1;
+    }
+    static char line[Eet::Protocol::Msg::LogMsg::LOG_MSG_MAX_SIZE];
+    uint64_t offset = writer.getEndOffset();
+    uint32_t numOfLines = 0U;
+    while(nullptr != std::fgets(line, sizeof(line), log)) {
+      auto size = static_cast<uint32_t>(std::strlen(line));
+      if('\n' != line[size - 1U]) {
+        break; // partially written line, next build continues from it
+      }
+      // not log lines are not indexed but stay inside blocks
+      numOfLines += writer.addLine(0U, offset, line, size);
+      offset += size;
+    }
+    std::fclose(log);
+    writer.close();
+    std::printf("Indexed %u lines\n", numOfLines);
+    return 0;
+  }
+
+  int query(const char *logPath, const char *indexPath, int argc, char *argv[]) {
+    Eet::LogIndex::Query query{0U, UINT64_MAX, 0U, 0U, 0U};
+    for(int i = 0; i + 1 < argc; i += 2) {
+      auto value = std::strtoull(argv[i + 1], nullptr, 0);
+      if(0 == std::strcmp(argv[i], "-f")) {
+        query.m_fromNs = value;
+      } else if(0 == std::strcmp(argv[i], "-t")) {
+        query.m_toNs = value;
+      } else if(0 == std::strcmp(argv[i], "-d")) {
+        query.m_deviceMask |= Eet::LogIndex::getDeviceBit(static_cast<char>(value));
+      } else if(0 == std::strcmp(argv[i], "-c")) {
+        query.m_cmdTypeMask |= Eet::LogIndex::getCmdTypeBit(
+                                  static_cast<Eet::Protocol::CmdType>(value));
+      } else if(0 == std::strcmp(argv[i], "-e")) {
+        query.m_errorMask |= static_cast<uint8_t>(1U << value);
+      } else {
+        std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+        return 1;
+      }
+    }
+
+    Eet::LogIndex::Reader reader;
+    if(not reader.open(indexPath, logPath)) {
+      std::fprintf(stderr, "Can not open %s or %s\n", indexPath, logPath);
+      return 1;
+    }
+    uint32_t numOfBlocks = 0U;
+    for(uint32_t i = reader.first(query); i < reader.getNumOfBlocks();
+        i = reader.next(query, i + 1U)) {
+      const auto &block = reader.getBlock(i);
+      const char *data = reader.getData(block);
+      if(nullptr == data) {
+        break;
+      }
+      ++numOfBlocks;
+      // blocks are coarse, filter lines
+      const char *end = data + block.m_size;
+      while(data < end) {
+        auto *eol = static_cast<const char *>(std::memchr(data, '\n', end - data));
+        auto size = static_cast<uint32_t>((nullptr == eol) ? (end - data) : (eol + 1 - data));
+        Eet::LogRecord record{};
+        if(Eet::LogParser::parse(data, size, record)) {
+          uint16_t deviceMask = Eet::LogIndex::getDeviceBit(record.m_deviceId);
+          if('O' == record.m_type) {
+            deviceMask |= Eet::LogIndex::getDeviceBit(record.m_otherDeviceId);
+          }
+          Eet::LogIndex::Block one{record.m_timeNs, record.m_timeNs, 0U, size, 1U,
+                                   deviceMask,
+                                   Eet::LogIndex::getCmdTypeBit(record.m_cmdType),
+                                   static_cast<uint8_t>(record.m_errors), {}};
+          if(query.isMatch(one)) {
+            std::fwrite(data, 1U, size, stdout);
+          }
+        }
+        data += size;
+      }
+    }
+    std::fprintf(stderr, "Read %u of %u blocks\n", numOfBlocks, reader.getNumOfBlocks());
+    return 0;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if((argc >= 4) && (0 == std::strcmp(argv[1], "build"))) {
+    return build(argv[2], argv[3]);
+  }
+  if((argc >= 4) && (0 == std::strcmp(argv[1], "query"))) {
+    return query(argv[2], argv[3], argc - 4, argv + 4);
+  }
+  std::fprintf(stderr, "Usage: %s build <log> <index>\n"
+                       "       %s query <log> <index> [-f <from ns>] [-t <to ns>]"
+                       " [-d <device id>] [-c <cmd type>] [-e <error bit>]\n",
+               argv[0], argv[0]);
+  return 1;
+}
@@ -0,0 +1,54 @@
+/*
+ * Merges logs of several devices into one time-ordered log (see LogMerger.h).
+ *
+ * Usage: eet-merge [-j threads] -o <merged log> <log>...
+ *
+ * Every log has to carry <TimeNs> (see LogMsg::setTimeNs()) and be ordered
+ * by it, as logs written with WallClock are. Threads default to the number
+ * of CPUs.
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+#include "Clock.h"
+#include "LogMerger.h"
+
+int main(int argc, char *argv[]) {
+  using namespace Eet;
+
+  auto numOfThreads = std::thread::hardware_concurrency();
+  const char *outPath = nullptr;
+  int opt;
+  while(-1 != (opt = getopt(argc, argv, "j:o:"))) {
+    switch(opt) {
+      case 'j': numOfThreads = static_cast<uint32_t>(std::strtoul(optarg, nullptr, 10)); break;
+      case 'o': outPath = optarg; break;
+      default: outPath = nullptr; optind = argc + 1; break;
+    }
+  }
+  if((nullptr == outPath) || (optind >= argc)) {
+    std::fprintf(stderr, "Usage: %s [-j threads] -o <merged log> <log>...\n", argv[0]);
+    return 1;
+  }
+
+  static LogMerger merger;
+  for(int i = optind; i < argc; ++i) {
+    if(not merger.add(argv[i])) {
+      std::fprintf(stderr, "Can not map %s (at most %u logs)\n", argv[i], LogMerger::MAX_LOGS);
+      return 1;
+    }
+  }
+  auto startNs = Clock::monotonicNs();
+  if(not merger.merge(outPath, numOfThreads)) {
+    std::perror(outPath);
+    return 1;
+  }
+  auto seconds = static_cast<double>(Clock::monotonicNs() - startNs) / 1e9;
+  std::fprintf(stderr, "%u logs, %" PRIu64 " lines, %.1f MB in %.3f s (%.0f MB/s, %u threads)\n",
+               merger.getNumOfLogs(), merger.getNumOfLines(), merger.getSize() / 1e6, seconds,
+               merger.getSize() / 1e6 / seconds, numOfThreads);
+  return 0;
+}
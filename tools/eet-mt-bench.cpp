@@ -0,0 +1,146 @@
+/*
+ * Multi-threaded stress test and latency benchmark of Device access.
+ * Owner thread ingests heartbeats of 11 Slaves and calls update() every
+ * 1000 frames, reader threads poll getters, one thread taps buttons.
+ * Compares ThreadedDevice (lock-free) with one coarse mutex around Device.
+ *
+ * Usage: eet-mt-bench [readers] [seconds]
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Device.h"
+#include "ThreadedDevice.h"
+#include "Clock.h"
+#include "Histogram.h"
+#include "Print.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint32_t NUM_OF_SLAVES = 11U;
+  constexpr uint32_t FRAMES_PER_UPDATE = 1000U;
+
+  struct Result {
+    Histogram m_pushNs;
+    uint64_t m_numOfReads = 0U;
+    uint64_t m_numOfInvalid = 0U;
+  };
+
+  void makeFrames(std::vector<Protocol::Can::RawMsg> &frames) {
+    for(uint32_t i = 0U; i < NUM_OF_SLAVES; ++i) {
+      Protocol::Msg::CommonFields commonFields(static_cast<char>(i + 2U),
+                                               Protocol::DeviceType::SLAVE, 0U);
+      Protocol::Msg::Heartbeat heartbeat(commonFields,
+                                         i ? Protocol::SlaveState::NOT_ACTIVE :
+                                             Protocol::SlaveState::ACTIVE,
+                                         Protocol::ApproveState::NOT_APPROVED,
+                                         Protocol::CmdType::STOP);
+      frames.push_back(static_cast<Protocol::Can::RawMsg>(heartbeat));
+    }
+  }
+
+  bool isValid(Protocol::CmdType cmdType, Protocol::ApproveState approveState) {
+    return ((cmdType <= Protocol::CmdType::FULL_ASTERN) ||
+            (Protocol::CmdType::INVALID == cmdType)) &&
+           (approveState <= Protocol::ApproveState::APPROVED);
+  }
+
+  template<typename Push, typename Update, typename Read, typename Tap>
+  void run(uint32_t numOfReaders, uint64_t durationNs, Result &result,
+           Push push, Update update, Read read, Tap tap) {
+    std::vector<Protocol::Can::RawMsg> frames;
+    makeFrames(frames);
+    std::atomic<bool> isStopped(false);
+    std::vector<uint64_t> numOfReads(numOfReaders), numOfInvalid(numOfReaders);
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0U; i < numOfReaders; ++i) {
+      threads.emplace_back([&, i]() {
+        while(not isStopped.load(std::memory_order_relaxed)) {
+          numOfInvalid[i] += not read();
+          ++numOfReads[i];
+        }
+      });
+    }
+    threads.emplace_back([&]() {
+      uint32_t n = 0U;
+      while(not isStopped.load(std::memory_order_relaxed)) {
+        tap(static_cast<Protocol::CmdType>(n++ % 11U));
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+
+    auto startNs = Clock::monotonicNs();
+    uint64_t n = 0U;
+    while(Clock::monotonicNs() - startNs < durationNs) {
+      auto beforeNs = Clock::monotonicNs();
+      push(frames[n % frames.size()]);
+      result.m_pushNs.record(Clock::monotonicNs() - beforeNs);
+      if(0U == (++n % FRAMES_PER_UPDATE)) {
+        update();
+      }
+    }
+    isStopped = true;
+    for(auto &thread : threads) {
+      thread.join();
+    }
+    for(uint32_t i = 0U; i < numOfReaders; ++i) {
+      result.m_numOfReads += numOfReads[i];
+      result.m_numOfInvalid += numOfInvalid[i];
+    }
+  }
+}
+
+
+int main(int argc, char *argv[]) {
+  const uint32_t numOfReaders = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4U;
+  const uint64_t durationNs = ((argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1U) * 1000000000ULL;
+
+  static Result mutexResult;
+  {
+    Master master;
+    master.setDeviceId(1);
+    master.setNumOfSlaves(NUM_OF_SLAVES);
+    std::mutex mutex;
+    run(numOfReaders, durationNs, mutexResult,
+        [&](const Protocol::Can::RawMsg &msg) { std::lock_guard<std::mutex> lock(mutex); master.pushMsg(msg); },
+        [&]() { std::lock_guard<std::mutex> lock(mutex); master.update(); },
+        [&]() {
+          std::lock_guard<std::mutex> lock(mutex);
+          master.getErrors();
+          master.isAnyActiveSlave();
+          return isValid(master.getCmdType(), master.getApproveState());
+        },
+        [&](Protocol::CmdType cmdType) { std::lock_guard<std::mutex> lock(mutex); master.setCmdType(cmdType); });
+  }
+
+  static Result lockFreeResult;
+  {
+    Master master;
+    master.setDeviceId(1);
+    master.setNumOfSlaves(NUM_OF_SLAVES);
+    static ThreadedDevice device(master);
+    run(numOfReaders, durationNs, lockFreeResult,
+        [&](const Protocol::Can::RawMsg &msg) { device.pushMsg(msg); },
+        [&]() { device.update(); },
+        [&]() {
+          auto snapshot = device.getSnapshot();
+          return isValid(snapshot.m_cmdType, snapshot.m_approveState);
+        },
+        [&](Protocol::CmdType cmdType) { device.postCmdType(cmdType); });
+  }
+
+  Tools::printHistogramHeader();
+  Tools::printHistogram("pushMsg() mutex", mutexResult.m_pushNs);
+  Tools::printHistogram("pushMsg() lock-free", lockFreeResult.m_pushNs);
+  std::printf("readers %u: mutex %.2f M reads/s, lock-free %.2f M reads/s, inconsistent %llu\n",
+              numOfReaders,
+              mutexResult.m_numOfReads / (durationNs / 1e3),
+              lockFreeResult.m_numOfReads / (durationNs / 1e3),
+              static_cast<unsigned long long>(mutexResult.m_numOfInvalid + lockFreeResult.m_numOfInvalid));
+  return (0U == lockFreeResult.m_numOfInvalid) ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/*
+ * EET node: one Master or Slave on a CAN interface, optionally in real-time
+ * mode (see Realtime), with update() tick timing (see TickMonitor).
+ *
+ * Usage:
+ *   eet-node [-M] [-i id] [-n masters] [-s slaves] [-u update ms] [-h heartbeat ms]
+ *            [-j jitter budget us] [-c cpu] [-P priority] [-L] [-p stats period s]
+ *            [-d duration s] [-b broker path] [if]
+ *   -M Master (Slave by default), -c pin to CPU, -P SCHED_FIFO priority,
+ *   -L lock memory, -b publish state changes to local subscribers from a
+ *   broker thread (see PubSub::Publisher, eet-pubsub), the processing thread
+ *   only posts changed state. Without interface the device only ticks,
+ *   which measures wake-up latency and jitter of the box itself.
+ * Example - Slave 3 on vcan0, real-time on CPU 2:
+ *   eet-node -i 3 -n 1 -s 3 -c 2 -P 80 -L vcan0
+ *
+ * Warns (at most once a second) when jitter of a tick is over the budget,
+ * prints wake-up latency and jitter histograms each stats period.
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+
+#include "CanSocket.h"
+#include "Clock.h"
+#include "Device.h"
+#include "Print.h"
+#include "PubSub.h"
+#include "Realtime.h"
+#include "TickMonitor.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t US = 1000U;
+  constexpr uint64_t MS = 1000U * US;
+  constexpr uint64_t SEC = 1000U * MS;
+
+  volatile std::sig_atomic_t isStopped = 0;
+
+  struct Options {
+    bool m_isMaster = false;
+    char m_deviceId = 2;
+    uint32_t m_numOfMasters = 1U;
+    uint32_t m_numOfSlaves = 0U;
+    TickMonitor::Config m_tick = {300U * MS, 5U * MS};
+    uint64_t m_heartbeatPeriodNs = 100U * MS;
+    Realtime::Config m_realtime = {-1, 0, false, 256U * 1024U};
+    uint64_t m_periodNs = 10U * SEC;
+    uint64_t m_durationNs = 0U; // until SIGINT
+    const char *m_brokerPath = nullptr;
+    const char *m_ifName = nullptr;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "Mi:n:s:u:h:j:c:P:Lp:d:b:"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'M': options.m_isMaster = true; break;
+        case 'i': options.m_deviceId = static_cast<char>(value); break;
+        case 'n': options.m_numOfMasters = static_cast<uint32_t>(value); break;
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'u': options.m_tick.m_periodNs = value * MS; break;
+        case 'h': options.m_heartbeatPeriodNs = value * MS; break;
+        case 'j': options.m_tick.m_jitterBudgetNs = value * US; break;
+        case 'c': options.m_realtime.m_cpu = static_cast<int>(value); break;
+        case 'P': options.m_realtime.m_priority = static_cast<int>(value); break;
+        case 'L': options.m_realtime.m_isMemoryLocked = true; break;
+        case 'p': options.m_periodNs = value * SEC; break;
+        case 'd': options.m_durationNs = value * SEC; break;
+        case 'b': options.m_brokerPath = optarg; break;
+        default: return false;
+      }
+    }
+    if(optind < argc) {
+      options.m_ifName = argv[optind++];
+    }
+    return (optind == argc) && Protocol::DeviceId::isCorrectId(options.m_deviceId) &&
+           (options.m_tick.m_periodNs > 0U) && (options.m_heartbeatPeriodNs > 0U) &&
+           (options.m_periodNs > 0U);
+  }
+
+  void printStats(const TickMonitor &monitor, const Device &device) {
+    Tools::printHistogramHeader();
+    Tools::printHistogram("wake-up latency", monitor.getWakeUpLatencyNs());
+    Tools::printHistogram("tick jitter", monitor.getJitterNs());
+    std::printf("ticks %llu, over budget %llu, missed %llu, errors 0x%02x\n",
+                static_cast<unsigned long long>(monitor.getNumOfTicks()),
+                static_cast<unsigned long long>(monitor.getNumOfOverBudget()),
+                static_cast<unsigned long long>(monitor.getNumOfMissed()),
+                static_cast<unsigned>(static_cast<uint8_t>(device.getErrors())));
+  }
+
+  timespec toTimespec(uint64_t ns) {
+    return timespec{static_cast<time_t>(ns / SEC), static_cast<long>(ns % SEC)};
+  }
+
+  int run(const Options &options, Device &device) {
+    static CanSocket socket;
+    static CanSocket::Frame frames[CanSocket::MAX_BATCH];
+    static TickMonitor monitor(options.m_tick);
+    static PubSub::Publisher publisher;
+    bool isBus = (nullptr != options.m_ifName);
+    if(isBus && not socket.open(options.m_ifName, false, true)) {
+      std::fprintf(stderr, "Cannot open %s\n", options.m_ifName);
+      return 1;
+    }
+    bool isBroker = (nullptr != options.m_brokerPath);
+    // started before Realtime::apply(), broker thread stays normal
+    if(isBroker && not publisher.start(options.m_brokerPath)) {
+      std::fprintf(stderr, "Cannot open %s\n", options.m_brokerPath);
+      return 1;
+    }
+
+    auto status = Realtime::apply(options.m_realtime);
+    Realtime::print(options.m_realtime, status);
+    Realtime::prefault(frames, sizeof(frames));
+    Realtime::prefault(&monitor, sizeof(monitor));
+
+    pollfd fd = {socket.getFd(), POLLIN, 0};
+    auto startNs = Clock::monotonicNs();
+    auto stopNs = (0U != options.m_durationNs) ? startNs + options.m_durationNs : UINT64_MAX;
+    auto printNs = startNs + options.m_periodNs;
+    auto heartbeatNs = startNs;
+    uint64_t warnNs = 0U;
+    monitor.start(startNs);
+    while(not isStopped) {
+      auto nowNs = Clock::monotonicNs();
+      if(isBus) {
+        auto wakeNs = (heartbeatNs < monitor.getDeadlineNs()) ? heartbeatNs :
+                                                                monitor.getDeadlineNs();
+        auto timeout = toTimespec((wakeNs > nowNs) ? (wakeNs - nowNs) : 0U);
+        if(::ppoll(&fd, 1U, &timeout, nullptr) > 0) {
+          uint32_t numOfFrames = 0U;
+          while(0U != (numOfFrames = socket.recv(frames, CanSocket::MAX_BATCH))) {
+            for(uint32_t i = 0U; i < numOfFrames; ++i) {
+              device.pushMsg(CanSocket::toRawMsg(frames[i]));
+            }
+          }
+        }
+      } else {
+        monitor.sleep();
+      }
+
+      nowNs = Clock::monotonicNs();
+      if(monitor.isDue(nowNs)) {
+        if(not monitor.onTick(nowNs) && (nowNs >= warnNs)) {
+          std::fprintf(stderr, "Tick jitter %.1f us is over the budget of %.1f us\n",
+                       monitor.getLastJitterNs() / 1e3,
+                       options.m_tick.m_jitterBudgetNs / 1e3);
+          warnNs = nowNs + SEC;
+        }
+        device.update();
+      }
+      if(isBroker) {
+        publisher.post(device, nowNs);
+      }
+      if(isBus && ((nowNs >= heartbeatNs) || device.isHeartbeatRequested())) {
+        socket.send(device.getHeartbeatMsg());
+        heartbeatNs = nowNs + options.m_heartbeatPeriodNs;
+      }
+      if(nowNs >= printNs) {
+        printStats(monitor, device);
+        printNs = nowNs + options.m_periodNs;
+      }
+      isStopped = isStopped || (nowNs >= stopNs);
+    }
+    printStats(monitor, device);
+    return 0;
+  }
+
+  void onSignal(int) {
+    isStopped = 1;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-M] [-i id] [-n masters] [-s slaves] [-u update ms] "
+                         "[-h heartbeat ms]\n"
+                         "       [-j jitter budget us] [-c cpu] [-P priority] [-L] "
+                         "[-p stats period s] [-d duration s]\n"
+                         "       [-b broker path] [if]\n", argv[0]);
+    return 1;
+  }
+  static Master master;
+  static Slave slave;
+  Device &device = options.m_isMaster ? static_cast<Device &>(master) :
+                                        static_cast<Device &>(slave);
+  device.setDeviceId(options.m_deviceId);
+  device.setNumOfMasters(options.m_numOfMasters);
+  device.setNumOfSlaves(options.m_numOfSlaves);
+  Realtime::prefault(&device, options.m_isMaster ? sizeof(master) : sizeof(slave));
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  return run(options, device);
+}
@@ -0,0 +1,266 @@
+/*
+ * Subscriber of PubSub::Broker, and benchmark of the broker.
+ *
+ * Usage:
+ *   eet-pubsub [-T device type] [-i id] [-F fields] path
+ *     prints updates, -T 1 Masters, 2 Slaves (any by default), -i Device ID
+ *     (any by default), -F mask of PubSub::Field bits (all by default)
+ *   eet-pubsub -B [-n clients] [-S slow clients] [-f frames/s] [-c cmd period ms]
+ *                 [-u update ms] [-t seconds] path
+ *     Publisher publishes a Slave which listens to generated traffic (see
+ *     TrafficGenerator), clients subscribe to everything. Slow clients read
+ *     once per SLOW_READ_MS and get coalesced updates.
+ * Example - 50 clients, 2 of them slow:
+ *   eet-pubsub -B -n 50 -S 2 -f 2000 /tmp/eet-pubsub
+ *
+ * Prints cost of Publisher::post() on the processing thread and latency
+ * from post() to receive() of the clients (age of the received state).
+ */
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Clock.h"
+#include "Device.h"
+#include "Histogram.h"
+#include "Print.h"
+#include "PubSub.h"
+#include "TrafficGenerator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint32_t SLOW_READ_MS = 50U;
+  constexpr uint64_t CONNECT_TIMEOUT_NS = 5U * SEC;
+
+  volatile std::sig_atomic_t isStopped = 0;
+
+  struct Options {
+    bool m_isBench = false;
+    Protocol::DeviceType m_deviceType = Protocol::DeviceType::INVALID;
+    char m_deviceId = PubSub::ANY_DEVICE_ID;
+    uint8_t m_fields = PubSub::ALL_FIELDS;
+    uint32_t m_numOfClients = 50U;
+    uint32_t m_numOfSlow = 0U;
+    uint64_t m_fps = 1000U;
+    uint64_t m_cmdPeriodNs = 100U * MS;
+    uint64_t m_updatePeriodNs = 100U * MS;
+    uint64_t m_durationNs = 5U * SEC;
+    const char *m_path = nullptr;
+  };
+
+  struct Result {
+    Histogram m_latencyNs;
+    uint64_t m_numOfUpdates = 0U;
+    uint64_t m_numOfCoalesced = 0U;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "BT:i:F:n:S:f:c:u:t:"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 0) : 0U;
+      switch(opt) {
+        case 'B': options.m_isBench = true; break;
+        case 'T': options.m_deviceType = static_cast<Protocol::DeviceType>(value); break;
+        case 'i': options.m_deviceId = static_cast<char>(value); break;
+        case 'F': options.m_fields = static_cast<uint8_t>(value); break;
+        case 'n': options.m_numOfClients = static_cast<uint32_t>(value); break;
+        case 'S': options.m_numOfSlow = static_cast<uint32_t>(value); break;
+        case 'f': options.m_fps = value; break;
+        case 'c': options.m_cmdPeriodNs = value * MS; break;
+        case 'u': options.m_updatePeriodNs = value * MS; break;
+        case 't': options.m_durationNs = value * SEC; break;
+        default: return false;
+      }
+    }
+    if(optind < argc) {
+      options.m_path = argv[optind++];
+    }
+    return (optind == argc) && (nullptr != options.m_path) && (options.m_fps > 0U) &&
+           (options.m_updatePeriodNs > 0U) && (options.m_numOfSlow <= options.m_numOfClients);
+  }
+
+  void print(const PubSub::Update &update) {
+    std::printf("%llu %s %s %d fields 0x%02x errors 0x%02x slave %u approve %u cmd %u "
+                "flags 0x%02x active 0x%04x slaves 0x%04x masters 0x%04x\n",
+                static_cast<unsigned long long>(update.m_timeNs),
+                update.m_isSnapshot ? "snapshot" : "update",
+                (Protocol::DeviceType::MASTER == update.m_deviceType) ? "Master" : "Slave",
+                update.m_deviceId, update.m_fields,
+                static_cast<unsigned>(static_cast<uint8_t>(update.m_errors)),
+                static_cast<unsigned>(update.m_slaveState),
+                static_cast<unsigned>(update.m_approveState),
+                static_cast<unsigned>(update.m_cmdType), update.m_flags,
+                update.ma_activeSlaves, update.ma_respondedSlaves, update.ma_respondedMasters);
+  }
+
+  int listen(const Options &options) {
+    static PubSub::Subscriber subscriber;
+    if(not subscriber.open(options.m_path) ||
+       not subscriber.subscribe(options.m_deviceType, options.m_deviceId, options.m_fields)) {
+      std::fprintf(stderr, "Cannot subscribe to %s\n", options.m_path);
+      return 1;
+    }
+    PubSub::Update updates[PubSub::MAX_TOPICS];
+    uint64_t numOfCoalesced = 0U;
+    while(subscriber.isOpen() && not isStopped) {
+      auto numOfUpdates = subscriber.receive(updates, PubSub::MAX_TOPICS, 100);
+      if(numOfCoalesced != subscriber.getNumOfCoalesced()) {
+        numOfCoalesced = subscriber.getNumOfCoalesced();
+        std::printf("coalesced\n");
+      }
+      for(uint32_t i = 0U; i < numOfUpdates; ++i) {
+        print(updates[i]);
+      }
+      std::fflush(stdout);
+    }
+    return 0;
+  }
+
+  void runClient(const char *path, bool isSlow, const std::atomic<bool> &isDone,
+                 Result &result) {
+    PubSub::Subscriber subscriber;
+    if(not subscriber.open(path) ||
+       not subscriber.subscribe(Protocol::DeviceType::INVALID, PubSub::ANY_DEVICE_ID,
+                                PubSub::ALL_FIELDS)) {
+      return;
+    }
+    PubSub::Update updates[PubSub::MAX_TOPICS];
+    while(subscriber.isOpen() && not isDone.load(std::memory_order_relaxed)) {
+      auto numOfUpdates = subscriber.receive(updates, PubSub::MAX_TOPICS, 100);
+      auto nowNs = Clock::monotonicNs();
+      for(uint32_t i = 0U; i < numOfUpdates; ++i) {
+        if(not updates[i].m_isSnapshot) {
+          result.m_latencyNs.record(nowNs - updates[i].m_timeNs);
+        }
+      }
+      result.m_numOfUpdates += numOfUpdates;
+      if(isSlow) {
+        ::usleep(SLOW_READ_MS * 1000U);
+      }
+    }
+    result.m_numOfCoalesced = subscriber.getNumOfCoalesced();
+  }
+
+  int bench(const Options &options) {
+    static PubSub::Publisher publisher;
+    if(not publisher.start(options.m_path)) {
+      std::fprintf(stderr, "Cannot open %s\n", options.m_path);
+      return 1;
+    }
+    TrafficGenerator::Config config = {1U, 4U, 0U, 0U, options.m_cmdPeriodNs,
+                                       TrafficGenerator::Scenario::APPROVE, 0U, 1U,
+                                       Protocol::Can::IdScheme::V1};
+    config.m_heartbeatPeriodNs = (config.m_numOfMasters + config.m_numOfSlaves) * SEC /
+                                 options.m_fps;
+    static TrafficGenerator generator(config);
+    if(not generator.isValid()) {
+      std::fprintf(stderr, "Configuration of devices is not valid\n");
+      return 1;
+    }
+    // listens as one more Slave after all generated IDs
+    static Slave slave;
+    slave.setDeviceId(static_cast<char>(config.m_numOfMasters + config.m_numOfSlaves + 1U));
+    slave.setNumOfMasters(config.m_numOfMasters);
+    slave.setNumOfSlaves(config.m_numOfSlaves + 1U);
+
+    std::atomic<bool> isDone(false);
+    std::vector<Result> results(options.m_numOfClients);
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0U; i < options.m_numOfClients; ++i) {
+      bool isSlow = (i < options.m_numOfSlow);
+      threads.emplace_back(runClient, options.m_path, isSlow, std::cref(isDone),
+                           std::ref(results[i]));
+    }
+    auto connectNs = Clock::monotonicNs() + CONNECT_TIMEOUT_NS;
+    while((publisher.getNumOfClients() < options.m_numOfClients) &&
+          (Clock::monotonicNs() < connectNs) && not isStopped) {
+      ::usleep(10000U);
+    }
+
+    static Histogram postNs;
+    uint64_t busyNs = 0U;
+    Protocol::Can::RawMsg msgs[64];
+    auto startNs = Clock::monotonicNs();
+    auto updateNs = options.m_updatePeriodNs;
+    uint64_t elapsedNs = 0U;
+    while((elapsedNs < options.m_durationNs) && not isStopped) {
+      auto numOfMsgs = generator.generate(elapsedNs, msgs, 64U);
+      for(uint32_t i = 0U; i < numOfMsgs; ++i) {
+        slave.pushMsg(msgs[i]);
+      }
+      if(elapsedNs >= updateNs) {
+        slave.update();
+        updateNs += options.m_updatePeriodNs;
+      }
+      auto postStartNs = Clock::monotonicNs();
+      publisher.post(slave, postStartNs);
+      auto doneNs = Clock::monotonicNs();
+      busyNs += doneNs - postStartNs;
+      postNs.record(doneNs - postStartNs);
+      if(numOfMsgs < 64U) {
+        ::usleep(1000U);
+      }
+      elapsedNs = Clock::monotonicNs() - startNs;
+    }
+    isDone = true;
+    for(auto &thread : threads) {
+      thread.join();
+    }
+    publisher.stop();
+    const auto &broker = publisher.getBroker();
+
+    Histogram latencyNs;
+    Histogram slowLatencyNs;
+    uint64_t numOfUpdates = 0U;
+    uint64_t numOfCoalesced = 0U;
+    for(uint32_t i = 0U; i < options.m_numOfClients; ++i) {
+      ((i < options.m_numOfSlow) ? slowLatencyNs : latencyNs).merge(results[i].m_latencyNs);
+      numOfUpdates += results[i].m_numOfUpdates;
+      numOfCoalesced += results[i].m_numOfCoalesced;
+    }
+    std::printf("%llu frames, %u clients (%u slow), %llu packets, %llu updates received\n",
+                static_cast<unsigned long long>(generator.getNumOfFrames()),
+                options.m_numOfClients, options.m_numOfSlow,
+                static_cast<unsigned long long>(broker.getNumOfPackets()),
+                static_cast<unsigned long long>(numOfUpdates));
+    std::printf("coalesced packets %llu (received %llu), refused %llu, "
+                "post %.3f%% of the time\n",
+                static_cast<unsigned long long>(broker.getNumOfCoalesced()),
+                static_cast<unsigned long long>(numOfCoalesced),
+                static_cast<unsigned long long>(broker.getNumOfRefused()),
+                (elapsedNs > 0U) ? 100.0 * busyNs / elapsedNs : 0.0);
+    Tools::printHistogramHeader();
+    Tools::printHistogram("post", postNs);
+    Tools::printHistogram("latency", latencyNs);
+    if(0U != options.m_numOfSlow) {
+      Tools::printHistogram("latency slow", slowLatencyNs);
+    }
+    return 0;
+  }
+
+  void onSignal(int) {
+    isStopped = 1;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-T device type] [-i id] [-F fields] path\n"
+                         "       %s -B [-n clients] [-S slow clients] [-f frames/s] "
+                         "[-c cmd period ms]\n"
+                         "             [-u update ms] [-t seconds] path\n", argv[0], argv[0]);
+    return 1;
+  }
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  return options.m_isBench ? bench(options) : listen(options);
+}
@@ -0,0 +1,288 @@
+/*
+ * Redundant buses merged into one stream (see BusMerger), and benchmark
+ * of the merger with random frame losses.
+ *
+ * Usage:
+ *   eet-redundancy [-w window ms] [-T bus timeout ms] [-p stats period s]
+ *                  [-o out_if] bus_if bus_if...
+ *     first copies of frames of 2..4 bus_if go to out_if (e.g. a vcan
+ *     a node listens on), per-bus stats are printed every period
+ *   eet-redundancy -B [-n masters] [-s slaves] [-h heartbeat ms] [-c cmd period ms]
+ *                  [-u update ms] [-b buses] [-l loss per mille] [-w window ms]
+ *                  [-t seconds]
+ *     generated traffic (see TrafficGenerator) in virtual time goes on every
+ *     bus, each bus drops frames at random. One Slave receives the merged
+ *     stream, another one every frame delivered by any bus, their states are
+ *     compared after each update(), loss counters are checked against drops
+ * Example - two redundant segments:
+ *   eet-gen -P timer vcan0 & eet-gen -P timer vcan1 &
+ *   eet-redundancy -o vcan2 vcan0 vcan1
+ *
+ * Window has to be shorter than the heartbeat period (see BusMerger).
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+
+#include "BusMerger.h"
+#include "CanSocket.h"
+#include "Clock.h"
+#include "Device.h"
+#include "TrafficGenerator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint32_t MAX_MSGS = 64U;
+
+  volatile std::sig_atomic_t isStopped = 0;
+
+  struct Options {
+    bool m_isBench = false;
+    uint32_t m_numOfMasters = 2U;
+    uint32_t m_numOfSlaves = 9U;
+    uint64_t m_heartbeatPeriodNs = 100U * MS;
+    uint64_t m_cmdPeriodNs = 1000U * MS;
+    uint64_t m_updatePeriodNs = 300U * MS;
+    uint32_t m_numOfBuses = 2U;
+    uint32_t m_lossPerMille = 50U;
+    uint64_t m_windowNs = 20U * MS;
+    uint64_t m_timeoutNs = 500U * MS;
+    uint64_t m_durationNs = 600U * SEC;
+    uint64_t m_periodNs = 10U * SEC;
+    const char *m_outIfName = nullptr;
+    const char *ma_busIfNames[BusMerger::MAX_BUSES] = {};
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "Bn:s:h:c:u:b:l:w:T:t:p:o:"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'B': options.m_isBench = true; break;
+        case 'n': options.m_numOfMasters = static_cast<uint32_t>(value); break;
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'h': options.m_heartbeatPeriodNs = value * MS; break;
+        case 'c': options.m_cmdPeriodNs = value * MS; break;
+        case 'u': options.m_updatePeriodNs = value * MS; break;
+        case 'b': options.m_numOfBuses = static_cast<uint32_t>(value); break;
+        case 'l': options.m_lossPerMille = static_cast<uint32_t>(value); break;
+        case 'w': options.m_windowNs = value * MS; break;
+        case 'T': options.m_timeoutNs = value * MS; break;
+        case 't': options.m_durationNs = value * SEC; break;
+        case 'p': options.m_periodNs = value * SEC; break;
+        case 'o': options.m_outIfName = optarg; break;
+        default: return false;
+      }
+    }
+    if(not options.m_isBench) {
+      options.m_numOfBuses = 0U;
+      while((optind < argc) && (options.m_numOfBuses < BusMerger::MAX_BUSES)) {
+        options.ma_busIfNames[options.m_numOfBuses++] = argv[optind++];
+      }
+    }
+    // IDs of generated devices and of the listening Slave
+    auto numOfIds = options.m_numOfMasters + options.m_numOfSlaves + 1U;
+    return (optind == argc) && (options.m_numOfBuses >= 2U) &&
+           (options.m_numOfBuses <= BusMerger::MAX_BUSES) &&
+           (numOfIds <= static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID)) &&
+           (options.m_heartbeatPeriodNs > options.m_windowNs) &&
+           (options.m_updatePeriodNs > 0U) && (options.m_lossPerMille <= 1000U) &&
+           (options.m_periodNs > 0U);
+  }
+
+  void printStats(const BusMerger &merger, uint64_t nowNs, uint64_t timeoutNs) {
+    std::printf("%-5s %12s %12s %12s %12s %6s\n", "bus", "frames", "first", "duplicates",
+                "lost", "alive");
+    for(uint32_t bus = 0U; bus < merger.getNumOfBuses(); ++bus) {
+      const auto &stats = merger.getBusStats(bus);
+      std::printf("%-5u %12llu %12llu %12llu %12llu %6s\n", bus,
+                  static_cast<unsigned long long>(stats.m_numOfFrames),
+                  static_cast<unsigned long long>(stats.m_numOfFirst),
+                  static_cast<unsigned long long>(stats.m_numOfDuplicates),
+                  static_cast<unsigned long long>(stats.m_numOfLost),
+                  merger.isBusAlive(bus, nowNs, timeoutNs) ? "yes" : "no");
+    }
+    std::fflush(stdout);
+  }
+
+  bool isSameState(const Device &lhs, const Device &rhs) {
+    return (lhs.getErrors() == rhs.getErrors()) &&
+           (lhs.getSlaveState() == rhs.getSlaveState()) &&
+           (lhs.getApproveState() == rhs.getApproveState()) &&
+           (lhs.getCmdType() == rhs.getCmdType());
+  }
+
+  int bench(const Options &options) {
+    TrafficGenerator::Config config = {options.m_numOfMasters, options.m_numOfSlaves, 0U,
+                                       options.m_heartbeatPeriodNs, options.m_cmdPeriodNs,
+                                       TrafficGenerator::Scenario::APPROVE, 0U, 1U,
+                                       Protocol::Can::IdScheme::V1};
+    static TrafficGenerator generator(config);
+    if(not generator.isValid()) {
+      std::fprintf(stderr, "Configuration of devices is not valid\n");
+      return 1;
+    }
+    // both listen as one more Slave after all generated IDs
+    static Slave mergedSlave;
+    static Slave referenceSlave;
+    Slave *slaves[] = {&mergedSlave, &referenceSlave};
+    for(auto slave : slaves) {
+      slave->setDeviceId(static_cast<char>(config.m_numOfMasters + config.m_numOfSlaves + 1U));
+      slave->setNumOfMasters(config.m_numOfMasters);
+      slave->setNumOfSlaves(config.m_numOfSlaves + 1U);
+    }
+    static BusMerger merger(options.m_numOfBuses, options.m_windowNs);
+    std::srand(1U);
+
+    Protocol::Can::RawMsg msgs[MAX_MSGS];
+    uint64_t drops[BusMerger::MAX_BUSES] = {};
+    uint64_t numOfDelivered = 0U; // by any bus
+    uint64_t numOfForwarded = 0U;
+    uint64_t numOfAccepts = 0U;
+    uint64_t acceptNs = 0U;
+    uint64_t numOfUpdates = 0U;
+    uint64_t numOfMismatches = 0U;
+    uint64_t updateNs = options.m_updatePeriodNs;
+    while(not isStopped) {
+      auto nowNs = generator.getNextNs();
+      nowNs = (updateNs < nowNs) ? updateNs : nowNs;
+      if(nowNs > options.m_durationNs) {
+        break;
+      }
+      auto numOfMsgs = generator.generate(nowNs, msgs, MAX_MSGS);
+      for(uint32_t i = 0U; i < numOfMsgs; ++i) {
+        // random losses, the first copy comes from a random bus
+        bool isDropped[BusMerger::MAX_BUSES] = {};
+        bool isDelivered = false;
+        for(uint32_t bus = 0U; bus < options.m_numOfBuses; ++bus) {
+          isDropped[bus] = static_cast<uint32_t>(std::rand() % 1000) < options.m_lossPerMille;
+          isDelivered = isDelivered || not isDropped[bus];
+        }
+        if(not isDelivered) {
+          continue; // lost on every bus, no counter can see it
+        }
+        for(uint32_t bus = 0U; bus < options.m_numOfBuses; ++bus) {
+          drops[bus] += isDropped[bus] ? 1U : 0U;
+        }
+        ++numOfDelivered;
+        referenceSlave.pushMsg(msgs[i]);
+        auto first = static_cast<uint32_t>(std::rand()) % options.m_numOfBuses;
+        auto beforeNs = Clock::monotonicNs();
+        for(uint32_t j = 0U; j < options.m_numOfBuses; ++j) {
+          auto bus = (first + j) % options.m_numOfBuses;
+          if(isDropped[bus]) {
+            continue;
+          }
+          ++numOfAccepts;
+          if(merger.accept(bus, msgs[i], nowNs)) {
+            ++numOfForwarded;
+            mergedSlave.pushMsg(msgs[i]);
+          }
+        }
+        acceptNs += Clock::monotonicNs() - beforeNs;
+      }
+      if(nowNs >= updateNs) {
+        mergedSlave.update();
+        referenceSlave.update();
+        ++numOfUpdates;
+        numOfMismatches += isSameState(mergedSlave, referenceSlave) ? 0U : 1U;
+        updateNs += options.m_updatePeriodNs;
+      }
+    }
+    auto endNs = options.m_durationNs + options.m_windowNs;
+    merger.expire(endNs);
+
+    uint64_t numOfWrongLosses = 0U;
+    for(uint32_t bus = 0U; bus < options.m_numOfBuses; ++bus) {
+      numOfWrongLosses += (merger.getBusStats(bus).m_numOfLost != drops[bus]) ? 1U : 0U;
+    }
+    std::printf("%u Masters, %u Slaves, heartbeat %.1f ms, cmd every %.1f ms, %u buses, "
+                "loss %.1f%%, window %.1f ms\n", options.m_numOfMasters,
+                options.m_numOfSlaves, options.m_heartbeatPeriodNs / 1e6,
+                options.m_cmdPeriodNs / 1e6, options.m_numOfBuses,
+                options.m_lossPerMille / 10.0, options.m_windowNs / 1e6);
+    printStats(merger, endNs, endNs);
+    std::printf("generated %llu, delivered by any bus %llu, forwarded %llu, "
+                "accept() %.1f ns/frame\n",
+                static_cast<unsigned long long>(generator.getNumOfFrames()),
+                static_cast<unsigned long long>(numOfDelivered),
+                static_cast<unsigned long long>(numOfForwarded),
+                numOfAccepts ? static_cast<double>(acceptNs) / numOfAccepts : 0.0);
+    std::printf("buses with wrong loss count %llu, state mismatches %llu of %llu updates\n",
+                static_cast<unsigned long long>(numOfWrongLosses),
+                static_cast<unsigned long long>(numOfMismatches),
+                static_cast<unsigned long long>(numOfUpdates));
+    return ((numOfForwarded == numOfDelivered) && (0U == numOfWrongLosses) &&
+            (0U == numOfMismatches)) ? 0 : 2;
+  }
+
+  int run(const Options &options) {
+    static CanSocket sockets[BusMerger::MAX_BUSES];
+    pollfd fds[BusMerger::MAX_BUSES];
+    for(uint32_t bus = 0U; bus < options.m_numOfBuses; ++bus) {
+      if(not sockets[bus].open(options.ma_busIfNames[bus], true, true)) {
+        std::fprintf(stderr, "Cannot open %s\n", options.ma_busIfNames[bus]);
+        return 1;
+      }
+      fds[bus] = {sockets[bus].getFd(), POLLIN, 0};
+    }
+    static CanSocket outSocket;
+    if((nullptr != options.m_outIfName) && not outSocket.open(options.m_outIfName, false)) {
+      std::fprintf(stderr, "Cannot open %s\n", options.m_outIfName);
+      return 1;
+    }
+    static BusMerger merger(options.m_numOfBuses, options.m_windowNs);
+    Protocol::Can::FdRawMsg fdMsg{};
+    Protocol::Can::RawMsg msg{};
+    auto printNs = Clock::monotonicNs() + options.m_periodNs;
+    while(not isStopped) {
+      if(::poll(fds, options.m_numOfBuses, 100) < 0) {
+        continue; // EINTR
+      }
+      auto nowNs = Clock::monotonicNs();
+      for(uint32_t bus = 0U; bus < options.m_numOfBuses; ++bus) {
+        while(sockets[bus].recv(fdMsg)) {
+          if(Protocol::Can::toRawMsg(fdMsg, msg) && merger.accept(bus, msg, nowNs) &&
+             outSocket.isOpen()) {
+            outSocket.send(msg);
+          }
+        }
+      }
+      if(nowNs >= printNs) {
+        merger.expire(nowNs);
+        printStats(merger, nowNs, options.m_timeoutNs);
+        printNs = nowNs + options.m_periodNs;
+      }
+    }
+    auto nowNs = Clock::monotonicNs();
+    merger.expire(nowNs + options.m_windowNs);
+    printStats(merger, nowNs, options.m_timeoutNs);
+    return 0;
+  }
+
+  void onSignal(int) {
+    isStopped = 1;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-w window ms] [-T bus timeout ms] [-p stats period s] "
+                         "[-o out_if] bus_if bus_if...\n"
+                         "       %s -B [-n masters] [-s slaves] [-h heartbeat ms] "
+                         "[-c cmd period ms] [-u update ms]\n"
+                         "             [-b buses] [-l loss per mille] [-w window ms] "
+                         "[-t seconds]\n", argv[0], argv[0]);
+    return 1;
+  }
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  return options.m_isBench ? bench(options) : run(options);
+}
@@ -0,0 +1,166 @@
+/*
+ * Restart-to-operational benchmark of Checkpoint. A Master runs with
+ * save() after every update(), then a fresh process (this binary executed
+ * again with -C) opens the checkpoint, loads it and restores a Master
+ * from it. Measured per round:
+ *   restart - from fork() to the restored Master in the new process
+ *             (fork, exec, dynamic loading, open + load + restore)
+ *   restore - open() + load() + restore() within the new process
+ * and the cost of save() in the running process. Restored state is
+ * compared with the saved one.
+ *
+ * Usage:
+ *   eet-restart [-r rounds] [-n updates] [path]
+ * Example - 100 restarts, 1000 updates between them:
+ *   eet-restart -r 100 -n 1000
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Checkpoint.h"
+#include "Clock.h"
+#include "Device.h"
+#include "Histogram.h"
+#include "Print.h"
+
+namespace {
+  using namespace Eet;
+
+  struct Options {
+    bool m_isChild = false;
+    uint32_t m_numOfRounds = 20U;
+    uint32_t m_numOfUpdates = 1000U;
+    const char *m_path = "/tmp/eet-restart.ckpt";
+  };
+
+  // written by the restarted process to its stdout
+  struct Report {
+    uint64_t m_readyNs; // CLOCK_MONOTONIC when Master is restored
+    uint64_t m_restoreNs;
+    uint8_t ma_state[Snapshot::SIZE];
+    bool m_isRestored;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "Cr:n:"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'C': options.m_isChild = true; break;
+        case 'r': options.m_numOfRounds = static_cast<uint32_t>(value); break;
+        case 'n': options.m_numOfUpdates = static_cast<uint32_t>(value); break;
+        default: return false;
+      }
+    }
+    if(optind < argc) {
+      options.m_path = argv[optind++];
+    }
+    return (optind == argc);
+  }
+
+  int restart(const Options &options) {
+    Report report{};
+    auto startNs = Clock::monotonicNs();
+    static Checkpoint checkpoint;
+    static Master master;
+    Snapshot snapshot{};
+    report.m_isRestored = checkpoint.open(options.m_path) && checkpoint.load(snapshot) &&
+                          master.restore(snapshot);
+    report.m_readyNs = Clock::monotonicNs();
+    report.m_restoreNs = report.m_readyNs - startNs;
+    master.getSnapshot().encode(report.ma_state, Snapshot::SIZE);
+    return (sizeof(report) == ::write(STDOUT_FILENO, &report, sizeof(report))) ? 0 : 1;
+  }
+
+  // false if the restarted process has failed
+  bool runRound(const char *self, const Options &options, Report &report, uint64_t &forkNs) {
+    int fds[2];
+    if(0 != ::pipe(fds)) {
+      std::perror("pipe");
+      return false;
+    }
+    forkNs = Clock::monotonicNs();
+    auto pid = ::fork();
+    if(0 == pid) {
+      ::dup2(fds[1], STDOUT_FILENO);
+      ::close(fds[0]);
+      ::close(fds[1]);
+      ::execl(self, self, "-C", options.m_path, static_cast<char *>(nullptr));
+      ::_exit(127);
+    }
+    ::close(fds[1]);
+    auto size = (pid > 0) ? ::read(fds[0], &report, sizeof(report)) : -1;
+    ::close(fds[0]);
+    if(pid > 0) {
+      ::waitpid(pid, nullptr, 0);
+    }
+    return (sizeof(report) == size) && report.m_isRestored;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-r rounds] [-n updates] [path]\n", argv[0]);
+    return 1;
+  }
+  if(options.m_isChild) {
+    return restart(options);
+  }
+  char self[4096];
+  auto len = ::readlink("/proc/self/exe", self, sizeof(self) - 1U);
+  if(len <= 0) {
+    std::perror("readlink");
+    return 1;
+  }
+  self[len] = '\0';
+
+  static Checkpoint checkpoint;
+  if(not checkpoint.open(options.m_path)) {
+    std::fprintf(stderr, "Cannot open %s\n", options.m_path);
+    return 1;
+  }
+  static Master master;
+  master.setDeviceId(1);
+  master.setNumOfMasters(1U);
+  master.setNumOfSlaves(2U);
+  master.setLiveness(3U);
+  master.setIdScheme(Protocol::Can::IdScheme::V2);
+  master.setCmdType(Protocol::CmdType::HALF_AHEAD);
+
+  static Histogram saveNs;
+  static Histogram restartNs;
+  static Histogram restoreNs;
+  uint32_t numOfFailed = 0U;
+  uint32_t numOfMismatches = 0U;
+  for(uint32_t round = 0U; round < options.m_numOfRounds; ++round) {
+    for(uint32_t i = 0U; i < options.m_numOfUpdates; ++i) {
+      master.update();
+      auto beforeNs = Clock::monotonicNs();
+      checkpoint.save(master.getSnapshot());
+      saveNs.record(Clock::monotonicNs() - beforeNs);
+    }
+    Report report{};
+    uint64_t forkNs = 0U;
+    if(not runRound(self, options, report, forkNs)) {
+      ++numOfFailed;
+      continue;
+    }
+    restartNs.record(report.m_readyNs - forkNs);
+    restoreNs.record(report.m_restoreNs);
+    uint8_t saved[Snapshot::SIZE];
+    master.getSnapshot().encode(saved, Snapshot::SIZE);
+    numOfMismatches += (0 != std::memcmp(saved, report.ma_state, Snapshot::SEQUENCE_POS));
+  }
+  std::printf("%u rounds of %u updates, failed %u, state mismatches %u\n",
+              options.m_numOfRounds, options.m_numOfUpdates, numOfFailed, numOfMismatches);
+  Tools::printHistogramHeader();
+  Tools::printHistogram("save", saveNs);
+  Tools::printHistogram("restore", restoreNs);
+  Tools::printHistogram("restart", restartNs);
+  return ((0U == numOfFailed) && (0U == numOfMismatches)) ? 0 : 2;
+}
@@ -0,0 +1,80 @@
+/*
+ * Benchmark of SharedState: one writer publishes as fast as it can while
+ * N reader threads take snapshots. Every snapshot is checked for
+ * consistency (numOfSlaves is written together with the update counter).
+ *
+ * Usage: eet-shm-bench [readers] [seconds]
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Device.h"
+#include "SharedState.h"
+#include "Clock.h"
+#include "Histogram.h"
+#include "Print.h"
+
+int main(int argc, char *argv[]) {
+  using namespace Eet;
+
+  const uint32_t numOfReaders = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4U;
+  const uint64_t durationNs = ((argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1U) * 1000000000ULL;
+  const char *name = "/eet-shm-bench";
+
+  SharedState::Writer writer;
+  Master master;
+  if(not writer.open(name)) {
+    std::perror("shm_open");
+    return 1;
+  }
+  master.setDeviceId(1);
+  writer.publish(master);
+
+  std::atomic<bool> isStopped(false);
+  std::vector<uint64_t> numOfReads(numOfReaders), numOfTorn(numOfReaders);
+  std::vector<std::thread> readers;
+  for(uint32_t i = 0U; i < numOfReaders; ++i) {
+    readers.emplace_back([&, i]() {
+      SharedState::Reader reader;
+      SharedState::Record record{};
+      reader.open(name);
+      while(not isStopped.load(std::memory_order_relaxed)) {
+        if(reader.read(record)) {
+          ++numOfReads[i];
+          numOfTorn[i] += (record.m_snapshot.m_numOfSlaves !=
+                           static_cast<uint8_t>(record.m_numOfUpdates - 1U));
+        }
+      }
+    });
+  }
+
+  static Histogram publishNs;
+  uint64_t numOfPublishes = 0U;
+  auto startNs = Clock::monotonicNs();
+  while(Clock::monotonicNs() - startNs < durationNs) {
+    master.setNumOfSlaves(static_cast<uint8_t>(++numOfPublishes));
+    auto beforeNs = Clock::monotonicNs();
+    writer.publish(master);
+    publishNs.record(Clock::monotonicNs() - beforeNs);
+  }
+  isStopped = true;
+  for(auto &reader : readers) {
+    reader.join();
+  }
+
+  uint64_t totalReads = 0U, totalTorn = 0U;
+  for(uint32_t i = 0U; i < numOfReaders; ++i) {
+    totalReads += numOfReads[i];
+    totalTorn += numOfTorn[i];
+  }
+  auto seconds = durationNs / 1e9;
+  Tools::printHistogramHeader();
+  Tools::printHistogram("publish()", publishNs);
+  std::printf("readers %u, publishes %.2f M/s, reads %.2f M/s, inconsistent %llu\n",
+              numOfReaders, numOfPublishes / seconds / 1e6, totalReads / seconds / 1e6,
+              static_cast<unsigned long long>(totalTorn));
+  return (0U == totalTorn) ? 0 : 1;
+}
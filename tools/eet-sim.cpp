@@ -0,0 +1,206 @@
+/*
+ * Simulates one Master and several Slaves on a single bus, sweeps the
+ * lever through all commands, lets active Slave approve every command and
+ * prints command latency of every stage.
+ *
+ * Usage: eet-sim [-s slaves] [-n commands] [-a approve delay ms]
+ *                [-b bitrate] [-h heartbeat ms] [-u update ms]
+ *                [-i idle heartbeat ms] [-f fast heartbeat ms]
+ *                [-v id scheme] [-q f|p] [-c] [-T trace file]
+ *
+ * -i enables adaptive heartbeat (see HeartbeatPolicy) with 3 fast heartbeats
+ * after every change, -h is ignored then.
+ * -v 2 switches all devices to V2 CAN IDs (see Protocol::Can::IdScheme),
+ * -q f makes TX queues of devices FIFO instead of PRIORITY (see TxQueue).
+ * -c makes all devices send heartbeats at the same time (critical instant).
+ * With -c and short heartbeat period ISSUED->RECEIVED max is the worst-case
+ * cmd latency under load.
+ * -T records processing spans and state transitions (needs EET_TRACING,
+ * see Tracer) and saves them as Chrome trace JSON if the file name ends
+ * with .json, as Perfetto protobuf otherwise. Span times are real time.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "Device.h"
+#include "Simulator.h"
+#include "HeartbeatPolicy.h"
+#include "CmdTrace.h"
+#include "Tracer.h"
+#include "Print.h"
+
+namespace {
+  constexpr uint64_t MS = 1000000U;
+
+  struct Options {
+    uint32_t m_numOfSlaves = 2U;
+    uint32_t m_numOfCommands = 100U;
+    uint64_t m_approveDelayNs = 0U;
+    Eet::Simulator::Config m_config = {125000U, 100U * MS, 300U * MS};
+    Eet::HeartbeatPolicy::Config m_policy = {20U * MS, 3U, 0U};
+    Eet::Protocol::Can::IdScheme m_idScheme = Eet::Protocol::Can::IdScheme::V1;
+    Eet::TxQueue::Mode m_txQueueMode = Eet::TxQueue::Mode::PRIORITY;
+    bool m_isCriticalInstant = false;
+    const char *m_tracePath = nullptr;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "s:n:a:b:h:u:i:f:v:q:cT:"))) {
+      auto value = optarg ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'n': options.m_numOfCommands = static_cast<uint32_t>(value); break;
+        case 'a': options.m_approveDelayNs = value * MS; break;
+        case 'b': options.m_config.m_bitrate = static_cast<uint32_t>(value); break;
+        case 'h': options.m_config.m_heartbeatPeriodNs = value * MS; break;
+        case 'u': options.m_config.m_updatePeriodNs = value * MS; break;
+        case 'i': options.m_policy.m_idlePeriodNs = value * MS; break;
+        case 'f': options.m_policy.m_fastPeriodNs = value * MS; break;
+        case 'v': options.m_idScheme = (2U == value) ? Eet::Protocol::Can::IdScheme::V2 :
+                                                       Eet::Protocol::Can::IdScheme::V1; break;
+        case 'q': options.m_txQueueMode = ('f' == optarg[0]) ? Eet::TxQueue::Mode::FIFO :
+                                                               Eet::TxQueue::Mode::PRIORITY; break;
+        case 'c': options.m_isCriticalInstant = true; break;
+        case 'T': options.m_tracePath = optarg; break;
+        default: return false;
+      }
+    }
+    return (options.m_numOfSlaves > 0U) &&
+           (options.m_numOfSlaves < Eet::Simulator::MAX_DEVICES) &&
+           (options.m_config.m_bitrate > 0U) &&
+           (options.m_policy.m_fastPeriodNs > 0U);
+  }
+}
+
+
+int main(int argc, char *argv[]) {
+  using namespace Eet;
+
+  Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-s slaves] [-n commands] [-a approve delay ms] "
+                         "[-b bitrate] [-h heartbeat ms] [-u update ms] "
+                         "[-i idle heartbeat ms] [-f fast heartbeat ms] [-v id scheme] [-q f|p] [-c] [-T trace file]\n", argv[0]);
+    return 1;
+  }
+#ifdef EET_TRACE_ENABLED
+  Tracer::enable(nullptr != options.m_tracePath);
+#else
+  if(nullptr != options.m_tracePath) {
+    std::fprintf(stderr, "Built without EET_TRACING\n");
+    return 1;
+  }
+#endif
+
+  Simulator sim(options.m_config);
+  sim.setTxQueueMode(options.m_txQueueMode);
+  static CmdTrace trace(sim);
+  Master master;
+  static Slave slaves[Simulator::MAX_DEVICES];
+  static HeartbeatPolicy policies[Simulator::MAX_DEVICES];
+  bool isAdaptive = (0U != options.m_policy.m_idlePeriodNs);
+  uint32_t liveness = isAdaptive ? HeartbeatPolicy::getLiveness(options.m_policy,
+                                                                options.m_config.m_updatePeriodNs) :
+                                   1U;
+
+  master.setDeviceId(1);
+  master.setNumOfMasters(0U);
+  master.setNumOfSlaves(options.m_numOfSlaves);
+  master.setObserver(&trace);
+  master.setLiveness(liveness);
+  master.setIdScheme(options.m_idScheme);
+  sim.attach(master);
+  for(uint32_t i = 0U; i < options.m_numOfSlaves; ++i) {
+    slaves[i].setDeviceId(static_cast<char>(i + 2U));
+    slaves[i].setNumOfMasters(1U);
+    slaves[i].setNumOfSlaves(options.m_numOfSlaves - 1U);
+    slaves[i].setObserver(&trace);
+    slaves[i].setLiveness(liveness);
+    slaves[i].setIdScheme(options.m_idScheme);
+    sim.attach(slaves[i]);
+  }
+  if(options.m_isCriticalInstant) {
+    sim.setHeartbeatPhase(master, 0U);
+    for(uint32_t i = 0U; i < options.m_numOfSlaves; ++i) {
+      sim.setHeartbeatPhase(slaves[i], 0U);
+    }
+  }
+  if(isAdaptive) {
+    policies[0] = HeartbeatPolicy(options.m_policy);
+    sim.setHeartbeatPolicy(master, &policies[0]);
+    for(uint32_t i = 0U; i < options.m_numOfSlaves; ++i) {
+      policies[i + 1U] = HeartbeatPolicy(options.m_policy);
+      sim.setHeartbeatPolicy(slaves[i], &policies[i + 1U]);
+    }
+  }
+
+  // let devices see each other, then activate the first Slave
+  auto &active = slaves[0];
+  sim.run(2U * options.m_config.m_updatePeriodNs);
+  active.activate();
+  sim.run(2U * options.m_config.m_updatePeriodNs);
+  if(Protocol::SlaveState::ACTIVE != active.getSlaveState()) {
+    std::fprintf(stderr, "Slave has not been activated\n");
+    return 1;
+  }
+
+  const uint64_t stepNs = MS / 10U;
+  const uint64_t timeoutNs = 10U * options.m_config.m_updatePeriodNs;
+  uint32_t numOfLost = 0U;
+  for(uint32_t i = 0U; i < options.m_numOfCommands; ++i) {
+    auto cmdType = static_cast<Protocol::CmdType>(
+      i % (static_cast<uint32_t>(Protocol::CmdType::FULL_ASTERN) + 1U));
+    if(cmdType == master.getCmdType()) {
+      cmdType = Protocol::CmdType::STOP == cmdType ? Protocol::CmdType::COMPLETE :
+                                                      Protocol::CmdType::STOP;
+    }
+    master.setCmdType(cmdType);
+    sim.send(master, master.getCmdMsg());
+
+    uint64_t waitedNs = 0U;
+    while((active.getCmdType() != cmdType) && (waitedNs < timeoutNs)) {
+      sim.run(stepNs);
+      waitedNs += stepNs;
+    }
+    sim.run(options.m_approveDelayNs);
+    active.approve(cmdType);
+    while((Protocol::ApproveState::APPROVED != master.getApproveState()) &&
+          (waitedNs < timeoutNs)) {
+      sim.run(stepNs);
+      waitedNs += stepNs;
+    }
+    numOfLost += (waitedNs >= timeoutNs);
+    // let the bus settle, next lever move is not synchronized with heartbeats
+    sim.run(options.m_config.m_heartbeatPeriodNs * (i % 7U + 1U) / 3U);
+  }
+
+  Tools::printHistogramHeader();
+  Tools::printHistogram("ISSUED->RECEIVED", trace.getHistogram(CmdTrace::TO_SLAVE));
+  Tools::printHistogram("RECEIVED->APPROVED", trace.getHistogram(CmdTrace::TO_APPROVE));
+  Tools::printHistogram("APPROVED->CONFIRMED", trace.getHistogram(CmdTrace::TO_MASTER));
+  Tools::printHistogram("ISSUED->CONFIRMED", trace.getHistogram(CmdTrace::TOTAL));
+  std::printf("commands %u, not confirmed %u, frames %llu, bus load %.2f%%, "
+              "loss alarms %llu, dropped %llu\n",
+              options.m_numOfCommands, numOfLost,
+              static_cast<unsigned long long>(sim.getNumOfFrames()),
+              100.0 * sim.getBusyNs() / sim.nowNs(),
+              static_cast<unsigned long long>(sim.getNumOfAlarms()),
+              static_cast<unsigned long long>(sim.getNumOfDropped()));
+#ifdef EET_TRACE_ENABLED
+  if(nullptr != options.m_tracePath) {
+    Tracer::enable(false);
+    auto len = std::strlen(options.m_tracePath);
+    bool isJson = (len > 5U) && (0 == std::strcmp(options.m_tracePath + len - 5U, ".json"));
+    bool isSaved = isJson ? Tracer::exportJson(options.m_tracePath) :
+                            Tracer::exportPerfetto(options.m_tracePath);
+    std::printf("trace events %llu, lost %llu%s\n",
+                static_cast<unsigned long long>(Tracer::getNumOfEvents()),
+                static_cast<unsigned long long>(Tracer::getNumOfLost()),
+                isSaved ? "" : ", cannot save");
+  }
+#endif
+  return 0;
+}
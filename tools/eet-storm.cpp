@@ -0,0 +1,210 @@
+/*
+ * Storm replay benchmark of Admission. One babbling Slave floods the bus
+ * with heartbeats, a part of them with a wrong DLC, while generated
+ * devices (see TrafficGenerator) send their usual heartbeats. Frames are
+ * replayed in virtual time into two listening Slaves:
+ *   direct   - every frame goes to pushMsg()
+ *   admitted - admit() first, pushMsg() only for ADMITTED frames
+ * and the cost of both receive paths per frame is measured on batches of
+ * frames. Legitimate frames must all be admitted.
+ *
+ * Usage:
+ *   eet-storm [-n masters] [-s slaves] [-h heartbeat ms] [-f babbler frames/s]
+ *             [-b bad DLC per mille] [-t seconds] [-r sender rate/s] [-q quarantine ms]
+ * Example - 1M frames/s babbler, half of the frames with a wrong DLC:
+ *   eet-storm -f 1000000 -b 500 -t 10
+ *
+ * Babbler takes the Device ID after the listening Slave, so generated
+ * devices and the two extra IDs have to fit MAX_DEVICE_ID.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "Admission.h"
+#include "Clock.h"
+#include "Device.h"
+#include "TrafficGenerator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint32_t MAX_MSGS = 64U;
+  constexpr uint32_t BATCH = 4096U;
+  constexpr uint64_t UPDATE_PERIOD_NS = 100U * MS;
+
+  struct Options {
+    uint32_t m_numOfMasters = 1U;
+    uint32_t m_numOfSlaves = 9U;
+    uint64_t m_heartbeatPeriodNs = 100U * MS;
+    uint32_t m_babblerRate = 1000000U;
+    uint32_t m_badDlcPerMille = 500U;
+    uint64_t m_durationNs = 10U * SEC;
+    uint32_t m_senderRate = 100U;
+    uint64_t m_quarantineNs = 1000U * MS;
+  };
+
+  struct Frame {
+    Protocol::Can::RawMsg m_msg;
+    uint64_t m_timeNs;
+    bool m_isLegitimate;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "n:s:h:f:b:t:r:q:"))) {
+      auto value = (nullptr != optarg) ? std::strtoull(optarg, nullptr, 10) : 0U;
+      switch(opt) {
+        case 'n': options.m_numOfMasters = static_cast<uint32_t>(value); break;
+        case 's': options.m_numOfSlaves = static_cast<uint32_t>(value); break;
+        case 'h': options.m_heartbeatPeriodNs = value * MS; break;
+        case 'f': options.m_babblerRate = static_cast<uint32_t>(value); break;
+        case 'b': options.m_badDlcPerMille = static_cast<uint32_t>(value); break;
+        case 't': options.m_durationNs = value * SEC; break;
+        case 'r': options.m_senderRate = static_cast<uint32_t>(value); break;
+        case 'q': options.m_quarantineNs = value * MS; break;
+        default: return false;
+      }
+    }
+    // IDs of generated devices, of the listening Slave and of the babbler
+    auto numOfIds = options.m_numOfMasters + options.m_numOfSlaves + 2U;
+    return (optind == argc) &&
+           (numOfIds <= static_cast<uint32_t>(Protocol::DeviceId::MAX_DEVICE_ID)) &&
+           (options.m_heartbeatPeriodNs > 0U) && (options.m_babblerRate > 0U) &&
+           (options.m_badDlcPerMille <= 1000U) && (options.m_senderRate > 0U);
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-n masters] [-s slaves] [-h heartbeat ms] "
+                         "[-f babbler frames/s] [-b bad DLC per mille]\n"
+                         "          [-t seconds] [-r sender rate/s] [-q quarantine ms]\n",
+                 argv[0]);
+    return 1;
+  }
+  TrafficGenerator::Config config = {options.m_numOfMasters, options.m_numOfSlaves, 0U,
+                                     options.m_heartbeatPeriodNs, options.m_heartbeatPeriodNs,
+                                     TrafficGenerator::Scenario::HEARTBEATS_ONLY, 0U, 1U,
+                                     Protocol::Can::IdScheme::V1};
+  static TrafficGenerator generator(config);
+  if(not generator.isValid()) {
+    std::fprintf(stderr, "Configuration of devices is not valid\n");
+    return 1;
+  }
+  auto listenerId = static_cast<char>(config.m_numOfMasters + config.m_numOfSlaves + 1U);
+  auto babblerId = static_cast<char>(listenerId + 1);
+  static Slave directSlave;
+  static Slave admittedSlave;
+  Slave *slaves[] = {&directSlave, &admittedSlave};
+  for(auto slave : slaves) {
+    slave->setDeviceId(listenerId);
+    slave->setNumOfMasters(config.m_numOfMasters);
+    slave->setNumOfSlaves(config.m_numOfSlaves + 1U);
+  }
+  Admission::Config admissionConfig = {options.m_senderRate, 20U, 1000U, 100U, 10U,
+                                       options.m_quarantineNs};
+  static Admission admission(admissionConfig);
+
+  auto babble = static_cast<Protocol::Can::RawMsg>(Protocol::Msg::Heartbeat(
+    Protocol::Msg::CommonFields(babblerId, Protocol::DeviceType::SLAVE, 0U),
+    Protocol::SlaveState::NOT_ACTIVE, Protocol::ApproveState::NOT_APPROVED,
+    Protocol::CmdType::COMPLETE));
+  auto badBabble = babble;
+  badBabble.m_dlc = 8U;
+  const uint64_t babblePeriodNs = SEC / options.m_babblerRate;
+  uint64_t babbleNs = 0U;
+  uint64_t numOfBabbles = 0U;
+  std::srand(1U);
+
+  static Frame frames[BATCH];
+  Protocol::Can::RawMsg msgs[MAX_MSGS];
+  uint64_t numOfFrames = 0U;
+  uint64_t numOfLegitimate = 0U;
+  uint64_t numOfLegitimateAdmitted = 0U;
+  uint64_t directNs = 0U;
+  uint64_t admittedNs = 0U;
+  uint64_t updateNs = UPDATE_PERIOD_NS;
+  bool isDone = false;
+  while(not isDone) {
+    // batch of frames in time order
+    uint32_t numOfBatched = 0U;
+    while(numOfBatched + MAX_MSGS <= BATCH) {
+      auto nowNs = generator.getNextNs();
+      if((babbleNs <= nowNs) && (babbleNs <= options.m_durationNs)) {
+        auto isBad = static_cast<uint32_t>(std::rand() % 1000) < options.m_badDlcPerMille;
+        frames[numOfBatched++] = {isBad ? badBabble : babble, babbleNs, false};
+        babbleNs += babblePeriodNs;
+        ++numOfBabbles;
+        continue;
+      }
+      if(nowNs > options.m_durationNs) {
+        isDone = true;
+        break;
+      }
+      auto numOfMsgs = generator.generate(nowNs, msgs, MAX_MSGS);
+      for(uint32_t i = 0U; i < numOfMsgs; ++i) {
+        frames[numOfBatched++] = {msgs[i], nowNs, true};
+      }
+    }
+    numOfFrames += numOfBatched;
+
+    auto startNs = Clock::monotonicNs();
+    for(uint32_t i = 0U; i < numOfBatched; ++i) {
+      directSlave.pushMsg(frames[i].m_msg);
+    }
+    auto midNs = Clock::monotonicNs();
+    for(uint32_t i = 0U; i < numOfBatched; ++i) {
+      if(Admission::ADMITTED == admission.admit(frames[i].m_msg, frames[i].m_timeNs)) {
+        admittedSlave.pushMsg(frames[i].m_msg);
+      }
+    }
+    auto endNs = Clock::monotonicNs();
+    directNs += midNs - startNs;
+    admittedNs += endNs - midNs;
+
+    // update() whenever the batch has crossed an update period
+    auto lastNs = numOfBatched ? frames[numOfBatched - 1U].m_timeNs : updateNs;
+    while(lastNs >= updateNs) {
+      directSlave.update();
+      admittedSlave.update();
+      updateNs += UPDATE_PERIOD_NS;
+    }
+    for(uint32_t i = 0U; i < numOfBatched; ++i) {
+      numOfLegitimate += frames[i].m_isLegitimate ? 1U : 0U;
+    }
+  }
+  for(char id = 1; id < babblerId; ++id) {
+    numOfLegitimateAdmitted += admission.getSenderStats(id).m_numOfAdmitted;
+  }
+
+  const auto &babbler = admission.getSenderStats(babblerId);
+  std::printf("%u Masters, %u Slaves, heartbeat %.1f ms, babbler %u frames/s "
+              "(%.1f%% bad DLC), %.1f s\n", options.m_numOfMasters, options.m_numOfSlaves,
+              options.m_heartbeatPeriodNs / 1e6, options.m_babblerRate,
+              options.m_badDlcPerMille / 10.0, options.m_durationNs / 1e9);
+  std::printf("frames %llu, babbler %llu, legitimate %llu (admitted %llu)\n",
+              static_cast<unsigned long long>(numOfFrames),
+              static_cast<unsigned long long>(numOfBabbles),
+              static_cast<unsigned long long>(numOfLegitimate),
+              static_cast<unsigned long long>(numOfLegitimateAdmitted));
+  std::printf("babbler admitted %llu, rejected %llu, quarantined %llu times\n",
+              static_cast<unsigned long long>(babbler.m_numOfAdmitted),
+              static_cast<unsigned long long>(babbler.m_numOfRejected),
+              static_cast<unsigned long long>(babbler.m_numOfQuarantines));
+  static const char *verdicts[] = {"admitted", "invalid CAN ID", "invalid DLC",
+                                   "invalid device ID", "invalid device type",
+                                   "sender rate", "CAN ID rate", "quarantined"};
+  for(uint32_t i = 0U; i < Admission::NUM_OF_VERDICTS; ++i) {
+    std::printf("  %-20s %12llu\n", verdicts[i], static_cast<unsigned long long>(
+                  admission.getCount(static_cast<Admission::Verdict>(i))));
+  }
+  std::printf("receive path: pushMsg() only %.1f ns/frame, admit() first %.1f ns/frame\n",
+              numOfFrames ? static_cast<double>(directNs) / numOfFrames : 0.0,
+              numOfFrames ? static_cast<double>(admittedNs) / numOfFrames : 0.0);
+  return (numOfLegitimateAdmitted == numOfLegitimate) ? 0 : 2;
+}
@@ -0,0 +1,31 @@
+/*
+ * Correlates command trace events saved by CmdTrace::saveEvents() in
+ * several processes (e.g. Master and Slaves on vcan) and prints latency
+ * of every stage.
+ *
+ * Usage: eet-trace <events file>...
+ */
+#include <cstdio>
+
+#include "CmdTrace.h"
+#include "Print.h"
+
+int main(int argc, char *argv[]) {
+  using Eet::CmdTrace;
+
+  if(argc < 2) {
+    std::fprintf(stderr, "Usage: %s <events file>...\n", argv[0]);
+    return 1;
+  }
+  static CmdTrace trace;
+  if(not trace.loadEvents(argv + 1, static_cast<uint32_t>(argc - 1))) {
+    std::fprintf(stderr, "Can not read events\n");
+    return 1;
+  }
+  Eet::Tools::printHistogramHeader();
+  Eet::Tools::printHistogram("ISSUED->RECEIVED", trace.getHistogram(CmdTrace::TO_SLAVE));
+  Eet::Tools::printHistogram("RECEIVED->APPROVED", trace.getHistogram(CmdTrace::TO_APPROVE));
+  Eet::Tools::printHistogram("APPROVED->CONFIRMED", trace.getHistogram(CmdTrace::TO_MASTER));
+  Eet::Tools::printHistogram("ISSUED->CONFIRMED", trace.getHistogram(CmdTrace::TOTAL));
+  return 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * Trends of a device from TimeSeries, and load test of the store.
+ *
+ * Usage: eet-trend [-H hours] [-C chunks] [-c cmd period s] [-o outage period min]
+ *                  [-w window min] [-q readers]
+ *   A Slave listens to generated traffic (see TrafficGenerator) for -H hours
+ *   of virtual time, all frames are dropped for OUTAGE_NS every -o minutes
+ *   (connection-loss incidents). TimeSeries of -C chunks records its
+ *   transitions while -q reader threads query trends of the last -w minutes.
+ * Example - one shift with 64 KiB of history:
+ *   eet-trend -H 8 -C 64 -c 30
+ *
+ * Prints trends of the last window, the last commands, cost of append on
+ * the device thread and of a batch of queries on reader threads (and of
+ * the same batch over the last window and the whole history at the end).
+ */
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Clock.h"
+#include "Device.h"
+#include "Histogram.h"
+#include "Print.h"
+#include "TimeSeries.h"
+#include "TrafficGenerator.h"
+
+namespace {
+  using namespace Eet;
+
+  constexpr uint64_t MS = 1000000U;
+  constexpr uint64_t SEC = 1000U * MS;
+  constexpr uint64_t MIN = 60U * SEC;
+  constexpr uint64_t STEP_NS = 10U * MS;
+  constexpr uint64_t UPDATE_PERIOD_NS = 300U * MS;
+  constexpr uint64_t OUTAGE_NS = 3U * SEC;
+  constexpr uint32_t MAX_CHUNKS = 4096U;
+  constexpr uint32_t NUM_OF_CMD_TYPES = static_cast<uint32_t>(Protocol::CmdType::FULL_ASTERN) + 1U;
+  constexpr uint32_t NUM_OF_LAST = 10U;
+  constexpr uint32_t NUM_OF_FULL_QUERIES = 1000U;
+
+  const char *const CMD_NAMES[NUM_OF_CMD_TYPES] = {
+    "COMPLETE", "GET_READY", "FULL_AHEAD", "HALF_AHEAD", "SLOW_AHEAD",
+    "DEAD_SLOW_AHEAD", "STOP", "DEAD_SLOW_ASTERN", "SLOW_ASTERN",
+    "HALF_ASTERN", "FULL_ASTERN"
+  };
+
+  const char *const ERROR_NAMES[] = {
+    "DUPLICATED_DEVICE_ID", "CON_WITH_SOME_SLAVES_LOST", "CON_WITH_ALL_SLAVES_LOST",
+    "CON_WITH_SOME_MASTERS_LOST", "CON_WITH_ALL_MASTERS_LOST", "NO_CONNECTION",
+    "NO_ACTIVE_SLAVE"
+  };
+
+  volatile std::sig_atomic_t isStopped = 0;
+
+  struct Options {
+    uint64_t m_durationNs = 8U * 60U * MIN;
+    uint32_t m_numOfChunks = 256U;
+    uint64_t m_cmdPeriodNs = 60U * SEC;
+    uint64_t m_outagePeriodNs = 20U * MIN;
+    uint64_t m_windowNs = 60U * MIN;
+    uint32_t m_numOfReaders = 1U;
+  };
+
+  class VirtualClock final : public IClock {
+    public:
+      uint64_t nowNs() const override {
+        return m_nowNs.load(std::memory_order_relaxed);
+      }
+
+      void set(uint64_t nowNs) {
+        m_nowNs.store(nowNs, std::memory_order_relaxed);
+      }
+
+    private:
+      std::atomic<uint64_t> m_nowNs{0U};
+  };
+
+  // times TimeSeries append on the device thread
+  class TimedObserver final : public IObserver {
+    public:
+      explicit TimedObserver(TimeSeries &series) :
+        m_series(series) {}
+
+      void onTransition(const Device &device, StateField field,
+                        uint8_t from, uint8_t to) override {
+        auto startNs = Clock::monotonicNs();
+        m_series.onTransition(device, field, from, to);
+        m_appendNs.record(Clock::monotonicNs() - startNs);
+      }
+
+      const Histogram &getAppendNs() const {
+        return m_appendNs;
+      }
+
+    private:
+      TimeSeries &m_series;
+      Histogram m_appendNs;
+  };
+
+  bool parse(int argc, char *argv[], Options &options) {
+    int opt;
+    while(-1 != (opt = getopt(argc, argv, "H:C:c:o:w:q:"))) {
+      auto value = std::strtoull(optarg, nullptr, 10);
+      switch(opt) {
+        case 'H': options.m_durationNs = value * 60U * MIN; break;
+        case 'C': options.m_numOfChunks = static_cast<uint32_t>(value); break;
+        case 'c': options.m_cmdPeriodNs = value * SEC; break;
+        case 'o': options.m_outagePeriodNs = value * MIN; break;
+        case 'w': options.m_windowNs = value * MIN; break;
+        case 'q': options.m_numOfReaders = static_cast<uint32_t>(value); break;
+        default: return false;
+      }
+    }
+    return (optind == argc) && (options.m_durationNs > 0U) && (options.m_numOfChunks > 0U) &&
+           (options.m_numOfChunks <= MAX_CHUNKS) && (options.m_cmdPeriodNs > 0U) &&
+           (options.m_windowNs > 0U);
+  }
+
+  // the trend screen: time in each cmd type, approvals, transitions, last commands
+  uint64_t queryTrends(const TimeSeries &series, uint64_t fromNs, uint64_t toNs) {
+    uint64_t checksum = 0U;
+    for(uint32_t cmd = 0U; cmd < NUM_OF_CMD_TYPES; ++cmd) {
+      checksum += series.getTimeInState(TimeSeries::CMD_TYPE, static_cast<uint8_t>(cmd),
+                                        fromNs, toNs);
+    }
+    checksum += series.getTimeInState(TimeSeries::APPROVE_STATE,
+                                      static_cast<uint8_t>(Protocol::ApproveState::APPROVED),
+                                      fromNs, toNs);
+    for(uint32_t signal = 0U; signal < TimeSeries::NUM_OF_SIGNALS; ++signal) {
+      checksum += series.getNumOfTransitions(static_cast<TimeSeries::Signal>(signal),
+                                             fromNs, toNs);
+    }
+    TimeSeries::Transition last[NUM_OF_LAST];
+    checksum += series.getLast(TimeSeries::CMD_TYPE, last, NUM_OF_LAST);
+    return checksum;
+  }
+
+  void runReader(const TimeSeries &series, const VirtualClock &clock, uint64_t windowNs,
+                 const std::atomic<bool> &isDone, Histogram &queryNs) {
+    volatile uint64_t checksum = 0U;
+    while(not isDone.load(std::memory_order_relaxed)) {
+      auto toNs = clock.nowNs();
+      auto fromNs = (toNs > windowNs) ? (toNs - windowNs) : 0U;
+      auto startNs = Clock::monotonicNs();
+      checksum = checksum + queryTrends(series, fromNs, toNs);
+      queryNs.record(Clock::monotonicNs() - startNs);
+    }
+  }
+
+  void printTrends(const TimeSeries &series, uint64_t fromNs, uint64_t toNs) {
+    auto windowNs = toNs - fromNs;
+    std::printf("last %.0f min:\n", windowNs / 60e9);
+    for(uint32_t cmd = 0U; cmd < NUM_OF_CMD_TYPES; ++cmd) {
+      auto timeNs = series.getTimeInState(TimeSeries::CMD_TYPE, static_cast<uint8_t>(cmd),
+                                          fromNs, toNs);
+      if(0U != timeNs) {
+        std::printf("  cmd %-28s %8.1f s %5.1f%%\n", CMD_NAMES[cmd], timeNs / 1e9,
+                    100.0 * timeNs / windowNs);
+      }
+    }
+    auto approvedNs = series.getTimeInState(TimeSeries::APPROVE_STATE,
+                                            static_cast<uint8_t>(Protocol::ApproveState::APPROVED),
+                                            fromNs, toNs);
+    std::printf("  %-32s %8.1f s %5.1f%%, %u transitions\n", "approved", approvedNs / 1e9,
+                100.0 * approvedNs / windowNs,
+                series.getNumOfTransitions(TimeSeries::APPROVE_STATE, fromNs, toNs));
+    std::printf("  %-32s %8u\n", "cmd transitions",
+                series.getNumOfTransitions(TimeSeries::CMD_TYPE, fromNs, toNs));
+    for(uint32_t bit = 0U; bit <= Protocol::NO_ACTIVE_SLAVE; ++bit) {
+      auto signal = static_cast<TimeSeries::Signal>(TimeSeries::ERROR_BITS + bit);
+      auto transitions = series.getNumOfTransitions(signal, fromNs, toNs);
+      if(0U != transitions) {
+        std::printf("  %-32s %8.1f s, %u transitions\n", ERROR_NAMES[bit],
+                    series.getTimeInState(signal, 1U, fromNs, toNs) / 1e9, transitions);
+      }
+    }
+    TimeSeries::Transition last[NUM_OF_LAST];
+    auto numOfLast = series.getLast(TimeSeries::CMD_TYPE, last, NUM_OF_LAST);
+    std::printf("last %u commands:\n", numOfLast);
+    for(uint32_t i = 0U; i < numOfLast; ++i) {
+      std::printf("  %8.1f s ago %s\n", (toNs - last[i].m_timeNs) / 1e9,
+                  (last[i].m_value < NUM_OF_CMD_TYPES) ? CMD_NAMES[last[i].m_value] : "INVALID");
+    }
+  }
+
+  void onSignal(int) {
+    isStopped = 1;
+  }
+} // end namespace
+
+
+int main(int argc, char *argv[]) {
+  static Options options;
+  if(not parse(argc, argv, options)) {
+    std::fprintf(stderr, "Usage: %s [-H hours] [-C chunks] [-c cmd period s] "
+                         "[-o outage period min]\n"
+                         "       [-w window min] [-q readers]\n", argv[0]);
+    return 1;
+  }
+  TrafficGenerator::Config config = {1U, 4U, 0U, 100U * MS, options.m_cmdPeriodNs,
+                                     TrafficGenerator::Scenario::APPROVE, 0U, 1U,
+                                     Protocol::Can::IdScheme::V1};
+  static TrafficGenerator generator(config);
+  static VirtualClock clock;
+  static TimeSeries::Chunk chunks[MAX_CHUNKS];
+  static TimeSeries series(chunks, options.m_numOfChunks, clock);
+  static TimedObserver observer(series);
+  // listens as one more Slave after all generated IDs
+  static Slave slave;
+  slave.setDeviceId(static_cast<char>(config.m_numOfMasters + config.m_numOfSlaves + 1U));
+  slave.setNumOfMasters(config.m_numOfMasters);
+  slave.setNumOfSlaves(config.m_numOfSlaves + 1U);
+  slave.setObserver(&observer);
+  series.sync(slave);
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  std::atomic<bool> isDone(false);
+  std::vector<Histogram> queryNs(options.m_numOfReaders);
+  std::vector<std::thread> readers;
+  for(uint32_t i = 0U; i < options.m_numOfReaders; ++i) {
+    readers.emplace_back(runReader, std::cref(series), std::cref(clock), options.m_windowNs,
+                         std::cref(isDone), std::ref(queryNs[i]));
+  }
+
+  Protocol::Can::RawMsg msgs[64];
+  uint64_t updateNs = UPDATE_PERIOD_NS;
+  uint64_t nowNs = 0U;
+  auto startNs = Clock::monotonicNs();
+  while((nowNs < options.m_durationNs) && not isStopped) {
+    nowNs += STEP_NS;
+    clock.set(nowNs);
+    bool isOutage = (0U != options.m_outagePeriodNs) &&
+                    (nowNs % options.m_outagePeriodNs >= options.m_outagePeriodNs - OUTAGE_NS);
+    uint32_t numOfMsgs = 0U;
+    while(0U != (numOfMsgs = generator.generate(nowNs, msgs, 64U))) {
+      for(uint32_t i = 0U; (i < numOfMsgs) && not isOutage; ++i) {
+        slave.pushMsg(msgs[i]);
+      }
+    }
+    if(nowNs >= updateNs) {
+      slave.update();
+      updateNs += UPDATE_PERIOD_NS;
+    }
+  }
+  auto elapsedNs = Clock::monotonicNs() - startNs;
+  isDone = true;
+  for(auto &reader : readers) {
+    reader.join();
+  }
+
+  auto oldestNs = series.getOldestNs();
+  std::printf("%.1f h in %.2f s, %llu frames, %llu transitions, %u chunks (%llu bytes), "
+              "history %.1f h\n",
+              nowNs / 3600e9, elapsedNs / 1e9,
+              static_cast<unsigned long long>(generator.getNumOfFrames()),
+              static_cast<unsigned long long>(series.getNumOfEvents()), options.m_numOfChunks,
+              static_cast<unsigned long long>(options.m_numOfChunks * sizeof(TimeSeries::Chunk)),
+              (nowNs - oldestNs) / 3600e9);
+  printTrends(series, (nowNs > options.m_windowNs) ? (nowNs - options.m_windowNs) : 0U, nowNs);
+
+  Histogram allQueryNs;
+  for(const auto &histogram : queryNs) {
+    allQueryNs.merge(histogram);
+  }
+  // the same queries of the last window and of the whole history without the writer
+  static Histogram windowQueryNs;
+  static Histogram fullQueryNs;
+  volatile uint64_t checksum = 0U;
+  for(uint32_t i = 0U; i < NUM_OF_FULL_QUERIES; ++i) {
+    auto queryStartNs = Clock::monotonicNs();
+    checksum = checksum + queryTrends(series, (nowNs > options.m_windowNs) ?
+                                              (nowNs - options.m_windowNs) : 0U, nowNs);
+    auto windowEndNs = Clock::monotonicNs();
+    checksum = checksum + queryTrends(series, oldestNs, nowNs);
+    windowQueryNs.record(windowEndNs - queryStartNs);
+    fullQueryNs.record(Clock::monotonicNs() - windowEndNs);
+  }
+  Tools::printHistogramHeader();
+  Tools::printHistogram("append", observer.getAppendNs());
+  Tools::printHistogram("trend queries", allQueryNs);
+  Tools::printHistogram("queries of window", windowQueryNs);
+  Tools::printHistogram("queries of history", fullQueryNs);
+  return 0;
+}